@@ -0,0 +1,140 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/algorithms/detection/motion_detection/frame_difference_motion_detector.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "visionai/algorithms/detection/motion_detection/frame_difference_motion_detector_config.pb.h"
+#include "visionai/algorithms/media/util/pixel_conversion.h"
+#include "visionai/types/raw_image.h"
+
+namespace visionai {
+namespace motion_detection {
+
+namespace {
+
+// The number of fractional bits of the reference frame.
+constexpr int kReferenceShift = 8;
+
+// The largest downscale factor whose block sums still fit into 16 bits.
+constexpr int kMaxDownscaleFactor = 16;
+
+// The largest update shift that still moves the reference frame by at least
+// one fractional level per luma level of difference.
+constexpr int kMaxReferenceUpdateShift = kReferenceShift;
+
+}  // namespace
+
+FrameDifferenceMotionDetector::FrameDifferenceMotionDetector(
+    const FrameDifferenceMotionDetectorConfig& config)
+    : config_(config) {}
+
+absl::StatusOr<bool> FrameDifferenceMotionDetector::DetectMotion(
+    const RawImage& raw_image) {
+  if (raw_image.format() != RawImage::Format::kSRGB) {
+    return absl::InvalidArgumentError("Only SRGB images are supported");
+  }
+  return DetectMotion(raw_image.data(), 3 * raw_image.width(),
+                      raw_image.width(), raw_image.height());
+}
+
+absl::StatusOr<bool> FrameDifferenceMotionDetector::DetectMotion(
+    const uint8_t* rgb, int stride, int width, int height) {
+  const int factor = config_.downscale_factor();
+  if (factor < 1 || factor > kMaxDownscaleFactor) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("The downscale factor must be between 1 and %d, got %d",
+                        kMaxDownscaleFactor, factor));
+  }
+  const int update_shift = config_.reference_update_shift();
+  if (update_shift < 0 || update_shift > kMaxReferenceUpdateShift) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "The reference update shift must be between 0 and %d, got %d",
+        kMaxReferenceUpdateShift, update_shift));
+  }
+  if (width < factor || height < factor) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("The frame is smaller than a block: %dx%d", width,
+                        height));
+  }
+
+  bool size_changed = width != width_ || height != height_;
+  if (size_changed) {
+    width_ = width;
+    height_ = height;
+    scaled_width_ = width / factor;
+    scaled_height_ = height / factor;
+    luma_.resize(scaled_width_ * scaled_height_);
+    reference_.resize(luma_.size());
+    row_luma_.resize(scaled_width_ * factor);
+    column_sums_.resize(row_luma_.size());
+  }
+  Downscale(rgb, stride);
+
+  const int n = static_cast<int>(luma_.size());
+  const uint8_t* luma = luma_.data();
+  uint16_t* reference = reference_.data();
+  if (size_changed) {
+    for (int i = 0; i < n; ++i) {
+      reference[i] = static_cast<uint16_t>(luma[i] << kReferenceShift);
+    }
+    changed_area_ratio_ = 0;
+    return false;
+  }
+
+  // Count the changed pixels and update the reference frame in a single
+  // branch free pass. The steps never overshoot the frame, so the reference
+  // stays within the range of luma.
+  const int threshold = config_.pixel_difference_threshold()
+                        << kReferenceShift;
+  int num_changed = 0;
+  for (int i = 0; i < n; ++i) {
+    int difference = (luma[i] << kReferenceShift) - reference[i];
+    num_changed += std::abs(difference) > threshold ? 1 : 0;
+    reference[i] =
+        static_cast<uint16_t>(reference[i] + (difference >> update_shift));
+  }
+  changed_area_ratio_ = static_cast<float>(num_changed) / n;
+  return changed_area_ratio_ > config_.motion_area_threshold();
+}
+
+void FrameDifferenceMotionDetector::Downscale(const uint8_t* rgb,
+                                              int stride) {
+  const int factor = config_.downscale_factor();
+  const int row_size = static_cast<int>(row_luma_.size());
+  const int block_area = factor * factor;
+  const uint8_t* row_luma = row_luma_.data();
+  uint16_t* column_sums = column_sums_.data();
+  for (int i = 0; i < scaled_height_; ++i) {
+    // Sum up the rows of the block first, so that both passes over the full
+    // resolution pixels have fixed access patterns.
+    std::fill(column_sums_.begin(), column_sums_.end(), 0);
+    for (int k = 0; k < factor; ++k) {
+      RgbToGray(rgb + static_cast<size_t>(stride) * (i * factor + k), stride,
+                row_luma_.data(), row_size, row_size, 1);
+      for (int j = 0; j < row_size; ++j) {
+        column_sums[j] += row_luma[j];
+      }
+    }
+    uint8_t* scaled_row = luma_.data() + i * scaled_width_;
+    for (int j = 0; j < scaled_width_; ++j) {
+      int sum = 0;
+      for (int k = 0; k < factor; ++k) {
+        sum += column_sums[j * factor + k];
+      }
+      scaled_row[j] = static_cast<uint8_t>((sum + block_area / 2) / block_area);
+    }
+  }
+}
+
+}  // namespace motion_detection
+}  // namespace visionai
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file or at
+ * https://developers.google.com/open-source/licenses/bsd
+ */
+
+#ifndef THIRD_PARTY_VISIONAI_ALGORITHMS_DETECTION_MOTION_DETECTION_FRAME_DIFFERENCE_MOTION_DETECTOR_H_
+#define THIRD_PARTY_VISIONAI_ALGORITHMS_DETECTION_MOTION_DETECTION_FRAME_DIFFERENCE_MOTION_DETECTOR_H_
+
+// Determine if motion is presented in a frame by comparing it against a
+// slowly updated reference frame.
+//
+// The frames are converted to luma and downscaled by averaging blocks of
+// pixels. A frame contains motion when enough of its downscaled pixels differ
+// from the reference frame by more than a threshold. The reference frame then
+// moves a fixed fraction of the way towards the frame, which absorbs lighting
+// changes and objects that stop moving.
+//
+// Everything is computed in integer arithmetic with fixed access patterns,
+// which the compiler vectorizes. This is much cheaper than the per pixel
+// Gaussian mixtures of OpenCVMotionDetector, at the cost of more false
+// positives on dynamic backgrounds such as foliage or water.
+// Note: This class is not thread-safe.
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "visionai/algorithms/detection/motion_detection/frame_difference_motion_detector_config.pb.h"
+#include "visionai/types/raw_image.h"
+
+namespace visionai {
+namespace motion_detection {
+
+class FrameDifferenceMotionDetector {
+ public:
+  explicit FrameDifferenceMotionDetector(
+      const FrameDifferenceMotionDetectorConfig& config);
+  virtual ~FrameDifferenceMotionDetector() = default;
+
+  // Main function to call to detect motion.
+  //
+  // The first frame, and the first one after a change of the frame size, only
+  // initialize the reference frame and never contain motion.
+  absl::StatusOr<bool> DetectMotion(const RawImage& raw_image);
+
+  // Same as above, for a `width` x `height` RGB image whose rows begin every
+  // `stride` bytes.
+  absl::StatusOr<bool> DetectMotion(const uint8_t* rgb, int stride, int width,
+                                    int height);
+
+  // Return the ratio of the downscaled pixels that changed in the last frame.
+  float GetChangedAreaRatio() const { return changed_area_ratio_; }
+
+ private:
+  // Downscales the luma of the frame into luma_.
+  void Downscale(const uint8_t* rgb, int stride);
+
+  FrameDifferenceMotionDetectorConfig config_;
+
+  // The size of the frames, and of the downscaled frames. The remainders of
+  // the frame that do not fill a whole block are ignored.
+  int width_ = 0;
+  int height_ = 0;
+  int scaled_width_ = 0;
+  int scaled_height_ = 0;
+
+  // The downscaled luma of the current frame.
+  std::vector<uint8_t> luma_;
+
+  // The downscaled luma of the reference frame, with kReferenceShift
+  // fractional bits, so that it moves even by a fraction of a level.
+  std::vector<uint16_t> reference_;
+
+  // One row of full resolution luma, and the sums of the rows of a block.
+  std::vector<uint8_t> row_luma_;
+  std::vector<uint16_t> column_sums_;
+
+  float changed_area_ratio_ = 0;
+};
+
+}  // namespace motion_detection
+}  // namespace visionai
+
+#endif  // THIRD_PARTY_VISIONAI_ALGORITHMS_DETECTION_MOTION_DETECTION_FRAME_DIFFERENCE_MOTION_DETECTOR_H_
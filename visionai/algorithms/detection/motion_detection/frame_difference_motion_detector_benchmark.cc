@@ -0,0 +1,106 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+// Compares the frame differencing motion detector against the MOG2 based
+// OpenCVMotionDetector on the 1080p frames of the motion test clip.
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "glog/logging.h"
+#include "opencv4/opencv2/core.hpp"
+#include "opencv4/opencv2/imgcodecs.hpp"
+#include "opencv4/opencv2/imgproc.hpp"
+#include "absl/strings/str_format.h"
+#include "visionai/algorithms/detection/motion_detection/frame_difference_motion_detector.h"
+#include "visionai/algorithms/detection/motion_detection/frame_difference_motion_detector_config.pb.h"
+#include "visionai/algorithms/detection/motion_detection/opencv_motion_detector.h"
+#include "visionai/algorithms/detection/motion_detection/opencv_motion_detector_config.pb.h"
+#include "visionai/types/raw_image.h"
+#include "visionai/util/file_path.h"
+
+namespace visionai {
+namespace motion_detection {
+namespace {
+
+const char kTestFolder[] = "visionai/testing/testdata/media/motion";
+constexpr int kNumTestImages = 20;
+
+// Returns the frames of the test clip, loaded once.
+const std::vector<RawImage>& TestFrames() {
+  static const auto* const frames = [] {
+    auto* frames = new std::vector<RawImage>();
+    for (int i = 0; i < kNumTestImages; ++i) {
+      cv::Mat bgr = cv::imread(file::JoinPath(
+          kTestFolder, absl::StrFormat("frame01%02d.jpg", i)));
+      CHECK(!bgr.empty());
+      RawImage image(bgr.rows, bgr.cols, RawImage::Format::kSRGB);
+      cv::Mat rgb(bgr.rows, bgr.cols, CV_8UC3, image.data());
+      cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB);
+      frames->push_back(std::move(image));
+    }
+    return frames;
+  }();
+  return *frames;
+}
+
+void SetBytesProcessed(benchmark::State& state, const RawImage& frame) {
+  state.SetBytesProcessed(state.iterations() * frame.size());
+}
+
+// Benchmarks OpenCVMotionDetector with the same settings as MotionFilter.
+void BM_OpenCVMotionDetector(benchmark::State& state) {
+  const std::vector<RawImage>& frames = TestFrames();
+  OpenCVMotionDetectorConfig config;
+  config.set_scale(0.1);
+  config.set_background_history_frame_length(5);
+  config.set_motion_area_threshold(0.01);
+  config.set_motion_foreground_pixel_threshold(120);
+  OpenCVMotionDetector detector(config);
+  int i = 0;
+  int num_motion_frames = 0;
+  for (auto _ : state) {
+    auto motion = detector.DetectMotion(frames[i]);
+    CHECK(motion.ok());
+    num_motion_frames += *motion ? 1 : 0;
+    i = (i + 1) % frames.size();
+  }
+  state.counters["motion_frames"] = benchmark::Counter(
+      num_motion_frames, benchmark::Counter::kAvgIterations);
+  SetBytesProcessed(state, frames[0]);
+}
+BENCHMARK(BM_OpenCVMotionDetector);
+
+// Benchmarks FrameDifferenceMotionDetector with the downscale factor given as
+// the argument.
+void BM_FrameDifferenceMotionDetector(benchmark::State& state) {
+  const std::vector<RawImage>& frames = TestFrames();
+  FrameDifferenceMotionDetectorConfig config;
+  config.set_downscale_factor(state.range(0));
+  config.set_motion_area_threshold(0.01);
+  FrameDifferenceMotionDetector detector(config);
+  int i = 0;
+  int num_motion_frames = 0;
+  for (auto _ : state) {
+    auto motion = detector.DetectMotion(frames[i]);
+    CHECK(motion.ok());
+    num_motion_frames += *motion ? 1 : 0;
+    i = (i + 1) % frames.size();
+  }
+  state.counters["motion_frames"] = benchmark::Counter(
+      num_motion_frames, benchmark::Counter::kAvgIterations);
+  SetBytesProcessed(state, frames[0]);
+}
+BENCHMARK(BM_FrameDifferenceMotionDetector)->Arg(4)->Arg(8)->Arg(16);
+
+}  // namespace
+}  // namespace motion_detection
+}  // namespace visionai
+
+BENCHMARK_MAIN();
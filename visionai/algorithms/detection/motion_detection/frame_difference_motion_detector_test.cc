@@ -0,0 +1,158 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/algorithms/detection/motion_detection/frame_difference_motion_detector.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "visionai/algorithms/detection/motion_detection/frame_difference_motion_detector_config.pb.h"
+#include "visionai/types/raw_image.h"
+
+namespace visionai {
+namespace motion_detection {
+namespace {
+
+constexpr int kFrameSize = 64;
+constexpr int kBackground = 100;
+
+FrameDifferenceMotionDetectorConfig MakeConfig() {
+  FrameDifferenceMotionDetectorConfig config;
+  config.set_downscale_factor(4);
+  config.set_pixel_difference_threshold(20);
+  config.set_reference_update_shift(2);
+  config.set_motion_area_threshold(0.01);
+  return config;
+}
+
+// Returns a gray frame with a white square of `square_size` pixels at (x, y).
+RawImage MakeFrame(int x, int y, int square_size, int gray = kBackground) {
+  RawImage image(kFrameSize, kFrameSize, RawImage::Format::kSRGB);
+  for (int i = 0; i < kFrameSize; ++i) {
+    for (int j = 0; j < kFrameSize; ++j) {
+      bool in_square = i >= y && i < y + square_size && j >= x &&
+                       j < x + square_size;
+      for (int c = 0; c < 3; ++c) {
+        image((i * kFrameSize + j) * 3 + c) = in_square ? 255 : gray;
+      }
+    }
+  }
+  return image;
+}
+
+TEST(FrameDifferenceMotionDetectorTest, NoMotionInStaticScene) {
+  FrameDifferenceMotionDetector detector(MakeConfig());
+  for (int i = 0; i < 10; ++i) {
+    auto motion = detector.DetectMotion(MakeFrame(8, 8, 8));
+    ASSERT_TRUE(motion.ok());
+    EXPECT_FALSE(*motion);
+    EXPECT_FLOAT_EQ(detector.GetChangedAreaRatio(), 0);
+  }
+}
+
+TEST(FrameDifferenceMotionDetectorTest, DetectsMovingObject) {
+  FrameDifferenceMotionDetector detector(MakeConfig());
+  // The first frame only initializes the reference frame.
+  auto motion = detector.DetectMotion(MakeFrame(0, 0, 8));
+  ASSERT_TRUE(motion.ok());
+  EXPECT_FALSE(*motion);
+
+  for (int x = 8; x < kFrameSize - 8; x += 8) {
+    motion = detector.DetectMotion(MakeFrame(x, 16, 8));
+    ASSERT_TRUE(motion.ok());
+    EXPECT_TRUE(*motion) << x;
+    EXPECT_GT(detector.GetChangedAreaRatio(), 0.01);
+  }
+}
+
+TEST(FrameDifferenceMotionDetectorTest, AbsorbsSmallAndLastingChanges) {
+  FrameDifferenceMotionDetector detector(MakeConfig());
+  ASSERT_TRUE(detector.DetectMotion(MakeFrame(0, 0, 0)).ok());
+
+  // A global change below the pixel threshold is not motion.
+  auto motion = detector.DetectMotion(MakeFrame(0, 0, 0, kBackground + 15));
+  ASSERT_TRUE(motion.ok());
+  EXPECT_FALSE(*motion);
+
+  // An object that appears and stays still is motion at first, until the
+  // reference frame catches up with it.
+  motion = detector.DetectMotion(MakeFrame(16, 16, 16, kBackground + 15));
+  ASSERT_TRUE(motion.ok());
+  EXPECT_TRUE(*motion);
+  for (int i = 0; i < 10; ++i) {
+    motion = detector.DetectMotion(MakeFrame(16, 16, 16, kBackground + 15));
+    ASSERT_TRUE(motion.ok());
+  }
+  EXPECT_FALSE(*motion);
+}
+
+TEST(FrameDifferenceMotionDetectorTest, IgnoresRowPadding) {
+  FrameDifferenceMotionDetector padded_detector(MakeConfig());
+  FrameDifferenceMotionDetector detector(MakeConfig());
+  const int stride = 3 * kFrameSize + 5;
+  for (int x : {0, 24, 48}) {
+    RawImage frame = MakeFrame(x, x, 16);
+    std::vector<uint8_t> padded(stride * kFrameSize, 0);
+    for (int i = 0; i < kFrameSize; ++i) {
+      for (int j = 0; j < 3 * kFrameSize; ++j) {
+        padded[i * stride + j] = frame(i * 3 * kFrameSize + j);
+      }
+      // Noise in the padding must never be read.
+      for (int j = 3 * kFrameSize; j < stride; ++j) {
+        padded[i * stride + j] = (i * j) % 256;
+      }
+    }
+    auto padded_motion = padded_detector.DetectMotion(padded.data(), stride,
+                                                      kFrameSize, kFrameSize);
+    auto motion = detector.DetectMotion(frame);
+    ASSERT_TRUE(padded_motion.ok());
+    ASSERT_TRUE(motion.ok());
+    EXPECT_EQ(*padded_motion, *motion);
+    EXPECT_FLOAT_EQ(padded_detector.GetChangedAreaRatio(),
+                    detector.GetChangedAreaRatio());
+  }
+}
+
+TEST(FrameDifferenceMotionDetectorTest, RestartsOnSizeChange) {
+  FrameDifferenceMotionDetector detector(MakeConfig());
+  ASSERT_TRUE(detector.DetectMotion(MakeFrame(0, 0, 0)).ok());
+
+  RawImage smaller(kFrameSize / 2, kFrameSize / 2, RawImage::Format::kSRGB);
+  auto motion = detector.DetectMotion(smaller);
+  ASSERT_TRUE(motion.ok());
+  EXPECT_FALSE(*motion);
+  motion = detector.DetectMotion(smaller);
+  ASSERT_TRUE(motion.ok());
+  EXPECT_FALSE(*motion);
+}
+
+TEST(FrameDifferenceMotionDetectorTest, InvalidArguments) {
+  FrameDifferenceMotionDetectorConfig config = MakeConfig();
+  config.set_downscale_factor(0);
+  FrameDifferenceMotionDetector zero_factor_detector(config);
+  EXPECT_EQ(
+      zero_factor_detector.DetectMotion(MakeFrame(0, 0, 0)).status().code(),
+      absl::StatusCode::kInvalidArgument);
+
+  config = MakeConfig();
+  config.set_reference_update_shift(9);
+  FrameDifferenceMotionDetector large_shift_detector(config);
+  EXPECT_EQ(
+      large_shift_detector.DetectMotion(MakeFrame(0, 0, 0)).status().code(),
+      absl::StatusCode::kInvalidArgument);
+
+  FrameDifferenceMotionDetector detector(MakeConfig());
+  RawImage tiny(2, 2, RawImage::Format::kSRGB);
+  EXPECT_EQ(detector.DetectMotion(tiny).status().code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+}  // namespace
+}  // namespace motion_detection
+}  // namespace visionai
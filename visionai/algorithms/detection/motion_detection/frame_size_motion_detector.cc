@@ -0,0 +1,85 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/algorithms/detection/motion_detection/frame_size_motion_detector.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "visionai/algorithms/detection/motion_detection/frame_size_motion_detector_config.pb.h"
+
+namespace visionai {
+namespace motion_detection {
+
+namespace {
+// The number of consecutive early key frames with the same GOP length after
+// which that length is adopted as the new regular GOP length. This makes the
+// detector adapt when the camera is reconfigured to a shorter GOP.
+constexpr int kEarlyKeyFramesToAdoptGopLength = 3;
+
+// The factor applied to the baseline update rate for frames with motion.
+constexpr double kMotionFrameUpdateRateScale = 0.1;
+}  // namespace
+
+FrameSizeMotionDetector::FrameSizeMotionDetector(
+    const FrameSizeMotionDetectorConfig& config)
+    : config_(config) {}
+
+bool FrameSizeMotionDetector::UpdateGopLength(int gop_length) {
+  if (regular_gop_length_ == 0 || gop_length >= regular_gop_length_) {
+    regular_gop_length_ = gop_length;
+    consecutive_early_key_frames_ = 0;
+    return false;
+  }
+  if (gop_length >= config_.early_key_frame_ratio() * regular_gop_length_) {
+    consecutive_early_key_frames_ = 0;
+    return false;
+  }
+  if (++consecutive_early_key_frames_ >= kEarlyKeyFramesToAdoptGopLength) {
+    regular_gop_length_ = gop_length;
+    consecutive_early_key_frames_ = 0;
+    return false;
+  }
+  return true;
+}
+
+bool FrameSizeMotionDetector::DetectMotion(int64_t frame_size,
+                                           bool is_key_frame) {
+  if (is_key_frame) {
+    bool early_key_frame = false;
+    if (frames_since_key_frame_ > 0) {
+      early_key_frame = UpdateGopLength(frames_since_key_frame_);
+    }
+    frames_since_key_frame_ = 1;
+    return early_key_frame;
+  }
+  if (frames_since_key_frame_ > 0) {
+    ++frames_since_key_frame_;
+  }
+
+  double size = static_cast<double>(frame_size);
+  if (num_baseline_frames_ < std::max(config_.warmup_frames(), 1)) {
+    // Plain running mean during the warm-up.
+    ++num_baseline_frames_;
+    baseline_ += (size - baseline_) / num_baseline_frames_;
+    return false;
+  }
+
+  double threshold = config_.size_ratio_threshold() * baseline_;
+  bool motion = size > threshold;
+  // Frames with motion are clamped and weighted down so that a burst of motion
+  // barely raises the baseline, while a lasting change of the scene is still
+  // adapted to eventually.
+  double update_rate = config_.baseline_update_rate();
+  if (motion) {
+    update_rate *= kMotionFrameUpdateRateScale;
+  }
+  baseline_ += update_rate * (std::min(size, threshold) - baseline_);
+  return motion;
+}
+
+}  // namespace motion_detection
+}  // namespace visionai
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file or at
+ * https://developers.google.com/open-source/licenses/bsd
+ */
+
+#ifndef THIRD_PARTY_VISIONAI_ALGORITHMS_DETECTION_MOTION_DETECTION_FRAME_SIZE_MOTION_DETECTOR_H_
+#define THIRD_PARTY_VISIONAI_ALGORITHMS_DETECTION_MOTION_DETECTION_FRAME_SIZE_MOTION_DETECTOR_H_
+
+// Determine if motion is presented in a frame by analyzing the statistics of
+// the encoded bitstream, without decoding it.
+//
+// Inter-coded frames of a static scene are small since almost every macroblock
+// is skipped. Motion makes them grow. The detector keeps a running baseline of
+// the non-key frame sizes and reports motion when a frame is much larger than
+// the baseline. Besides, encoders insert extra key frames on scene changes, so
+// a key frame that arrives much earlier than the regular GOP cadence is also
+// reported as motion.
+
+#include <cstdint>
+
+#include "visionai/algorithms/detection/motion_detection/frame_size_motion_detector_config.pb.h"
+
+namespace visionai {
+namespace motion_detection {
+
+class FrameSizeMotionDetector {
+ public:
+  explicit FrameSizeMotionDetector(const FrameSizeMotionDetectorConfig& config);
+  virtual ~FrameSizeMotionDetector() = default;
+
+  // Perform motion detection given the encoded size (in bytes) of the next
+  // frame and whether it is a key frame. Frames must be given in decoding
+  // order.
+  bool DetectMotion(int64_t frame_size, bool is_key_frame);
+
+  // Return the running baseline of the non-key frame sizes.
+  double GetBaseline() const { return baseline_; }
+
+  // Return the regular GOP length, in frames, or 0 if it isn't known yet.
+  int GetRegularGopLength() const { return regular_gop_length_; }
+
+ private:
+  // Returns true if a key frame that closes a GOP of `gop_length` frames
+  // arrives earlier than the regular cadence.
+  bool UpdateGopLength(int gop_length);
+
+  FrameSizeMotionDetectorConfig config_;
+
+  // Running baseline of the non-key frame sizes.
+  double baseline_ = 0;
+  int num_baseline_frames_ = 0;
+
+  // Number of frames since the last key frame, including it. -1 if no key
+  // frame has been seen yet.
+  int frames_since_key_frame_ = -1;
+
+  // The GOP length that the encoder regularly produces.
+  int regular_gop_length_ = 0;
+
+  // The number of consecutive GOPs that were shorter than the regular length.
+  int consecutive_early_key_frames_ = 0;
+};
+
+}  // namespace motion_detection
+}  // namespace visionai
+
+#endif  // THIRD_PARTY_VISIONAI_ALGORITHMS_DETECTION_MOTION_DETECTION_FRAME_SIZE_MOTION_DETECTOR_H_
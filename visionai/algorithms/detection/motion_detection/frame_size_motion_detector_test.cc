@@ -0,0 +1,112 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/algorithms/detection/motion_detection/frame_size_motion_detector.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "visionai/algorithms/detection/motion_detection/frame_size_motion_detector_config.pb.h"
+
+namespace visionai {
+namespace motion_detection {
+namespace {
+
+constexpr int kGopLength = 30;
+constexpr int kStaticFrameSize = 1000;
+constexpr int kKeyFrameSize = 50000;
+
+FrameSizeMotionDetectorConfig MakeConfig() {
+  FrameSizeMotionDetectorConfig config;
+  config.set_size_ratio_threshold(2.0);
+  config.set_baseline_update_rate(0.1);
+  config.set_warmup_frames(10);
+  config.set_early_key_frame_ratio(0.5);
+  return config;
+}
+
+// Feeds `num_gops` GOPs of a static scene. Returns the number of frames for
+// which motion was detected.
+int FeedStaticGops(FrameSizeMotionDetector& detector, int num_gops) {
+  int num_motion_frames = 0;
+  for (int i = 0; i < num_gops * kGopLength; ++i) {
+    bool is_key_frame = i % kGopLength == 0;
+    if (detector.DetectMotion(is_key_frame ? kKeyFrameSize : kStaticFrameSize,
+                              is_key_frame)) {
+      ++num_motion_frames;
+    }
+  }
+  return num_motion_frames;
+}
+
+TEST(FrameSizeMotionDetectorTest, NoMotionInStaticScene) {
+  FrameSizeMotionDetector detector(MakeConfig());
+  EXPECT_EQ(FeedStaticGops(detector, 5), 0);
+  EXPECT_DOUBLE_EQ(detector.GetBaseline(), kStaticFrameSize);
+  EXPECT_EQ(detector.GetRegularGopLength(), kGopLength);
+}
+
+TEST(FrameSizeMotionDetectorTest, NoMotionDuringWarmup) {
+  FrameSizeMotionDetector detector(MakeConfig());
+  EXPECT_FALSE(detector.DetectMotion(kKeyFrameSize, true));
+  for (int i = 0; i < 9; ++i) {
+    EXPECT_FALSE(detector.DetectMotion(kStaticFrameSize, false));
+  }
+  // Still warming up, so even a large frame is absorbed into the baseline.
+  EXPECT_FALSE(detector.DetectMotion(10 * kStaticFrameSize, false));
+}
+
+TEST(FrameSizeMotionDetectorTest, DetectsLargeInterFrames) {
+  FrameSizeMotionDetector detector(MakeConfig());
+  ASSERT_EQ(FeedStaticGops(detector, 2), 0);
+
+  // Key frames are large, but that alone is no motion.
+  EXPECT_FALSE(detector.DetectMotion(kKeyFrameSize, true));
+  EXPECT_FALSE(detector.DetectMotion(kStaticFrameSize, false));
+  EXPECT_TRUE(detector.DetectMotion(5 * kStaticFrameSize, false));
+  EXPECT_TRUE(detector.DetectMotion(5 * kStaticFrameSize, false));
+  EXPECT_FALSE(detector.DetectMotion(kStaticFrameSize, false));
+
+  // The outliers only raised the baseline by a bounded amount.
+  EXPECT_LT(detector.GetBaseline(), 1.5 * kStaticFrameSize);
+}
+
+TEST(FrameSizeMotionDetectorTest, DetectsEarlyKeyFrames) {
+  FrameSizeMotionDetector detector(MakeConfig());
+  ASSERT_EQ(FeedStaticGops(detector, 2), 0);
+
+  // The key frame that closes the 2nd GOP arrives on time.
+  EXPECT_FALSE(detector.DetectMotion(kKeyFrameSize, true));
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_FALSE(detector.DetectMotion(kStaticFrameSize, false));
+  }
+  // An encoder-inserted key frame after only 6 frames.
+  EXPECT_TRUE(detector.DetectMotion(kKeyFrameSize, true));
+  EXPECT_EQ(detector.GetRegularGopLength(), kGopLength);
+}
+
+TEST(FrameSizeMotionDetectorTest, AdoptsShorterGopLength) {
+  FrameSizeMotionDetector detector(MakeConfig());
+  ASSERT_EQ(FeedStaticGops(detector, 2), 0);
+
+  constexpr int kShortGopLength = 10;
+  int num_early_key_frames = 0;
+  for (int gop = 0; gop < 5; ++gop) {
+    if (detector.DetectMotion(kKeyFrameSize, true)) {
+      ++num_early_key_frames;
+    }
+    for (int i = 1; i < kShortGopLength; ++i) {
+      EXPECT_FALSE(detector.DetectMotion(kStaticFrameSize, false));
+    }
+  }
+  // The first key frame closes a regular GOP. The 2nd and 3rd are early. The
+  // 4th makes the detector adopt the shorter GOP length.
+  EXPECT_EQ(num_early_key_frames, 2);
+  EXPECT_EQ(detector.GetRegularGopLength(), kShortGopLength);
+}
+
+}  // namespace
+}  // namespace motion_detection
+}  // namespace visionai
@@ -19,7 +19,6 @@
 #include "visionai/algorithms/stream_annotation/geometry_lib.h"
 #include "visionai/algorithms/stream_annotation/stream_annotation_util.h"
 #include "visionai/types/motion_vector.h"
-#include "visionai/util/array/array3d.h"
 #include "visionai/util/status/status_macros.h"
 
 namespace visionai {
@@ -46,7 +45,8 @@ bool MotionVectorBasedMotionDetector::DetectMotion(
   absl::Status status =
       ::visionai::motion_detection::ComputeMaxMagnitudeEntropyWithSpatialGrid(
           motion_vectors, grids_features_buffer_, spatial_grid_number,
-          frame_height_, frame_width_, mv_features_spatial_temporal_);
+          frame_height_, frame_width_, mv_features_spatial_temporal_,
+          &motion_vector_grid_);
 
   if (!status.ok()) {
     LOG(ERROR) << status.message();
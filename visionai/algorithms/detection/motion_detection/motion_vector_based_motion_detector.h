@@ -16,11 +16,11 @@
 
 #include "absl/status/statusor.h"
 #include "visionai/algorithms/detection/motion_detection/motion_vector_based_motion_detector_config.pb.h"
+#include "visionai/algorithms/detection/motion_detection/temporal_feature_buffer.h"
+#include "visionai/algorithms/detection/motion_detection/util.h"
 #include "visionai/algorithms/stream_annotation/geometry_lib.h"
 #include "visionai/algorithms/stream_annotation/stream_annotation_util.h"
 #include "visionai/types/motion_vector.h"
-#include "visionai/util/array/array3d.h"
-#include "visionai/util/gtl/circularbuffer.h"
 
 namespace visionai {
 namespace motion_detection {
@@ -63,11 +63,14 @@ class MotionVectorBasedMotionDetector {
 
   // Holds the spatial temporal motion feature buffer, which gets continuously
   // updated  when new motion vectors come in.
-  gtl::CircularBuffer<Array3D<float>> grids_features_buffer_;
+  TemporalFeatureBuffer grids_features_buffer_;
 
   // Motion features used for motion prediction in all the spatial grids.
   std::vector<float> mv_features_spatial_temporal_;
 
+  // Reusable scratch space for bucketing the motion vectors by grid cell.
+  MotionVectorGrid motion_vector_grid_;
+
   // Filtered motion vector based on zone config.
   std::vector<MotionVector> filtered_motion_vectors_;
 
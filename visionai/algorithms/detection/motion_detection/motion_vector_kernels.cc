@@ -0,0 +1,265 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/algorithms/detection/motion_detection/motion_vector_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "glog/logging.h"
+#include "absl/container/inlined_vector.h"
+#include "visionai/types/motion_vector.h"
+
+namespace visionai {
+namespace motion_detection {
+
+namespace {
+
+constexpr float kEpsilon = 1e-5;
+
+// The number of entropy bins up to which no heap allocation is needed.
+constexpr int kMaxInlinedBins = 64;
+
+// The number of independent accumulators used by the reductions.
+//
+// Floating point additions are not associative, so the compiler may not
+// vectorize a reduction into a single accumulator on its own. Spreading the
+// reduction over independent lanes lets it map each lane onto a SIMD lane,
+// whether the target has 4 (SSE, NEON) or 8 (AVX2) floats per register.
+constexpr int kLanes = 8;
+
+// Returns the sum of `term(i)` for 0 <= i < n.
+template <typename Term>
+inline float SumLanes(int n, Term term) {
+  float lanes[kLanes] = {0};
+  int i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    for (int j = 0; j < kLanes; ++j) {
+      lanes[j] += term(i + j);
+    }
+  }
+  float sum = 0;
+  for (; i < n; ++i) {
+    sum += term(i);
+  }
+  for (int j = 0; j < kLanes; ++j) {
+    sum += lanes[j];
+  }
+  return sum;
+}
+
+// Returns the diamond angle of (x, y) in [0, 4).
+//
+// This maps the directions monotonically onto [0, 4), as atan2 does onto
+// [0, 2 * pi), with the axes landing on the integers.
+inline float DiamondAngle(float x, float y) {
+  float ax = std::abs(x);
+  float ay = std::abs(y);
+  float s = ax + ay;
+  // The fraction of the way through the current quadrant.
+  float t_even = ay / s;
+  float t_odd = ax / s;
+  if (y >= 0) {
+    return x >= 0 ? t_even : 1 + t_odd;
+  }
+  return x < 0 ? 2 + t_even : 3 + t_odd;
+}
+
+// Loads `motion_vectors[index(i)]` for 0 <= i < n into `arrays`.
+template <typename Index>
+void LoadArrays(int n, Index index, const MotionVectors& motion_vectors,
+                int frame_height, int frame_width, MotionVectorArrays* arrays) {
+  arrays->Resize(n);
+  float* x = arrays->x.data();
+  float* y = arrays->y.data();
+  float* block_size = arrays->block_size.data();
+  for (int i = 0; i < n; ++i) {
+    const MotionVector& mv = motion_vectors[index(i)];
+    x[i] = static_cast<float>(mv.motion_x) / mv.motion_scale / frame_width;
+    y[i] = static_cast<float>(mv.motion_y) / mv.motion_scale / frame_height;
+    block_size[i] = std::sqrt(mv.w * mv.h);
+    if (std::abs(x[i]) > kEpsilon || std::abs(y[i]) > kEpsilon) {
+      CHECK(mv.w > 0 && mv.h > 0);
+    }
+  }
+  ComputeMagnitudes(x, y, n, arrays->magnitude.data());
+}
+
+}  // namespace
+
+void MotionVectorArrays::Resize(int n) {
+  x.resize(n);
+  y.resize(n);
+  magnitude.resize(n);
+  block_size.resize(n);
+  float_scratch.resize(n);
+  int_scratch.resize(n);
+}
+
+void LoadMotionVectorArrays(const MotionVectors& motion_vectors,
+                            int frame_height, int frame_width,
+                            MotionVectorArrays* arrays) {
+  LoadArrays(
+      static_cast<int>(motion_vectors.size()), [](int i) { return i; },
+      motion_vectors, frame_height, frame_width, arrays);
+}
+
+void LoadMotionVectorArrays(const MotionVectors& motion_vectors,
+                            const int* indices, int num_indices,
+                            int frame_height, int frame_width,
+                            MotionVectorArrays* arrays) {
+  LoadArrays(
+      num_indices, [indices](int i) { return indices[i]; }, motion_vectors,
+      frame_height, frame_width, arrays);
+}
+
+NonzeroMotionStats ComputeNonzeroMotionStats(const MotionVectorArrays& arrays,
+                                             float min_motion) {
+  const float* x = arrays.x.data();
+  const float* y = arrays.y.data();
+  const float* block_size = arrays.block_size.data();
+  int n = arrays.size();
+  auto is_nonzero = [x, y, min_motion](int i) {
+    return std::abs(x[i]) > min_motion || std::abs(y[i]) > min_motion;
+  };
+
+  NonzeroMotionStats stats;
+  for (int i = 0; i < n; ++i) {
+    stats.count += is_nonzero(i) ? 1 : 0;
+  }
+  // The block size of a zero vector may be zero, so select rather than
+  // multiply by a mask.
+  stats.weighted_count = SumLanes(n, [&is_nonzero, block_size](int i) {
+    return is_nonzero(i) ? 16.0f / block_size[i] : 0.0f;
+  });
+  stats.block_size_sum = SumLanes(n, [&is_nonzero, block_size](int i) {
+    return is_nonzero(i) ? block_size[i] : 0.0f;
+  });
+  return stats;
+}
+
+void ComputeMagnitudes(const float* x, const float* y, int n,
+                       float* magnitudes) {
+  for (int i = 0; i < n; ++i) {
+    magnitudes[i] = std::sqrt(x[i] * x[i] + y[i] * y[i]);
+  }
+}
+
+float Sum(const float* values, int n) {
+  return SumLanes(n, [values](int i) { return values[i]; });
+}
+
+int ArgMax(const float* values, int n) {
+  if (n <= 0) {
+    return -1;
+  }
+  // Find the maximum with independent lanes first, and only then look for its
+  // first occurrence, so that the hot loop carries no index.
+  float lanes[kLanes];
+  std::fill(lanes, lanes + kLanes, values[0]);
+  int i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    for (int j = 0; j < kLanes; ++j) {
+      lanes[j] = std::max(lanes[j], values[i + j]);
+    }
+  }
+  float max_value = *std::max_element(lanes, lanes + kLanes);
+  for (; i < n; ++i) {
+    max_value = std::max(max_value, values[i]);
+  }
+  return static_cast<int>(std::find(values, values + n, max_value) - values);
+}
+
+float SumAbsoluteDeviation(const float* values, int n, float center) {
+  return SumLanes(
+      n, [values, center](int i) { return std::abs(values[i] - center); });
+}
+
+float SumSquaredDeviation(const float* values, int n, float center) {
+  return SumLanes(n, [values, center](int i) {
+    float d = values[i] - center;
+    return d * d;
+  });
+}
+
+float SumDistances(const float* x, const float* y, int n, float center_x,
+                   float center_y) {
+  return SumLanes(n, [x, y, center_x, center_y](int i) {
+    float dx = x[i] - center_x;
+    float dy = y[i] - center_y;
+    return std::sqrt(dx * dx + dy * dy);
+  });
+}
+
+float SumAnglesToReference(const float* x, const float* y,
+                           const float* magnitudes, int n, float ref_x,
+                           float ref_y, float ref_magnitude,
+                           float min_magnitude, float* cosines) {
+  // Compute all of the cosines in a branch free pass first. Vectors that must
+  // not contribute get a cosine of 1, i.e. an angle of 0.
+  for (int i = 0; i < n; ++i) {
+    float cosine = (x[i] * ref_x + y[i] * ref_y) /
+                   (magnitudes[i] * ref_magnitude);
+    // Rounding may push the cosine of (nearly) parallel vectors past 1.
+    cosine = std::min(1.0f, std::max(-1.0f, cosine));
+    cosines[i] = magnitudes[i] > min_magnitude ? cosine : 1.0f;
+  }
+  for (int i = 0; i < n; ++i) {
+    cosines[i] = std::acos(cosines[i]);
+  }
+  return Sum(cosines, n);
+}
+
+void ComputeDirectionHistogram(const float* x, const float* y,
+                               const float* magnitudes, int n, int num_bins,
+                               float min_magnitude, float* histogram) {
+  if (num_bins <= 0) {
+    return;
+  }
+  std::fill(histogram, histogram + num_bins, 0.0f);
+  float bins_per_quadrant = num_bins / 4.0f;
+  for (int i = 0; i < n; ++i) {
+    bool counted = magnitudes[i] > min_magnitude;
+    // Vectors that are not counted may have no direction at all.
+    float angle = counted ? DiamondAngle(x[i], y[i]) : 0.0f;
+    int bin = std::min(num_bins - 1,
+                       static_cast<int>(angle * bins_per_quadrant));
+    histogram[bin] += counted ? magnitudes[i] : 0.0f;
+  }
+}
+
+float EstimateEntropy(const float* values, int n, float mean,
+                      float standard_deviation, int num_bins, int* bins) {
+  if (n <= 0 || std::abs(standard_deviation) < kEpsilon) {
+    return 0;
+  }
+
+  float upper_bound = mean + 5 * standard_deviation;
+  float bin_size = upper_bound / num_bins;
+
+  // Compute the bin indices in a branch free pass, and only then histogram
+  // them.
+  for (int i = 0; i < n; ++i) {
+    bins[i] = std::min(num_bins,
+                       static_cast<int>(std::floor(values[i] / bin_size)));
+  }
+  absl::InlinedVector<float, kMaxInlinedBins> frequencies(num_bins + 1, 0);
+  for (int i = 0; i < n; ++i) {
+    frequencies[bins[i]] += 1.0;
+  }
+
+  float entropy = 0;
+  for (int i = 0; i < num_bins + 1; ++i) {
+    if (frequencies[i] > 0) {
+      frequencies[i] /= n;
+      entropy -= frequencies[i] * std::log(frequencies[i]);
+    }
+  }
+  return entropy;
+}
+
+}  // namespace motion_detection
+}  // namespace visionai
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file or at
+ * https://developers.google.com/open-source/licenses/bsd
+ */
+
+#ifndef THIRD_PARTY_VISIONAI_ALGORITHMS_DETECTION_MOTION_DETECTION_MOTION_VECTOR_KERNELS_H_
+#define THIRD_PARTY_VISIONAI_ALGORITHMS_DETECTION_MOTION_DETECTION_MOTION_VECTOR_KERNELS_H_
+
+#include <vector>
+
+#include "visionai/types/motion_vector.h"
+
+namespace visionai {
+namespace motion_detection {
+
+// Motion vectors in a structure-of-arrays layout.
+//
+// `MotionVectors` stores each vector as a packed struct, which forces the
+// feature kernels to process one vector at a time. This layout keeps each
+// quantity in its own contiguous array instead, so that the kernels below can
+// process several vectors per instruction.
+struct MotionVectorArrays {
+  // The motion along x, normalized by the frame width.
+  std::vector<float> x;
+
+  // The motion along y, normalized by the frame height.
+  std::vector<float> y;
+
+  // The norm of (x, y).
+  std::vector<float> magnitude;
+
+  // The side length of the equivalent square block, sqrt(w * h).
+  std::vector<float> block_size;
+
+  // Scratch space for the kernels that need a temporary per vector.
+  std::vector<float> float_scratch;
+  std::vector<int> int_scratch;
+
+  int size() const { return static_cast<int>(x.size()); }
+
+  // Resizes all of the arrays to `n` elements.
+  //
+  // The arrays keep their capacity, so that reusing an instance across frames
+  // stops allocating once it has seen the largest frame.
+  void Resize(int n);
+};
+
+// Converts `motion_vectors` into the structure-of-arrays layout.
+//
+// The motion is normalized by the frame size, and the magnitudes are computed.
+void LoadMotionVectorArrays(const MotionVectors& motion_vectors,
+                            int frame_height, int frame_width,
+                            MotionVectorArrays* arrays);
+
+// Same as above, but only loads `motion_vectors[indices[i]]` for
+// 0 <= i < `num_indices`, in that order.
+void LoadMotionVectorArrays(const MotionVectors& motion_vectors,
+                            const int* indices, int num_indices,
+                            int frame_height, int frame_width,
+                            MotionVectorArrays* arrays);
+
+// Statistics of the vectors whose motion is not negligible.
+struct NonzeroMotionStats {
+  // The number of such vectors.
+  int count = 0;
+
+  // The sum of 16 / block_size over such vectors, i.e. their number in units
+  // of 16x16 macroblocks.
+  float weighted_count = 0;
+
+  // The sum of block_size over such vectors.
+  float block_size_sum = 0;
+};
+
+// Computes the statistics of the vectors of `arrays` whose motion along x or y
+// exceeds `min_motion` in absolute value.
+NonzeroMotionStats ComputeNonzeroMotionStats(const MotionVectorArrays& arrays,
+                                             float min_motion);
+
+// Computes magnitudes[i] = sqrt(x[i]^2 + y[i]^2) for 0 <= i < n.
+void ComputeMagnitudes(const float* x, const float* y, int n,
+                       float* magnitudes);
+
+// Returns the sum of `values[0, n)`.
+float Sum(const float* values, int n);
+
+// Returns the index of the first largest element of `values[0, n)`, or -1 if
+// n is zero.
+int ArgMax(const float* values, int n);
+
+// Returns the sum of |values[i] - center| for 0 <= i < n.
+float SumAbsoluteDeviation(const float* values, int n, float center);
+
+// Returns the sum of (values[i] - center)^2 for 0 <= i < n.
+float SumSquaredDeviation(const float* values, int n, float center);
+
+// Returns the sum of the norms of (x[i] - center_x, y[i] - center_y) for
+// 0 <= i < n.
+float SumDistances(const float* x, const float* y, int n, float center_x,
+                   float center_y);
+
+// Returns the sum of the angles (in radians) between (x[i], y[i]) and the
+// reference vector (ref_x, ref_y) whose norm is `ref_magnitude`.
+//
+// Only the vectors whose magnitude exceeds `min_magnitude` contribute to the
+// sum. `cosines` is a scratch buffer of at least `n` elements.
+float SumAnglesToReference(const float* x, const float* y,
+                           const float* magnitudes, int n, float ref_x,
+                           float ref_y, float ref_magnitude,
+                           float min_magnitude, float* cosines);
+
+// Computes a magnitude weighted histogram of the directions of the vectors.
+//
+// The directions are binned by their "diamond angle", a cheap monotonic proxy
+// of atan2 that does not need any transcendental function. The bin edges
+// coincide with those of the true angle whenever `num_bins` divides 8. Bin 0
+// starts at the positive x axis, and the bins turn towards the positive y
+// axis.
+//
+// Vectors whose magnitude does not exceed `min_magnitude` are ignored.
+// `histogram` must have `num_bins` elements.
+void ComputeDirectionHistogram(const float* x, const float* y,
+                               const float* magnitudes, int n, int num_bins,
+                               float min_magnitude, float* histogram);
+
+// Estimates the entropy of `values[0, n)`, given their mean and standard
+// deviation.
+//
+// The values are histogrammed into `num_bins` bins of equal width that cover
+// [0, mean + 5 * standard_deviation), plus one bin for everything beyond.
+// Returns 0 if n is zero or the standard deviation is negligible.
+// `bins` is a scratch buffer of at least `n` elements.
+float EstimateEntropy(const float* values, int n, float mean,
+                      float standard_deviation, int num_bins, int* bins);
+
+}  // namespace motion_detection
+}  // namespace visionai
+
+#endif  // THIRD_PARTY_VISIONAI_ALGORITHMS_DETECTION_MOTION_DETECTION_MOTION_VECTOR_KERNELS_H_
@@ -0,0 +1,184 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/algorithms/detection/motion_detection/motion_vector_kernels.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "visionai/types/motion_vector.h"
+
+namespace visionai {
+namespace motion_detection {
+namespace {
+
+constexpr float kTolerance = 1e-4;
+
+// Lengths that exercise both the vectorized body and the scalar tail.
+constexpr int kLengths[] = {0, 1, 7, 8, 9, 31, 1000};
+
+std::vector<float> RandomValues(int n, float low, float high,
+                                std::mt19937* rng) {
+  std::uniform_real_distribution<float> distribution(low, high);
+  std::vector<float> values(n);
+  for (float& value : values) {
+    value = distribution(*rng);
+  }
+  return values;
+}
+
+TEST(MotionVectorKernelsTest, LoadMotionVectorArrays) {
+  MotionVectors motion_vectors = {
+      MotionVector{/* .source = */ -1, /* .w = */ 16, /* .h = */ 16,
+                   /* .src_x = */ 0, /* .src_y = */ 0, /* .dst_x = */ 0,
+                   /* .dst_y = */ 0, /* .motion_x = */ 6,
+                   /* .motion_y = */ -8, /* .motion_scale = */ 2},
+      MotionVector{/* .source = */ 1, /* .w = */ 8, /* .h = */ 16,
+                   /* .src_x = */ 0, /* .src_y = */ 0, /* .dst_x = */ 0,
+                   /* .dst_y = */ 0, /* .motion_x = */ 0,
+                   /* .motion_y = */ 0, /* .motion_scale = */ 4}};
+
+  MotionVectorArrays arrays;
+  LoadMotionVectorArrays(motion_vectors, /*frame_height=*/4,
+                         /*frame_width=*/3, &arrays);
+  ASSERT_EQ(arrays.size(), 2);
+  EXPECT_FLOAT_EQ(arrays.x[0], 1.0);
+  EXPECT_FLOAT_EQ(arrays.y[0], -1.0);
+  EXPECT_FLOAT_EQ(arrays.magnitude[0], std::sqrt(2));
+  EXPECT_FLOAT_EQ(arrays.block_size[0], 16.0);
+  EXPECT_FLOAT_EQ(arrays.x[1], 0.0);
+  EXPECT_FLOAT_EQ(arrays.y[1], 0.0);
+  EXPECT_FLOAT_EQ(arrays.magnitude[1], 0.0);
+  EXPECT_FLOAT_EQ(arrays.block_size[1], std::sqrt(128));
+
+  std::vector<int> indices = {1};
+  LoadMotionVectorArrays(motion_vectors, indices.data(), indices.size(),
+                         /*frame_height=*/4, /*frame_width=*/3, &arrays);
+  ASSERT_EQ(arrays.size(), 1);
+  EXPECT_FLOAT_EQ(arrays.block_size[0], std::sqrt(128));
+}
+
+TEST(MotionVectorKernelsTest, ReductionsMatchScalarLoops) {
+  std::mt19937 rng(42);
+  for (int n : kLengths) {
+    std::vector<float> x = RandomValues(n, -1, 1, &rng);
+    std::vector<float> y = RandomValues(n, -1, 1, &rng);
+    float center = 0.25;
+
+    double sum = 0;
+    double sum_absolute_deviation = 0;
+    double sum_squared_deviation = 0;
+    double sum_distances = 0;
+    for (int i = 0; i < n; ++i) {
+      sum += x[i];
+      sum_absolute_deviation += std::abs(x[i] - center);
+      sum_squared_deviation += std::pow(x[i] - center, 2.0);
+      sum_distances +=
+          std::sqrt(std::pow(x[i] - center, 2.0) + std::pow(y[i] + center, 2));
+    }
+
+    EXPECT_NEAR(Sum(x.data(), n), sum, kTolerance) << n;
+    EXPECT_NEAR(SumAbsoluteDeviation(x.data(), n, center),
+                sum_absolute_deviation, kTolerance)
+        << n;
+    EXPECT_NEAR(SumSquaredDeviation(x.data(), n, center),
+                sum_squared_deviation, kTolerance)
+        << n;
+    EXPECT_NEAR(SumDistances(x.data(), y.data(), n, center, -center),
+                sum_distances, kTolerance)
+        << n;
+
+    std::vector<float> magnitudes(n);
+    ComputeMagnitudes(x.data(), y.data(), n, magnitudes.data());
+    for (int i = 0; i < n; ++i) {
+      EXPECT_NEAR(magnitudes[i],
+                  std::sqrt(std::pow(x[i], 2.0) + std::pow(y[i], 2.0)),
+                  kTolerance);
+    }
+  }
+}
+
+TEST(MotionVectorKernelsTest, ArgMax) {
+  std::vector<float> values = {0, 3, 1, 3, 2, 0, 0, 0, 0, 5, 5, 1};
+  EXPECT_EQ(ArgMax(values.data(), 0), -1);
+  EXPECT_EQ(ArgMax(values.data(), 1), 0);
+  EXPECT_EQ(ArgMax(values.data(), 8), 1);
+  EXPECT_EQ(ArgMax(values.data(), values.size()), 9);
+}
+
+TEST(MotionVectorKernelsTest, SumAnglesToReference) {
+  std::vector<float> x = {1, 0, -1, 0, 1, 0};
+  std::vector<float> y = {0, 1, 0, -1, 1, 0};
+  std::vector<float> magnitudes(x.size());
+  ComputeMagnitudes(x.data(), y.data(), x.size(), magnitudes.data());
+  std::vector<float> cosines(x.size());
+
+  // The angles to (1, 0) are 0, pi/2, pi, pi/2 and pi/4, and the zero vector
+  // is skipped.
+  EXPECT_NEAR(SumAnglesToReference(x.data(), y.data(), magnitudes.data(),
+                                   x.size(), 1, 0, 1, 1e-5, cosines.data()),
+              2.25 * M_PI, kTolerance);
+
+  // Parallel vectors never produce a NaN.
+  std::vector<float> parallel_x = {0.1, 0.3, 0.7};
+  std::vector<float> parallel_y = {0.3, 0.9, 2.1};
+  ComputeMagnitudes(parallel_x.data(), parallel_y.data(), parallel_x.size(),
+                    magnitudes.data());
+  EXPECT_NEAR(SumAnglesToReference(parallel_x.data(), parallel_y.data(),
+                                   magnitudes.data(), parallel_x.size(),
+                                   parallel_x[2], parallel_y[2], magnitudes[2],
+                                   1e-5, cosines.data()),
+              0, 1e-3);
+}
+
+TEST(MotionVectorKernelsTest, ComputeDirectionHistogram) {
+  // One vector per octant, with increasing magnitudes, plus a zero vector.
+  std::vector<float> x, y;
+  for (int k = 0; k < 8; ++k) {
+    float angle = (k + 0.5) * M_PI / 4;
+    x.push_back((k + 1) * std::cos(angle));
+    y.push_back((k + 1) * std::sin(angle));
+  }
+  x.push_back(0);
+  y.push_back(0);
+  std::vector<float> magnitudes(x.size());
+  ComputeMagnitudes(x.data(), y.data(), x.size(), magnitudes.data());
+
+  std::vector<float> histogram(8);
+  ComputeDirectionHistogram(x.data(), y.data(), magnitudes.data(), x.size(),
+                            histogram.size(), 1e-5, histogram.data());
+  EXPECT_THAT(histogram, testing::Pointwise(testing::FloatNear(kTolerance),
+                                            {1, 2, 3, 4, 5, 6, 7, 8}));
+
+  std::vector<float> quadrants(4);
+  ComputeDirectionHistogram(x.data(), y.data(), magnitudes.data(), x.size(),
+                            quadrants.size(), 1e-5, quadrants.data());
+  EXPECT_THAT(quadrants, testing::Pointwise(testing::FloatNear(kTolerance),
+                                            {3, 7, 11, 15}));
+}
+
+TEST(MotionVectorKernelsTest, EstimateEntropy) {
+  std::vector<int> bins(4);
+  std::vector<float> values = {1, 2, 3, 4};
+  EXPECT_FLOAT_EQ(EstimateEntropy(values.data(), 0, 2.5, 1.1, 50, bins.data()),
+                  0);
+  EXPECT_FLOAT_EQ(EstimateEntropy(values.data(), 4, 2.5, 0, 50, bins.data()),
+                  0);
+  // Four values in four distinct bins.
+  EXPECT_FLOAT_EQ(
+      EstimateEntropy(values.data(), 4, 2.5, 1.118034, 50, bins.data()),
+      std::log(4));
+  // All of the values beyond the upper bound land in the same bin.
+  EXPECT_FLOAT_EQ(EstimateEntropy(values.data(), 4, 0.1, 0.1, 50, bins.data()),
+                  0);
+}
+
+}  // namespace
+}  // namespace motion_detection
+}  // namespace visionai
@@ -12,18 +12,42 @@
 
 #include "visionai/algorithms/detection/motion_detection/opencv_motion_detector.h"
 
+#include <cstdint>
+#include <map>
+#include <vector>
+
 #include "opencv4/opencv2/core.hpp"
 #include "opencv4/opencv2/imgproc.hpp"
 #include "opencv4/opencv2/video.hpp"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "visionai/algorithms/detection/motion_detection/opencv_motion_detector_config.pb.h"
-#include "visionai/algorithms/detection/motion_detection/util.h"
+#include "visionai/algorithms/media/util/pixel_conversion.h"
+#include "visionai/algorithms/stream_annotation/geometry_lib.h"
+#include "visionai/algorithms/stream_annotation/stream_annotation_util.h"
 #include "visionai/types/raw_image.h"
 #include "visionai/util/status/status_macros.h"
 
 namespace visionai {
 namespace motion_detection {
 
+namespace {
+
+using ::visionai::stream_annotation::ParseAnnotationToZoneMap;
+
+// The number of fractional bits of the zone vertices when rasterizing them.
+constexpr int kZoneVertexShift = 4;
+
+// Wraps `raw_image` into a cv::Mat without copying its pixels.
+//
+// The frame is only ever read, so the constness can safely be cast away.
+cv::Mat WrapRawImage(const RawImage &raw_image) {
+  return cv::Mat(raw_image.height(), raw_image.width(), CV_8UC3,
+                 const_cast<uint8_t *>(raw_image.data()));
+}
+
+}  // namespace
+
 OpenCVMotionDetector::OpenCVMotionDetector(
     const OpenCVMotionDetectorConfig &config)
     : config_(config) {
@@ -39,22 +63,21 @@ absl::Status OpenCVMotionDetector::ComputeForeground(const cv::Mat &image_frame,
   CHECK(foreground != nullptr);
 
   // Compute the new size for the frame.
-  int new_width = config_.scale() * image_frame.cols;
-  int new_height = config_.scale() * image_frame.rows;
-  if (new_width % 2 == 1) new_width += 1;
-  if (new_height % 2 == 1) new_height += 1;
-
-  if (new_width == 0 || new_height == 0) {
+  cv::Size new_size = ScaledSize(image_frame.size());
+  if (new_size.empty()) {
     return absl::InvalidArgumentError("resized image size = 0");
   }
 
   // Resize and convert the image to grayscale.
   cv::Mat input_image_scaled;
-  cv::resize(image_frame, input_image_scaled, cv::Size(new_width, new_height),
-             0, 0, cv::INTER_LINEAR);
+  cv::resize(image_frame, input_image_scaled, new_size, 0, 0,
+             cv::INTER_LINEAR);
   cv::Mat input_image_gray;
   if (image_frame.channels() > 1) {
-    cv::cvtColor(input_image_scaled, input_image_gray, cv::COLOR_RGB2GRAY);
+    input_image_gray.create(input_image_scaled.size(), CV_8UC1);
+    RgbToGray(input_image_scaled.data, input_image_scaled.step[0],
+              input_image_gray.data, input_image_gray.step[0],
+              input_image_scaled.cols, input_image_scaled.rows);
   } else {
     input_image_gray = input_image_scaled;
   }
@@ -65,20 +88,133 @@ absl::Status OpenCVMotionDetector::ComputeForeground(const cv::Mat &image_frame,
 
 bool OpenCVMotionDetector::MotionDetectionFromForegroundMask(
     const cv::Mat &foreground_mask) {
-  const float motion_area_ratio = ::visionai::motion_detection::MotionAreaRatio(
-      foreground_mask, config_.motion_foreground_pixel_threshold());
-  return static_cast<int>(motion_area_ratio > config_.motion_area_threshold());
+  if (foreground_mask.empty()) {
+    return false;
+  }
+  cv::Mat motion =
+      foreground_mask >= config_.motion_foreground_pixel_threshold();
+  float motion_area_ratio =
+      static_cast<float>(cv::countNonZero(motion)) / foreground_mask.total();
+  return motion_area_ratio > config_.motion_area_threshold();
+}
+
+bool OpenCVMotionDetector::MotionDetectionFromForegroundMask(
+    const cv::Mat &foreground_mask, const cv::Mat &zone_mask) {
+  int zone_area = cv::countNonZero(zone_mask);
+  if (zone_area == 0) {
+    return false;
+  }
+  cv::Mat motion =
+      (foreground_mask >= config_.motion_foreground_pixel_threshold()) &
+      zone_mask;
+  float motion_area_ratio =
+      static_cast<float>(cv::countNonZero(motion)) / zone_area;
+  return motion_area_ratio > config_.motion_area_threshold();
 }
 
 absl::StatusOr<bool> OpenCVMotionDetector::DetectMotion(
     const RawImage &raw_image) {
-  cv::Mat image_frame(raw_image.height(), raw_image.width(), CV_8UC3);
-  std::memcpy(image_frame.data, raw_image.data(),
-              image_frame.step[0] * image_frame.rows);
   cv::Mat foreground_mask;
-  VAI_RETURN_IF_ERROR(ComputeForeground(image_frame, &foreground_mask));
+  VAI_RETURN_IF_ERROR(
+      ComputeForeground(WrapRawImage(raw_image), &foreground_mask));
   return MotionDetectionFromForegroundMask(foreground_mask);
 }
 
+absl::StatusOr<bool> OpenCVMotionDetector::ZoneBasedDetectMotion(
+    const RawImage &raw_image,
+    const OpenCVMotionDetectorZoneConfig &zone_config) {
+  if (zone_config.zone_annotation().empty()) {
+    return DetectMotion(raw_image);
+  }
+  VAI_RETURN_IF_ERROR(UpdateZones(
+      zone_config, cv::Size(raw_image.width(), raw_image.height())));
+  if (zone_region_.empty()) {
+    return false;
+  }
+
+  // The background model adapts to the size of its input, so it simply starts
+  // over whenever the region changes.
+  cv::Mat foreground_mask;
+  VAI_RETURN_IF_ERROR(ComputeForeground(WrapRawImage(raw_image)(zone_region_),
+                                        &foreground_mask));
+  return MotionDetectionFromForegroundMask(foreground_mask, zone_mask_);
+}
+
+cv::Size OpenCVMotionDetector::ScaledSize(const cv::Size &size) const {
+  int new_width = config_.scale() * size.width;
+  int new_height = config_.scale() * size.height;
+  if (new_width % 2 == 1) new_width += 1;
+  if (new_height % 2 == 1) new_height += 1;
+  return cv::Size(new_width, new_height);
+}
+
+absl::Status OpenCVMotionDetector::UpdateZones(
+    const OpenCVMotionDetectorZoneConfig &zone_config,
+    const cv::Size &frame_size) {
+  if (zone_config.zone_annotation() != zone_annotation_) {
+    VAI_ASSIGN_OR_RETURN(
+        auto zone_map, ParseAnnotationToZoneMap(zone_config.zone_annotation()));
+    zones_.clear();
+    for (const auto &zone : zone_map) {
+      std::vector<cv::Point2f> vertices;
+      for (const auto &vertex : zone.second) {
+        vertices.push_back(cv::Point2f(vertex.x, vertex.y));
+      }
+      zones_.push_back(std::move(vertices));
+    }
+    zone_annotation_ = zone_config.zone_annotation();
+    // Force the mask to be computed again.
+    zone_frame_size_ = cv::Size();
+  }
+  if (frame_size == zone_frame_size_ &&
+      zone_config.exclude_annotated_zone() == exclude_annotated_zone_) {
+    return absl::OkStatus();
+  }
+  zone_frame_size_ = frame_size;
+  exclude_annotated_zone_ = zone_config.exclude_annotated_zone();
+
+  // Motion outside of the zones may be anywhere in the frame.
+  cv::Rect frame(cv::Point(0, 0), frame_size);
+  zone_region_ = frame;
+  if (!exclude_annotated_zone_) {
+    zone_region_ = cv::Rect();
+    for (const auto &zone : zones_) {
+      zone_region_ |= cv::boundingRect(zone);
+    }
+    zone_region_ &= frame;
+  }
+  if (zone_region_.empty()) {
+    zone_mask_.release();
+    return absl::OkStatus();
+  }
+
+  cv::Size scaled_size = ScaledSize(zone_region_.size());
+  if (scaled_size.empty()) {
+    return absl::InvalidArgumentError("resized zone size = 0");
+  }
+  // Map the zones into the scaled region, in fixed point.
+  double scale_x = static_cast<double>(scaled_size.width) / zone_region_.width;
+  double scale_y =
+      static_cast<double>(scaled_size.height) / zone_region_.height;
+  std::vector<std::vector<cv::Point>> scaled_zones;
+  for (const auto &zone : zones_) {
+    std::vector<cv::Point> scaled_zone;
+    for (const auto &vertex : zone) {
+      scaled_zone.push_back(
+          cv::Point((vertex.x - zone_region_.x) * scale_x *
+                        (1 << kZoneVertexShift),
+                    (vertex.y - zone_region_.y) * scale_y *
+                        (1 << kZoneVertexShift)));
+    }
+    scaled_zones.push_back(std::move(scaled_zone));
+  }
+  zone_mask_ = cv::Mat(scaled_size, CV_8UC1,
+                       cv::Scalar(exclude_annotated_zone_ ? 255 : 0));
+  cv::fillPoly(zone_mask_, scaled_zones,
+               cv::Scalar(exclude_annotated_zone_ ? 0 : 255), cv::LINE_8,
+               kZoneVertexShift);
+  return absl::OkStatus();
+}
+
 }  // namespace motion_detection
 }  // namespace visionai
@@ -18,9 +18,13 @@
 // subtraction on consecutive video frames and return a foreground mask.
 // Note: These modules are not thread-safe.
 
+#include <string>
+#include <vector>
+
 #include "opencv4/opencv2/core.hpp"
 #include "opencv4/opencv2/video.hpp"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "visionai/algorithms/detection/motion_detection/opencv_motion_detector_config.pb.h"
 #include "visionai/types/raw_image.h"
 
@@ -41,12 +45,55 @@ class OpenCVMotionDetector {
 
   bool MotionDetectionFromForegroundMask(const cv::Mat &foreground_mask);
 
+  // Same as above, but only considers the pixels of `foreground_mask` that are
+  // set in `zone_mask`, which must have the same size.
+  bool MotionDetectionFromForegroundMask(const cv::Mat &foreground_mask,
+                                         const cv::Mat &zone_mask);
+
   // Main function to call to detect motion.
   absl::StatusOr<bool> DetectMotion(const RawImage &raw_image);
 
+  // Performs motion detection with regard to the annotated zones.
+  // If the zone config contains no zone, detects motion in the whole frame.
+  // Else, only runs the background subtraction on the bounding box of the
+  // zones, and only considers the foreground within the zones. Set
+  // exclude_annotated_zone to true to detect motion outside of the zones
+  // instead, which still needs the whole frame.
+  //
+  // The zone annotation is only parsed again when it changes, and the zone
+  // mask when the frame size changes.
+  absl::StatusOr<bool> ZoneBasedDetectMotion(
+      const RawImage &raw_image,
+      const OpenCVMotionDetectorZoneConfig &zone_config);
+
  private:
+  // Returns the size that ComputeForeground scales a frame of `size` to.
+  cv::Size ScaledSize(const cv::Size &size) const;
+
+  // Updates the zones from `zone_config`, as well as their bounding box and
+  // mask for frames of `frame_size`.
+  absl::Status UpdateZones(const OpenCVMotionDetectorZoneConfig &zone_config,
+                           const cv::Size &frame_size);
+
   OpenCVMotionDetectorConfig config_;
 
+  // The zone annotation that zones_ was parsed from.
+  std::string zone_annotation_;
+
+  // The zones, in pixels.
+  std::vector<std::vector<cv::Point2f>> zones_;
+
+  // Whether zone_mask_ excludes the zones rather than includes them, and the
+  // frame size that it was computed for.
+  bool exclude_annotated_zone_ = false;
+  cv::Size zone_frame_size_;
+
+  // The region of the frame that the background subtraction runs on.
+  cv::Rect zone_region_;
+
+  // The mask of the pixels to consider within the scaled zone_region_.
+  cv::Mat zone_mask_;
+
   // Background subtraction module.
   cv::Ptr<cv::BackgroundSubtractorMOG2> background_subtractor_;
 };
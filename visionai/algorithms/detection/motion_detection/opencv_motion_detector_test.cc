@@ -19,9 +19,12 @@
 #include "opencv4/opencv2/core.hpp"
 #include "opencv4/opencv2/imgcodecs.hpp"
 #include "opencv4/opencv2/imgproc.hpp"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "visionai/types/raw_image.h"
 #include "visionai/util/file_path.h"
+#include "visionai/util/status/status_macros.h"
 
 namespace visionai {
 namespace motion_detection {
@@ -30,6 +33,43 @@ namespace {
 const char kTestFolder[] = "visionai/testing/testdata/media/motion";
 constexpr int kNumTestImages = 20;
 
+constexpr int kFrameSize = 64;
+constexpr int kNumBackgroundFrames = 10;
+
+// Zones that cover the top left and the bottom right quarters of the frame.
+constexpr char kTopLeftZone[] = "0:0;31:0;31:31;0:31";
+constexpr char kBottomRightZone[] = "32:32;63:32;63:63;32:63";
+
+// Returns a black frame, with a white square in the bottom right quarter if
+// `with_square` is true.
+RawImage MakeFrame(bool with_square) {
+  RawImage image(kFrameSize, kFrameSize, RawImage::Format::kSRGB);
+  cv::Mat frame(kFrameSize, kFrameSize, CV_8UC3, image.data());
+  frame.setTo(cv::Scalar::all(0));
+  if (with_square) {
+    cv::rectangle(frame, cv::Rect(40, 40, 16, 16), cv::Scalar::all(255),
+                  /* fill */ -1);
+  }
+  return image;
+}
+
+// Returns whether the detector sees motion once the square appears, after it
+// learned the black background.
+absl::StatusOr<bool> DetectSquare(
+    const OpenCVMotionDetectorZoneConfig &zone_config) {
+  OpenCVMotionDetectorConfig config;
+  config.set_scale(0.5);
+  config.set_background_history_frame_length(kNumBackgroundFrames);
+  config.set_motion_area_threshold(0.01);
+  OpenCVMotionDetector detector(config);
+  for (int i = 0; i < kNumBackgroundFrames; ++i) {
+    VAI_RETURN_IF_ERROR(
+        detector.ZoneBasedDetectMotion(MakeFrame(false), zone_config)
+            .status());
+  }
+  return detector.ZoneBasedDetectMotion(MakeFrame(true), zone_config);
+}
+
 // Tests that the motion detection interface works, by loading some image frames
 // and verifying the foreground masks against expected results.
 TEST(OpenCVMotionDetectorTest, TestComputeForeground) {
@@ -69,6 +109,76 @@ TEST(OpenCVMotionDetectorTest, TestMotionDetectionFromForegroundMask) {
   EXPECT_FALSE(detector.MotionDetectionFromForegroundMask(image_frame2));
 }
 
+// Tests that motion is only detected within the annotated zones.
+TEST(OpenCVMotionDetectorTest, TestZoneBasedDetectMotion) {
+  OpenCVMotionDetectorZoneConfig zone_config;
+  auto motion = DetectSquare(zone_config);
+  ASSERT_TRUE(motion.ok());
+  EXPECT_TRUE(*motion);
+
+  zone_config.set_zone_annotation(kBottomRightZone);
+  motion = DetectSquare(zone_config);
+  ASSERT_TRUE(motion.ok());
+  EXPECT_TRUE(*motion);
+
+  zone_config.set_zone_annotation(kTopLeftZone);
+  motion = DetectSquare(zone_config);
+  ASSERT_TRUE(motion.ok());
+  EXPECT_FALSE(*motion);
+
+  // Both zones at once.
+  zone_config.set_zone_annotation(
+      absl::StrCat(kTopLeftZone, "-", kBottomRightZone));
+  motion = DetectSquare(zone_config);
+  ASSERT_TRUE(motion.ok());
+  EXPECT_TRUE(*motion);
+}
+
+// Tests that motion is only detected outside of the excluded zones.
+TEST(OpenCVMotionDetectorTest, TestZoneBasedDetectMotionExcludingZones) {
+  OpenCVMotionDetectorZoneConfig zone_config;
+  zone_config.set_exclude_annotated_zone(true);
+
+  zone_config.set_zone_annotation(kTopLeftZone);
+  auto motion = DetectSquare(zone_config);
+  ASSERT_TRUE(motion.ok());
+  EXPECT_TRUE(*motion);
+
+  zone_config.set_zone_annotation(kBottomRightZone);
+  motion = DetectSquare(zone_config);
+  ASSERT_TRUE(motion.ok());
+  EXPECT_FALSE(*motion);
+}
+
+// Tests that invalid zone annotations are reported.
+TEST(OpenCVMotionDetectorTest, TestZoneBasedDetectMotionInvalidZone) {
+  OpenCVMotionDetectorZoneConfig zone_config;
+  zone_config.set_zone_annotation("0:0;1:1");
+  EXPECT_FALSE(DetectSquare(zone_config).ok());
+}
+
+// Tests that motion detection within a zone mask only counts the masked
+// pixels.
+TEST(OpenCVMotionDetectorTest, TestMotionDetectionFromMaskedForeground) {
+  OpenCVMotionDetectorConfig config;
+  config.set_motion_area_threshold(0.15);
+  OpenCVMotionDetector detector(config);
+
+  // The left half of the frame is foreground.
+  cv::Mat foreground(4, 8, CV_8UC1, cv::Scalar(0));
+  foreground(cv::Rect(0, 0, 4, 4)).setTo(255);
+
+  cv::Mat zone_mask(4, 8, CV_8UC1, cv::Scalar(0));
+  EXPECT_FALSE(
+      detector.MotionDetectionFromForegroundMask(foreground, zone_mask));
+  zone_mask(cv::Rect(4, 0, 4, 4)).setTo(255);
+  EXPECT_FALSE(
+      detector.MotionDetectionFromForegroundMask(foreground, zone_mask));
+  zone_mask(cv::Rect(3, 0, 1, 4)).setTo(255);
+  EXPECT_TRUE(
+      detector.MotionDetectionFromForegroundMask(foreground, zone_mask));
+}
+
 }  // namespace
 }  // namespace motion_detection
 }  // namespace visionai
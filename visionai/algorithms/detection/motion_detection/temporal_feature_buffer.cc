@@ -0,0 +1,47 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/algorithms/detection/motion_detection/temporal_feature_buffer.h"
+
+#include "glog/logging.h"
+
+namespace visionai {
+namespace motion_detection {
+
+TemporalFeatureBuffer::TemporalFeatureBuffer(int capacity)
+    : capacity_(capacity) {
+  CHECK_GE(capacity, 0);
+}
+
+void TemporalFeatureBuffer::Reset(int num_features) {
+  CHECK_GE(num_features, 0);
+  num_features_ = num_features;
+  begin_ = 0;
+  size_ = 0;
+  slab_.resize(static_cast<size_t>(capacity_) * num_features_);
+}
+
+float* TemporalFeatureBuffer::PushBack() {
+  DCHECK_GT(capacity_, 0);
+  int slot;
+  if (size_ < capacity_) {
+    slot = (begin_ + size_) % capacity_;
+    ++size_;
+  } else {
+    slot = begin_;
+    begin_ = (begin_ + 1) % capacity_;
+  }
+  return slab_.data() + static_cast<size_t>(slot) * num_features_;
+}
+
+const float* TemporalFeatureBuffer::at(int i) const {
+  DCHECK(i >= 0 && i < size_);
+  int slot = (begin_ + i) % capacity_;
+  return slab_.data() + static_cast<size_t>(slot) * num_features_;
+}
+
+}  // namespace motion_detection
+}  // namespace visionai
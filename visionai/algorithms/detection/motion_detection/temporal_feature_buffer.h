@@ -0,0 +1,68 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file or at
+ * https://developers.google.com/open-source/licenses/bsd
+ */
+
+#ifndef THIRD_PARTY_VISIONAI_ALGORITHMS_DETECTION_MOTION_DETECTION_TEMPORAL_FEATURE_BUFFER_H_
+#define THIRD_PARTY_VISIONAI_ALGORITHMS_DETECTION_MOTION_DETECTION_TEMPORAL_FEATURE_BUFFER_H_
+
+#include <vector>
+
+namespace visionai {
+namespace motion_detection {
+
+// A circular buffer of the feature vectors of the most recent frames.
+//
+// All of the feature vectors live in a single slab that is allocated once.
+// Pushing a frame into a full buffer overwrites the slot of the oldest frame in
+// place, so that steady-state use does not allocate at all.
+class TemporalFeatureBuffer {
+ public:
+  // Creates a buffer that holds the features of up to `capacity` frames.
+  explicit TemporalFeatureBuffer(int capacity);
+
+  // Removes all of the frames, and sets the number of features per frame.
+  //
+  // The slab is only reallocated if it grows.
+  void Reset(int num_features);
+
+  // Appends a frame, evicting the oldest one if the buffer is full, and returns
+  // its `num_features()` features to be filled in.
+  //
+  // The returned features hold stale values. They remain valid until the next
+  // call to `Reset()`.
+  //
+  // Requires: capacity() > 0.
+  float* PushBack();
+
+  // Returns the features of the i-th oldest frame, for 0 <= i < size().
+  const float* at(int i) const;
+
+  // The number of frames in the buffer.
+  int size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+  int capacity() const { return capacity_; }
+
+  int num_features() const { return num_features_; }
+
+ private:
+  int capacity_ = 0;
+  int num_features_ = 0;
+
+  // The slot of the oldest frame.
+  int begin_ = 0;
+  int size_ = 0;
+
+  // `capacity_` slots of `num_features_` features each.
+  std::vector<float> slab_;
+};
+
+}  // namespace motion_detection
+}  // namespace visionai
+
+#endif  // THIRD_PARTY_VISIONAI_ALGORITHMS_DETECTION_MOTION_DETECTION_TEMPORAL_FEATURE_BUFFER_H_
@@ -0,0 +1,61 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/algorithms/detection/motion_detection/temporal_feature_buffer.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace visionai {
+namespace motion_detection {
+namespace {
+
+TEST(TemporalFeatureBufferTest, OverwritesOldestFrame) {
+  TemporalFeatureBuffer buffer(3);
+  buffer.Reset(2);
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(buffer.capacity(), 3);
+  EXPECT_EQ(buffer.num_features(), 2);
+
+  std::vector<const float*> slots;
+  for (int frame = 0; frame < 5; ++frame) {
+    float* features = buffer.PushBack();
+    features[0] = frame;
+    features[1] = -frame;
+    if (frame < 3) {
+      slots.push_back(features);
+    } else {
+      // The slot of the evicted frame is reused.
+      EXPECT_EQ(features, slots[frame % 3]);
+    }
+  }
+
+  ASSERT_EQ(buffer.size(), 3);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(buffer.at(i)[0], i + 2);
+    EXPECT_EQ(buffer.at(i)[1], -(i + 2));
+  }
+}
+
+TEST(TemporalFeatureBufferTest, Reset) {
+  TemporalFeatureBuffer buffer(2);
+  buffer.Reset(4);
+  buffer.PushBack()[0] = 1;
+  buffer.PushBack()[0] = 2;
+  EXPECT_EQ(buffer.size(), 2);
+
+  buffer.Reset(1);
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(buffer.num_features(), 1);
+  buffer.PushBack()[0] = 3;
+  ASSERT_EQ(buffer.size(), 1);
+  EXPECT_EQ(buffer.at(0)[0], 3);
+}
+
+}  // namespace
+}  // namespace motion_detection
+}  // namespace visionai
@@ -8,13 +8,13 @@
 
 #include <cmath>
 #include <cstring>
+#include <numeric>
 #include <vector>
 
 #include "absl/status/status.h"
 #include "absl/strings/str_format.h"
-#include "visionai/util/array/array2d.h"
-#include "visionai/util/array/array3d.h"
-#include "visionai/util/gtl/circularbuffer.h"
+#include "visionai/algorithms/detection/motion_detection/motion_vector_kernels.h"
+#include "visionai/algorithms/detection/motion_detection/temporal_feature_buffer.h"
 
 constexpr float kEpsilon = 1e-5;
 constexpr int kBinNumber = 50;
@@ -25,38 +25,64 @@ namespace motion_detection {
 
 float EstimateEntropy(const std::vector<float>& numbers, float mean,
                       float standard_deviation) {
-  if (numbers.empty() || std::abs(standard_deviation) < kEpsilon) {
-    return 0;
-  }
+  std::vector<int> bins(numbers.size());
+  return EstimateEntropy(numbers.data(), static_cast<int>(numbers.size()), mean,
+                         standard_deviation, kBinNumber, bins.data());
+}
 
-  float entropy = 0;
-  float upper_bound = mean + 5 * standard_deviation;
-  float bin_size = upper_bound / kBinNumber;
-  std::vector<float> frequencies(kBinNumber + 1, 0);
+float VectorAverage(const std::vector<float>& vec) {
+  return std::accumulate(vec.begin(), vec.end(), 0.0) /
+         static_cast<float>(vec.size());
+}
 
-  for (const float& number : numbers) {
-    int bin = std::min(kBinNumber, static_cast<int>(floor(number / bin_size)));
-    frequencies[bin] += 1.0;
+void BucketMotionVectors(const MotionVectors& motion_vectors, int num_grid,
+                         int grid_height, int grid_width,
+                         MotionVectorGrid* grid) {
+  int num_mvs = static_cast<int>(motion_vectors.size());
+  int num_cells = num_grid * num_grid;
+  grid->cells.resize(num_mvs);
+  grid->cell_begin.assign(num_cells + 1, 0);
+
+  // Count the motion vectors of each cell. Cell `c` is counted in
+  // cell_begin[c + 1], so that the prefix sum below yields the beginnings.
+  for (int i = 0; i < num_mvs; ++i) {
+    const MotionVector& mv = motion_vectors[i];
+    int grid_x = mv.dst_x / grid_width;
+    int grid_y = mv.dst_y / grid_height;
+    if (grid_x < 0 || grid_y < 0 || grid_x >= num_grid || grid_y >= num_grid) {
+      grid->cells[i] = -1;
+      continue;
+    }
+    int cell = grid_y * num_grid + grid_x;
+    grid->cells[i] = cell;
+    ++grid->cell_begin[cell + 1];
+  }
+  for (int c = 0; c < num_cells; ++c) {
+    grid->cell_begin[c + 1] += grid->cell_begin[c];
   }
 
-  for (int i = 0; i < kBinNumber + 1; ++i) {
-    if (frequencies[i] > 0) {
-      frequencies[i] /= numbers.size();
-      entropy -= frequencies[i] * std::log(frequencies[i]);
+  // Scatter the indices in their original order, which keeps the sort stable.
+  grid->indices.resize(grid->cell_begin[num_cells]);
+  for (int i = 0; i < num_mvs; ++i) {
+    int cell = grid->cells[i];
+    if (cell < 0) {
+      continue;
     }
+    // cell_begin[cell] serves as the insertion point until it is restored
+    // below.
+    grid->indices[grid->cell_begin[cell]++] = i;
   }
-  return entropy;
-}
-
-float VectorAverage(const std::vector<float>& vec) {
-  return std::accumulate(vec.begin(), vec.end(), 0.0) /
-         static_cast<float>(vec.size());
+  for (int c = num_cells; c > 0; --c) {
+    grid->cell_begin[c] = grid->cell_begin[c - 1];
+  }
+  grid->cell_begin[0] = 0;
 }
 
 absl::Status ComputeMotionVectorFeaturesWithSpatialGrid(
     const MotionVectors& motion_vectors,
-    gtl::CircularBuffer<Array3D<float>>& grids_features_buffer, int num_grid,
-    int frame_height, int frame_width, std::vector<float>& mv_features) {
+    TemporalFeatureBuffer& grids_features_buffer, int num_grid,
+    int frame_height, int frame_width, std::vector<float>& mv_features,
+    MotionVectorGrid* grid) {
   if (num_grid <= 0 || frame_height <= 0 || frame_width <= 0) {
     return absl::InvalidArgumentError(
         "One of grid number, frame height or width is less than or equal to "
@@ -75,73 +101,60 @@ absl::Status ComputeMotionVectorFeaturesWithSpatialGrid(
 
   std::fill(mv_features.begin(), mv_features.end(), 0.0);
 
-  Array3D<float> feature_average(SHARE_WITH_FOREIGN_INSTANCE, num_grid,
-                                 num_grid, kNumFeatures, mv_features.data());
-  Array3D<float> feature_standard_deviation(
-      SHARE_WITH_FOREIGN_INSTANCE, num_grid, num_grid, kNumFeatures,
-      mv_features.data() + num_grid * num_grid * kNumFeatures);
-
-  Array3D<float> features_from_all_grids(num_grid, num_grid, kNumFeatures, 0.0);
+  int num_features = num_grid * num_grid * kNumFeatures;
+  float* feature_average = mv_features.data();
+  float* feature_standard_deviation = mv_features.data() + num_features;
 
-  // Finds the motion vector indexes for each grid in array `motion_vectors`.
-  Array2D<std::vector<int>> grid_mv_idx(num_grid, num_grid);
-  for (int i = 0; i < motion_vectors.size(); ++i) {
-    const MotionVector& mv = motion_vectors[i];
-    int grid_x = mv.dst_x / grid_width;
-    int grid_y = mv.dst_y / grid_height;
-    if (grid_x >= num_grid || grid_y >= num_grid)
-      continue;
-    grid_mv_idx(grid_y, grid_x).push_back(i);
+  if (grids_features_buffer.num_features() != num_features) {
+    grids_features_buffer.Reset(num_features);
   }
 
-  for (int h = 0; h < num_grid; ++h) {
-    for (int w = 0; w < num_grid; ++w) {
-      // Store the motion vectors in this particular grid.
-      std::vector<MotionVector> grid_motion_vectors;
-      grid_motion_vectors.reserve(grid_mv_idx(h, w).size());
-      for (int i = 0; i < grid_mv_idx(h, w).size(); ++i) {
-        grid_motion_vectors.push_back(motion_vectors[grid_mv_idx(h, w)[i]]);
-      }
+  // Update the temportal grid feature buffer except for the I frame. The
+  // features of the new frame overwrite those of the oldest one in place.
+  if (!motion_vectors.empty()) {
+    float* features_from_all_grids = grids_features_buffer.PushBack();
 
-      // Compute the features for a particular grid.
-      std::vector<float> features_from_one_grid = ComputeMotionVectorFeatures(
-          grid_motion_vectors, num_grid, frame_height, frame_width);
+    MotionVectorGrid local_grid;
+    if (grid == nullptr) {
+      grid = &local_grid;
+    }
+    BucketMotionVectors(motion_vectors, num_grid, grid_height, grid_width,
+                        grid);
+
+    for (int cell = 0; cell < num_grid * num_grid; ++cell) {
+      // Load the motion vectors in this particular grid.
+      int begin = grid->cell_begin[cell];
+      LoadMotionVectorArrays(motion_vectors, grid->indices.data() + begin,
+                             grid->cell_begin[cell + 1] - begin, frame_height,
+                             frame_width, &grid->arrays);
 
-      for (int k = 0; k < kNumFeatures; ++k) {
-        features_from_all_grids(h, w, k) = features_from_one_grid[k];
-      }
+      // Compute the features for a particular grid.
+      ComputeMotionVectorFeatures(
+          &grid->arrays, num_grid, frame_height, frame_width,
+          features_from_all_grids + cell * kNumFeatures);
     }
   }
 
-  // Update the temportal grid feature buffer except for the I frame.
-  if (!motion_vectors.empty()) {
-    grids_features_buffer.push_back(features_from_all_grids);
-  }
+  int num_frames = grids_features_buffer.size();
+  for (int i = 0; i < num_features; ++i) {
+    // Update the running average.
+    float average_sum = 0;
+    for (int j = 0; j < num_frames; ++j) {
+      average_sum += grids_features_buffer.at(j)[i];
+    }
+
+    feature_average[i] = average_sum / num_frames;
+
+    // Update the running standard_deviation.
+    float standard_deviation_sum = 0;
 
-  for (int h = 0; h < num_grid; ++h) {
-    for (int w = 0; w < num_grid; ++w) {
-      for (int k = 0; k < kNumFeatures; ++k) {
-        // Update the running average.
-        float average_sum = 0;
-        for (int j = 0; j < grids_features_buffer.size(); ++j) {
-          average_sum += grids_features_buffer.at(j)(h, w, k);
-        }
-
-        feature_average(h, w, k) = average_sum / grids_features_buffer.size();
-
-        // Update the running standard_deviation.
-        float standard_deviation_sum = 0;
-
-        for (int j = 0; j < grids_features_buffer.size(); ++j) {
-          standard_deviation_sum += std::pow(
-              grids_features_buffer.at(j)(h, w, k) - feature_average(h, w, k),
-              2.0);
-        }
-
-        feature_standard_deviation(h, w, k) =
-            std::sqrt(standard_deviation_sum / grids_features_buffer.size());
-      }
+    for (int j = 0; j < num_frames; ++j) {
+      standard_deviation_sum +=
+          std::pow(grids_features_buffer.at(j)[i] - feature_average[i], 2.0);
     }
+
+    feature_standard_deviation[i] =
+        std::sqrt(standard_deviation_sum / num_frames);
   }
   return absl::OkStatus();
 }
@@ -149,132 +162,113 @@ absl::Status ComputeMotionVectorFeaturesWithSpatialGrid(
 std::vector<float> ComputeMotionVectorFeatures(
     const MotionVectors& motion_vectors, int num_grid,
     int frame_height, int frame_width) {
-  // MV number
-  int input_mv_number = motion_vectors.size();
-  float weighted_mv_number = 0;
-  int nonzero_mv_number = 0;
-
-  // Motion magnitudes
-  std::vector<float> motion_magnitudes(input_mv_number, 0);
-  std::vector<float> motion_x(input_mv_number, 0);
-  std::vector<float> motion_y(input_mv_number, 0);
+  MotionVectorArrays arrays;
+  LoadMotionVectorArrays(motion_vectors, frame_height, frame_width, &arrays);
+  std::vector<float> features(kNumFeatures);
+  ComputeMotionVectorFeatures(&arrays, num_grid, frame_height, frame_width,
+                              features.data());
+  return features;
+}
 
-  // First and higher order spread of magnitudes
-  float magnitude_mean_absolute_deviation = 0;
-  float magnitude_standard_deviation = 0;
+void ComputeMotionVectorFeatures(MotionVectorArrays* arrays, int num_grid,
+                                 int frame_height, int frame_width,
+                                 float* features) {
+  // MV number
+  int input_mv_number = arrays->size();
+  const float* motion_x = arrays->x.data();
+  const float* motion_y = arrays->y.data();
+  const float* motion_magnitudes = arrays->magnitude.data();
 
   // Maximum motion magnitude
   float max_motion_magnitude = 0;
   float max_motion_x = 0;
   float max_motion_y = 0;
+  int max_index = ArgMax(motion_magnitudes, input_mv_number);
+  if (max_index >= 0 && motion_magnitudes[max_index] > 0) {
+    max_motion_magnitude = motion_magnitudes[max_index];
+    max_motion_x = motion_x[max_index];
+    max_motion_y = motion_y[max_index];
+  }
 
   // Macroblock sizes
-  float total_block_size = 0;
-  float nonzero_block_size = 0;
+  float total_block_size = Sum(arrays->block_size.data(), input_mv_number);
+  NonzeroMotionStats nonzero_stats = ComputeNonzeroMotionStats(*arrays,
+                                                               kEpsilon);
+  int nonzero_mv_number = nonzero_stats.count;
+
+  float mean_motion_magnitude =
+      Sum(motion_magnitudes, input_mv_number) / input_mv_number;
+  float mean_motion_x = Sum(motion_x, input_mv_number) / input_mv_number;
+  float mean_motion_y = Sum(motion_y, input_mv_number) / input_mv_number;
+  float mean_motion_norm =
+      std::sqrt(mean_motion_x * mean_motion_x + mean_motion_y * mean_motion_y);
 
   // First order spread of motion vector wrt to mean motion vector
-  float mean_absolute_deviation = 0;
+  float mean_absolute_deviation =
+      SumDistances(motion_x, motion_y, input_mv_number, mean_motion_x,
+                   mean_motion_y) /
+      input_mv_number;
 
   // Directional information
   float mean_angle = 0;
   float mean_angle_wrt_max = 0;
-
-  for (int i = 0; i < input_mv_number; ++i) {
-    const MotionVector& mv = motion_vectors[i];
-    float mv_x =
-        static_cast<float>(mv.motion_x) / mv.motion_scale / frame_width;
-    float mv_y =
-        static_cast<float>(mv.motion_y) / mv.motion_scale / frame_height;
-    total_block_size += std::sqrt(mv.w * mv.h);
-
-    float motion_magnitude =
-        std::sqrt(std::pow(mv_x, 2.0) + std::pow(mv_y, 2.0));
-    motion_magnitudes[i] = motion_magnitude;
-    motion_x[i] = mv_x;
-    motion_y[i] = mv_y;
-
-    if (motion_magnitude > max_motion_magnitude) {
-      max_motion_magnitude = motion_magnitude;
-      max_motion_x = mv_x;
-      max_motion_y = mv_y;
-    }
-
-    if (std::abs(mv_x) > kEpsilon || std::abs(mv_y) > kEpsilon) {
-      nonzero_mv_number += 1;
-
-      CHECK(mv.w > 0 && mv.h > 0);
-      weighted_mv_number += 16.0 / std::sqrt(mv.w * mv.h);
-      nonzero_block_size += std::sqrt(mv.w * mv.h);
-    }
-  }
-
-  float mean_motion_magnitude = VectorAverage(motion_magnitudes);
-  float mean_motion_x = VectorAverage(motion_x);
-  float mean_motion_y = VectorAverage(motion_y);
-  float mean_motion_norm =
-      std::sqrt(mean_motion_x * mean_motion_x + mean_motion_y * mean_motion_y);
-
-  for (int i = 0; i < input_mv_number; ++i) {
-    mean_absolute_deviation +=
-        std::sqrt(std::pow(motion_x[i] - mean_motion_x, 2.0) +
-                  std::pow(motion_y[i] - mean_motion_y, 2.0));
-
-    if (mean_motion_norm > kEpsilon && motion_magnitudes[i] > kEpsilon) {
-      mean_angle += std::acos(
-          (motion_x[i] * mean_motion_x + motion_y[i] * mean_motion_y) /
-          (motion_magnitudes[i] * mean_motion_norm));
-      mean_angle_wrt_max +=
-          std::acos((motion_x[i] * max_motion_x + motion_y[i] * max_motion_y) /
-                    (motion_magnitudes[i] * max_motion_magnitude));
-    }
+  if (mean_motion_norm > kEpsilon) {
+    mean_angle = SumAnglesToReference(
+        motion_x, motion_y, motion_magnitudes, input_mv_number, mean_motion_x,
+        mean_motion_y, mean_motion_norm, kEpsilon,
+        arrays->float_scratch.data());
+    mean_angle_wrt_max = SumAnglesToReference(
+        motion_x, motion_y, motion_magnitudes, input_mv_number, max_motion_x,
+        max_motion_y, max_motion_magnitude, kEpsilon,
+        arrays->float_scratch.data());
   }
-
-  mean_absolute_deviation /= input_mv_number;
   mean_angle /= input_mv_number;
   mean_angle_wrt_max /= input_mv_number;
 
-  for (int i = 0; i < input_mv_number; ++i) {
-    magnitude_mean_absolute_deviation +=
-        std::abs(motion_magnitudes[i] - mean_motion_magnitude);
-    magnitude_standard_deviation +=
-        std::pow(motion_magnitudes[i] - mean_motion_magnitude, 2.0);
-  }
-
-  magnitude_mean_absolute_deviation /= input_mv_number;
-  magnitude_standard_deviation =
-      std::sqrt(magnitude_standard_deviation / input_mv_number);
-
-  float mean_nonzero_block_size = nonzero_block_size / 16.0 / nonzero_mv_number;
+  // First and higher order spread of magnitudes
+  float magnitude_mean_absolute_deviation =
+      SumAbsoluteDeviation(motion_magnitudes, input_mv_number,
+                           mean_motion_magnitude) /
+      input_mv_number;
+  float magnitude_standard_deviation =
+      std::sqrt(SumSquaredDeviation(motion_magnitudes, input_mv_number,
+                                    mean_motion_magnitude) /
+                input_mv_number);
+
+  float mean_nonzero_block_size =
+      nonzero_stats.block_size_sum / 16.0 / nonzero_mv_number;
   float mean_block_size = total_block_size / 16.0 / input_mv_number;
   float magnitude_entropy = EstimateEntropy(
-      motion_magnitudes, mean_motion_magnitude, magnitude_standard_deviation);
+      motion_magnitudes, input_mv_number, mean_motion_magnitude,
+      magnitude_standard_deviation, kBinNumber, arrays->int_scratch.data());
   float mv_density = static_cast<float>(input_mv_number) * 256 * num_grid *
                      num_grid / (frame_height * frame_width);
-  float weighted_mv_density = weighted_mv_number * 256 * num_grid * num_grid /
-                              (frame_height * frame_width);
+  float weighted_mv_density = nonzero_stats.weighted_count * 256 * num_grid *
+                              num_grid / (frame_height * frame_width);
   float nonzero_mv_density = nonzero_mv_number * 256 * num_grid * num_grid /
                              (frame_height * frame_width);
-  std::vector<float> features = {max_motion_magnitude,
-                                 mean_motion_magnitude,
-                                 mean_motion_norm,
-                                 mean_absolute_deviation,
-                                 mean_angle,
-                                 mean_angle_wrt_max,
-                                 mean_block_size,
-                                 mean_nonzero_block_size,
-                                 magnitude_mean_absolute_deviation,
-                                 magnitude_standard_deviation,
-                                 magnitude_entropy,
-                                 mv_density,
-                                 weighted_mv_density,
-                                 nonzero_mv_density};
-  return features;
+
+  features[0] = max_motion_magnitude;
+  features[1] = mean_motion_magnitude;
+  features[2] = mean_motion_norm;
+  features[3] = mean_absolute_deviation;
+  features[4] = mean_angle;
+  features[5] = mean_angle_wrt_max;
+  features[6] = mean_block_size;
+  features[7] = mean_nonzero_block_size;
+  features[8] = magnitude_mean_absolute_deviation;
+  features[9] = magnitude_standard_deviation;
+  features[10] = magnitude_entropy;
+  features[11] = mv_density;
+  features[12] = weighted_mv_density;
+  features[13] = nonzero_mv_density;
 }
 
 absl::Status ComputeMaxMagnitudeEntropyWithSpatialGrid(
     const MotionVectors& motion_vectors,
-    gtl::CircularBuffer<Array3D<float>>& grids_features_buffer, int num_grid,
-    int frame_height, int frame_width, std::vector<float>& mv_features) {
+    TemporalFeatureBuffer& grids_features_buffer, int num_grid,
+    int frame_height, int frame_width, std::vector<float>& mv_features,
+    MotionVectorGrid* grid) {
   if (num_grid <= 0 || frame_height <= 0 || frame_width <= 0) {
     return absl::InvalidArgumentError(
         "One of grid number, frame height or width is less than or equal to "
@@ -294,58 +288,45 @@ absl::Status ComputeMaxMagnitudeEntropyWithSpatialGrid(
   }
   std::fill(mv_features.begin(), mv_features.end(), 0.0);
 
-  Array3D<float> feature_average(SHARE_WITH_FOREIGN_INSTANCE, num_grid,
-                                 num_grid, featureNum, mv_features.data());
-
-  Array3D<float> features_from_all_grids(num_grid, num_grid, featureNum, 0.0);
+  float* feature_average = mv_features.data();
 
-  // Finds the motion vector indexes for each grid in array `motion_vectors`.
-  Array2D<std::vector<int>> grid_mv_idx(num_grid, num_grid);
-  for (int i = 0; i < motion_vectors.size(); ++i) {
-    const MotionVector& mv = motion_vectors[i];
-    int grid_x = mv.dst_x / grid_width;
-    int grid_y = mv.dst_y / grid_height;
-    if (grid_x >= num_grid || grid_y >= num_grid) continue;
-    grid_mv_idx(grid_y, grid_x).push_back(i);
+  if (grids_features_buffer.num_features() != mv_features_size) {
+    grids_features_buffer.Reset(mv_features_size);
   }
 
-  for (int h = 0; h < num_grid; ++h) {
-    for (int w = 0; w < num_grid; ++w) {
-      // Store the motion vectors in this particular grid.
-      std::vector<MotionVector> grid_motion_vectors;
-      grid_motion_vectors.reserve(grid_mv_idx(h, w).size());
-      for (int i = 0; i < grid_mv_idx(h, w).size(); ++i) {
-        grid_motion_vectors.push_back(motion_vectors[grid_mv_idx(h, w)[i]]);
-      }
-
-      // Compute the features for a particular grid.
-      std::vector<float> features_from_one_grid =
-          ComputeMaxMagnitudeEntropyFeatures(grid_motion_vectors, num_grid,
-                                             frame_height, frame_width);
+  // Update the temportal grid feature buffer except for the I frame. The
+  // features of the new frame overwrite those of the oldest one in place.
+  if (!motion_vectors.empty()) {
+    float* features_from_all_grids = grids_features_buffer.PushBack();
 
-      for (int k = 0; k < featureNum; ++k) {
-        features_from_all_grids(h, w, k) = features_from_one_grid[k];
-      }
+    MotionVectorGrid local_grid;
+    if (grid == nullptr) {
+      grid = &local_grid;
+    }
+    BucketMotionVectors(motion_vectors, num_grid, grid_height, grid_width,
+                        grid);
+
+    for (int cell = 0; cell < num_grid * num_grid; ++cell) {
+      // Load the motion vectors in this particular grid.
+      int begin = grid->cell_begin[cell];
+      LoadMotionVectorArrays(motion_vectors, grid->indices.data() + begin,
+                             grid->cell_begin[cell + 1] - begin, frame_height,
+                             frame_width, &grid->arrays);
+
+      // Compute the feature for a particular grid.
+      features_from_all_grids[cell] = ComputeMagnitudeEntropy(&grid->arrays);
     }
   }
 
-  // Update the temportal grid feature buffer except for the I frame.
-  if (!motion_vectors.empty()) {
-    grids_features_buffer.push_back(features_from_all_grids);
-  }
-
-  for (int h = 0; h < num_grid; ++h) {
-    for (int w = 0; w < num_grid; ++w) {
-      for (int k = 0; k < featureNum; ++k) {
-        // Update the running average.
-        float average_sum = 0;
-        for (int j = 0; j < grids_features_buffer.size(); ++j) {
-          average_sum += grids_features_buffer.at(j)(h, w, k);
-        }
-
-        feature_average(h, w, k) = average_sum / grids_features_buffer.size();
-      }
+  int num_frames = grids_features_buffer.size();
+  for (int i = 0; i < mv_features_size; ++i) {
+    // Update the running average.
+    float average_sum = 0;
+    for (int j = 0; j < num_frames; ++j) {
+      average_sum += grids_features_buffer.at(j)[i];
     }
+
+    feature_average[i] = average_sum / num_frames;
   }
 
   return absl::OkStatus();
@@ -354,40 +335,29 @@ absl::Status ComputeMaxMagnitudeEntropyWithSpatialGrid(
 std::vector<float> ComputeMaxMagnitudeEntropyFeatures(
     const MotionVectors& motion_vectors, int num_grid, int frame_height,
     int frame_width) {
+  MotionVectorArrays arrays;
+  LoadMotionVectorArrays(motion_vectors, frame_height, frame_width, &arrays);
+  return {ComputeMagnitudeEntropy(&arrays)};
+}
+
+float ComputeMagnitudeEntropy(MotionVectorArrays* arrays) {
   // MV number
-  int input_mv_number = motion_vectors.size();
+  int input_mv_number = arrays->size();
   // Motion magnitudes
-  std::vector<float> motion_magnitudes(input_mv_number, 0);
+  const float* motion_magnitudes = arrays->magnitude.data();
 
-  // First and higher order spread of magnitudes
-  float magnitude_standard_deviation = 0;
-
-  for (int i = 0; i < input_mv_number; ++i) {
-    const MotionVector& mv = motion_vectors[i];
-    float mv_x =
-        static_cast<float>(mv.motion_x) / mv.motion_scale / frame_width;
-    float mv_y =
-        static_cast<float>(mv.motion_y) / mv.motion_scale / frame_height;
-
-    float motion_magnitude =
-        std::sqrt(std::pow(mv_x, 2.0) + std::pow(mv_y, 2.0));
-    motion_magnitudes[i] = motion_magnitude;
-  }
-
-  float mean_motion_magnitude = VectorAverage(motion_magnitudes);
+  float mean_motion_magnitude =
+      Sum(motion_magnitudes, input_mv_number) / input_mv_number;
 
-  for (int i = 0; i < input_mv_number; ++i) {
-    magnitude_standard_deviation +=
-        std::pow(motion_magnitudes[i] - mean_motion_magnitude, 2.0);
-  }
-
-  magnitude_standard_deviation =
-      std::sqrt(magnitude_standard_deviation / input_mv_number);
-
-  float magnitude_entropy = EstimateEntropy(
-      motion_magnitudes, mean_motion_magnitude, magnitude_standard_deviation);
-
-  return {magnitude_entropy};
+  // First and higher order spread of magnitudes
+  float magnitude_standard_deviation =
+      std::sqrt(SumSquaredDeviation(motion_magnitudes, input_mv_number,
+                                    mean_motion_magnitude) /
+                input_mv_number);
+
+  return EstimateEntropy(motion_magnitudes, input_mv_number,
+                         mean_motion_magnitude, magnitude_standard_deviation,
+                         kBinNumber, arrays->int_scratch.data());
 }
 
 }  // namespace motion_detection
@@ -12,9 +12,9 @@
 #include <vector>
 
 #include "absl/status/status.h"
+#include "visionai/algorithms/detection/motion_detection/motion_vector_kernels.h"
+#include "visionai/algorithms/detection/motion_detection/temporal_feature_buffer.h"
 #include "visionai/types/motion_vector.h"
-#include "visionai/util/array/array3d.h"
-#include "visionai/util/gtl/circularbuffer.h"
 
 namespace visionai {
 namespace motion_detection {
@@ -26,27 +26,82 @@ float VectorAverage(const std::vector<float>& vec);
 // of this array.
 float EstimateEntropy(const std::vector<float>& numbers, float mean, float std);
 
+// Motion vectors bucketed by spatial grid cell.
+//
+// The bucketing only permutes indices into the original motion vectors, so no
+// motion vector is copied. Reusing an instance across frames keeps the grid
+// feature extraction free of heap allocations once it has seen the largest
+// frame.
+struct MotionVectorGrid {
+  // The indices of the motion vectors sorted by grid cell. Within a cell, the
+  // indices keep their original order.
+  std::vector<int> indices;
+
+  // Cell `c` holds indices[cell_begin[c], cell_begin[c + 1]). The cells are
+  // numbered in row-major order.
+  std::vector<int> cell_begin;
+
+  // The cell of each motion vector, or -1 if it falls outside of the grid.
+  std::vector<int> cells;
+
+  // The motion vectors of the cell being processed.
+  MotionVectorArrays arrays;
+};
+
+// Buckets `motion_vectors` into a `num_grid` x `num_grid` grid of cells of
+// `grid_height` x `grid_width` pixels, according to their destination.
+//
+// This is a counting sort, which takes two passes over the motion vectors.
+void BucketMotionVectors(const MotionVectors& motion_vectors, int num_grid,
+                         int grid_height, int grid_width,
+                         MotionVectorGrid* grid);
+
 // Extract features from motion vectors for a video with regard to spatial
 // grid
+//
+// The features of the grid cells are pushed into `grids_features_buffer`,
+// unless there are no motion vectors, and `mv_features` receives their running
+// average and standard deviation over the buffer.
+//
+// `grid` is optional scratch space. Pass the same instance for every frame to
+// avoid allocating per frame.
 absl::Status ComputeMotionVectorFeaturesWithSpatialGrid(
     const MotionVectors& motion_vectors,
-    gtl::CircularBuffer<Array3D<float>>& grids_features_buffer, int num_grid,
-    int frame_height, int frame_width, std::vector<float>& mv_features);
+    TemporalFeatureBuffer& grids_features_buffer, int num_grid,
+    int frame_height, int frame_width, std::vector<float>& mv_features,
+    MotionVectorGrid* grid = nullptr);
 
 // Extract feature from motion vectors
 std::vector<float> ComputeMotionVectorFeatures(
     const MotionVectors& motion_vectors, int num_grid, int frame_height,
     int frame_width);
 
+// Same as above, but takes the motion vectors in the structure-of-arrays
+// layout and writes the features to `features[0, 14)`.
+//
+// The scratch space of `arrays` is used for temporaries.
+void ComputeMotionVectorFeatures(MotionVectorArrays* arrays, int num_grid,
+                                 int frame_height, int frame_width,
+                                 float* features);
+
 // Extract max magnitude entropy from motion vectors
+//
+// `grid` is optional scratch space, as above.
 absl::Status ComputeMaxMagnitudeEntropyWithSpatialGrid(
     const MotionVectors& motion_vectors,
-    gtl::CircularBuffer<Array3D<float>>& grids_features_buffer, int num_grid,
-    int frame_height, int frame_width, std::vector<float>& mv_features);
+    TemporalFeatureBuffer& grids_features_buffer, int num_grid,
+    int frame_height, int frame_width, std::vector<float>& mv_features,
+    MotionVectorGrid* grid = nullptr);
 std::vector<float> ComputeMaxMagnitudeEntropyFeatures(
     const MotionVectors& motion_vectors, int num_grid, int frame_height,
     int frame_width);
 
+// Compute the magnitude entropy of motion vectors in the structure-of-arrays
+// layout.
+//
+// The scratch space of `arrays` is used for temporaries.
+float ComputeMagnitudeEntropy(MotionVectorArrays* arrays);
+
 }  // namespace motion_detection
 }  // namespace visionai
 
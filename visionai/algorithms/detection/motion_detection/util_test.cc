@@ -9,18 +9,183 @@
 #include <cmath>
 #include <iostream>
 #include <memory>
+#include <numeric>
+#include <random>
 #include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "visionai/algorithms/detection/motion_detection/temporal_feature_buffer.h"
 #include "visionai/types/motion_vector.h"
-#include "visionai/util/array/array3d.h"
-#include "visionai/util/gtl/circularbuffer.h"
 
 namespace visionai {
 namespace motion_detection {
 namespace {
 
+constexpr float kEpsilon = 1e-5;
+constexpr int kBinNumber = 50;
+
+// The scalar implementation that the structure-of-arrays kernels replaced.
+float ReferenceEstimateEntropy(const std::vector<float>& numbers, float mean,
+                               float standard_deviation) {
+  if (numbers.empty() || std::abs(standard_deviation) < kEpsilon) {
+    return 0;
+  }
+
+  float entropy = 0;
+  float upper_bound = mean + 5 * standard_deviation;
+  float bin_size = upper_bound / kBinNumber;
+  std::vector<float> frequencies(kBinNumber + 1, 0);
+
+  for (const float& number : numbers) {
+    int bin = std::min(kBinNumber, static_cast<int>(floor(number / bin_size)));
+    frequencies[bin] += 1.0;
+  }
+
+  for (int i = 0; i < kBinNumber + 1; ++i) {
+    if (frequencies[i] > 0) {
+      frequencies[i] /= numbers.size();
+      entropy -= frequencies[i] * std::log(frequencies[i]);
+    }
+  }
+  return entropy;
+}
+
+float ReferenceVectorAverage(const std::vector<float>& vec) {
+  return std::accumulate(vec.begin(), vec.end(), 0.0) /
+         static_cast<float>(vec.size());
+}
+
+// The scalar implementation returned a NaN whenever rounding pushed the cosine
+// of parallel vectors past 1, which the kernels now clamp.
+float ClampedAcos(float x) {
+  return std::acos(std::min(1.0f, std::max(-1.0f, x)));
+}
+
+std::vector<float> ReferenceComputeMotionVectorFeatures(
+    const MotionVectors& motion_vectors, int num_grid, int frame_height,
+    int frame_width) {
+  int input_mv_number = motion_vectors.size();
+  float weighted_mv_number = 0;
+  int nonzero_mv_number = 0;
+  std::vector<float> motion_magnitudes(input_mv_number, 0);
+  std::vector<float> motion_x(input_mv_number, 0);
+  std::vector<float> motion_y(input_mv_number, 0);
+  float magnitude_mean_absolute_deviation = 0;
+  float magnitude_standard_deviation = 0;
+  float max_motion_magnitude = 0;
+  float max_motion_x = 0;
+  float max_motion_y = 0;
+  float total_block_size = 0;
+  float nonzero_block_size = 0;
+  float mean_absolute_deviation = 0;
+  float mean_angle = 0;
+  float mean_angle_wrt_max = 0;
+
+  for (int i = 0; i < input_mv_number; ++i) {
+    const MotionVector& mv = motion_vectors[i];
+    float mv_x =
+        static_cast<float>(mv.motion_x) / mv.motion_scale / frame_width;
+    float mv_y =
+        static_cast<float>(mv.motion_y) / mv.motion_scale / frame_height;
+    total_block_size += std::sqrt(mv.w * mv.h);
+    float motion_magnitude =
+        std::sqrt(std::pow(mv_x, 2.0) + std::pow(mv_y, 2.0));
+    motion_magnitudes[i] = motion_magnitude;
+    motion_x[i] = mv_x;
+    motion_y[i] = mv_y;
+    if (motion_magnitude > max_motion_magnitude) {
+      max_motion_magnitude = motion_magnitude;
+      max_motion_x = mv_x;
+      max_motion_y = mv_y;
+    }
+    if (std::abs(mv_x) > kEpsilon || std::abs(mv_y) > kEpsilon) {
+      nonzero_mv_number += 1;
+      weighted_mv_number += 16.0 / std::sqrt(mv.w * mv.h);
+      nonzero_block_size += std::sqrt(mv.w * mv.h);
+    }
+  }
+
+  float mean_motion_magnitude = ReferenceVectorAverage(motion_magnitudes);
+  float mean_motion_x = ReferenceVectorAverage(motion_x);
+  float mean_motion_y = ReferenceVectorAverage(motion_y);
+  float mean_motion_norm =
+      std::sqrt(mean_motion_x * mean_motion_x + mean_motion_y * mean_motion_y);
+
+  for (int i = 0; i < input_mv_number; ++i) {
+    mean_absolute_deviation +=
+        std::sqrt(std::pow(motion_x[i] - mean_motion_x, 2.0) +
+                  std::pow(motion_y[i] - mean_motion_y, 2.0));
+    if (mean_motion_norm > kEpsilon && motion_magnitudes[i] > kEpsilon) {
+      mean_angle += ClampedAcos(
+          (motion_x[i] * mean_motion_x + motion_y[i] * mean_motion_y) /
+          (motion_magnitudes[i] * mean_motion_norm));
+      mean_angle_wrt_max += ClampedAcos(
+          (motion_x[i] * max_motion_x + motion_y[i] * max_motion_y) /
+          (motion_magnitudes[i] * max_motion_magnitude));
+    }
+  }
+  mean_absolute_deviation /= input_mv_number;
+  mean_angle /= input_mv_number;
+  mean_angle_wrt_max /= input_mv_number;
+
+  for (int i = 0; i < input_mv_number; ++i) {
+    magnitude_mean_absolute_deviation +=
+        std::abs(motion_magnitudes[i] - mean_motion_magnitude);
+    magnitude_standard_deviation +=
+        std::pow(motion_magnitudes[i] - mean_motion_magnitude, 2.0);
+  }
+  magnitude_mean_absolute_deviation /= input_mv_number;
+  magnitude_standard_deviation =
+      std::sqrt(magnitude_standard_deviation / input_mv_number);
+
+  float mean_nonzero_block_size = nonzero_block_size / 16.0 / nonzero_mv_number;
+  float mean_block_size = total_block_size / 16.0 / input_mv_number;
+  float magnitude_entropy = ReferenceEstimateEntropy(
+      motion_magnitudes, mean_motion_magnitude, magnitude_standard_deviation);
+  float mv_density = static_cast<float>(input_mv_number) * 256 * num_grid *
+                     num_grid / (frame_height * frame_width);
+  float weighted_mv_density = weighted_mv_number * 256 * num_grid * num_grid /
+                              (frame_height * frame_width);
+  float nonzero_mv_density = nonzero_mv_number * 256 * num_grid * num_grid /
+                             (frame_height * frame_width);
+  return {max_motion_magnitude,
+          mean_motion_magnitude,
+          mean_motion_norm,
+          mean_absolute_deviation,
+          mean_angle,
+          mean_angle_wrt_max,
+          mean_block_size,
+          mean_nonzero_block_size,
+          magnitude_mean_absolute_deviation,
+          magnitude_standard_deviation,
+          magnitude_entropy,
+          mv_density,
+          weighted_mv_density,
+          nonzero_mv_density};
+}
+
+MotionVectors RandomMotionVectors(int n, int frame_height, int frame_width,
+                                  std::mt19937* rng) {
+  std::uniform_int_distribution<int> motion(-64, 64);
+  std::uniform_int_distribution<int> log_scale(0, 2);
+  std::uniform_int_distribution<int> log_block_size(2, 4);
+  std::uniform_int_distribution<int> dst_x(0, frame_width - 1);
+  std::uniform_int_distribution<int> dst_y(0, frame_height - 1);
+  MotionVectors motion_vectors(n);
+  for (MotionVector& mv : motion_vectors) {
+    mv.source = -1;
+    mv.w = 1 << log_block_size(*rng);
+    mv.h = 1 << log_block_size(*rng);
+    mv.dst_x = dst_x(*rng);
+    mv.dst_y = dst_y(*rng);
+    mv.motion_x = motion(*rng);
+    mv.motion_y = motion(*rng);
+    mv.motion_scale = 1 << log_scale(*rng);
+  }
+  return motion_vectors;
+}
+
 TEST(MotionVectorUtilTest, CanProcessEmptyMotionVectors) {
   int frame_width = 1;
   int frame_height = 2;
@@ -32,8 +197,7 @@ TEST(MotionVectorUtilTest, CanProcessEmptyMotionVectors) {
       ComputeMotionVectorFeatures({}, num_grid, frame_height, frame_width);
   EXPECT_EQ(features.size(), feature_number);
 
-  gtl::CircularBuffer<Array3D<float>> grids_features_buffer(
-      temporal_buffer_size);
+  TemporalFeatureBuffer grids_features_buffer(temporal_buffer_size);
   features.resize(num_grid * num_grid * feature_number * 2, 0.0);
 
   absl::Status status = ComputeMotionVectorFeaturesWithSpatialGrid(
@@ -93,14 +257,135 @@ TEST(MotionVectorUtilTest, CanComputeMotionVectorFeatures) {
   EXPECT_FLOAT_EQ(features[13], 512.0);
 }
 
+TEST(MotionVectorUtilTest, MotionVectorFeaturesMatchScalarImplementation) {
+  constexpr int kFrameHeight = 1080;
+  constexpr int kFrameWidth = 1920;
+  std::mt19937 rng(7);
+  for (int n : {1, 2, 15, 16, 17, 100, 8160}) {
+    MotionVectors motion_vectors =
+        RandomMotionVectors(n, kFrameHeight, kFrameWidth, &rng);
+    // Also cover frames in which most of the blocks are still.
+    for (int i = 0; i < n; i += 2) {
+      motion_vectors[i].motion_x = 0;
+      motion_vectors[i].motion_y = 0;
+    }
+    std::vector<float> features = ComputeMotionVectorFeatures(
+        motion_vectors, /*num_grid=*/1, kFrameHeight, kFrameWidth);
+    std::vector<float> expected = ReferenceComputeMotionVectorFeatures(
+        motion_vectors, /*num_grid=*/1, kFrameHeight, kFrameWidth);
+    ASSERT_EQ(features.size(), expected.size());
+    for (int k = 0; k < expected.size(); ++k) {
+      // E.g. the mean size of the moving blocks is undefined without any.
+      if (std::isnan(expected[k])) {
+        EXPECT_TRUE(std::isnan(features[k]))
+            << "n = " << n << ", feature " << k;
+        continue;
+      }
+      EXPECT_NEAR(features[k], expected[k],
+                  1e-4 * std::max(1.0f, std::abs(expected[k])))
+          << "n = " << n << ", feature " << k;
+    }
+  }
+}
+
+TEST(MotionVectorUtilTest, BucketMotionVectors) {
+  // Two rows of three cells of 10x10 pixels.
+  MotionVectors motion_vectors(6);
+  motion_vectors[0].dst_x = 25;  // Cell 2.
+  motion_vectors[1].dst_x = 5;   // Cell 0.
+  motion_vectors[2].dst_x = 35;  // Beyond the grid.
+  motion_vectors[2].dst_y = 5;
+  motion_vectors[3].dst_x = 15;  // Cell 4.
+  motion_vectors[3].dst_y = 19;
+  motion_vectors[4].dst_x = 29;  // Cell 2.
+  motion_vectors[4].dst_y = 9;
+  motion_vectors[5].dst_x = -15;  // Beyond the grid.
+
+  MotionVectorGrid grid;
+  BucketMotionVectors(motion_vectors, /*num_grid=*/3, /*grid_height=*/10,
+                      /*grid_width=*/10, &grid);
+  EXPECT_THAT(grid.cell_begin, testing::ElementsAre(0, 1, 1, 3, 3, 4, 4, 4,
+                                                    4, 4));
+  EXPECT_THAT(grid.indices, testing::ElementsAre(1, 0, 4, 3));
+
+  // Reusing the grid does not leave anything behind.
+  BucketMotionVectors({motion_vectors[3]}, /*num_grid=*/3, /*grid_height=*/10,
+                      /*grid_width=*/10, &grid);
+  EXPECT_THAT(grid.cell_begin, testing::ElementsAre(0, 0, 0, 0, 0, 1, 1, 1,
+                                                    1, 1));
+  EXPECT_THAT(grid.indices, testing::ElementsAre(0));
+}
+
+TEST(MotionVectorUtilTest, SpatialGridFeaturesMatchPerCellFeatures) {
+  constexpr int kFrameHeight = 1080;
+  constexpr int kFrameWidth = 1920;
+  constexpr int kNumGrid = 3;
+  constexpr int kFeatureNumber = 14;
+  std::mt19937 rng(11);
+  MotionVectorGrid grid;
+  for (int n : {500, 40, 0, 3000}) {
+    MotionVectors motion_vectors =
+        RandomMotionVectors(n, kFrameHeight, kFrameWidth, &rng);
+    if (n > 0) {
+      motion_vectors[0].dst_x = kFrameWidth;
+      motion_vectors[n - 1].dst_y = -kFrameHeight;
+    }
+
+    // Bucket the motion vectors the straightforward way.
+    std::vector<MotionVectors> cells(kNumGrid * kNumGrid);
+    for (const MotionVector& mv : motion_vectors) {
+      int grid_x = mv.dst_x / (kFrameWidth / kNumGrid);
+      int grid_y = mv.dst_y / (kFrameHeight / kNumGrid);
+      if (grid_x >= 0 && grid_y >= 0 && grid_x < kNumGrid &&
+          grid_y < kNumGrid) {
+        cells[grid_y * kNumGrid + grid_x].push_back(mv);
+      }
+    }
+
+    // With a single frame in the buffer, the average is the frame's features.
+    TemporalFeatureBuffer grids_features_buffer(1);
+    std::vector<float> features(kNumGrid * kNumGrid * kFeatureNumber * 2);
+    ASSERT_TRUE(ComputeMotionVectorFeaturesWithSpatialGrid(
+                    motion_vectors, grids_features_buffer, kNumGrid,
+                    kFrameHeight, kFrameWidth, features, &grid)
+                    .ok());
+    TemporalFeatureBuffer entropy_buffer(1);
+    std::vector<float> entropies(kNumGrid * kNumGrid);
+    ASSERT_TRUE(ComputeMaxMagnitudeEntropyWithSpatialGrid(
+                    motion_vectors, entropy_buffer, kNumGrid, kFrameHeight,
+                    kFrameWidth, entropies, &grid)
+                    .ok());
+    if (n == 0) {
+      continue;
+    }
+
+    for (int c = 0; c < cells.size(); ++c) {
+      std::vector<float> expected = ComputeMotionVectorFeatures(
+          cells[c], kNumGrid, kFrameHeight, kFrameWidth);
+      for (int k = 0; k < kFeatureNumber; ++k) {
+        float feature = features[c * kFeatureNumber + k];
+        if (std::isnan(expected[k])) {
+          EXPECT_TRUE(std::isnan(feature)) << "cell " << c << ", feature " << k;
+        } else {
+          EXPECT_EQ(feature, expected[k]) << "cell " << c << ", feature " << k;
+        }
+      }
+      EXPECT_EQ(entropies[c],
+                ComputeMaxMagnitudeEntropyFeatures(cells[c], kNumGrid,
+                                                   kFrameHeight, kFrameWidth)
+                    .front())
+          << "cell " << c;
+    }
+  }
+}
+
 TEST(MotionVectorUtilTest, CanComputeMaxMagnitudeEntropywithSpatialGrid) {
   int frame_width = 10;
   int frame_height = 10;
   int num_grid = 1;
   int feature_number = 1;
   int temporal_buffer_size = 3;
-  gtl::CircularBuffer<Array3D<float>> grids_features_buffer(
-      temporal_buffer_size);
+  TemporalFeatureBuffer grids_features_buffer(temporal_buffer_size);
 
   MotionVector mv00{/* .source = */ 1,
                     /* .w = */ 16,
@@ -223,8 +508,7 @@ TEST(MotionVectorUtilTest, CanComputeMotionVectorFeaturesWithSpatialGrid) {
   int num_grid = 2;
   int feature_number = 14;
   int temporal_buffer_size = 3;
-  gtl::CircularBuffer<Array3D<float>> grids_features_buffer(
-      temporal_buffer_size);
+  TemporalFeatureBuffer grids_features_buffer(temporal_buffer_size);
 
   MotionVector mv00{/* .source = */ 1,
                     /* .w = */ 16,
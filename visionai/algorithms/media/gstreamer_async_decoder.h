@@ -18,6 +18,7 @@
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 #include "absl/types/variant.h"
+#include "visionai/algorithms/media/util/frame_sampling.h"
 #include "visionai/algorithms/media/util/gstreamer_runner.h"
 #include "visionai/algorithms/media/util/type_util.h"
 #include "visionai/types/gstreamer_buffer.h"
@@ -41,6 +42,14 @@ namespace visionai {
 // for every `p` seconds. However, the number that `receiver_callback` for the
 // GstreamerRunner is called will not change.
 //
+// Because `output_period_nanos` only drops frames after they are decoded, it
+// does not reduce the decoding work. To avoid decoding frames that will never
+// be used, pass a `sampling_mode` to the constructor. Frames that are not
+// selected by the FrameSamplingMode are dropped in Feed() before they reach
+// the decoder, and their associated data is discarded without invoking the
+// callback. For example, `FrameSamplingMode::kKeyFramesOnly` combined with an
+// `output_period_nanos` of one second decodes only one frame per GOP.
+//
 // NOTE: Only 1 callback may be active at a time, more data will not be returned
 // until the previous callback has returned. This is to prevent race conditions.
 //
@@ -74,6 +83,17 @@ namespace visionai {
 //
 //   decoder.Feed(input_gstreamer_buffer, some_context);
 //
+// Example:
+//   GstreamerAsyncDecoder<> decoder(
+//     [](absl::StatusOr<RawImage> image) {
+//       // Do something with image.
+//     },
+//     /*queue_size =*/300, /*feed_timeout =*/absl::Seconds(60),
+//     /*output_period_nanos =*/0,
+//     /*sampling_mode =*/FrameSamplingMode::kKeyFramesOnly);
+//
+//   decoder.Feed(input_gstreamer_buffer);
+//
 //
 // NOTE: This class is thread-unsafe.
 template <class... Args>
@@ -92,13 +112,18 @@ class GstreamerAsyncDecoder {
   //
   // If EOS is reached, the callback will be supplied with a kResourceExhausted
   // error.
-  GstreamerAsyncDecoder(Callback callback, size_t queue_size = 300,
-                        absl::Duration feed_timeout = absl::Seconds(60),
-                        int64_t output_period_nanos = 0)
+  //
+  // Frames that are not selected by `sampling_mode` are not decoded at all.
+  GstreamerAsyncDecoder(
+      Callback callback, size_t queue_size = 300,
+      absl::Duration feed_timeout = absl::Seconds(60),
+      int64_t output_period_nanos = 0,
+      FrameSamplingMode sampling_mode = FrameSamplingMode::kAll)
       : callback_(callback),
         feed_timeout_(feed_timeout),
         pcqueue_(queue_size),
-        output_period_nanos_(output_period_nanos) {}
+        output_period_nanos_(output_period_nanos),
+        sampling_mode_(sampling_mode) {}
 
   // Disable copying and moving.
   GstreamerAsyncDecoder(const GstreamerAsyncDecoder&) = delete;
@@ -113,6 +138,10 @@ class GstreamerAsyncDecoder {
   // The first call will be slightly slower than subsequent calls because it
   // will initialize the underlying GstreamerRunner.
   //
+  // If the buffer is not selected by the sampling mode given in the
+  // constructor, it is dropped before decoding and OK is returned. The
+  // associated data is discarded and the callback is not invoked for it.
+  //
   // If the internal queue is full, this function will block until either the
   // queue has free space or `feed_timeout`, as specified in the constructor, is
   // reached.
@@ -181,6 +210,10 @@ class GstreamerAsyncDecoder {
   // `output_period_nanos_`.
   int64_t output_period_nanos_ = 0;
   int64_t start_pts_nanos_ = -1;
+
+  // Selects the frames to be decoded. Frames that are not selected are dropped
+  // before they are fed to the GstreamerRunner.
+  FrameSamplingMode sampling_mode_ = FrameSamplingMode::kAll;
 };
 
 template <class... Args>
@@ -273,6 +306,10 @@ absl::Status GstreamerAsyncDecoder<Args...>::Feed(
     return EOSStatus();
   }
 
+  if (!ShouldDecodeFrame(sampling_mode_, gstreamer_buffer)) {
+    return absl::OkStatus();
+  }
+
   if (gstreamer_runner_ == nullptr) {
     absl::Status status = Initialize(gstreamer_buffer);
     if (!status.ok()) {
@@ -20,6 +20,7 @@
 #include "third_party/gstreamer/subprojects/gstreamer/gst/gst.h"
 #include "third_party/gstreamer/subprojects/gstreamer/gst/gstplugin.h"
 #include "third_party/gstreamer/subprojects/gstreamer/gst/gstregistry.h"
+#include "visionai/algorithms/media/util/frame_sampling.h"
 #include "visionai/algorithms/media/util/test_util.h"
 #include "visionai/algorithms/media/util/util.h"
 #include "visionai/testing/status/status_matchers.h"
@@ -262,6 +263,41 @@ TEST_F(GstreamerAsyncDecoderTest, LimitFrameRateTest) {
   EXPECT_EQ(results[0].second, 0);
 }
 
+TEST_F(GstreamerAsyncDecoderTest, KeyFramesOnlySamplingTest) {
+  absl::LeakCheckDisabler disabler;
+  std::vector<std::pair<absl::StatusOr<RawImage>, int>> results;
+  GstreamerAsyncDecoder<int> decoder(
+      [&results](absl::StatusOr<RawImage> image, int timestamp) {
+        if (image.ok()) {
+          results.push_back(std::make_pair(std::move(image), timestamp));
+        }
+      },
+      /*queue_size=*/30,
+      /*feed_timeout=*/absl::Seconds(60),
+      /*output_period_nanos=*/0,
+      /*sampling_mode=*/FrameSamplingMode::kKeyFramesOnly);
+
+  // Only the first frame is a key frame. The others should be dropped before
+  // they reach the decoder.
+  std::vector<absl::string_view> paths = {
+      kEncodedFrame1Path, kEncodedFrame2Path, kEncodedFrame3Path,
+      kEncodedFrame4Path};
+  for (int i = 0; i < paths.size(); ++i) {
+    GstreamerBuffer gstreamer_buffer =
+        GstreamerBufferFromFile(paths[i], kH264CapsString, i, i, 0).value();
+    gstreamer_buffer.set_is_key_frame(i == 0);
+    ASSERT_THAT(decoder.Feed(gstreamer_buffer, i), IsOk());
+  }
+
+  decoder.SignalEOS();
+  decoder.WaitUntilCompleted(absl::Seconds(2));
+
+  ASSERT_THAT(results, SizeIs(1));
+  EXPECT_EQ(results[0].first->height(), 300);
+  EXPECT_EQ(results[0].first->width(), 460);
+  EXPECT_EQ(results[0].second, 0);
+}
+
 TEST_F(GstreamerAsyncDecoderTest, LegalOutputPeriodTest) {
   absl::LeakCheckDisabler disabler;
   std::vector<std::pair<absl::StatusOr<GstreamerBuffer>, int>> results;
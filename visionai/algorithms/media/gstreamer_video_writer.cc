@@ -60,6 +60,15 @@ absl::StatusOr<std::string> GetFramerateFractionFromCaps(
   return absl::StrFormat("%d/%d", fr_numerator, fr_denominator);
 }
 
+std::string Mp4MuxElement(const GstreamerVideoWriter::Options& options) {
+  if (options.fragment_duration <= absl::ZeroDuration()) {
+    return "mp4mux";
+  }
+  return absl::StrFormat(
+      "mp4mux fragment-duration=%d",
+      absl::ToInt64Milliseconds(options.fragment_duration));
+}
+
 absl::StatusOr<std::string> AssembleTranscodeMuxPipeline(
     const GstreamerVideoWriter::Options& options, std::string framerate) {
   std::vector<std::string> pipeline_elements;
@@ -70,7 +79,7 @@ absl::StatusOr<std::string> AssembleTranscodeMuxPipeline(
   pipeline_elements.push_back(
       absl::StrFormat("video/x-raw,framerate=%s", framerate));
   pipeline_elements.push_back("x264enc");
-  pipeline_elements.push_back("mp4mux");
+  pipeline_elements.push_back(Mp4MuxElement(options));
   pipeline_elements.push_back(
       absl::StrFormat("filesink location=%s", options.file_path));
   return absl::StrJoin(pipeline_elements, " ! ");
@@ -80,7 +89,7 @@ absl::StatusOr<std::string> AssembleH264MuxPipeline(
     const GstreamerVideoWriter::Options& options) {
   std::vector<std::string> pipeline_elements;
   pipeline_elements.push_back("video/x-h264");
-  pipeline_elements.push_back("mp4mux");
+  pipeline_elements.push_back(Mp4MuxElement(options));
   pipeline_elements.push_back(
       absl::StrFormat("filesink location=%s", options.file_path));
   return absl::StrJoin(pipeline_elements, " ! ");
@@ -14,6 +14,7 @@
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/time/time.h"
 #include "visionai/algorithms/media/util/gstreamer_runner.h"
 #include "visionai/types/gstreamer_buffer.h"
 #include "visionai/types/raw_image.h"
@@ -36,6 +37,11 @@ class GstreamerVideoWriter {
 
     // If set true, the h264 inputs will be muxed without transcoding.
     bool h264_mux_only = false;
+
+    // If positive, writes a fragmented MP4 with a fragment this often. Such a
+    // file is playable while it is being written, and whatever was written
+    // before a crash remains readable.
+    absl::Duration fragment_duration = absl::ZeroDuration();
   };
 
   // Create an instance in a fully initialized state.
@@ -135,6 +135,43 @@ TEST_F(GstreamerVideoWriterTest, H264InputMuxOnly) {
   std::remove(output_file.c_str());
 }
 
+TEST_F(GstreamerVideoWriterTest, H264InputMuxOnlyFragmented) {
+  std::string output_file = "/tmp/H264InputMuxOnlyFragmented.mp4";
+  GstreamerVideoWriter::Options options;
+  options.file_path = output_file;
+  options.caps_string = kExerciseVideoCapString;
+  options.h264_mux_only = true;
+  options.fragment_duration = absl::Seconds(1);
+  auto writer = GstreamerVideoWriter::Create(options).value();
+
+  EXPECT_EQ(writer->GetPipelineStr(),
+            absl::StrFormat("video/x-h264 ! mp4mux fragment-duration=1000 ! "
+                            "filesink location=%s",
+                            output_file));
+
+  std::vector<int64_t> expected_pts, expected_dts, expected_duration;
+  GstreamerRunner::Options input_runner_opt;
+  input_runner_opt.processing_pipeline_string = absl::StrFormat(
+      "filesrc location=%s ! qtdemux ! h264parse", kExerciseVideoPath);
+  input_runner_opt.appsink_sync = true;
+  input_runner_opt.receiver_callback =
+      [&](GstreamerBuffer buffer) -> absl::Status {
+    expected_pts.push_back(buffer.get_pts());
+    expected_dts.push_back(buffer.get_dts());
+    expected_duration.push_back(buffer.get_duration());
+    return writer->Put(buffer);
+  };
+  auto input_runner = GstreamerRunner::Create(input_runner_opt).value();
+  absl::SleepFor(absl::Seconds(2));
+  input_runner->SignalEOS();
+  absl::SleepFor(absl::Milliseconds(100));
+  writer.reset();
+
+  VerifyOutputVideo(output_file, expected_pts.size(), expected_pts,
+                    expected_dts, expected_duration);
+  std::remove(output_file.c_str());
+}
+
 TEST_F(GstreamerVideoWriterTest, NonH264InputRejected) {
   GstreamerVideoWriter::Options options;
   options.file_path = kOutputFile;
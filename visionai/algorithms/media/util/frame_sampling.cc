@@ -0,0 +1,146 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/algorithms/media/util/frame_sampling.h"
+
+#include <cstdint>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "visionai/types/gstreamer_buffer.h"
+
+namespace visionai {
+
+namespace {
+
+constexpr char kH264MediaType[] = "video/x-h264";
+
+// The size of the NAL unit length prefix for the "avc" stream format.
+//
+// The actual size is carried in the codec_data of the caps, but all encoders
+// and payloaders that we have encountered use 4 bytes.
+constexpr size_t kAvcLengthSize = 4;
+
+// The result of inspecting the VCL NAL units of one access unit.
+struct VclSummary {
+  int num_vcl_nal_units = 0;
+  bool has_reference_slice = false;
+};
+
+void InspectH264NalHeader(uint8_t header, VclSummary* summary) {
+  int nal_unit_type = header & 0x1f;
+  int nal_ref_idc = (header >> 5) & 0x3;
+  // Types 1 to 5 are the coded slices.
+  if (nal_unit_type >= 1 && nal_unit_type <= 5) {
+    summary->num_vcl_nal_units++;
+    if (nal_ref_idc != 0) {
+      summary->has_reference_slice = true;
+    }
+  }
+}
+
+// Inspects an access unit in the Annex B byte-stream format.
+void InspectByteStream(absl::string_view data, VclSummary* summary) {
+  size_t i = 0;
+  while (i + 3 < data.size()) {
+    if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+      InspectH264NalHeader(static_cast<uint8_t>(data[i + 3]), summary);
+      if (summary->has_reference_slice) {
+        return;
+      }
+      i += 3;
+    } else {
+      ++i;
+    }
+  }
+}
+
+// Inspects an access unit in the length-prefixed "avc" format.
+//
+// Returns false if the lengths are inconsistent with the data.
+bool InspectLengthPrefixed(absl::string_view data, VclSummary* summary) {
+  size_t i = 0;
+  while (i + kAvcLengthSize < data.size()) {
+    size_t nal_size = 0;
+    for (size_t j = 0; j < kAvcLengthSize; ++j) {
+      nal_size = (nal_size << 8) | static_cast<uint8_t>(data[i + j]);
+    }
+    i += kAvcLengthSize;
+    if (nal_size == 0 || nal_size > data.size() - i) {
+      return false;
+    }
+    InspectH264NalHeader(static_cast<uint8_t>(data[i]), summary);
+    if (summary->has_reference_slice) {
+      return true;
+    }
+    i += nal_size;
+  }
+  return true;
+}
+
+}  // namespace
+
+absl::StatusOr<FrameSamplingMode> ToFrameSamplingMode(absl::string_view s) {
+  if (s.empty() || s == "all") {
+    return FrameSamplingMode::kAll;
+  } else if (s == "skip_non_reference") {
+    return FrameSamplingMode::kSkipNonReference;
+  } else if (s == "key_frames_only") {
+    return FrameSamplingMode::kKeyFramesOnly;
+  }
+  return absl::InvalidArgumentError(
+      absl::StrFormat("Given an unrecognized frame sampling mode \"%s\". "
+                      "Expected one of \"all\", \"skip_non_reference\" or "
+                      "\"key_frames_only\".",
+                      s));
+}
+
+std::string ToString(FrameSamplingMode mode) {
+  switch (mode) {
+    case FrameSamplingMode::kAll:
+      return "all";
+    case FrameSamplingMode::kSkipNonReference:
+      return "skip_non_reference";
+    case FrameSamplingMode::kKeyFramesOnly:
+      return "key_frames_only";
+  }
+  return "unknown";
+}
+
+bool IsNonReferenceFrame(const GstreamerBuffer& buffer) {
+  if (buffer.is_key_frame() || buffer.media_type() != kH264MediaType) {
+    return false;
+  }
+  absl::string_view data(buffer.data(), buffer.size());
+  VclSummary summary;
+  if (absl::StrContains(buffer.caps_string(), "stream-format=(string)avc") ||
+      absl::StrContains(buffer.caps_string(), "stream-format=avc")) {
+    if (!InspectLengthPrefixed(data, &summary)) {
+      return false;
+    }
+  } else {
+    InspectByteStream(data, &summary);
+  }
+  return summary.num_vcl_nal_units > 0 && !summary.has_reference_slice;
+}
+
+bool ShouldDecodeFrame(FrameSamplingMode mode, const GstreamerBuffer& buffer) {
+  switch (mode) {
+    case FrameSamplingMode::kAll:
+      return true;
+    case FrameSamplingMode::kSkipNonReference:
+      return !IsNonReferenceFrame(buffer);
+    case FrameSamplingMode::kKeyFramesOnly:
+      return buffer.is_key_frame();
+  }
+  return true;
+}
+
+}  // namespace visionai
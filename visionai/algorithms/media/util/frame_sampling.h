@@ -0,0 +1,58 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef THIRD_PARTY_VISIONAI_ALGORITHMS_MEDIA_UTIL_FRAME_SAMPLING_H_
+#define THIRD_PARTY_VISIONAI_ALGORITHMS_MEDIA_UTIL_FRAME_SAMPLING_H_
+
+#include <string>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "visionai/types/gstreamer_buffer.h"
+
+namespace visionai {
+
+// Controls which encoded frames are handed to a decoder.
+//
+// Frames that are not selected are dropped before decoding, so that the cost
+// of decoding is only paid for the frames that may actually be used.
+enum class FrameSamplingMode {
+  // Decode every frame.
+  kAll,
+
+  // Drop frames that no other frame references (e.g. non-reference B-frames
+  // in H.264). Dropping these never corrupts the decoding of the remaining
+  // frames.
+  kSkipNonReference,
+
+  // Decode only key frames.
+  kKeyFramesOnly,
+};
+
+// Parses a FrameSamplingMode from its string representation.
+//
+// Accepted values are "all", "skip_non_reference" and "key_frames_only". An
+// empty string is parsed as "all".
+absl::StatusOr<FrameSamplingMode> ToFrameSamplingMode(absl::string_view s);
+
+// Returns the string representation of `mode`.
+std::string ToString(FrameSamplingMode mode);
+
+// Returns true if the encoded frame in `buffer` is a non-reference frame.
+//
+// A frame is non-reference if all of its coded slices have a zero nal_ref_idc.
+// Only H.264 buffers in either the byte-stream or the length-prefixed (avc)
+// format are inspected. For any other media type, or if the bitstream cannot be
+// parsed, false is returned so that the frame is conservatively decoded.
+bool IsNonReferenceFrame(const GstreamerBuffer& buffer);
+
+// Returns true if the encoded frame in `buffer` should be fed to the decoder
+// under the given sampling `mode`.
+bool ShouldDecodeFrame(FrameSamplingMode mode, const GstreamerBuffer& buffer);
+
+}  // namespace visionai
+
+#endif  // THIRD_PARTY_VISIONAI_ALGORITHMS_MEDIA_UTIL_FRAME_SAMPLING_H_
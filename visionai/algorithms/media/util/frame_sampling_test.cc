@@ -0,0 +1,137 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/algorithms/media/util/frame_sampling.h"
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "visionai/types/gstreamer_buffer.h"
+
+namespace visionai {
+
+namespace {
+
+constexpr char kH264ByteStreamCaps[] =
+    "video/x-h264, stream-format=(string)byte-stream, alignment=(string)au";
+constexpr char kH264AvcCaps[] =
+    "video/x-h264, stream-format=(string)avc, alignment=(string)au";
+
+// Builds an Annex B access unit out of the given NAL unit headers. Each NAL
+// unit carries a couple of payload bytes.
+GstreamerBuffer MakeByteStreamBuffer(const std::vector<uint8_t>& headers,
+                                     bool is_key_frame = false) {
+  std::string bytes;
+  for (uint8_t header : headers) {
+    bytes.append({0, 0, 0, 1, static_cast<char>(header), 0x11, 0x22});
+  }
+  GstreamerBuffer buffer;
+  buffer.set_caps_string(kH264ByteStreamCaps);
+  buffer.set_is_key_frame(is_key_frame);
+  buffer.assign(std::move(bytes));
+  return buffer;
+}
+
+// Builds a length-prefixed access unit out of the given NAL unit headers.
+GstreamerBuffer MakeAvcBuffer(const std::vector<uint8_t>& headers) {
+  std::string bytes;
+  for (uint8_t header : headers) {
+    bytes.append({0, 0, 0, 3, static_cast<char>(header), 0x11, 0x22});
+  }
+  GstreamerBuffer buffer;
+  buffer.set_caps_string(kH264AvcCaps);
+  buffer.assign(std::move(bytes));
+  return buffer;
+}
+
+// NAL unit headers: (nal_ref_idc << 5) | nal_unit_type.
+constexpr uint8_t kIdrSlice = (3 << 5) | 5;
+constexpr uint8_t kReferenceSlice = (2 << 5) | 1;
+constexpr uint8_t kNonReferenceSlice = (0 << 5) | 1;
+constexpr uint8_t kSei = (0 << 5) | 6;
+constexpr uint8_t kAud = (0 << 5) | 9;
+
+}  // namespace
+
+TEST(FrameSamplingTest, ToFrameSamplingMode) {
+  EXPECT_EQ(*ToFrameSamplingMode(""), FrameSamplingMode::kAll);
+  EXPECT_EQ(*ToFrameSamplingMode("all"), FrameSamplingMode::kAll);
+  EXPECT_EQ(*ToFrameSamplingMode("skip_non_reference"),
+            FrameSamplingMode::kSkipNonReference);
+  EXPECT_EQ(*ToFrameSamplingMode("key_frames_only"),
+            FrameSamplingMode::kKeyFramesOnly);
+  EXPECT_EQ(ToFrameSamplingMode("some_frames").status().code(),
+            absl::StatusCode::kInvalidArgument);
+
+  for (auto mode :
+       {FrameSamplingMode::kAll, FrameSamplingMode::kSkipNonReference,
+        FrameSamplingMode::kKeyFramesOnly}) {
+    EXPECT_EQ(*ToFrameSamplingMode(ToString(mode)), mode);
+  }
+}
+
+TEST(FrameSamplingTest, IsNonReferenceFrameByteStream) {
+  EXPECT_FALSE(IsNonReferenceFrame(MakeByteStreamBuffer({kIdrSlice}, true)));
+  EXPECT_FALSE(IsNonReferenceFrame(MakeByteStreamBuffer({kReferenceSlice})));
+  EXPECT_TRUE(IsNonReferenceFrame(MakeByteStreamBuffer({kNonReferenceSlice})));
+  EXPECT_TRUE(IsNonReferenceFrame(
+      MakeByteStreamBuffer({kAud, kSei, kNonReferenceSlice})));
+
+  // A frame is only non-reference if all of its slices are.
+  EXPECT_FALSE(IsNonReferenceFrame(
+      MakeByteStreamBuffer({kNonReferenceSlice, kReferenceSlice})));
+
+  // Without any coded slices, the frame is conservatively kept.
+  EXPECT_FALSE(IsNonReferenceFrame(MakeByteStreamBuffer({kAud, kSei})));
+  EXPECT_FALSE(IsNonReferenceFrame(MakeByteStreamBuffer({})));
+}
+
+TEST(FrameSamplingTest, IsNonReferenceFrameAvc) {
+  EXPECT_FALSE(IsNonReferenceFrame(MakeAvcBuffer({kReferenceSlice})));
+  EXPECT_TRUE(IsNonReferenceFrame(MakeAvcBuffer({kSei, kNonReferenceSlice})));
+
+  // Inconsistent NAL unit lengths are conservatively kept.
+  GstreamerBuffer buffer = MakeAvcBuffer({kNonReferenceSlice});
+  buffer.data()[3] = 42;
+  EXPECT_FALSE(IsNonReferenceFrame(buffer));
+}
+
+TEST(FrameSamplingTest, IsNonReferenceFrameOtherMediaTypes) {
+  GstreamerBuffer buffer = MakeByteStreamBuffer({kNonReferenceSlice});
+  buffer.set_caps_string("video/x-h265, stream-format=(string)byte-stream");
+  EXPECT_FALSE(IsNonReferenceFrame(buffer));
+  buffer.set_caps_string("image/jpeg");
+  EXPECT_FALSE(IsNonReferenceFrame(buffer));
+}
+
+TEST(FrameSamplingTest, ShouldDecodeFrame) {
+  GstreamerBuffer key_frame = MakeByteStreamBuffer({kIdrSlice}, true);
+  GstreamerBuffer reference_frame = MakeByteStreamBuffer({kReferenceSlice});
+  GstreamerBuffer non_reference_frame =
+      MakeByteStreamBuffer({kNonReferenceSlice});
+
+  EXPECT_TRUE(ShouldDecodeFrame(FrameSamplingMode::kAll, key_frame));
+  EXPECT_TRUE(ShouldDecodeFrame(FrameSamplingMode::kAll, reference_frame));
+  EXPECT_TRUE(ShouldDecodeFrame(FrameSamplingMode::kAll, non_reference_frame));
+
+  EXPECT_TRUE(
+      ShouldDecodeFrame(FrameSamplingMode::kSkipNonReference, key_frame));
+  EXPECT_TRUE(
+      ShouldDecodeFrame(FrameSamplingMode::kSkipNonReference, reference_frame));
+  EXPECT_FALSE(ShouldDecodeFrame(FrameSamplingMode::kSkipNonReference,
+                                 non_reference_frame));
+
+  EXPECT_TRUE(ShouldDecodeFrame(FrameSamplingMode::kKeyFramesOnly, key_frame));
+  EXPECT_FALSE(
+      ShouldDecodeFrame(FrameSamplingMode::kKeyFramesOnly, reference_frame));
+  EXPECT_FALSE(ShouldDecodeFrame(FrameSamplingMode::kKeyFramesOnly,
+                                 non_reference_frame));
+}
+
+}  // namespace visionai
@@ -0,0 +1,176 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/algorithms/media/util/pixel_conversion.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace visionai {
+
+namespace {
+
+// BT.601 luma weights in 14-bit fixed point.
+constexpr int kGrayShift = 14;
+constexpr int kRedToGray = 4899;
+constexpr int kGreenToGray = 9617;
+constexpr int kBlueToGray = 1868;
+
+// Limited range BT.601 YUV to RGB coefficients in 8-bit fixed point.
+constexpr int kYuvShift = 8;
+constexpr int kYScale = 298;
+constexpr int kVToRed = 409;
+constexpr int kUToGreen = -100;
+constexpr int kVToGreen = -208;
+constexpr int kUToBlue = 516;
+
+// The number of pixels that the YUV conversion processes at a time.
+constexpr int kYuvChunkSize = 256;
+
+inline uint8_t Clamp(int value) {
+  return static_cast<uint8_t>(std::min(255, std::max(0, value)));
+}
+
+// Converts a row of YUV 4:2:0 pixels into RGB.
+//
+// The chroma samples of the row begin at `u` and `v`, and are
+// `kChromaPixelStride` bytes apart.
+//
+// The chroma terms are first upsampled into per pixel arrays, so that both
+// passes only have fixed access patterns that the compiler can vectorize.
+template <int kChromaPixelStride>
+void YuvRowToRgb(const uint8_t* __restrict y, const uint8_t* __restrict u,
+                 const uint8_t* __restrict v, uint8_t* __restrict dst,
+                 int width) {
+  int red[kYuvChunkSize];
+  int green[kYuvChunkSize];
+  int blue[kYuvChunkSize];
+  // Chunks begin on even pixels, so that they hold whole chroma samples.
+  for (int begin = 0; begin < width; begin += kYuvChunkSize) {
+    int size = std::min(kYuvChunkSize, width - begin);
+    const uint8_t* chunk_u = u + begin / 2 * kChromaPixelStride;
+    const uint8_t* chunk_v = v + begin / 2 * kChromaPixelStride;
+    // Each chroma sample covers two pixels of the row.
+    int num_samples = (size + 1) / 2;
+    for (int i = 0; i < num_samples; ++i) {
+      int d = chunk_u[i * kChromaPixelStride] - 128;
+      int e = chunk_v[i * kChromaPixelStride] - 128;
+      red[2 * i] = red[2 * i + 1] = kVToRed * e;
+      green[2 * i] = green[2 * i + 1] = kUToGreen * d + kVToGreen * e;
+      blue[2 * i] = blue[2 * i + 1] = kUToBlue * d;
+    }
+
+    const uint8_t* chunk_y = y + begin;
+    uint8_t* chunk_dst = dst + 3 * begin;
+    for (int j = 0; j < size; ++j) {
+      int luma = kYScale * (chunk_y[j] - 16) + (1 << (kYuvShift - 1));
+      chunk_dst[3 * j] = Clamp((luma + red[j]) >> kYuvShift);
+      chunk_dst[3 * j + 1] = Clamp((luma + green[j]) >> kYuvShift);
+      chunk_dst[3 * j + 2] = Clamp((luma + blue[j]) >> kYuvShift);
+    }
+  }
+}
+
+}  // namespace
+
+void CopyRows(const uint8_t* src, int src_stride, uint8_t* dst, int dst_stride,
+              int row_size, int height) {
+  if (height <= 0 || row_size <= 0) {
+    return;
+  }
+  // Copy the whole image at once when there is no padding at all.
+  if (src_stride == row_size && dst_stride == row_size) {
+    std::memcpy(dst, src, static_cast<size_t>(row_size) * height);
+    return;
+  }
+  for (int i = 0; i < height; ++i) {
+    std::memcpy(dst + static_cast<size_t>(dst_stride) * i,
+                src + static_cast<size_t>(src_stride) * i, row_size);
+  }
+}
+
+void PackPixels(const uint8_t* src, int src_stride, int src_pixel_stride,
+                uint8_t* dst, int dst_stride, int width, int height,
+                int components) {
+  if (src_pixel_stride == components) {
+    CopyRows(src, src_stride, dst, dst_stride, width * components, height);
+    return;
+  }
+  for (int i = 0; i < height; ++i) {
+    const uint8_t* src_row = src + static_cast<size_t>(src_stride) * i;
+    uint8_t* dst_row = dst + static_cast<size_t>(dst_stride) * i;
+    // Specialize the common case so that the compiler knows the pixel sizes.
+    if (components == 3 && src_pixel_stride == 4) {
+      for (int j = 0; j < width; ++j) {
+        dst_row[3 * j] = src_row[4 * j];
+        dst_row[3 * j + 1] = src_row[4 * j + 1];
+        dst_row[3 * j + 2] = src_row[4 * j + 2];
+      }
+      continue;
+    }
+    for (int j = 0; j < width; ++j) {
+      std::memcpy(dst_row + components * j, src_row + src_pixel_stride * j,
+                  components);
+    }
+  }
+}
+
+void SwapRedAndBlue(const uint8_t* src, int src_stride, uint8_t* dst,
+                    int dst_stride, int width, int height) {
+  for (int i = 0; i < height; ++i) {
+    const uint8_t* src_row = src + static_cast<size_t>(src_stride) * i;
+    uint8_t* dst_row = dst + static_cast<size_t>(dst_stride) * i;
+    for (int j = 0; j < width; ++j) {
+      // Read the whole pixel first, so that this also works in place.
+      uint8_t first = src_row[3 * j];
+      uint8_t second = src_row[3 * j + 1];
+      uint8_t third = src_row[3 * j + 2];
+      dst_row[3 * j] = third;
+      dst_row[3 * j + 1] = second;
+      dst_row[3 * j + 2] = first;
+    }
+  }
+}
+
+void RgbToGray(const uint8_t* src, int src_stride, uint8_t* dst, int dst_stride,
+               int width, int height) {
+  for (int i = 0; i < height; ++i) {
+    const uint8_t* src_row = src + static_cast<size_t>(src_stride) * i;
+    uint8_t* dst_row = dst + static_cast<size_t>(dst_stride) * i;
+    for (int j = 0; j < width; ++j) {
+      int gray = kRedToGray * src_row[3 * j] +
+                 kGreenToGray * src_row[3 * j + 1] +
+                 kBlueToGray * src_row[3 * j + 2] + (1 << (kGrayShift - 1));
+      // The weights sum up to 1 << kGrayShift, so this never exceeds 255.
+      dst_row[j] = static_cast<uint8_t>(gray >> kGrayShift);
+    }
+  }
+}
+
+void Nv12ToRgb(const uint8_t* y, int y_stride, const uint8_t* uv, int uv_stride,
+               uint8_t* dst, int dst_stride, int width, int height) {
+  for (int i = 0; i < height; ++i) {
+    const uint8_t* uv_row = uv + static_cast<size_t>(uv_stride) * (i / 2);
+    YuvRowToRgb</*kChromaPixelStride=*/2>(
+        y + static_cast<size_t>(y_stride) * i, uv_row, uv_row + 1,
+        dst + static_cast<size_t>(dst_stride) * i, width);
+  }
+}
+
+void I420ToRgb(const uint8_t* y, int y_stride, const uint8_t* u, int u_stride,
+               const uint8_t* v, int v_stride, uint8_t* dst, int dst_stride,
+               int width, int height) {
+  for (int i = 0; i < height; ++i) {
+    YuvRowToRgb</*kChromaPixelStride=*/1>(
+        y + static_cast<size_t>(y_stride) * i,
+        u + static_cast<size_t>(u_stride) * (i / 2),
+        v + static_cast<size_t>(v_stride) * (i / 2),
+        dst + static_cast<size_t>(dst_stride) * i, width);
+  }
+}
+
+}  // namespace visionai
@@ -0,0 +1,73 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef THIRD_PARTY_VISIONAI_ALGORITHMS_MEDIA_UTIL_PIXEL_CONVERSION_H_
+#define THIRD_PARTY_VISIONAI_ALGORITHMS_MEDIA_UTIL_PIXEL_CONVERSION_H_
+
+#include <cstdint>
+
+namespace visionai {
+
+// Pixel format conversions and row repacking for 8-bit images.
+//
+// All of the functions take the address of the first row of each image along
+// with its stride, i.e. the distance in bytes between the beginnings of two
+// consecutive rows. Strides may exceed the size of a row to account for
+// padding, which is never read nor written.
+//
+// The inner loops are branch free and have fixed access patterns, so that the
+// compiler vectorizes them without any intrinsics. The interleaved RGB
+// accesses need byte shuffles, i.e. NEON or at least SSSE3 on x86.
+
+// Copies `height` rows of `row_size` bytes each from `src` to `dst`.
+//
+// This strips the row padding when `dst_stride` is `row_size`, and adds it
+// when `src_stride` is `row_size`. The padding of `dst` is left untouched.
+void CopyRows(const uint8_t* src, int src_stride, uint8_t* dst, int dst_stride,
+              int row_size, int height);
+
+// Copies a `width` x `height` image of `components` bytes per pixel from
+// `src`, whose pixels begin every `src_pixel_stride` bytes, into the tightly
+// packed pixels of `dst`.
+//
+// E.g. this drops the padding byte of RGBx pixels with `components` 3 and
+// `src_pixel_stride` 4.
+void PackPixels(const uint8_t* src, int src_stride, int src_pixel_stride,
+                uint8_t* dst, int dst_stride, int width, int height,
+                int components);
+
+// Converts a `width` x `height` RGB image into BGR, or vice versa.
+//
+// `src` and `dst` may be the same image to convert in place.
+void SwapRedAndBlue(const uint8_t* src, int src_stride, uint8_t* dst,
+                    int dst_stride, int width, int height);
+
+// Converts a `width` x `height` RGB image into grayscale.
+//
+// This uses the BT.601 luma weights in 14-bit fixed point. The result may
+// differ by one from that of OpenCV's `cv::COLOR_RGB2GRAY` on some pixels,
+// depending on the precision of the OpenCV build.
+void RgbToGray(const uint8_t* src, int src_stride, uint8_t* dst, int dst_stride,
+               int width, int height);
+
+// Converts a `width` x `height` NV12 image into RGB.
+//
+// NV12 has a full resolution luma plane followed by a plane of interleaved U
+// and V samples subsampled by two in both directions. The conversion assumes
+// limited range BT.601, as produced by most video decoders.
+void Nv12ToRgb(const uint8_t* y, int y_stride, const uint8_t* uv, int uv_stride,
+               uint8_t* dst, int dst_stride, int width, int height);
+
+// Converts a `width` x `height` I420 image into RGB.
+//
+// I420 is the same as NV12, except that U and V each have their own plane.
+void I420ToRgb(const uint8_t* y, int y_stride, const uint8_t* u, int u_stride,
+               const uint8_t* v, int v_stride, uint8_t* dst, int dst_stride,
+               int width, int height);
+
+}  // namespace visionai
+
+#endif  // THIRD_PARTY_VISIONAI_ALGORITHMS_MEDIA_UTIL_PIXEL_CONVERSION_H_
@@ -0,0 +1,133 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <cstdint>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "visionai/algorithms/media/util/pixel_conversion.h"
+
+namespace visionai {
+namespace {
+
+// The benchmarked frame sizes, as {width, height}: 720p, 1080p and 4K.
+void FrameSizes(benchmark::internal::Benchmark* benchmark) {
+  benchmark->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
+}
+
+// GStreamer pads the rows of raw video up to a multiple of 4 bytes.
+int PaddedStride(int row_size) { return (row_size + 3) & ~3; }
+
+void SetBytesProcessed(benchmark::State& state, int64_t bytes_per_frame) {
+  state.SetBytesProcessed(state.iterations() * bytes_per_frame);
+}
+
+void BM_CopyRowsStripPadding(benchmark::State& state) {
+  // An odd width, so that the rows are actually padded.
+  int width = state.range(0) + 1;
+  int height = state.range(1);
+  int row_size = 3 * width;
+  int stride = PaddedStride(row_size);
+  std::vector<uint8_t> src(stride * height, 1);
+  std::vector<uint8_t> dst(row_size * height);
+  for (auto _ : state) {
+    CopyRows(src.data(), stride, dst.data(), row_size, row_size, height);
+    benchmark::DoNotOptimize(dst.data());
+  }
+  SetBytesProcessed(state, static_cast<int64_t>(row_size) * height);
+}
+BENCHMARK(BM_CopyRowsStripPadding)->Apply(FrameSizes);
+
+void BM_CopyRowsAddPadding(benchmark::State& state) {
+  int width = state.range(0) + 1;
+  int height = state.range(1);
+  int row_size = 3 * width;
+  int stride = PaddedStride(row_size);
+  std::vector<uint8_t> src(row_size * height, 1);
+  std::vector<uint8_t> dst(stride * height);
+  for (auto _ : state) {
+    CopyRows(src.data(), row_size, dst.data(), stride, row_size, height);
+    benchmark::DoNotOptimize(dst.data());
+  }
+  SetBytesProcessed(state, static_cast<int64_t>(row_size) * height);
+}
+BENCHMARK(BM_CopyRowsAddPadding)->Apply(FrameSizes);
+
+void BM_PackRgbxPixels(benchmark::State& state) {
+  int width = state.range(0);
+  int height = state.range(1);
+  std::vector<uint8_t> src(4 * width * height, 1);
+  std::vector<uint8_t> dst(3 * width * height);
+  for (auto _ : state) {
+    PackPixels(src.data(), 4 * width, 4, dst.data(), 3 * width, width, height,
+               3);
+    benchmark::DoNotOptimize(dst.data());
+  }
+  SetBytesProcessed(state, static_cast<int64_t>(3) * width * height);
+}
+BENCHMARK(BM_PackRgbxPixels)->Apply(FrameSizes);
+
+void BM_SwapRedAndBlue(benchmark::State& state) {
+  int width = state.range(0);
+  int height = state.range(1);
+  std::vector<uint8_t> image(3 * width * height, 1);
+  for (auto _ : state) {
+    SwapRedAndBlue(image.data(), 3 * width, image.data(), 3 * width, width,
+                   height);
+    benchmark::DoNotOptimize(image.data());
+  }
+  SetBytesProcessed(state, static_cast<int64_t>(3) * width * height);
+}
+BENCHMARK(BM_SwapRedAndBlue)->Apply(FrameSizes);
+
+void BM_RgbToGray(benchmark::State& state) {
+  int width = state.range(0);
+  int height = state.range(1);
+  std::vector<uint8_t> src(3 * width * height, 1);
+  std::vector<uint8_t> dst(width * height);
+  for (auto _ : state) {
+    RgbToGray(src.data(), 3 * width, dst.data(), width, width, height);
+    benchmark::DoNotOptimize(dst.data());
+  }
+  SetBytesProcessed(state, static_cast<int64_t>(3) * width * height);
+}
+BENCHMARK(BM_RgbToGray)->Apply(FrameSizes);
+
+void BM_Nv12ToRgb(benchmark::State& state) {
+  int width = state.range(0);
+  int height = state.range(1);
+  std::vector<uint8_t> y(width * height, 100);
+  std::vector<uint8_t> uv(width * height / 2, 120);
+  std::vector<uint8_t> dst(3 * width * height);
+  for (auto _ : state) {
+    Nv12ToRgb(y.data(), width, uv.data(), width, dst.data(), 3 * width, width,
+              height);
+    benchmark::DoNotOptimize(dst.data());
+  }
+  SetBytesProcessed(state, static_cast<int64_t>(3) * width * height);
+}
+BENCHMARK(BM_Nv12ToRgb)->Apply(FrameSizes);
+
+void BM_I420ToRgb(benchmark::State& state) {
+  int width = state.range(0);
+  int height = state.range(1);
+  std::vector<uint8_t> y(width * height, 100);
+  std::vector<uint8_t> u(width * height / 4, 120);
+  std::vector<uint8_t> v(width * height / 4, 140);
+  std::vector<uint8_t> dst(3 * width * height);
+  for (auto _ : state) {
+    I420ToRgb(y.data(), width, u.data(), width / 2, v.data(), width / 2,
+              dst.data(), 3 * width, width, height);
+    benchmark::DoNotOptimize(dst.data());
+  }
+  SetBytesProcessed(state, static_cast<int64_t>(3) * width * height);
+}
+BENCHMARK(BM_I420ToRgb)->Apply(FrameSizes);
+
+}  // namespace
+}  // namespace visionai
+
+BENCHMARK_MAIN();
@@ -0,0 +1,197 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/algorithms/media/util/pixel_conversion.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "opencv4/opencv2/core.hpp"
+#include "opencv4/opencv2/core/mat.hpp"
+#include "opencv4/opencv2/imgproc.hpp"
+
+namespace visionai {
+namespace {
+
+using ::testing::ElementsAre;
+
+// Widths that exercise both the vectorized body and the tails.
+constexpr int kWidths[] = {1, 2, 3, 17, 64, 101};
+constexpr int kHeight = 5;
+
+std::vector<uint8_t> RandomBytes(int n, std::mt19937* rng) {
+  std::uniform_int_distribution<int> distribution(0, 255);
+  std::vector<uint8_t> bytes(n);
+  for (uint8_t& byte : bytes) {
+    byte = distribution(*rng);
+  }
+  return bytes;
+}
+
+TEST(PixelConversionTest, CopyRowsStripsAndAddsPadding) {
+  // Two rows of 3 bytes, padded up to 4.
+  std::vector<uint8_t> padded = {1, 2, 3, 0, 4, 5, 6, 0};
+  std::vector<uint8_t> packed(6);
+  CopyRows(padded.data(), 4, packed.data(), 3, 3, 2);
+  EXPECT_THAT(packed, ElementsAre(1, 2, 3, 4, 5, 6));
+
+  std::vector<uint8_t> repadded(8, 9);
+  CopyRows(packed.data(), 3, repadded.data(), 4, 3, 2);
+  EXPECT_THAT(repadded, ElementsAre(1, 2, 3, 9, 4, 5, 6, 9));
+
+  std::vector<uint8_t> copy(6);
+  CopyRows(packed.data(), 3, copy.data(), 3, 3, 2);
+  EXPECT_EQ(copy, packed);
+}
+
+TEST(PixelConversionTest, PackPixels) {
+  std::vector<uint8_t> rgbx = {1, 2, 3, 0, 4, 5, 6, 0, 7, 8, 9, 0, 0, 0, 0, 0};
+  std::vector<uint8_t> rgb(6);
+  // Two rows of one pixel, 8 bytes apart.
+  PackPixels(rgbx.data(), 8, 4, rgb.data(), 3, 1, 2, 3);
+  EXPECT_THAT(rgb, ElementsAre(1, 2, 3, 7, 8, 9));
+
+  // Two pixels of two components in a 5 byte pixel stride.
+  std::vector<uint8_t> wide = {1, 2, 0, 0, 0, 3, 4, 0, 0, 0};
+  std::vector<uint8_t> narrow(4);
+  PackPixels(wide.data(), 10, 5, narrow.data(), 4, 2, 1, 2);
+  EXPECT_THAT(narrow, ElementsAre(1, 2, 3, 4));
+}
+
+TEST(PixelConversionTest, SwapRedAndBlue) {
+  std::mt19937 rng(1);
+  for (int width : kWidths) {
+    int stride = 3 * width + 1;
+    std::vector<uint8_t> rgb = RandomBytes(stride * kHeight, &rng);
+    std::vector<uint8_t> bgr(3 * width * kHeight);
+    SwapRedAndBlue(rgb.data(), stride, bgr.data(), 3 * width, width, kHeight);
+    for (int i = 0; i < kHeight; ++i) {
+      for (int j = 0; j < width; ++j) {
+        const uint8_t* src = &rgb[i * stride + 3 * j];
+        const uint8_t* dst = &bgr[(i * width + j) * 3];
+        ASSERT_THAT(std::vector<uint8_t>(dst, dst + 3),
+                    ElementsAre(src[2], src[1], src[0]))
+            << "width = " << width;
+      }
+    }
+
+    // Swapping twice in place restores the image.
+    std::vector<uint8_t> copy = bgr;
+    SwapRedAndBlue(copy.data(), 3 * width, copy.data(), 3 * width, width,
+                   kHeight);
+    SwapRedAndBlue(copy.data(), 3 * width, copy.data(), 3 * width, width,
+                   kHeight);
+    EXPECT_EQ(copy, bgr);
+  }
+}
+
+TEST(PixelConversionTest, RgbToGray) {
+  std::vector<uint8_t> rgb = {255, 255, 255, 0, 0, 0, 255, 0, 0,
+                              0,   255, 0,   0, 0, 255};
+  std::vector<uint8_t> gray(5);
+  RgbToGray(rgb.data(), 15, gray.data(), 5, 5, 1);
+  EXPECT_THAT(gray, ElementsAre(255, 0, 76, 150, 29));
+
+  std::mt19937 rng(2);
+  for (int width : kWidths) {
+    std::vector<uint8_t> image = RandomBytes(3 * width * kHeight, &rng);
+    std::vector<uint8_t> result(width * kHeight);
+    RgbToGray(image.data(), 3 * width, result.data(), width, width, kHeight);
+    for (int i = 0; i < width * kHeight; ++i) {
+      int expected = (image[3 * i] * 4899 + image[3 * i + 1] * 9617 +
+                      image[3 * i + 2] * 1868 + (1 << 13)) >>
+                     14;
+      ASSERT_EQ(result[i], expected) << "width = " << width;
+    }
+  }
+}
+
+TEST(PixelConversionTest, RgbToGrayIsCloseToOpenCV) {
+  std::mt19937 rng(4);
+  for (int width : kWidths) {
+    std::vector<uint8_t> image = RandomBytes(3 * width * kHeight, &rng);
+    std::vector<uint8_t> result(width * kHeight);
+    RgbToGray(image.data(), 3 * width, result.data(), width, width, kHeight);
+    cv::Mat rgb(kHeight, width, CV_8UC3, image.data());
+    cv::Mat gray;
+    cv::cvtColor(rgb, gray, cv::COLOR_RGB2GRAY);
+    for (int i = 0; i < kHeight; ++i) {
+      for (int j = 0; j < width; ++j) {
+        ASSERT_NEAR(result[i * width + j], gray.at<uint8_t>(i, j), 1)
+            << "width = " << width;
+      }
+    }
+  }
+}
+
+TEST(PixelConversionTest, YuvToRgbColors) {
+  // A 2x2 block for each of white, black and (nominal) red.
+  struct Case {
+    uint8_t y, u, v;
+    std::vector<int> rgb;
+  };
+  for (const Case& c : std::vector<Case>{{235, 128, 128, {255, 255, 255}},
+                                         {16, 128, 128, {0, 0, 0}},
+                                         {81, 90, 240, {255, 0, 0}}}) {
+    std::vector<uint8_t> y(4, c.y);
+    std::vector<uint8_t> uv = {c.u, c.v};
+    std::vector<uint8_t> rgb(12);
+    Nv12ToRgb(y.data(), 2, uv.data(), 2, rgb.data(), 6, 2, 2);
+    for (int i = 0; i < 4; ++i) {
+      for (int k = 0; k < 3; ++k) {
+        EXPECT_NEAR(rgb[3 * i + k], c.rgb[k], 1);
+      }
+    }
+  }
+}
+
+TEST(PixelConversionTest, Nv12AndI420Agree) {
+  std::mt19937 rng(3);
+  for (int width : kWidths) {
+    int chroma_width = (width + 1) / 2;
+    int chroma_height = (kHeight + 1) / 2;
+    int y_stride = width + 3;
+    std::vector<uint8_t> y = RandomBytes(y_stride * kHeight, &rng);
+    std::vector<uint8_t> u = RandomBytes(chroma_width * chroma_height, &rng);
+    std::vector<uint8_t> v = RandomBytes(chroma_width * chroma_height, &rng);
+    std::vector<uint8_t> uv(2 * chroma_width * chroma_height);
+    for (int i = 0; i < chroma_width * chroma_height; ++i) {
+      uv[2 * i] = u[i];
+      uv[2 * i + 1] = v[i];
+    }
+
+    std::vector<uint8_t> from_nv12(3 * width * kHeight);
+    std::vector<uint8_t> from_i420(3 * width * kHeight);
+    Nv12ToRgb(y.data(), y_stride, uv.data(), 2 * chroma_width,
+              from_nv12.data(), 3 * width, width, kHeight);
+    I420ToRgb(y.data(), y_stride, u.data(), chroma_width, v.data(),
+              chroma_width, from_i420.data(), 3 * width, width, kHeight);
+    EXPECT_EQ(from_nv12, from_i420) << "width = " << width;
+
+    // Check the pixels against the floating point definition.
+    for (int i = 0; i < kHeight; ++i) {
+      for (int j = 0; j < width; ++j) {
+        float luma = 1.164 * (y[i * y_stride + j] - 16);
+        float d = u[(i / 2) * chroma_width + j / 2] - 128;
+        float e = v[(i / 2) * chroma_width + j / 2] - 128;
+        float expected[] = {luma + 1.596f * e, luma - 0.391f * d - 0.813f * e,
+                            luma + 2.018f * d};
+        for (int k = 0; k < 3; ++k) {
+          float clamped = std::min(255.0f, std::max(0.0f, expected[k]));
+          ASSERT_NEAR(from_i420[(i * width + j) * 3 + k], clamped, 1.5)
+              << "width = " << width << ", pixel (" << i << ", " << j << ")";
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+}  // namespace visionai
@@ -6,6 +6,8 @@
 
 #include "visionai/algorithms/media/util/type_util.h"
 
+#include <cstdint>
+
 #include "absl/status/status.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_format.h"
@@ -14,6 +16,7 @@ extern "C"{
 }
 #include "third_party/gstreamer/subprojects/gst_plugins_base/gst_libs/gst/video/video.h"
 #include "third_party/gstreamer/subprojects/gstreamer/gst/gst.h"
+#include "visionai/algorithms/media/util/pixel_conversion.h"
 #include "visionai/algorithms/media/util/util.h"
 #include "visionai/types/gstreamer_buffer.h"
 #include "visionai/types/motion_vector.h"
@@ -135,17 +138,10 @@ absl::StatusOr<RawImage> ToRgbRawImage(const GstreamerRawImageInfo& info,
 
   // Slow path to close extra padding.
   RawImage r(info.height, info.width, *format);
-  for (int i = 0; i < info.height; ++i) {
-    int src_row_start = info.rstride * i;
-    int dst_row_start = info.width * info.components * i;
-    for (int j = 0; j < info.width; ++j) {
-      int src_pix_start = src_row_start + info.pstride * j;
-      int dst_pix_start = dst_row_start + info.components * j;
-      for (int k = 0; k < info.components; ++k) {
-        r(dst_pix_start + k) = gstreamer_buffer.data()[src_pix_start + k];
-      }
-    }
-  }
+  PackPixels(reinterpret_cast<const uint8_t*>(gstreamer_buffer.data()),
+             info.rstride, info.pstride, r.data(),
+             info.width * info.components, info.width, info.height,
+             info.components);
   return std::move(r);
 }
 
@@ -180,10 +176,8 @@ absl::StatusOr<GstreamerBuffer> RgbRawImageToGstreamerBuffer(RawImage r) {
   int row_stride = ROUND_UP_4(row_size);
   std::string bytes;
   bytes.resize(row_stride * r.height());
-  for (int i = 0; i < r.height(); ++i) {
-    std::copy(r.data() + row_size * i, r.data() + row_size * (i + 1),
-              const_cast<char*>(bytes.data() + row_stride * i));
-  }
+  CopyRows(r.data(), row_size, reinterpret_cast<uint8_t*>(&bytes[0]),
+           row_stride, row_size, r.height());
   gstreamer_buffer.assign(std::move(bytes));
   return gstreamer_buffer;
 }
@@ -188,6 +188,7 @@ absl::StatusOr<std::unique_ptr<StreamReceiver>> StreamReceiver::Create(
                          ? RandomString(kRandomNameLength)
                          : options.receiver_id;
   stream_receiver->receiver_id_ = receiver_id;
+  stream_receiver->receive_buffer_size_ = options.receive_buffer_size;
 
   if (options.event_id.empty()) {
     EventUpdateReceiver::Options event_update_receiver_options;
@@ -250,7 +251,7 @@ absl::Status StreamReceiver::Receive(Packet* packet) {
   return Receive(absl::InfiniteDuration(), packet);
 }
 
-absl::Status StreamReceiver::Receive(absl::Duration timeout, Packet* packet) {
+absl::Status StreamReceiver::PreparePacketReceiver(absl::Duration timeout) {
   if (event_id_.empty()) {
     VAI_RETURN_IF_ERROR(GetFirstEvent(timeout));
   }
@@ -261,12 +262,30 @@ absl::Status StreamReceiver::Receive(absl::Duration timeout, Packet* packet) {
     packet_receiver_options.channel.stream_id = stream_id_;
     packet_receiver_options.channel.event_id = event_id_;
     packet_receiver_options.lessee = receiver_id_;
+    packet_receiver_options.advanced.receive_buffer_size =
+        receive_buffer_size_;
     VAI_ASSIGN_OR_RETURN(packet_receiver_,
                          PacketReceiver::Create(packet_receiver_options));
   }
+  return absl::OkStatus();
+}
+
+absl::Status StreamReceiver::Receive(absl::Duration timeout, Packet* packet) {
+  VAI_RETURN_IF_ERROR(PreparePacketReceiver(timeout));
   return packet_receiver_->Receive(timeout, packet);
 }
 
+absl::Status StreamReceiver::ReceiveBatch(int max_packets,
+                                          absl::Duration timeout,
+                                          std::vector<Packet>* packets) {
+  if (max_packets <= 0) {
+    return absl::InvalidArgumentError(
+        "The maximum number of packets must be positive.");
+  }
+  VAI_RETURN_IF_ERROR(PreparePacketReceiver(timeout));
+  return packet_receiver_->ReceiveBatch(max_packets, timeout, packets);
+}
+
 // ----------------------------------------------------------------------------
 // Ingest Methods
 // ----------------------------------------------------------------------------
@@ -408,6 +408,12 @@ class StreamReceiver {
     ///
     /// Leave empty to have it be automatically generated.
     std::string receiver_id;
+
+    /// @brief OPTIONAL: The most `Packet`s to buffer ahead of the reads.
+    ///
+    /// A larger buffer lets `ReceiveBatch` return more `Packet`s per call.
+    /// Leave at 0 to buffer a single `Packet`.
+    int receive_buffer_size = 0;
   };
 
   /// @brief Create a readily usable instance of a `StreamReceiver`.
@@ -438,6 +444,21 @@ class StreamReceiver {
   absl::Status Receive(Packet* packet);
   absl::Status Receive(absl::Duration timeout, Packet* packet);
 
+  /// @brief Receive all of the available `Packet`s from a stream, up to
+  ///        `max_packets`.
+  ///
+  /// This behaves as the second overload of `Receive`, except that on
+  /// success, `*packets` is replaced with every `Packet` that is buffered once
+  /// the first one has arrived, up to `max_packets`, in the order of arrival.
+  /// This saves a call per `Packet` to the consumers that process them in
+  /// batches. On any error, `*packets` is left unchanged.
+  ///
+  /// `max_packets` must be positive. Set `receive_buffer_size` to at least
+  /// `max_packets` for the batches to fill up.
+  ///
+  absl::Status ReceiveBatch(int max_packets, absl::Duration timeout,
+                            std::vector<Packet>* packets);
+
   // Copy-control members.
   //
   // Do not use the constructors directly. Use `Create` instead.
@@ -451,11 +472,13 @@ class StreamReceiver {
   std::string stream_id_;
   std::string receiver_id_;
   std::string event_id_;
+  int receive_buffer_size_ = 0;
 
   std::unique_ptr<EventUpdateReceiver> event_update_receiver_ = nullptr;
   std::unique_ptr<PacketReceiver> packet_receiver_ = nullptr;
 
   absl::Status GetFirstEvent(absl::Duration timeout);
+  absl::Status PreparePacketReceiver(absl::Duration timeout);
 };
 
 /// @}
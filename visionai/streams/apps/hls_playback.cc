@@ -29,16 +29,50 @@
 #include "visionai/streams/apps/hls_playback.h"
 
 #include <memory>
+#include <string>
 
 #include "absl/functional/bind_front.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "visionai/streams/apps/util/event_loop_runner.h"
+#include "visionai/streams/apps/util/multi_stream_runner.h"
 #include "visionai/streams/apps/util/packet_loop_runner.h"
 #include "visionai/streams/client/event_update_receiver.h"
+#include "visionai/streams/client/packet_receiver.h"
 #include "visionai/streams/plugins/event_writers/hls_event_writer.h"
+#include "visionai/util/file_helpers.h"
+#include "visionai/util/file_path.h"
 
 namespace visionai {
 
 absl::Status HLSPlayback::Run() {
+  PacketReceiver::Options packet_receiver_options;
+  packet_receiver_options.cluster_selection = options_.cluster_selection;
+  if (!options_.streaming_server_addr.empty()) {
+    packet_receiver_options.cluster_selection.set_use_insecure_channel(true);
+    packet_receiver_options.cluster_selection.set_cluster_endpoint(
+        options_.streaming_server_addr);
+  }
+  packet_receiver_options.lessee =
+      absl::StrCat(options_.receiver_id, "-packet-receiver");
+  packet_receiver_options.receive_mode = "eager";
+  // Connect once for the packets of all of the streams.
+  PrepareSharedConnection(packet_receiver_options);
+
+  MultiStreamRunner::Options runner_options;
+  runner_options.stream_ids = options_.stream_ids;
+  runner_options.event_loop_runner_factory =
+      [this, &packet_receiver_options](const std::string& stream_id) {
+        return CreateStreamRunner(stream_id, packet_receiver_options);
+      };
+  MultiStreamRunner runner(runner_options);
+  return runner.Run();
+}
+
+absl::StatusOr<std::unique_ptr<EventLoopRunner>>
+HLSPlayback::CreateStreamRunner(
+    const std::string& stream_id,
+    const PacketReceiver::Options& packet_receiver_options) {
   EventUpdateReceiver::Options event_update_receiver_options;
   event_update_receiver_options.cluster_selection = options_.cluster_selection;
   if (!options_.streaming_server_addr.empty()) {
@@ -47,7 +81,7 @@ absl::Status HLSPlayback::Run() {
     event_update_receiver_options.cluster_selection.set_cluster_endpoint(
         options_.streaming_server_addr);
   }
-  event_update_receiver_options.stream_id = options_.stream_id;
+  event_update_receiver_options.stream_id = stream_id;
   event_update_receiver_options.receiver = options_.receiver_id;
   event_update_receiver_options.starting_logical_offset = "most-recent";
   event_update_receiver_options.fallback_starting_offset = "end";
@@ -55,23 +89,20 @@ absl::Status HLSPlayback::Run() {
   EventReceiverFactory event_receiver_factory =
       absl::bind_front(EventUpdateReceiver::Create);
 
-  PacketReceiver::Options packet_receiver_options;
-  packet_receiver_options.cluster_selection = options_.cluster_selection;
-  if (!options_.streaming_server_addr.empty()) {
-    packet_receiver_options.cluster_selection.set_use_insecure_channel(true);
-    packet_receiver_options.cluster_selection.set_cluster_endpoint(
-        options_.streaming_server_addr);
-  }
-  packet_receiver_options.channel.stream_id = options_.stream_id;
-  packet_receiver_options.lessee =
-      absl::StrCat(options_.receiver_id, "-packet-receiver");
-  packet_receiver_options.receive_mode = "eager";
+  PacketReceiver::Options stream_packet_receiver_options =
+      packet_receiver_options;
+  stream_packet_receiver_options.channel.stream_id = stream_id;
 
   PacketReceiverFactory packet_receiver_factory =
       absl::bind_front(PacketReceiver::Create);
 
   HLSEventWriter::Options event_writer_options;
   event_writer_options.local_dir = options_.local_dir;
+  if (options_.stream_ids.size() > 1) {
+    event_writer_options.local_dir =
+        file::JoinPath(options_.local_dir, stream_id);
+    VAI_RETURN_IF_ERROR(RecursivelyCreateDir(event_writer_options.local_dir));
+  }
   event_writer_options.max_files = options_.max_files;
   event_writer_options.target_duration_in_sec = options_.target_duration_in_sec;
   event_writer_options.labels.project_id =
@@ -80,7 +111,7 @@ absl::Status HLSPlayback::Run() {
       options_.cluster_selection.location_id();
   event_writer_options.labels.cluster_id =
       options_.cluster_selection.cluster_id();
-  event_writer_options.labels.stream_id = options_.stream_id;
+  event_writer_options.labels.stream_id = stream_id;
   EventWriterFactory event_writer_factory =
       [=](const std::string& event_id, OffsetCommitCallback commit_callback)
       -> absl::StatusOr<std::shared_ptr<EventWriter>> {
@@ -94,9 +125,8 @@ absl::Status HLSPlayback::Run() {
   runner_options.event_receiver_factory = event_receiver_factory;
   runner_options.event_receiver_options = event_update_receiver_options;
   runner_options.packet_receiver_factory = packet_receiver_factory;
-  runner_options.packet_receiver_options = packet_receiver_options;
-  auto runner = CreateEventLoopRunner(runner_options);
-  return runner->Run();
+  runner_options.packet_receiver_options = stream_packet_receiver_options;
+  return CreateEventLoopRunner(runner_options);
 }
 
 std::unique_ptr<EventLoopRunner> HLSPlayback::CreateEventLoopRunner(
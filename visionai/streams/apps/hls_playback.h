@@ -29,11 +29,15 @@
 #ifndef THIRD_PARTY_VISIONAI_STREAMS_APPS_HLS_PLAYBACK_H_
 #define THIRD_PARTY_VISIONAI_STREAMS_APPS_HLS_PLAYBACK_H_
 
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "visionai/proto/cluster_selection.pb.h"
 #include "visionai/streams/apps/util/event_loop_runner.h"
+#include "visionai/streams/client/packet_receiver.h"
 #include "visionai/streams/plugins/event_writers/hls_event_writer.h"
 #include "visionai/util/status/status_macros.h"
 
@@ -51,8 +55,12 @@ class HLSPlayback {
     //
     // The information to identify the cluster.
     ClusterSelection cluster_selection;
-    // The stream id.
-    std::string stream_id;
+    // The ids of the streams to serve.
+    //
+    // All of the streams are served by this process over shared connections.
+    // A stream that fails is restarted on its own, without disrupting the
+    // others.
+    std::vector<std::string> stream_ids;
     // The receiver_id.
     // The lessee of the EventUpdateReceiver will be "{receiver_id}"" and the
     // lessee of the PacketReceiver will be "{receiver_id}-packet-receiver".
@@ -61,6 +69,9 @@ class HLSPlayback {
     // HLS Configs.
     //
     // The local directory to store the HLS playlist and video segments.
+    //
+    // With more than one stream, each stream is stored in the subdirectory
+    // named after its id.
     std::string local_dir;
     // The maximum number of video files at any time.
     int max_files;
@@ -77,6 +88,12 @@ class HLSPlayback {
  private:
   Options options_;
 
+  // Creates the `EventLoopRunner` of the stream `stream_id`, whose packet
+  // receivers connect through `packet_receiver_options`.
+  absl::StatusOr<std::unique_ptr<EventLoopRunner>> CreateStreamRunner(
+      const std::string& stream_id,
+      const PacketReceiver::Options& packet_receiver_options);
+
   virtual std::unique_ptr<EventLoopRunner> CreateEventLoopRunner(
       EventLoopRunner::Options);
 
@@ -26,6 +26,9 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include <string>
+#include <vector>
+
 #include "base/init_google.h"
 #include "absl/flags/flag.h"
 #include "absl/flags/parse.h"
@@ -41,7 +44,8 @@
 #include "visionai/util/telemetry/metrics/prometheus_metrics_recorder.h"
 #include "visionai/util/status/status_macros.h"
 
-ABSL_FLAG(std::string, stream_name, "", "Stream Name");
+ABSL_FLAG(std::vector<std::string>, stream_name, {},
+          "Comma-separated names of the streams to serve, all in one cluster");
 ABSL_FLAG(std::string, service_endpoint, "",
           "The service endpoint to AIS control plane");
 ABSL_FLAG(std::string, output_dir, "storage",
@@ -62,23 +66,21 @@ ABSL_FLAG(int, metrics_port, 9090, "The port to expose metrics to Prometheus");
 namespace visionai {
 
 absl::StatusOr<HLSPlayback::Options> ConstructHLSPlaybackOptions() {
-  // TODO: Update the ParseStreamName to return a struct.
-  VAI_ASSIGN_OR_RETURN(auto resource_ids,
-                   ParseStreamName(absl::GetFlag(FLAGS_stream_name)));
-  std::string project_id = resource_ids[0];
-  std::string location_id = resource_ids[1];
-  std::string cluster_id = resource_ids[2];
-  std::string stream_id = resource_ids[3];
+  VAI_ASSIGN_OR_RETURN(
+      auto streams,
+      ParseStreamNamesInCluster(absl::GetFlag(FLAGS_stream_name)));
 
   HLSPlayback::Options options;
-  options.cluster_selection.set_project_id(project_id);
-  options.cluster_selection.set_location_id(location_id);
-  options.cluster_selection.set_cluster_id(cluster_id);
+  options.cluster_selection.set_project_id(streams[0].project_id);
+  options.cluster_selection.set_location_id(streams[0].location_id);
+  options.cluster_selection.set_cluster_id(streams[0].cluster_id);
   // TODO(b/250697961): Remove the usage of control plane endpoint.
   // Can connect to data plane server endpoint directly.
   options.cluster_selection.set_service_endpoint(
       absl::GetFlag(FLAGS_service_endpoint));
-  options.stream_id = stream_id;
+  for (const auto& stream : streams) {
+    options.stream_ids.push_back(stream.stream_id);
+  }
   options.receiver_id = absl::GetFlag(FLAGS_receiver_id);
   options.streaming_server_addr =
       absl::GetFlag(FLAGS_k8s_streaming_server_addr);
@@ -264,7 +264,7 @@ TEST_F(HLSPlaybackTest, SuccessfulExecution) {
   options.streaming_server_addr = local_server_address_;
   options.cluster_selection = TestClusterSelection();
   options.receiver_id = kTestReceiverId;
-  options.stream_id = kTestStreamId;
+  options.stream_ids = {kTestStreamId};
   options.local_dir = local_dir_;
   options.target_duration_in_sec = kHLSTargetVideoDurationSeconds;
   options.max_files = kHLSMaxFiles;
@@ -6,17 +6,63 @@
 
 #include "visionai/streams/apps/storage_exporter.h"
 
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
 #include "absl/functional/bind_front.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
 #include "absl/synchronization/notification.h"
 #include "visionai/streams/apps/util/event_loop_runner.h"
+#include "visionai/streams/apps/util/multi_stream_runner.h"
 #include "visionai/streams/apps/util/packet_loop_runner.h"
 #include "visionai/streams/client/event_update_receiver.h"
+#include "visionai/streams/client/packet_receiver.h"
 #include "visionai/streams/packet/packet.h"
 #include "visionai/streams/plugins/event_writers/warehouse/warehouse_event_writer.h"
 
 namespace visionai {
 
 absl::Status StorageExporter::Export() {
+  if (options_.asset_names.size() != options_.stream_ids.size()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Given %d asset names for %d streams; expected one for each stream.",
+        options_.asset_names.size(), options_.stream_ids.size()));
+  }
+  absl::flat_hash_map<std::string, std::string> asset_names;
+  for (size_t i = 0; i < options_.stream_ids.size(); ++i) {
+    asset_names[options_.stream_ids[i]] = options_.asset_names[i];
+  }
+
+  PacketReceiver::Options packet_receiver_opts;
+  packet_receiver_opts.cluster_selection = options_.cluster_selection;
+  if (!options_.streaming_server_addr.empty()) {
+    packet_receiver_opts.cluster_selection.set_use_insecure_channel(true);
+    packet_receiver_opts.cluster_selection.set_cluster_endpoint(
+        options_.streaming_server_addr);
+  }
+  packet_receiver_opts.lessee = options_.receiver_id + "-packet-receiver";
+  packet_receiver_opts.receive_mode = "controlled";
+  // Connect once for the packets of all of the streams.
+  PrepareSharedConnection(packet_receiver_opts);
+
+  MultiStreamRunner::Options runner_options;
+  runner_options.stream_ids = options_.stream_ids;
+  runner_options.event_loop_runner_factory =
+      [&](const std::string& stream_id)
+      -> absl::StatusOr<std::unique_ptr<EventLoopRunner>> {
+    return CreateStreamRunner(stream_id, asset_names.at(stream_id),
+                              packet_receiver_opts);
+  };
+  MultiStreamRunner runner(runner_options);
+  return runner.Run();
+}
+
+std::unique_ptr<EventLoopRunner> StorageExporter::CreateStreamRunner(
+    const std::string& stream_id, const std::string& asset_name,
+    const PacketReceiver::Options& packet_receiver_opts) {
   EventUpdateReceiver::Options event_receiver_opts;
   event_receiver_opts.cluster_selection = options_.cluster_selection;
   if (!options_.streaming_server_addr.empty()) {
@@ -24,23 +70,15 @@ absl::Status StorageExporter::Export() {
     event_receiver_opts.cluster_selection.set_cluster_endpoint(
         options_.streaming_server_addr);
   }
-  event_receiver_opts.stream_id = options_.stream_id;
+  event_receiver_opts.stream_id = stream_id;
   event_receiver_opts.receiver = options_.receiver_id;
   event_receiver_opts.starting_logical_offset = "most-recent";
   event_receiver_opts.fallback_starting_offset = "end";
 
   EventReceiverFactory event_receiver_factory =
       absl::bind_front(EventUpdateReceiver::Create);
-  PacketReceiver::Options packet_receiver_opts;
-  packet_receiver_opts.cluster_selection = options_.cluster_selection;
-  if (!options_.streaming_server_addr.empty()) {
-    packet_receiver_opts.cluster_selection.set_use_insecure_channel(true);
-    packet_receiver_opts.cluster_selection.set_cluster_endpoint(
-        options_.streaming_server_addr);
-  }
-  packet_receiver_opts.channel.stream_id = options_.stream_id;
-  packet_receiver_opts.lessee = options_.receiver_id + "-packet-receiver";
-  packet_receiver_opts.receive_mode = "controlled";
+  PacketReceiver::Options stream_packet_receiver_opts = packet_receiver_opts;
+  stream_packet_receiver_opts.channel.stream_id = stream_id;
 
   PacketReceiverFactory packet_receiver_factory =
       absl::bind_front(PacketReceiver::Create);
@@ -50,8 +88,8 @@ absl::Status StorageExporter::Export() {
       -> absl::StatusOr<std::shared_ptr<EventWriter>> {
     WarehouseEventWriter::Options event_writer_opts;
     event_writer_opts.warehouse_server_address = options_.mwh_server_addr;
-    event_writer_opts.asset_name = options_.asset_name;
-    event_writer_opts.stream_id = options_.stream_id;
+    event_writer_opts.asset_name = asset_name;
+    event_writer_opts.stream_id = stream_id;
     event_writer_opts.temp_video_dir = options_.temp_video_dir;
     event_writer_opts.labels.project_id =
         options_.cluster_selection.project_id();
@@ -59,7 +97,7 @@ absl::Status StorageExporter::Export() {
         options_.cluster_selection.location_id();
     event_writer_opts.labels.cluster_id =
         options_.cluster_selection.cluster_id();
-    event_writer_opts.labels.stream_id = options_.stream_id;
+    event_writer_opts.labels.stream_id = stream_id;
     event_writer_opts.h264_only = options_.h264_only;
     event_writer_opts.h264_mux_only = options_.h264_mux_only;
     event_writer_opts.submission_callback = [=](const VideoPartition& file) {
@@ -76,8 +114,8 @@ absl::Status StorageExporter::Export() {
   runner_options.event_receiver_factory = event_receiver_factory;
   runner_options.event_receiver_options = event_receiver_opts;
   runner_options.packet_receiver_factory = packet_receiver_factory;
-  runner_options.packet_receiver_options = packet_receiver_opts;
-  EventLoopRunner runner(runner_options);
-  return runner.Run();
+  runner_options.packet_receiver_options = stream_packet_receiver_opts;
+  runner_options.max_concurrent_events = options_.max_concurrent_events;
+  return std::make_unique<EventLoopRunner>(runner_options);
 }
 }  // namespace visionai
\ No newline at end of file
@@ -8,10 +8,14 @@
 #define THIRD_PARTY_VISIONAI_STREAMS_APPS_STORAGE_EXPORTER_H_
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "visionai/proto/cluster_selection.pb.h"
+#include "visionai/streams/apps/util/event_loop_runner.h"
+#include "visionai/streams/client/packet_receiver.h"
 #include "visionai/util/status/status_macros.h"
 
 namespace visionai {
@@ -30,14 +34,19 @@ class StorageExporter {
     //
     // The information to identify the cluster.
     ClusterSelection cluster_selection;
-    // The stream id.
-    std::string stream_id;
+    // The ids of the streams to export.
+    //
+    // All of the streams are exported by this process over shared
+    // connections. A stream that fails is restarted on its own, without
+    // disrupting the others.
+    std::vector<std::string> stream_ids;
     // The receiver_id.
     // The lessee of the EventUpdateReceiver will be "{receiver_id}"" and the
     // lessee of the PacketReceiver will be "{receiver_id}-packet-receiver".
     std::string receiver_id;
-    // The MWH asset name to ingest into.
-    std::string asset_name;
+    // The MWH asset names to ingest into, one for each of `stream_ids` in the
+    // same order.
+    std::vector<std::string> asset_names;
 
     // Video export configs.
     //
@@ -47,6 +56,8 @@ class StorageExporter {
     bool h264_mux_only;
     // The directory to store the temporary local video files.
     std::string temp_video_dir;
+    // The most events to export at the same time.
+    int max_concurrent_events = 1;
   };
 
   StorageExporter(const Options& options) : options_(options) {}
@@ -58,6 +69,13 @@ class StorageExporter {
 
  private:
   Options options_;
+
+  // Creates the `EventLoopRunner` that exports the stream `stream_id` into
+  // the asset `asset_name`, whose packet receivers connect through
+  // `packet_receiver_opts`.
+  std::unique_ptr<EventLoopRunner> CreateStreamRunner(
+      const std::string& stream_id, const std::string& asset_name,
+      const PacketReceiver::Options& packet_receiver_opts);
 };
 
 }  // namespace visionai
@@ -6,6 +6,8 @@
 
 #include <cstdlib>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "base/commandlineflags.h"
 #include "base/init_google.h"
@@ -22,8 +24,10 @@
 #include "visionai/util/telemetry/metrics/prometheus_metrics_recorder.h"
 #include "visionai/util/status/status_macros.h"
 
-ABSL_FLAG(std::string, stream_name, "", "Stream Name");
-ABSL_FLAG(std::string, asset_name, "", "Media Warehouse Asset Name.");
+ABSL_FLAG(std::vector<std::string>, stream_name, {},
+          "Comma-separated names of the streams to export, all in one cluster");
+ABSL_FLAG(std::vector<std::string>, asset_name, {},
+          "Comma-separated Media Warehouse Asset Names, one for each stream.");
 ABSL_FLAG(
     std::string, receiver_id, "storage-exporter",
     "Event and packet receiver ID to keep track of read progress checkpoints.");
@@ -41,32 +45,35 @@ ABSL_FLAG(std::string, temp_video_dir, "/tmp/storage-exporter",
 ABSL_FLAG(bool, h264_only, false, "Whether to reject non-h264 streams");
 ABSL_FLAG(bool, h264_mux_only, true,
           "Whether to remove the transcoding for h264 streams");
+ABSL_FLAG(int, max_concurrent_events, 1,
+          "The most events to export at the same time. Raise it when the "
+          "events overlap or arrive faster than one can be uploaded");
 
 namespace visionai {
 
 absl::StatusOr<StorageExporter::Options> ConstructStorageExporterOptions() {
-  VAI_ASSIGN_OR_RETURN(auto resource_ids,
-                   ParseStreamName(absl::GetFlag(FLAGS_stream_name)));
-  std::string project_id = resource_ids[0];
-  std::string location_id = resource_ids[1];
-  std::string cluster_id = resource_ids[2];
-  std::string stream_id = resource_ids[3];
+  VAI_ASSIGN_OR_RETURN(
+      auto streams,
+      ParseStreamNamesInCluster(absl::GetFlag(FLAGS_stream_name)));
 
   StorageExporter::Options options;
-  options.cluster_selection.set_project_id(project_id);
-  options.cluster_selection.set_location_id(location_id);
-  options.cluster_selection.set_cluster_id(cluster_id);
+  options.cluster_selection.set_project_id(streams[0].project_id);
+  options.cluster_selection.set_location_id(streams[0].location_id);
+  options.cluster_selection.set_cluster_id(streams[0].cluster_id);
   options.cluster_selection.set_service_endpoint(
       absl::GetFlag(FLAGS_ais_service_endpoint));
-  options.stream_id = stream_id;
+  for (const auto& stream : streams) {
+    options.stream_ids.push_back(stream.stream_id);
+  }
   options.receiver_id = absl::GetFlag(FLAGS_receiver_id);
-  options.asset_name = absl::GetFlag(FLAGS_asset_name);
+  options.asset_names = absl::GetFlag(FLAGS_asset_name);
   options.mwh_server_addr = absl::GetFlag(FLAGS_mwh_server_address);
   options.streaming_server_addr =
       absl::GetFlag(FLAGS_k8s_streaming_server_addr);
   options.temp_video_dir = absl::GetFlag(FLAGS_temp_video_dir);
   options.h264_only = absl::GetFlag(FLAGS_h264_only);
   options.h264_mux_only = absl::GetFlag(FLAGS_h264_mux_only);
+  options.max_concurrent_events = absl::GetFlag(FLAGS_max_concurrent_events);
   return options;
 }
 
@@ -188,8 +188,8 @@ TEST_F(StorageExporterTest, SuccessfulExport) {
   options.mwh_server_addr = local_server_address_;
   options.cluster_selection = TestClusterSelection();
   options.receiver_id = kTestReceiverId;
-  options.stream_id = kTestStreamId;
-  options.asset_name = kTestAssetName;
+  options.stream_ids = {kTestStreamId};
+  options.asset_names = {kTestAssetName};
   options.h264_only = false;
   options.h264_mux_only = false;
   options.temp_video_dir = file::JoinPath(::testing::TempDir(), "test_dir");
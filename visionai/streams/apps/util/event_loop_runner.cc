@@ -6,9 +6,16 @@
 
 #include "visionai/streams/apps/util/event_loop_runner.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
 
+#include "visionai/proto/util/net/grpc/connection_options.pb.h"
+#include "visionai/streams/client/control.h"
 #include "visionai/streams/client/event_update.h"
+#include "visionai/util/net/grpc/client_connect.h"
 #include "visionai/util/telemetry/metrics/stats.h"
 
 namespace visionai {
@@ -31,11 +38,47 @@ void EventLoopRunner::OnReceiveEvent(EventUpdate event_update) {
   LOG(INFO) << "************ Processing event " << event_update.event()
             << "; offset " << event_update.offset() << " ************";
 
-  if (packet_loop_runner_) {
-    packet_loop_runner_->Cancel();
-    t_.join();
-    packet_loop_runner_.reset();
+  // Open the receiver of the new event before stopping the previous one, so
+  // that its setup overlaps with the tail of the previous event.
+  PacketReceiver::Options packet_receiver_options =
+      options_.packet_receiver_options;
+  packet_receiver_options.channel.event_id = event_update.event();
+  std::shared_ptr<PacketReceiver> packet_receiver;
+  auto packet_receiver_statusor =
+      options_.packet_receiver_factory(packet_receiver_options);
+  if (packet_receiver_statusor.ok()) {
+    packet_receiver = std::move(*packet_receiver_statusor);
+  } else {
+    LOG(WARNING) << "Failed to pre-open the PacketReceiver of event "
+                 << event_update.event() << ": "
+                 << packet_receiver_statusor.status();
+  }
+
+  ReapEventLoops();
+  while (static_cast<int>(event_loops_.size()) >=
+         std::max(1, options_.max_concurrent_events)) {
+    EventLoop& oldest = event_loops_.front();
+    CancelEventLoop(oldest);
+    oldest.t.join();
+    if (IsRunningEvent(oldest.event.offset())) {
+      // It keeps holding back the commits until it is resumed and completes.
+      LOG(INFO) << "Deferring the processing of the event at offset "
+                << oldest.event.offset() << " to make room for a new event";
+      deferred_events_.push_back(oldest.event);
+    }
+    event_loops_.pop_front();
+  }
+
+  {
+    absl::MutexLock lock(&event_offsets_mu_);
+    running_offsets_.insert(event_update.offset());
   }
+  StartEventLoop(event_update, std::move(packet_receiver));
+}
+
+void EventLoopRunner::StartEventLoop(
+    const EventUpdate& event_update,
+    std::shared_ptr<PacketReceiver> packet_receiver) {
   PacketLoopRunner::Options packet_loop_runner_opts;
   packet_loop_runner_opts.packet_receiver_options =
       options_.packet_receiver_options;
@@ -46,28 +89,119 @@ void EventLoopRunner::OnReceiveEvent(EventUpdate event_update) {
       event_update.event();
   packet_loop_runner_opts.current_event = event_update;
   packet_loop_runner_opts.event_commit_callback = [this](int64_t offset) {
-    return CommitEventOffset(offset);
+    OnEventCompleted(offset);
   };
-  packet_loop_runner_ =
-      std::make_unique<PacketLoopRunner>(packet_loop_runner_opts);
-  t_ = std::thread([=]() { packet_loop_runner_->Run().IgnoreError(); });
+  packet_loop_runner_opts.packet_receiver = std::move(packet_receiver);
+
+  event_loops_.emplace_back();
+  EventLoop& event_loop = event_loops_.back();
+  event_loop.event = event_update;
+  event_loop.packet_loop_runner =
+      std::make_shared<PacketLoopRunner>(packet_loop_runner_opts);
+  event_loop.is_canceled = std::make_shared<absl::Notification>();
+  event_loop.is_done = std::make_shared<absl::Notification>();
+  event_loop.t = std::thread([this, offset = event_update.offset(),
+                              runner = event_loop.packet_loop_runner,
+                              is_canceled = event_loop.is_canceled,
+                              is_done = event_loop.is_done]() {
+    // The event keeps holding back the commits of the later events while it
+    // is retried.
+    absl::Duration retry_delay = options_.min_event_retry_delay;
+    for (absl::Status s = runner->Run(); !s.ok(); s = runner->Run()) {
+      LOG(ERROR) << "Failed to process the event at offset " << offset
+                 << "; retrying it in " << retry_delay << ": " << s;
+      if (is_canceled->WaitForNotificationWithTimeout(retry_delay)) {
+        break;
+      }
+      retry_delay = std::min(retry_delay * 2, options_.max_event_retry_delay);
+    }
+    is_done->Notify();
+  });
+}
+
+void EventLoopRunner::CancelEventLoop(EventLoop& event_loop) {
+  event_loop.is_canceled->Notify();
+  event_loop.packet_loop_runner->Cancel();
+}
+
+void EventLoopRunner::ResumeDeferredEvents() {
+  ReapEventLoops();
+  while (!deferred_events_.empty() &&
+         static_cast<int>(event_loops_.size()) <
+             std::max(1, options_.max_concurrent_events)) {
+    LOG(INFO) << "Resuming the processing of the event at offset "
+              << deferred_events_.front().offset();
+    StartEventLoop(deferred_events_.front(), nullptr);
+    deferred_events_.pop_front();
+  }
+}
+
+bool EventLoopRunner::IsPendingEvent(int64_t offset) {
+  absl::MutexLock lock(&event_offsets_mu_);
+  return running_offsets_.count(offset) > 0 ||
+         completed_offsets_.count(offset) > 0;
+}
+
+bool EventLoopRunner::IsRunningEvent(int64_t offset) {
+  absl::MutexLock lock(&event_offsets_mu_);
+  return running_offsets_.count(offset) > 0;
+}
+
+void EventLoopRunner::OnEventCompleted(int64_t offset) {
+  int64_t commit_offset = -1;
+  {
+    absl::MutexLock lock(&event_offsets_mu_);
+    if (running_offsets_.erase(offset) == 0) {
+      return;
+    }
+    completed_offsets_.insert(offset);
+    while (!completed_offsets_.empty() &&
+           (running_offsets_.empty() ||
+            *completed_offsets_.begin() < *running_offsets_.begin())) {
+      commit_offset = *completed_offsets_.begin();
+      completed_offsets_.erase(completed_offsets_.begin());
+    }
+  }
+  if (commit_offset >= 0) {
+    CommitEventOffset(commit_offset);
+  }
+}
+
+void EventLoopRunner::ReapEventLoops() {
+  for (auto it = event_loops_.begin(); it != event_loops_.end();) {
+    if (it->is_done->HasBeenNotified()) {
+      it->t.join();
+      it = event_loops_.erase(it);
+    } else {
+      ++it;
+    }
+  }
 }
 
 void EventLoopRunner::Finalize() {
-  if (packet_loop_runner_) {
-    packet_loop_runner_->Cancel();
-    t_.join();
-    packet_loop_runner_.reset();
+  for (EventLoop& event_loop : event_loops_) {
+    CancelEventLoop(event_loop);
   }
+  for (EventLoop& event_loop : event_loops_) {
+    event_loop.t.join();
+  }
+  event_loops_.clear();
+  deferred_events_.clear();
   event_update_receiver_.reset();
 }
 
+EventLoopRunner::~EventLoopRunner() { Finalize(); }
+
 void EventLoopRunner::Cancel() { is_canceled_.Notify(); }
 
 void EventLoopRunner::CommitEventOffset(int64_t offset) {
   bool commit_ok;
   {
+    // The events may complete out of order when processed concurrently.
     absl::MutexLock lock(&local_commit_offset_mu_);
+    if (offset <= local_commit_offset_) {
+      return;
+    }
     local_commit_offset_ = offset;
   }
   if (!event_update_receiver_) {
@@ -84,15 +218,45 @@ void EventLoopRunner::CommitEventOffset(int64_t offset) {
   }
 }
 
+void PrepareSharedConnection(PacketReceiver::Options& receiver_options) {
+  if (receiver_options.advanced.grpc_channel != nullptr) {
+    return;
+  }
+  auto endpoint = GetClusterEndpoint(receiver_options.cluster_selection);
+  if (!endpoint.ok()) {
+    LOG(WARNING) << "Failed to resolve the cluster endpoint; each "
+                 << "PacketReceiver will connect on its own: "
+                 << endpoint.status();
+    return;
+  }
+  receiver_options.cluster_selection.set_cluster_endpoint(*endpoint);
+  ConnectionOptions connection_options = DefaultConnectionOptions();
+  connection_options.mutable_ssl_options()->set_use_insecure_channel(
+      receiver_options.cluster_selection.use_insecure_channel());
+  receiver_options.advanced.grpc_channel =
+      CreateChannel(*endpoint, connection_options);
+}
+
+void EventLoopRunner::PrepareSharedConnection() {
+  visionai::PrepareSharedConnection(options_.packet_receiver_options);
+}
+
 absl::Status EventLoopRunner::Run() {
   EventUpdate event_update;
   int64_t current_offset;
+  PrepareSharedConnection();
   while (!is_canceled_.HasBeenNotified()) {
+    ResumeDeferredEvents();
     if (event_update_receiver_ == nullptr) {
       LOG(INFO) << "Initializing event update receiver";
-      VAI_ASSIGN_OR_RETURN(
-          event_update_receiver_,
-          options_.event_receiver_factory(options_.event_receiver_options));
+      auto event_update_receiver =
+          options_.event_receiver_factory(options_.event_receiver_options);
+      if (!event_update_receiver.ok()) {
+        // Stop the events still being processed before giving up.
+        Finalize();
+        return event_update_receiver.status();
+      }
+      event_update_receiver_ = std::move(*event_update_receiver);
     }
     bool read_ok;
     if (!event_update_receiver_->Receive(kReceiveEventInterval, &event_update,
@@ -118,6 +282,11 @@ absl::Status EventLoopRunner::Run() {
         continue;
       }
     }
+    if (IsPendingEvent(current_offset)) {
+      LOG(INFO) << "Skipping event " << event_update.event()
+                << " that is already being processed";
+      continue;
+    }
     OnReceiveEvent(event_update);
   }
   Finalize();
@@ -7,14 +7,21 @@
 #ifndef THIRD_PARTY_VISIONAI_STREAMS_APPS_UTIL_EVENT_LOOP_RUNNER_H_
 #define THIRD_PARTY_VISIONAI_STREAMS_APPS_UTIL_EVENT_LOOP_RUNNER_H_
 
+#include <cstdint>
+#include <deque>
+#include <list>
 #include <memory>
+#include <set>
 #include <string>
 #include <thread>
 #include <vector>
 
 #include "glog/logging.h"
+#include "absl/base/thread_annotations.h"
 #include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
 #include "visionai/streams/apps/util/packet_loop_runner.h"
 #include "visionai/streams/client/event_update.h"
 #include "visionai/streams/client/event_update_receiver.h"
@@ -26,12 +33,30 @@ using EventReceiverFactory =
     std::function<absl::StatusOr<std::shared_ptr<EventUpdateReceiver>>(
         const EventUpdateReceiver::Options& options)>;
 
+// Connects `options` to the dataplane endpoint of its cluster through a new
+// grpc channel, unless it already has one.
+//
+// The `PacketReceiver`s created from `options`, or from copies of it, share
+// that channel rather than connecting on their own. On failure, they are left
+// to connect on their own.
+void PrepareSharedConnection(PacketReceiver::Options& options);
+
 // `EventLoopRunner` repetitively reads events from `EventUpdateReceiver` and
 // invokes `PacketLoopRunner` to process packets in each event.
 //
-// Note: `EventLoopRunner` operates on a sequential mode, processing one event
-// at a time. Whenever a new event arrives, the `PacketLoopRunner` of the last
-// event will be canceled.
+// Note: By default, `EventLoopRunner` operates on a sequential mode,
+// processing one event at a time. Whenever a new event arrives, the
+// `PacketLoopRunner` of the last event will be canceled.
+//
+// With `max_concurrent_events` above 1, the `PacketLoopRunner`s of up to that
+// many events run side by side, so that overlapping events, or events that
+// arrive faster than one can be processed, are not cut short. Only once that
+// many are running is the oldest one canceled to make room for a new event.
+//
+// An event that is canceled to make room before it completes is deferred, and
+// resumed once fewer than `max_concurrent_events` are running. The processing
+// of an event that fails is retried after a delay that backs off
+// exponentially while the failures persist.
 //
 // --------------------------
 // Receiving Events
@@ -41,8 +66,9 @@ using EventReceiverFactory =
 // while receiving the events:
 //
 // (1) Success:
-//      Cancel the `PacketLoopRunner` of the previous event (if it exists) and
-//      launch the new pipeline for the current event.
+//      Open the `PacketReceiver` of the current event, then cancel the oldest
+//      `PacketLoopRunner` if `max_concurrent_events` are running, and launch
+//      the new pipeline for the current event with the pre-opened receiver.
 // (2) Timeout:
 //      Continue to poll the events with the same `EventUpdateReceiver`.
 //      instance.
@@ -52,6 +78,17 @@ using EventReceiverFactory =
 //      Create another `EventLoopRunner` instance and retry.
 //
 // --------------------------
+// Switching Events
+// --------------------------
+// The connection setup of a new event is kept off the critical path of the
+// event switch:
+//
+// - The cluster dataplane endpoint is resolved once, and a single grpc channel
+//   to it is shared by the `PacketReceiver`s of all events.
+// - The `PacketReceiver` of a new event is opened while the `PacketLoopRunner`
+//   of the previous event is still running.
+//
+// --------------------------
 // Committing Events
 // --------------------------
 // The function `EventLoopRunner::CommitEventOffset()` is passed to the
@@ -59,12 +96,20 @@ using EventReceiverFactory =
 // callback to commit a particular event offset.
 //
 // The event commit is conducted as a fire-and-forget operation. We only
-// log the error encountered in the commit process.
+// log the error encountered in the commit process. The `EventUpdateReceiver`
+// coalesces the commits, so that at most one commit carrying the latest offset
+// is sent to the server per `advanced.commit_interval`.
 //
 // If the packet commit failed because the underlying gRPC stream terminated,
 // the main runner can identify the issue with `EventUpdateReceiver::Receive()`
 // and retry.
 //
+// An event is committed once its `PacketLoopRunner` has processed all of its
+// packets. The commit only advances past an event when all of the earlier
+// events have completed too; the events that failed or were deferred keep
+// holding it back until they are processed again and complete, so that a
+// restart never skips an event that has not been fully processed.
+//
 // The `EventLoopRunner` also keeps track of the `local_commit_offset_` to
 // deduplicate the events in the case of commit failures.
 class EventLoopRunner {
@@ -87,15 +132,30 @@ class EventLoopRunner {
 
     // The factory to create the `EventWriter` instance.
     EventWriterFactory event_writer_factory;
+
+    // The most events to process at the same time. 1 processes the events
+    // sequentially.
+    int max_concurrent_events = 1;
+
+    // The delay before the first retry of an event whose processing failed.
+    absl::Duration min_event_retry_delay = absl::Seconds(1);
+
+    // The longest delay between the retries of an event that keeps failing.
+    absl::Duration max_event_retry_delay = absl::Minutes(1);
   };
 
   EventLoopRunner(const Options& options)
       : options_(options), is_canceled_(false) {}
+  // Cancels and joins the processing of the events, if `Run` left any.
+  virtual ~EventLoopRunner();
 
-  absl::Status Run();
+  // Runs until canceled or until the events end. On return, the processing of
+  // all of the events has stopped, so that a failed runner can be destroyed
+  // and replaced.
+  virtual absl::Status Run();
 
   // Cancel the runner.
-  void Cancel();
+  virtual void Cancel();
 
  private:
   Options options_;
@@ -103,11 +163,48 @@ class EventLoopRunner {
   absl::Mutex local_commit_offset_mu_;
   int64_t local_commit_offset_ = -1;
   std::shared_ptr<EventUpdateReceiver> event_update_receiver_ = nullptr;
-  std::shared_ptr<PacketLoopRunner> packet_loop_runner_ = nullptr;
-  std::thread t_;
+
+  // The processing of one event.
+  struct EventLoop {
+    EventUpdate event;
+    std::shared_ptr<PacketLoopRunner> packet_loop_runner;
+    std::shared_ptr<absl::Notification> is_canceled;
+    std::shared_ptr<absl::Notification> is_done;
+    std::thread t;
+  };
+  // The events being processed, from the oldest to the newest.
+  std::list<EventLoop> event_loops_;
+  // The events that were canceled to make room before they completed, from
+  // the oldest to the newest.
+  std::deque<EventUpdate> deferred_events_;
+
+  // The offsets of the events being processed or deferred, and of the
+  // completed events that can't be committed before some earlier ones
+  // complete.
+  absl::Mutex event_offsets_mu_;
+  std::set<int64_t> running_offsets_ ABSL_GUARDED_BY(event_offsets_mu_);
+  std::set<int64_t> completed_offsets_ ABSL_GUARDED_BY(event_offsets_mu_);
 
   void CommitEventOffset(int64_t offset);
+  void PrepareSharedConnection();
   void OnReceiveEvent(EventUpdate event_update);
+  // Starts processing `event_update`, reading its packets from
+  // `packet_receiver` first if it is set.
+  void StartEventLoop(const EventUpdate& event_update,
+                      std::shared_ptr<PacketReceiver> packet_receiver);
+  void CancelEventLoop(EventLoop& event_loop);
+  // Resumes the deferred events for which there is room again.
+  void ResumeDeferredEvents();
+  // Returns true if the event at `offset` is being processed or awaits its
+  // commit.
+  bool IsPendingEvent(int64_t offset);
+  // Returns true if the event at `offset` is being processed or deferred.
+  bool IsRunningEvent(int64_t offset);
+  // Records that the event at `offset` completed, and commits past the events
+  // that no longer wait for an earlier one.
+  void OnEventCompleted(int64_t offset);
+  // Joins the event loops that have ended.
+  void ReapEventLoops();
   void Finalize();
 };
 
@@ -7,11 +7,13 @@
 #include "visionai/streams/apps/util/event_loop_runner.h"
 
 #include <memory>
+#include <vector>
 
 #include "glog/logging.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/synchronization/notification.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
@@ -24,6 +26,7 @@
 namespace visionai {
 
 using ::testing::_;
+using ::testing::ElementsAre;
 using ::testing::InSequence;
 using ::testing::Return;
 
@@ -168,6 +171,281 @@ TEST(EventLoopRunnerTest, SingleEventUpdateReceiver) {
   t.join();
 }
 
+TEST(EventLoopRunnerTest, ConcurrentEventsCommitInOrder) {
+  // The first event only ends once released, while the second one ends right
+  // away.
+  absl::Notification release_first_event;
+  PacketReceiverFactory packet_receiver_factory =
+      [&](const PacketReceiver::Options &options) {
+        if (options.channel.event_id != "ev-1001") {
+          return CreateMockPacketReceiverExpectNoPackets();
+        }
+        std::shared_ptr<MockPacketReceiver> packet_receiver =
+            std::make_shared<MockPacketReceiver>(PacketReceiver::Options());
+        EXPECT_CALL(*packet_receiver, Receive(_, _, _))
+            .WillRepeatedly([&](absl::Duration timeout, Packet *p, bool *ok) {
+              if (!release_first_event.WaitForNotificationWithTimeout(
+                      absl::Milliseconds(10))) {
+                return false;
+              }
+              *ok = false;
+              return true;
+            });
+        EXPECT_CALL(*packet_receiver, CommitsDone()).WillOnce(Return());
+        EXPECT_CALL(*packet_receiver, Finish())
+            .WillOnce(Return(absl::OutOfRangeError("event ended")));
+        return packet_receiver;
+      };
+  absl::Notification second_event_closed;
+  EventWriterFactory event_writer_factory = [&](const std::string &event_id,
+                                                OffsetCommitCallback callback) {
+    std::shared_ptr<MockEventWriter> event_writer =
+        std::make_shared<MockEventWriter>();
+    EXPECT_CALL(*event_writer, Close()).WillOnce([&, event_id]() {
+      if (event_id == "ev-1002") {
+        second_event_closed.Notify();
+      }
+      return absl::OkStatus();
+    });
+    return event_writer;
+  };
+  std::shared_ptr<MockEventUpdateReceiver> event_update_receiver =
+      std::make_shared<MockEventUpdateReceiver>(EventUpdateReceiver::Options());
+  EventReceiverFactory event_receiver_factory =
+      [&](const EventUpdateReceiver::Options &options) {
+        return event_update_receiver;
+      };
+
+  std::vector<EventUpdate> event_updates = {
+      CreateEventUpdate(1001, "ev-1001"), CreateEventUpdate(1002, "ev-1002")};
+  int index = 0;
+  EXPECT_CALL(*event_update_receiver, Receive(_, _, _))
+      .WillRepeatedly(
+          [&](absl::Duration timeout, EventUpdate *event_update, bool *ok) {
+            absl::SleepFor(absl::Milliseconds(20));
+            if (index < event_updates.size()) {
+              *event_update = event_updates[index++];
+              *ok = true;
+              return true;
+            }
+            return false;
+          });
+  absl::Mutex mu;
+  std::vector<int64_t> committed_offsets;
+  EXPECT_CALL(*event_update_receiver, Commit(_, _, _))
+      .WillRepeatedly([&](absl::Duration timeout, int64_t offset, bool *ok) {
+        absl::MutexLock lock(&mu);
+        committed_offsets.push_back(offset);
+        *ok = true;
+        return true;
+      });
+
+  EventLoopRunner::Options options;
+  options.event_receiver_factory = event_receiver_factory;
+  options.packet_receiver_factory = packet_receiver_factory;
+  options.event_writer_factory = event_writer_factory;
+  options.packet_receiver_options =
+      PacketReceiver::Options{.receive_mode = "controlled"};
+  options.event_receiver_options = EventUpdateReceiver::Options();
+  options.max_concurrent_events = 2;
+  EventLoopRunner runner(options);
+
+  std::thread t([&]() -> void {
+    // The second event must not be committed before the first one.
+    EXPECT_TRUE(
+        second_event_closed.WaitForNotificationWithTimeout(absl::Seconds(5)));
+    absl::SleepFor(absl::Milliseconds(100));
+    {
+      absl::MutexLock lock(&mu);
+      EXPECT_TRUE(committed_offsets.empty());
+    }
+    release_first_event.Notify();
+    absl::SleepFor(absl::Milliseconds(500));
+    runner.Cancel();
+  });
+
+  ASSERT_TRUE(runner.Run().ok());
+  t.join();
+  absl::MutexLock lock(&mu);
+  EXPECT_THAT(committed_offsets, ElementsAre(1002));
+}
+
+TEST(EventLoopRunnerTest, FailedEventBlocksLaterCommitsUntilRetried) {
+  // The EventWriter of the first event fails to be created until released.
+  // The PacketReceivers of the failed attempts are left unused.
+  absl::Notification release_first_event;
+  PacketReceiverFactory packet_receiver_factory =
+      [&](const PacketReceiver::Options &options) {
+        std::shared_ptr<MockPacketReceiver> packet_receiver =
+            std::make_shared<MockPacketReceiver>(PacketReceiver::Options());
+        EXPECT_CALL(*packet_receiver, Receive(_, _, _))
+            .WillRepeatedly([](absl::Duration timeout, Packet *p, bool *ok) {
+              *ok = false;
+              return true;
+            });
+        EXPECT_CALL(*packet_receiver, CommitsDone())
+            .WillRepeatedly(Return());
+        EXPECT_CALL(*packet_receiver, Finish())
+            .WillRepeatedly(Return(absl::OutOfRangeError("event ended")));
+        return packet_receiver;
+      };
+  EventWriterFactory event_writer_factory =
+      [&](const std::string &event_id, OffsetCommitCallback callback)
+      -> absl::StatusOr<std::shared_ptr<EventWriter>> {
+    if (event_id == "ev-1001" && !release_first_event.HasBeenNotified()) {
+      return absl::UnavailableError("cannot create the event writer");
+    }
+    return CreateMockEventWriterExpectNoPackets();
+  };
+  std::shared_ptr<MockEventUpdateReceiver> event_update_receiver =
+      std::make_shared<MockEventUpdateReceiver>(EventUpdateReceiver::Options());
+  EventReceiverFactory event_receiver_factory =
+      [&](const EventUpdateReceiver::Options &options) {
+        return event_update_receiver;
+      };
+
+  std::vector<EventUpdate> event_updates = {
+      CreateEventUpdate(1001, "ev-1001"), CreateEventUpdate(1002, "ev-1002")};
+  int index = 0;
+  EXPECT_CALL(*event_update_receiver, Receive(_, _, _))
+      .WillRepeatedly(
+          [&](absl::Duration timeout, EventUpdate *event_update, bool *ok) {
+            absl::SleepFor(absl::Milliseconds(20));
+            if (index < event_updates.size()) {
+              *event_update = event_updates[index++];
+              *ok = true;
+              return true;
+            }
+            return false;
+          });
+  absl::Mutex mu;
+  std::vector<int64_t> committed_offsets;
+  EXPECT_CALL(*event_update_receiver, Commit(_, _, _))
+      .WillRepeatedly([&](absl::Duration timeout, int64_t offset, bool *ok) {
+        absl::MutexLock lock(&mu);
+        committed_offsets.push_back(offset);
+        *ok = true;
+        return true;
+      });
+
+  EventLoopRunner::Options options;
+  options.event_receiver_factory = event_receiver_factory;
+  options.packet_receiver_factory = packet_receiver_factory;
+  options.event_writer_factory = event_writer_factory;
+  options.packet_receiver_options =
+      PacketReceiver::Options{.receive_mode = "controlled"};
+  options.event_receiver_options = EventUpdateReceiver::Options();
+  options.max_concurrent_events = 2;
+  options.min_event_retry_delay = absl::Milliseconds(10);
+  options.max_event_retry_delay = absl::Milliseconds(50);
+  EventLoopRunner runner(options);
+
+  std::thread t([&]() -> void {
+    // The second event completes, but the first one keeps failing.
+    absl::SleepFor(absl::Milliseconds(500));
+    {
+      absl::MutexLock lock(&mu);
+      EXPECT_TRUE(committed_offsets.empty());
+    }
+    release_first_event.Notify();
+    absl::SleepFor(absl::Milliseconds(500));
+    runner.Cancel();
+  });
+
+  ASSERT_TRUE(runner.Run().ok());
+  t.join();
+  absl::MutexLock lock(&mu);
+  EXPECT_THAT(committed_offsets, ElementsAre(1002));
+}
+
+TEST(EventLoopRunnerTest, DeferredEventBlocksLaterCommitsUntilResumed) {
+  // The first event only ends once released, while the second one, which
+  // makes room for itself by canceling the first one, ends right away.
+  absl::Notification release_first_event;
+  PacketReceiverFactory packet_receiver_factory =
+      [&](const PacketReceiver::Options &options) {
+        if (options.channel.event_id != "ev-1001") {
+          return CreateMockPacketReceiverExpectNoPackets();
+        }
+        std::shared_ptr<MockPacketReceiver> packet_receiver =
+            std::make_shared<MockPacketReceiver>(PacketReceiver::Options());
+        EXPECT_CALL(*packet_receiver, Receive(_, _, _))
+            .WillRepeatedly([&](absl::Duration timeout, Packet *p, bool *ok) {
+              if (!release_first_event.WaitForNotificationWithTimeout(
+                      absl::Milliseconds(10))) {
+                return false;
+              }
+              *ok = false;
+              return true;
+            });
+        EXPECT_CALL(*packet_receiver, CommitsDone())
+            .WillRepeatedly(Return());
+        EXPECT_CALL(*packet_receiver, Finish())
+            .WillRepeatedly(Return(absl::OutOfRangeError("event ended")));
+        return packet_receiver;
+      };
+  EventWriterFactory event_writer_factory = [&](const std::string &event_id,
+                                                OffsetCommitCallback callback) {
+    return CreateMockEventWriterExpectNoPackets();
+  };
+  std::shared_ptr<MockEventUpdateReceiver> event_update_receiver =
+      std::make_shared<MockEventUpdateReceiver>(EventUpdateReceiver::Options());
+  EventReceiverFactory event_receiver_factory =
+      [&](const EventUpdateReceiver::Options &options) {
+        return event_update_receiver;
+      };
+
+  std::vector<EventUpdate> event_updates = {
+      CreateEventUpdate(1001, "ev-1001"), CreateEventUpdate(1002, "ev-1002")};
+  int index = 0;
+  EXPECT_CALL(*event_update_receiver, Receive(_, _, _))
+      .WillRepeatedly(
+          [&](absl::Duration timeout, EventUpdate *event_update, bool *ok) {
+            absl::SleepFor(absl::Milliseconds(20));
+            if (index < event_updates.size()) {
+              *event_update = event_updates[index++];
+              *ok = true;
+              return true;
+            }
+            return false;
+          });
+  absl::Mutex mu;
+  std::vector<int64_t> committed_offsets;
+  EXPECT_CALL(*event_update_receiver, Commit(_, _, _))
+      .WillRepeatedly([&](absl::Duration timeout, int64_t offset, bool *ok) {
+        absl::MutexLock lock(&mu);
+        committed_offsets.push_back(offset);
+        *ok = true;
+        return true;
+      });
+
+  EventLoopRunner::Options options;
+  options.event_receiver_factory = event_receiver_factory;
+  options.packet_receiver_factory = packet_receiver_factory;
+  options.event_writer_factory = event_writer_factory;
+  options.packet_receiver_options =
+      PacketReceiver::Options{.receive_mode = "controlled"};
+  options.event_receiver_options = EventUpdateReceiver::Options();
+  EventLoopRunner runner(options);
+
+  std::thread t([&]() -> void {
+    // The resumed first event keeps running until released.
+    absl::SleepFor(absl::Milliseconds(500));
+    {
+      absl::MutexLock lock(&mu);
+      EXPECT_TRUE(committed_offsets.empty());
+    }
+    release_first_event.Notify();
+    absl::SleepFor(absl::Milliseconds(500));
+    runner.Cancel();
+  });
+
+  ASSERT_TRUE(runner.Run().ok());
+  t.join();
+  absl::MutexLock lock(&mu);
+  EXPECT_THAT(committed_offsets, ElementsAre(1002));
+}
+
 TEST(ConsumeSequentialEventTest, EventUpdateReceiverRestart) {
   PacketReceiverFactory packet_receiver_factory =
       [&](const PacketReceiver::Options &options) {
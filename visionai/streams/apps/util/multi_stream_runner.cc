@@ -0,0 +1,107 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/streams/apps/util/multi_stream_runner.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "glog/logging.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "visionai/streams/apps/util/event_loop_runner.h"
+#include "visionai/util/telemetry/metrics/stats.h"
+
+namespace visionai {
+
+absl::Status MultiStreamRunner::Run() {
+  if (options_.stream_ids.empty()) {
+    return absl::InvalidArgumentError("Given no streams to run.");
+  }
+  if (!options_.event_loop_runner_factory) {
+    return absl::InvalidArgumentError(
+        "Given no factory to create the EventLoopRunners.");
+  }
+  absl::flat_hash_set<std::string> stream_ids;
+  for (const auto& stream_id : options_.stream_ids) {
+    if (stream_id.empty()) {
+      return absl::InvalidArgumentError("Given an empty stream id.");
+    }
+    if (!stream_ids.insert(stream_id).second) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Given the stream \"%s\" more than once.",
+                          stream_id));
+    }
+  }
+
+  std::vector<std::thread> threads;
+  threads.reserve(options_.stream_ids.size());
+  for (const auto& stream_id : options_.stream_ids) {
+    threads.emplace_back([this, stream_id]() { RunStream(stream_id); });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  return absl::OkStatus();
+}
+
+void MultiStreamRunner::Cancel() {
+  is_canceled_.Notify();
+  absl::MutexLock lock(&mu_);
+  for (auto& [stream_id, runner] : runners_) {
+    runner->Cancel();
+  }
+}
+
+void MultiStreamRunner::RunStream(const std::string& stream_id) {
+  absl::Duration restart_delay = options_.min_restart_delay;
+  while (!is_canceled_.HasBeenNotified()) {
+    auto runner = options_.event_loop_runner_factory(stream_id);
+    absl::Status status = runner.status();
+    if (runner.ok()) {
+      {
+        // `Cancel` either sees the runner, or is seen here first.
+        absl::MutexLock lock(&mu_);
+        if (is_canceled_.HasBeenNotified()) {
+          break;
+        }
+        runners_[stream_id] = runner->get();
+      }
+      absl::Time start_time = absl::Now();
+      status = (*runner)->Run();
+      {
+        absl::MutexLock lock(&mu_);
+        runners_.erase(stream_id);
+      }
+      if (status.ok()) {
+        LOG(INFO) << "Finished running stream " << stream_id;
+        return;
+      }
+      // The failures no longer persist once the stream has run for a while.
+      if (absl::Now() - start_time >= options_.max_restart_delay) {
+        restart_delay = options_.min_restart_delay;
+      }
+    }
+
+    LOG(ERROR) << "Stream " << stream_id << " failed; restarting it in "
+               << restart_delay << ": " << status;
+    stream_runner_restarts_total().Add({{"stream_id", stream_id}}).Increment();
+    if (is_canceled_.WaitForNotificationWithTimeout(restart_delay)) {
+      break;
+    }
+    restart_delay = std::min(restart_delay * 2, options_.max_restart_delay);
+  }
+  LOG(INFO) << "Canceled stream " << stream_id;
+}
+
+}  // namespace visionai
@@ -0,0 +1,90 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef THIRD_PARTY_VISIONAI_STREAMS_APPS_UTIL_MULTI_STREAM_RUNNER_H_
+#define THIRD_PARTY_VISIONAI_STREAMS_APPS_UTIL_MULTI_STREAM_RUNNER_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+#include "visionai/streams/apps/util/event_loop_runner.h"
+
+namespace visionai {
+
+using EventLoopRunnerFactory =
+    std::function<absl::StatusOr<std::unique_ptr<EventLoopRunner>>(
+        const std::string& stream_id)>;
+
+// `MultiStreamRunner` runs one `EventLoopRunner` per stream, so that a single
+// process serves many streams.
+//
+// Each stream runs on its own thread, isolated from the others: when its
+// `EventLoopRunner` fails to be created or fails to run, only that stream is
+// restarted, after a delay that backs off exponentially while the failures
+// persist. The delay starts over once a stream fails after running for at
+// least `max_restart_delay`. Every restart is counted in
+// `stream_runner_restarts_total` under the stream id.
+//
+// A stream is done once its `EventLoopRunner` returns OK, that is once its
+// events have ended or it has been canceled.
+class MultiStreamRunner {
+ public:
+  struct Options {
+    // The ids of the streams to serve.
+    std::vector<std::string> stream_ids;
+
+    // The factory to create the `EventLoopRunner` of a stream.
+    EventLoopRunnerFactory event_loop_runner_factory;
+
+    // The delay before the first restart of a failed stream.
+    absl::Duration min_restart_delay = absl::Seconds(1);
+
+    // The longest delay between the restarts of a stream that keeps failing.
+    //
+    // A stream that runs for at least this long before failing is restarted
+    // after `min_restart_delay` again.
+    absl::Duration max_restart_delay = absl::Minutes(1);
+  };
+
+  explicit MultiStreamRunner(const Options& options) : options_(options) {}
+
+  // Runs all of the streams, and returns once they are all done.
+  //
+  // Returns INVALID_ARGUMENT if the options are incomplete or list a stream
+  // more than once.
+  absl::Status Run();
+
+  // Cancels the runner and the `EventLoopRunner`s of all of the streams.
+  void Cancel();
+
+  MultiStreamRunner(const MultiStreamRunner&) = delete;
+  MultiStreamRunner& operator=(const MultiStreamRunner&) = delete;
+
+ private:
+  // Runs the stream `stream_id` until it is done.
+  void RunStream(const std::string& stream_id);
+
+  const Options options_;
+  absl::Notification is_canceled_;
+
+  absl::Mutex mu_;
+  // The `EventLoopRunner`s that are running, by stream id.
+  absl::flat_hash_map<std::string, EventLoopRunner*> runners_
+      ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace visionai
+
+#endif  // THIRD_PARTY_VISIONAI_STREAMS_APPS_UTIL_MULTI_STREAM_RUNNER_H_
@@ -0,0 +1,268 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/streams/apps/util/multi_stream_runner.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "visionai/streams/apps/util/event_loop_runner.h"
+#include "visionai/streams/client/event_update.h"
+#include "visionai/streams/client/event_update_receiver.h"
+#include "visionai/streams/client/mock_event_update_receiver.h"
+#include "visionai/streams/client/mock_packet_receiver.h"
+#include "visionai/streams/framework/event_writer.h"
+#include "visionai/streams/packet/packet.h"
+
+namespace visionai {
+namespace {
+
+using ::testing::_;
+using ::testing::InSequence;
+using ::testing::Pair;
+using ::testing::Return;
+using ::testing::UnorderedElementsAre;
+
+// An `EventLoopRunner` that returns `status` after running for `run_time`, or
+// that runs until canceled if `status` is CANCELLED.
+class FakeEventLoopRunner : public EventLoopRunner {
+ public:
+  explicit FakeEventLoopRunner(absl::Status status,
+                               absl::Duration run_time = absl::ZeroDuration())
+      : EventLoopRunner(EventLoopRunner::Options()),
+        status_(status),
+        run_time_(run_time) {}
+
+  absl::Status Run() override {
+    if (absl::IsCancelled(status_)) {
+      is_canceled_.WaitForNotification();
+      return absl::OkStatus();
+    }
+    if (is_canceled_.WaitForNotificationWithTimeout(run_time_)) {
+      return absl::OkStatus();
+    }
+    return status_;
+  }
+
+  void Cancel() override { is_canceled_.Notify(); }
+
+ private:
+  absl::Status status_;
+  absl::Duration run_time_;
+  absl::Notification is_canceled_;
+};
+
+class MockEventWriter : public EventWriter {
+ public:
+  MOCK_METHOD(absl::Status, Init, (EventWriterInitContext * ctx), (override));
+  MOCK_METHOD(absl::Status, Open, (absl::string_view event_id), (override));
+  MOCK_METHOD(absl::Status, Write, (Packet packet), (override));
+  MOCK_METHOD(absl::Status, Close, (), (override));
+};
+
+class MultiStreamRunnerTest : public ::testing::Test {
+ protected:
+  // Creates runners that return the statuses of `run_statuses_` in turn for
+  // each stream, then OK.
+  MultiStreamRunner::Options TestOptions(std::vector<std::string> stream_ids) {
+    MultiStreamRunner::Options options;
+    options.stream_ids = std::move(stream_ids);
+    options.min_restart_delay = absl::Milliseconds(1);
+    options.max_restart_delay = absl::Milliseconds(10);
+    options.event_loop_runner_factory = [this](const std::string& stream_id)
+        -> absl::StatusOr<std::unique_ptr<EventLoopRunner>> {
+      absl::MutexLock lock(&mu_);
+      int attempt = num_runs_[stream_id]++;
+      const auto& statuses = run_statuses_[stream_id];
+      absl::Status status = attempt < static_cast<int>(statuses.size())
+                                ? statuses[attempt]
+                                : absl::OkStatus();
+      if (absl::IsFailedPrecondition(status)) {
+        return status;
+      }
+      return std::make_unique<FakeEventLoopRunner>(status);
+    };
+    return options;
+  }
+
+  absl::flat_hash_map<std::string, int> num_runs() {
+    absl::MutexLock lock(&mu_);
+    return num_runs_;
+  }
+
+  absl::Mutex mu_;
+  absl::flat_hash_map<std::string, std::vector<absl::Status>> run_statuses_;
+  absl::flat_hash_map<std::string, int> num_runs_ ABSL_GUARDED_BY(mu_);
+};
+
+TEST_F(MultiStreamRunnerTest, RejectsInvalidOptions) {
+  EXPECT_EQ(MultiStreamRunner(TestOptions({})).Run().code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(MultiStreamRunner(TestOptions({"a", "b", "a"})).Run().code(),
+            absl::StatusCode::kInvalidArgument);
+  MultiStreamRunner::Options options = TestOptions({"a"});
+  options.event_loop_runner_factory = nullptr;
+  EXPECT_EQ(MultiStreamRunner(options).Run().code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_TRUE(num_runs().empty());
+}
+
+TEST_F(MultiStreamRunnerTest, RestartsOnlyTheFailedStreams) {
+  run_statuses_["a"] = {absl::UnavailableError("down"),
+                        absl::FailedPreconditionError("cannot create")};
+  MultiStreamRunner runner(TestOptions({"a", "b", "c"}));
+  EXPECT_TRUE(runner.Run().ok());
+  EXPECT_THAT(num_runs(),
+              UnorderedElementsAre(Pair("a", 3), Pair("b", 1), Pair("c", 1)));
+}
+
+TEST_F(MultiStreamRunnerTest, CancelStopsAllStreams) {
+  run_statuses_["a"] = {absl::CancelledError("run until canceled")};
+  run_statuses_["b"] = std::vector<absl::Status>(
+      1000, absl::UnavailableError("down"));
+  MultiStreamRunner runner(TestOptions({"a", "b"}));
+  std::thread t([&runner]() {
+    absl::SleepFor(absl::Milliseconds(100));
+    runner.Cancel();
+  });
+  EXPECT_TRUE(runner.Run().ok());
+  t.join();
+  absl::flat_hash_map<std::string, int> runs = num_runs();
+  EXPECT_EQ(runs["a"], 1);
+  EXPECT_GT(runs["b"], 1);
+  EXPECT_LT(runs["b"], 1000);
+}
+
+TEST_F(MultiStreamRunnerTest, ResetsTheRestartDelayAfterALongRun) {
+  MultiStreamRunner::Options options = TestOptions({"a"});
+  options.min_restart_delay = absl::Milliseconds(1);
+  options.max_restart_delay = absl::Milliseconds(200);
+  // The stream fails right away until the restart delay reaches its maximum,
+  // then fails after running for longer than that, then ends.
+  std::vector<absl::Time> start_times;
+  options.event_loop_runner_factory = [&](const std::string& stream_id)
+      -> absl::StatusOr<std::unique_ptr<EventLoopRunner>> {
+    int attempt = start_times.size();
+    start_times.push_back(absl::Now());
+    if (attempt < 9) {
+      return std::make_unique<FakeEventLoopRunner>(
+          absl::UnavailableError("down"));
+    }
+    if (attempt == 9) {
+      return std::make_unique<FakeEventLoopRunner>(
+          absl::UnavailableError("down"), absl::Milliseconds(300));
+    }
+    return std::make_unique<FakeEventLoopRunner>(absl::OkStatus());
+  };
+  MultiStreamRunner runner(options);
+  EXPECT_TRUE(runner.Run().ok());
+  ASSERT_EQ(start_times.size(), 11);
+  EXPECT_GE(start_times[9] - start_times[8], absl::Milliseconds(200));
+  // The stream is restarted without waiting for another 200ms.
+  EXPECT_LT(start_times[10] - start_times[9], absl::Milliseconds(400));
+}
+
+TEST_F(MultiStreamRunnerTest, RestartsEventLoopRunnerThatFailsMidEvent) {
+  // The first `EventUpdateReceiver` delivers an event that runs until canceled,
+  // then breaks, and fails to be re-created, so that the first
+  // `EventLoopRunner` fails while the event is still being processed. The
+  // restarted one finds no more events.
+  std::shared_ptr<MockEventUpdateReceiver> broken_receiver =
+      std::make_shared<MockEventUpdateReceiver>(EventUpdateReceiver::Options());
+  {
+    InSequence s;
+    EXPECT_CALL(*broken_receiver, Receive(_, _, _))
+        .WillOnce([](absl::Duration timeout, EventUpdate* event_update,
+                     bool* ok) {
+          event_update->set_offset(1001);
+          event_update->set_event("ev-1001");
+          *ok = true;
+          return true;
+        })
+        .WillOnce([](absl::Duration timeout, EventUpdate* event_update,
+                     bool* ok) {
+          absl::SleepFor(absl::Milliseconds(50));
+          *ok = false;
+          return true;
+        });
+    EXPECT_CALL(*broken_receiver, CommitsDone()).WillOnce(Return());
+    EXPECT_CALL(*broken_receiver, Finish())
+        .WillOnce(Return(absl::UnavailableError("connection reset")));
+  }
+  std::shared_ptr<MockEventUpdateReceiver> ended_receiver =
+      std::make_shared<MockEventUpdateReceiver>(EventUpdateReceiver::Options());
+  {
+    InSequence s;
+    EXPECT_CALL(*ended_receiver, Receive(_, _, _))
+        .WillOnce([](absl::Duration timeout, EventUpdate* event_update,
+                     bool* ok) {
+          *ok = false;
+          return true;
+        });
+    EXPECT_CALL(*ended_receiver, CommitsDone()).WillOnce(Return());
+    EXPECT_CALL(*ended_receiver, Finish())
+        .WillOnce(Return(absl::OutOfRangeError("no more events")));
+  }
+
+  int num_event_receivers = 0;
+  EventLoopRunner::Options runner_options;
+  runner_options.event_receiver_factory =
+      [&](const EventUpdateReceiver::Options& options)
+      -> absl::StatusOr<std::shared_ptr<EventUpdateReceiver>> {
+    switch (num_event_receivers++) {
+      case 0:
+        return broken_receiver;
+      case 1:
+        return absl::UnavailableError("network is down");
+      default:
+        return ended_receiver;
+    }
+  };
+  runner_options.packet_receiver_factory =
+      [](const PacketReceiver::Options& options) {
+        auto packet_receiver =
+            std::make_shared<MockPacketReceiver>(PacketReceiver::Options());
+        EXPECT_CALL(*packet_receiver, Receive(_, _, _))
+            .WillRepeatedly(
+                [](absl::Duration timeout, Packet* packet, bool* ok) {
+                  absl::SleepFor(absl::Milliseconds(10));
+                  return false;
+                });
+        return packet_receiver;
+      };
+  runner_options.event_writer_factory = [](const std::string& event_id,
+                                           OffsetCommitCallback callback) {
+    auto event_writer = std::make_shared<MockEventWriter>();
+    EXPECT_CALL(*event_writer, Close()).WillOnce(Return(absl::OkStatus()));
+    return event_writer;
+  };
+  runner_options.packet_receiver_options =
+      PacketReceiver::Options{.receive_mode = "controlled"};
+
+  MultiStreamRunner::Options options = TestOptions({"a"});
+  options.event_loop_runner_factory = [&](const std::string& stream_id)
+      -> absl::StatusOr<std::unique_ptr<EventLoopRunner>> {
+    absl::MutexLock lock(&mu_);
+    ++num_runs_[stream_id];
+    return std::make_unique<EventLoopRunner>(runner_options);
+  };
+  MultiStreamRunner runner(options);
+  EXPECT_TRUE(runner.Run().ok());
+  EXPECT_THAT(num_runs(), UnorderedElementsAre(Pair("a", 2)));
+}
+
+}  // namespace
+}  // namespace visionai
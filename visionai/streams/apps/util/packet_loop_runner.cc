@@ -95,6 +95,7 @@ void PacketLoopRunner::Finalize() {
 }
 
 absl::Status PacketLoopRunner::Run() {
+  packet_receiver_ = std::move(options_.packet_receiver);
   // TODO(annikaz): Change the receive mode to enum representation.
   if (options_.packet_receiver_options.receive_mode == "controlled") {
     return RunControlledMode();
@@ -7,6 +7,8 @@
 #ifndef THIRD_PARTY_VISIONAI_STREAMS_APPS_UTIL_PACKET_LOOP_RUNNER_H_
 #define THIRD_PARTY_VISIONAI_STREAMS_APPS_UTIL_PACKET_LOOP_RUNNER_H_
 
+#include <memory>
+
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/synchronization/notification.h"
@@ -73,7 +75,9 @@ using EventWriterFactory =
 // to commit a particular packet offset.
 //
 // The packet commit is conducted as a fire-and-forget operation. We only
-// log the error encountered in the commit process.
+// log the error encountered in the commit process. The `PacketReceiver`
+// coalesces the commits, so that at most one commit carrying the latest offset
+// is sent to the server per `advanced.controlled_mode_options.commit_interval`.
 //
 // If the packet commit failed because the underlying gRPC stream terminated,
 // the main runner can identify the issue with `PacketReceiver::Receive()` and
@@ -94,6 +98,13 @@ class PacketLoopRunner {
     // The options to create the `PacketReceiver` instances.
     PacketReceiver::Options packet_receiver_options;
 
+    // An optional `PacketReceiver` that has already been opened for
+    // `current_event`.
+    //
+    // If set, it is used for the first receiving session instead of creating
+    // a new instance with `packet_receiver_factory`.
+    std::shared_ptr<PacketReceiver> packet_receiver;
+
     // The factory to create the `EventWriter` instance.
     EventWriterFactory event_writer_factory;
 
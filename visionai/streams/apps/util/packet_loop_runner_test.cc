@@ -89,6 +89,31 @@ TEST(PacketLoopRunnerTest, NoPackets) {
   ASSERT_TRUE(runner.Run().ok());
 }
 
+TEST(PacketLoopRunnerTest, PreOpenedPacketReceiver) {
+  int factory_calls = 0;
+  PacketReceiverFactory packet_receiver_factory =
+      [&](const PacketReceiver::Options &options)
+      -> absl::StatusOr<std::shared_ptr<PacketReceiver>> {
+    factory_calls++;
+    return absl::InternalError("no available receiver");
+  };
+  EventWriterFactory event_writer_factory = [&](const std::string &event_id,
+                                                OffsetCommitCallback callback) {
+    return CreateMockEventWriterExpectNoPackets();
+  };
+  PacketLoopRunner::Options options;
+  options.current_event = CreateEventUpdate(0, "ev-0");
+  options.event_writer_factory = event_writer_factory;
+  options.packet_receiver_factory = packet_receiver_factory;
+  options.packet_receiver_options =
+      PacketReceiver::Options{.receive_mode = "controlled"};
+  options.packet_receiver = CreateMockPacketReceiverExpectNoPackets();
+  options.event_commit_callback = [](int64_t offset) -> void { return; };
+  PacketLoopRunner runner(options);
+  ASSERT_TRUE(runner.Run().ok());
+  EXPECT_EQ(factory_calls, 0);
+}
+
 TEST(PacketLoopRunnerTest, SinglePacketReceiverControlledMode) {
   std::shared_ptr<MockPacketReceiver> packet_receiver =
       std::make_shared<MockPacketReceiver>(PacketReceiver::Options());
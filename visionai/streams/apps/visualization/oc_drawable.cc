@@ -83,31 +83,14 @@ void OccupancyAnalysisDrawable ::DrawActiveZoneCount(
     const google ::cloud::visionai::v1 ::OccupancyCountingPredictionResult&
         oc_result,
     double stats_alpha) {
-  std::vector<std::vector<cv::Point>> contours;
-  for (const auto& zone : oc_result.stats().active_zone_counts()) {
-    std::vector<cv::Point> temp_contour;
-    for (const auto& vertex :
-         zone.annotation().active_zone().normalized_vertices()) {
-      temp_contour.push_back(
-          cv::Point(vertex.x() * width, vertex.y() * height));
-    }
-    contours.push_back(std::move(temp_contour));
-  }
-  // Repurposed from render_utils.cc
-  // Use random colors to draw active zones
-  for (int i = 0; i < contours.size(); ++i) {
-    cv::Scalar color = GetColorFromPalette(i);
-    cv::drawContours(image, contours, i, color, kLineThick2);
-  }
-  // Repurposed from render_utils.cc
-  // Display zone ids next to active zone
-  for (int zone_id = 1; zone_id <= contours.size(); ++zone_id) {
-    const auto& contour = contours[zone_id - 1];
-    cv::putText(image, absl::StrCat("Zone-", zone_id),
-                cv::Point(contour.front().x, contour.front().y - 10),
-                kTextFontFamily, kStatsTextFontscale, kWhiteColor,
-                kStatsTextThickness);
+  // The zones only change with the annotation, so only record and rasterize
+  // them for the first frame, and composite the cached layer onto the others.
+  if (static_layer_size_ != cv::Size(width, height)) {
+    static_layer_ = StaticLayer();
+    AddActiveZones(width, height, oc_result, &static_layer_);
+    static_layer_size_ = cv::Size(width, height);
   }
+  static_layer_.CompositeOnto(image);
   // Repurposed from render_utils.cc
   // Store "zone_id -> label_string -> count" mapping information
   int number_of_zones = oc_result.stats().active_zone_counts_size();
@@ -165,77 +148,14 @@ void OccupancyAnalysisDrawable ::DrawLineCrossingCount(
     double stats_alpha) {
   int number_of_lines = oc_result.stats().crossing_line_counts_size();
 
-  // Draw crossing lines
-  for (int line_id = 1; line_id <= number_of_lines; ++line_id) {
-    const auto& crossing_line_count =
-        oc_result.stats().crossing_line_counts(line_id - 1);
-    int number_of_vertices = crossing_line_count.annotation()
-                                 .crossing_line()
-                                 .normalized_vertices_size();
-    for (int i = 0; i < number_of_vertices - 1; ++i) {
-      // Get start point and end point of the line.
-      double start_x = crossing_line_count.annotation()
-                           .crossing_line()
-                           .normalized_vertices(i)
-                           .x() *
-                       width;
-
-      double start_y = crossing_line_count.annotation()
-                           .crossing_line()
-                           .normalized_vertices(i)
-                           .y() *
-                       height;
-
-      double end_x = crossing_line_count.annotation()
-                         .crossing_line()
-                         .normalized_vertices(i + 1)
-                         .x() *
-                     width;
-      double end_y = crossing_line_count.annotation()
-                         .crossing_line()
-                         .normalized_vertices(i + 1)
-                         .y() *
-                     height;
-
-      // Get mid point of the line.
-      double mid_x = (start_x + end_x) / 2;
-      double mid_y = (start_y + end_y) / 2;
-
-      double k = (start_x - end_x) / (end_y - start_y);
-
-      double arrow_length = std::sqrt(std::pow(end_x - start_x, 2) +
-                                      std::pow(end_y - start_y, 2)) /
-                            4;
-      // Get the start and end point of the arrow.
-      double arrow_start_x = mid_x - arrow_length / std::sqrt(1 + k * k);
-      double arrow_start_y = mid_y - arrow_length * k / std::sqrt(1 + k * k);
-      double arrow_end_x = mid_x + arrow_length / std::sqrt(1 + k * k);
-      double arrow_end_y = mid_y + arrow_length * k / std::sqrt(1 + k * k);
-      // Change the direction of the arrow if end_y < start_y.
-      if (end_y < start_y) {
-        double temp_x = arrow_start_x;
-        arrow_start_x = arrow_end_x;
-        arrow_end_x = temp_x;
-        double temp_y = arrow_start_y;
-        arrow_start_y = arrow_end_y;
-        arrow_end_y = temp_y;
-      }
-      // Draw the crossing line.
-      cv::Scalar color = GetColorFromPalette(line_id - 1);
-      cv::line(image, cv::Point(start_x, start_y), cv::Point(end_x, end_y),
-               color, kLineThick2);
-      // Draw the arrow.
-      cv::arrowedLine(image, cv::Point(arrow_start_x, arrow_start_y),
-                      cv::Point(arrow_end_x, arrow_end_y), kWhiteColor,
-                      kLineThick1);
-      // Put mark beside the start of this polyline.
-      if (i == 0) {
-        cv::putText(image, absl::StrCat("Line-", line_id),
-                    cv::Point(start_x + 5, start_y - 5), kTextFontFamily, 1,
-                    kWhiteColor, kLineThick1);
-      }
-    }
+  // The lines only change with the annotation, so only record and rasterize
+  // them for the first frame, and composite the cached layer onto the others.
+  if (static_layer_size_ != cv::Size(width, height)) {
+    static_layer_ = StaticLayer();
+    AddCrossingLines(width, height, oc_result, &static_layer_);
+    static_layer_size_ = cv::Size(width, height);
   }
+  static_layer_.CompositeOnto(image);
 
   struct LineCounts {
     int positive_count = 0;
@@ -38,6 +38,11 @@ class OccupancyAnalysisDrawable: public Drawable {
   private:
    google::cloud::visionai::v1::OccupancyCountingPredictionResult oc_result_;
    double annotation_fps = 0.0;
+
+   // The zones or lines of oc_result_, recorded for frames of
+   // static_layer_size_.
+   StaticLayer static_layer_;
+   cv::Size static_layer_size_;
    
    void DrawFullFrameCount(
        cv::Mat& image,
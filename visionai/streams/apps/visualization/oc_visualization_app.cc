@@ -28,6 +28,7 @@
 #include "absl/strings/str_format.h"
 #include "absl/time/time.h"
 #include "visionai/algorithms/media/util/gstreamer_registry.h"
+#include "visionai/algorithms/media/util/pixel_conversion.h"
 #include "visionai/proto/cluster_selection.pb.h"
 #include "visionai/streams/apps/flags.h"
 #include "visionai/streams/apps/visualization/drawable.h"
@@ -327,9 +328,10 @@ absl::Status Run() {
         image = v_queue.Pop().value();
         int width = std::get<1>(image);
         int height = std::get<2>(image);
-        char* data = (char*)std::get<3>(image).data();
-        cv::Mat img = cv::Mat(height, width, CV_8UC3, data).clone();
-        cv::cvtColor(img, img, cv::COLOR_RGB2BGR);
+        const uint8_t* data =
+            reinterpret_cast<const uint8_t*>(std::get<3>(image).data());
+        cv::Mat img(height, width, CV_8UC3);
+        SwapRedAndBlue(data, width * 3, img.data, img.step[0], width, height);
 
         absl::Time img_time = std::get<0>(image);
         while (absl::Now() - img_time < annotation_buffer_time) {
@@ -6,6 +6,8 @@
 
 #include "visionai/streams/apps/visualization/render_utils.h"
 
+#include <algorithm>
+#include <climits>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
@@ -41,7 +43,9 @@ cv::Scalar CreateColor(float red, float green, float blue) {
 }
 
 cv::Scalar GetColorFromPalette(int entry) {
-  std::vector<cv::Scalar> palette = {
+  // Built once, since this is called for every box, zone and line of every
+  // frame.
+  static const auto* const kPalette = new std::vector<cv::Scalar>{
       CreateColor(/*red=*/1, /*green=*/0, /*blue=*/0),  // Red
       CreateColor(0, 1, 0),                             // Green
       CreateColor(0, 0, 1),                             // Blue
@@ -57,7 +61,7 @@ cv::Scalar GetColorFromPalette(int entry) {
       CreateColor(0.5, 0.5, 0), CreateColor(0, 0.5, 0.5),
       CreateColor(0.5, 0, 0.5), CreateColor(0.5, 0.25, 0),
       CreateColor(0.25, 0.25, 0.25)};
-  return palette[entry % palette.size()];
+  return (*kPalette)[entry % kPalette->size()];
 }
 
 void DrawBoundingBoxes(
@@ -202,6 +206,294 @@ void DrawBoundingBoxesWithDwellTime(
   }
 }
 
+namespace {
+
+// Returns the bounding box of `points`, grown by `margin` on every side.
+cv::Rect BoundsWithMargin(const std::vector<cv::Point>& points, int margin) {
+  cv::Rect bounds = cv::boundingRect(points);
+  return cv::Rect(bounds.x - margin, bounds.y - margin,
+                  bounds.width + 2 * margin, bounds.height + 2 * margin);
+}
+
+}  // namespace
+
+void RecordedDrawing::FillRect(const cv::Rect& rect, const cv::Scalar& color) {
+  Element element;
+  element.kind = Kind::kFilledRect;
+  element.rect = rect;
+  element.color = color;
+  Add(std::move(element), rect);
+}
+
+void RecordedDrawing::Line(const cv::Point& from, const cv::Point& to,
+                           const cv::Scalar& color, int thickness) {
+  Element element;
+  element.kind = Kind::kLine;
+  element.from = from;
+  element.to = to;
+  element.color = color;
+  element.thickness = thickness;
+  // Thick lines extend by half of their thickness, and have round caps.
+  Add(std::move(element),
+      BoundsWithMargin(std::vector<cv::Point>{from, to}, thickness + 1));
+}
+
+void RecordedDrawing::ArrowedLine(const cv::Point& from, const cv::Point& to,
+                                  const cv::Scalar& color, int thickness) {
+  Element element;
+  element.kind = Kind::kArrowedLine;
+  element.from = from;
+  element.to = to;
+  element.color = color;
+  element.thickness = thickness;
+  // The tip is a tenth of the length of the arrow, which is cv::arrowedLine's
+  // default.
+  int tip_length = static_cast<int>(std::ceil(0.1 * cv::norm(to - from)));
+  Add(std::move(element),
+      BoundsWithMargin(std::vector<cv::Point>{from, to},
+                       tip_length + thickness + 1));
+}
+
+void RecordedDrawing::Contour(std::vector<cv::Point> contour,
+                              const cv::Scalar& color, int thickness) {
+  if (contour.empty()) {
+    return;
+  }
+  cv::Rect bounds = BoundsWithMargin(contour, thickness + 1);
+  Element element;
+  element.kind = Kind::kContour;
+  element.contours.push_back(std::move(contour));
+  element.color = color;
+  element.thickness = thickness;
+  Add(std::move(element), bounds);
+}
+
+void RecordedDrawing::PutText(std::string text, const cv::Point& origin,
+                              int font_face, double font_scale,
+                              const cv::Scalar& color, int thickness) {
+  int baseline = 0;
+  cv::Size size =
+      cv::getTextSize(text, font_face, font_scale, thickness, &baseline);
+  // The glyphs may stick out of their nominal box a little, e.g. for accents
+  // or brackets, so leave a generous margin.
+  int margin = size.height + thickness;
+  cv::Point top_left(origin.x - margin, origin.y - size.height - margin);
+  cv::Point bottom_right(origin.x + size.width + margin,
+                         origin.y + baseline + margin);
+
+  Element element;
+  element.kind = Kind::kText;
+  element.from = origin;
+  element.color = color;
+  element.thickness = thickness;
+  element.text = std::move(text);
+  element.font_face = font_face;
+  element.font_scale = font_scale;
+  Add(std::move(element), cv::Rect(top_left, bottom_right));
+}
+
+cv::Rect RecordedDrawing::Region(const cv::Size& size) const {
+  return bounds_ & cv::Rect(cv::Point(0, 0), size);
+}
+
+void RecordedDrawing::DrawOnto(cv::Mat img) const {
+  DrawElements(cv::Point(0, 0), /*color=*/nullptr, img);
+}
+
+void RecordedDrawing::DrawElements(const cv::Point& offset,
+                                   const cv::Scalar* color,
+                                   cv::Mat img) const {
+  for (const Element& element : elements_) {
+    DrawElement(element, offset, color != nullptr ? *color : element.color,
+                img);
+  }
+}
+
+void RecordedDrawing::Add(Element element, const cv::Rect& bounds) {
+  elements_.push_back(std::move(element));
+  bounds_ |= bounds;
+}
+
+void RecordedDrawing::DrawElement(const Element& element,
+                                  const cv::Point& offset,
+                                  const cv::Scalar& color, cv::Mat img) {
+  switch (element.kind) {
+    case Kind::kFilledRect:
+      cv::rectangle(img, element.rect - offset, color, /* fill */ -1);
+      break;
+    case Kind::kLine:
+      cv::line(img, element.from - offset, element.to - offset, color,
+               element.thickness);
+      break;
+    case Kind::kArrowedLine:
+      cv::arrowedLine(img, element.from - offset, element.to - offset, color,
+                      element.thickness);
+      break;
+    case Kind::kContour:
+      cv::drawContours(img, element.contours, 0, color, element.thickness,
+                       cv::LINE_8, cv::noArray(), INT_MAX, -offset);
+      break;
+    case Kind::kText:
+      cv::putText(img, element.text, element.from - offset, element.font_face,
+                  element.font_scale, color, element.thickness);
+      break;
+  }
+}
+
+void OverlayPanel::BlendInto(cv::Mat img, double alpha) const {
+  cv::Rect region = Region(img.size());
+  if (region.empty()) {
+    return;
+  }
+
+  // Every element lies within the region, or is clipped by the same frame
+  // borders, so drawing relative to the region yields the same pixels.
+  cv::Mat roi = img(region);
+  cv::Mat overlay = roi.clone();
+  DrawElements(region.tl(), /*color=*/nullptr, overlay);
+
+  // Blend the overlay with the original region. Pixels that the elements do
+  // not touch blend with themselves, and so would not change anyway.
+  cv::addWeighted(overlay, alpha, roi, 1 - alpha, 0, roi);
+}
+
+void StaticLayer::CompositeOnto(cv::Mat img) {
+  if (img.size() != rasterized_size_ || size() != rasterized_elements_) {
+    rasterized_size_ = img.size();
+    rasterized_elements_ = size();
+    region_ = Region(img.size());
+    if (!region_.empty()) {
+      // Only the masked pixels are ever read back, so the initial contents of
+      // `pixels_` do not matter.
+      pixels_.create(region_.size(), img.type());
+      mask_ = cv::Mat::zeros(region_.size(), CV_8UC1);
+      DrawElements(region_.tl(), /*color=*/nullptr, pixels_);
+      const cv::Scalar covered(255);
+      DrawElements(region_.tl(), &covered, mask_);
+    }
+  }
+  if (region_.empty()) {
+    return;
+  }
+  pixels_.copyTo(img(region_), mask_);
+}
+
+void AddActiveZones(
+    int width, int height,
+    const google::cloud::visionai::v1::OccupancyCountingPredictionResult&
+        oc_result,
+    RecordedDrawing* drawing) {
+  // Get all contours
+  std::vector<std::vector<cv::Point>> contours;
+  for (const auto& zone : oc_result.stats().active_zone_counts()) {
+    std::vector<cv::Point> temp_contour;
+    for (const auto& vertex :
+         zone.annotation().active_zone().normalized_vertices()) {
+      temp_contour.push_back(
+          cv::Point(vertex.x() * width, vertex.y() * height));
+    }
+    contours.push_back(std::move(temp_contour));
+  }
+
+  // Use random colors to draw active zones
+  for (int i = 0; i < contours.size(); ++i) {
+    cv::Scalar color = GetColorFromPalette(i);
+    drawing->Contour(contours[i], color, kLineThick2);
+  }
+
+  // Display zone ids next to active zone
+  for (int zone_id = 1; zone_id <= contours.size(); ++zone_id) {
+    const auto& contour = contours[zone_id - 1];
+    if (contour.empty()) {
+      continue;
+    }
+    drawing->PutText(absl::StrCat("Zone-", zone_id),
+                     cv::Point(contour.front().x, contour.front().y - 10),
+                     kTextFontFamily, kStatsTextFontscale, kWhiteColor,
+                     kStatsTextThickness);
+  }
+}
+
+void AddCrossingLines(
+    int width, int height,
+    const google::cloud::visionai::v1::OccupancyCountingPredictionResult&
+        oc_result,
+    RecordedDrawing* drawing) {
+  int number_of_lines = oc_result.stats().crossing_line_counts_size();
+
+  // Draw crossing lines
+  for (int line_id = 1; line_id <= number_of_lines; ++line_id) {
+    const auto& crossing_line_count =
+        oc_result.stats().crossing_line_counts(line_id - 1);
+    int number_of_vertices = crossing_line_count.annotation()
+                                 .crossing_line()
+                                 .normalized_vertices_size();
+    for (int i = 0; i < number_of_vertices - 1; ++i) {
+      // Get start point and end point of the line.
+      double start_x = crossing_line_count.annotation()
+                           .crossing_line()
+                           .normalized_vertices(i)
+                           .x() *
+                       width;
+
+      double start_y = crossing_line_count.annotation()
+                           .crossing_line()
+                           .normalized_vertices(i)
+                           .y() *
+                       height;
+
+      double end_x = crossing_line_count.annotation()
+                         .crossing_line()
+                         .normalized_vertices(i + 1)
+                         .x() *
+                     width;
+      double end_y = crossing_line_count.annotation()
+                         .crossing_line()
+                         .normalized_vertices(i + 1)
+                         .y() *
+                     height;
+
+      // Get mid point of the line.
+      double mid_x = (start_x + end_x) / 2;
+      double mid_y = (start_y + end_y) / 2;
+
+      double k = (start_x - end_x) / (end_y - start_y);
+
+      double arrow_length = std::sqrt(std::pow(end_x - start_x, 2) +
+                                      std::pow(end_y - start_y, 2)) /
+                            4;
+      // Get the start and end point of the arrow.
+      double arrow_start_x = mid_x - arrow_length / std::sqrt(1 + k * k);
+      double arrow_start_y = mid_y - arrow_length * k / std::sqrt(1 + k * k);
+      double arrow_end_x = mid_x + arrow_length / std::sqrt(1 + k * k);
+      double arrow_end_y = mid_y + arrow_length * k / std::sqrt(1 + k * k);
+      // Change the direction of the arrow if end_y < start_y.
+      if (end_y < start_y) {
+        double temp_x = arrow_start_x;
+        arrow_start_x = arrow_end_x;
+        arrow_end_x = temp_x;
+        double temp_y = arrow_start_y;
+        arrow_start_y = arrow_end_y;
+        arrow_end_y = temp_y;
+      }
+      // Draw the crossing line.
+      cv::Scalar color = GetColorFromPalette(line_id - 1);
+      drawing->Line(cv::Point(start_x, start_y), cv::Point(end_x, end_y), color,
+                    kLineThick2);
+      // Draw the arrow.
+      drawing->ArrowedLine(cv::Point(arrow_start_x, arrow_start_y),
+                           cv::Point(arrow_end_x, arrow_end_y), kWhiteColor,
+                           kLineThick1);
+      // Put mark beside the start of this polyline.
+      if (i == 0) {
+        drawing->PutText(absl::StrCat("Line-", line_id),
+                         cv::Point(start_x + 5, start_y - 5), kTextFontFamily,
+                         1, kWhiteColor, kLineThick1);
+      }
+    }
+  }
+}
+
 void DrawFullFrameCount(
     cv::Mat img,
     const google::cloud::visionai::v1::OccupancyCountingPredictionResult&
@@ -225,57 +517,57 @@ void DrawFullFrameCount(
   int table_width = kFirstColumnWidth + kItemColumnWidth;
   int table_height = 2 * kRowHeight;
 
-  cv::Mat overlay = img.clone();
+  OverlayPanel overlay;
   cv::Rect black_backgroud(kXInitOffset, kYInitOffset, table_width,
                            table_height);
-  cv::rectangle(overlay, black_backgroud, kBlackColor, /* fill */ -1);
+  overlay.FillRect(black_backgroud, kBlackColor);
 
   // Draw horizontal lines of the table
   for (int i = 0; i < 3; ++i) {
-    cv::line(
-        overlay, cv::Point(kXInitOffset, kYInitOffset + i * kRowHeight),
+    overlay.Line(
+        cv::Point(kXInitOffset, kYInitOffset + i * kRowHeight),
         cv::Point(kXInitOffset + table_width, kYInitOffset + i * kRowHeight),
         kWhiteColor, kLineThick1);
   }
 
   // Draw vertical lines of the table
-  cv::line(overlay, cv::Point(kXInitOffset, kYInitOffset),
-           cv::Point(kXInitOffset, kYInitOffset + table_height), kWhiteColor,
-           kLineThick1);
+  overlay.Line(cv::Point(kXInitOffset, kYInitOffset),
+               cv::Point(kXInitOffset, kYInitOffset + table_height),
+               kWhiteColor, kLineThick1);
   for (int i = 0; i < 2; i++) {
-    cv::line(overlay,
-             cv::Point(kXInitOffset + kFirstColumnWidth + i * kItemColumnWidth,
-                       kYInitOffset),
-             cv::Point(kXInitOffset + kFirstColumnWidth + i * kItemColumnWidth,
-                       kYInitOffset + table_height),
-             kWhiteColor, kLineThick1);
+    overlay.Line(
+        cv::Point(kXInitOffset + kFirstColumnWidth + i * kItemColumnWidth,
+                  kYInitOffset),
+        cv::Point(kXInitOffset + kFirstColumnWidth + i * kItemColumnWidth,
+                  kYInitOffset + table_height),
+        kWhiteColor, kLineThick1);
   }
 
   // Put text
-  cv::putText(overlay, "Person",
-              cv::Point(kXInitOffset + kXTextOffset,
-                        kYInitOffset + kRowHeight + kYTextOffset),
-              kTextFontFamily, kStatsTextFontscale, kWhiteColor,
-              kStatsTextThickness);
-  cv::putText(overlay, absl::StrCat(person_count),
-              cv::Point(kXInitOffset + kFirstColumnWidth + kXTextOffset,
-                        kYInitOffset + kRowHeight + kYTextOffset),
-              kTextFontFamily, kStatsTextFontscale, kWhiteColor,
-              kStatsTextThickness);
-
-  cv::putText(overlay, "Vehicle",
-              cv::Point(kXInitOffset + kXTextOffset,
-                        kYInitOffset + 2 * kRowHeight + kYTextOffset),
-              kTextFontFamily, kStatsTextFontscale, kWhiteColor,
-              kStatsTextThickness);
-  cv::putText(overlay, absl::StrCat(vehicle_count),
-              cv::Point(kXInitOffset + kFirstColumnWidth + kXTextOffset,
-                        kYInitOffset + 2 * kRowHeight + kYTextOffset),
-              kTextFontFamily, kStatsTextFontscale, kWhiteColor,
-              kStatsTextThickness);
+  overlay.PutText("Person",
+                  cv::Point(kXInitOffset + kXTextOffset,
+                            kYInitOffset + kRowHeight + kYTextOffset),
+                  kTextFontFamily, kStatsTextFontscale, kWhiteColor,
+                  kStatsTextThickness);
+  overlay.PutText(absl::StrCat(person_count),
+                  cv::Point(kXInitOffset + kFirstColumnWidth + kXTextOffset,
+                            kYInitOffset + kRowHeight + kYTextOffset),
+                  kTextFontFamily, kStatsTextFontscale, kWhiteColor,
+                  kStatsTextThickness);
+
+  overlay.PutText("Vehicle",
+                  cv::Point(kXInitOffset + kXTextOffset,
+                            kYInitOffset + 2 * kRowHeight + kYTextOffset),
+                  kTextFontFamily, kStatsTextFontscale, kWhiteColor,
+                  kStatsTextThickness);
+  overlay.PutText(absl::StrCat(vehicle_count),
+                  cv::Point(kXInitOffset + kFirstColumnWidth + kXTextOffset,
+                            kYInitOffset + 2 * kRowHeight + kYTextOffset),
+                  kTextFontFamily, kStatsTextFontscale, kWhiteColor,
+                  kStatsTextThickness);
 
   // Blend the stats with original image
-  cv::addWeighted(overlay, stats_alpha, img, 1 - stats_alpha, 0, img);
+  overlay.BlendInto(img, stats_alpha);
 }
 
 void DrawActiveZoneCount(
@@ -283,32 +575,9 @@ void DrawActiveZoneCount(
     const google::cloud::visionai::v1::OccupancyCountingPredictionResult&
         oc_result,
     double stats_alpha) {
-  // Get all contours
-  std::vector<std::vector<cv::Point>> contours;
-  for (const auto& zone : oc_result.stats().active_zone_counts()) {
-    std::vector<cv::Point> temp_contour;
-    for (const auto& vertex :
-         zone.annotation().active_zone().normalized_vertices()) {
-      temp_contour.push_back(
-          cv::Point(vertex.x() * width, vertex.y() * height));
-    }
-    contours.push_back(std::move(temp_contour));
-  }
-
-  // Use random colors to draw active zones
-  for (int i = 0; i < contours.size(); ++i) {
-    cv::Scalar color = GetColorFromPalette(i);
-    cv::drawContours(img, contours, i, color, kLineThick2);
-  }
-
-  // Display zone ids next to active zone
-  for (int zone_id = 1; zone_id <= contours.size(); ++zone_id) {
-    const auto& contour = contours[zone_id - 1];
-    cv::putText(img, absl::StrCat("Zone-", zone_id),
-                cv::Point(contour.front().x, contour.front().y - 10),
-                kTextFontFamily, kStatsTextFontscale, kWhiteColor,
-                kStatsTextThickness);
-  }
+  RecordedDrawing zones;
+  AddActiveZones(width, height, oc_result, &zones);
+  zones.DrawOnto(img);
 
   // Store "zone_id -> label_string -> count" mapping information
   int number_of_zones = oc_result.stats().active_zone_counts_size();
@@ -323,90 +592,92 @@ void DrawActiveZoneCount(
   }
 
   // Begin drawing stats information
-  cv::Mat overlay = img.clone();
+  OverlayPanel overlay;
 
   // Draw black backgroud for stats table
   int table_width = kFirstColumnWidth + kItemColumnWidth * number_of_zones;
   int table_height = kRowHeight * (1 + count_map[1].size());
   cv::Rect black_background(kXInitOffset, kYInitOffset, table_width,
                             table_height);
-  cv::rectangle(overlay, black_background, kBlackColor,
-                /* fill */ -1);
+  overlay.FillRect(black_background, kBlackColor);
 
   // Draw horizontal lines of the stats table
   for (int i = 0; i <= 1 + count_map[1].size(); ++i) {
-    cv::line(
-        overlay, cv::Point(kXInitOffset, kYInitOffset + i * kRowHeight),
+    overlay.Line(
+        cv::Point(kXInitOffset, kYInitOffset + i * kRowHeight),
         cv::Point(kXInitOffset + table_width, kYInitOffset + i * kRowHeight),
         kWhiteColor);
   }
 
   // Draw vertical lines of the stats table
-  cv::line(overlay, cv::Point(kXInitOffset, kYInitOffset),
-           cv::Point(kXInitOffset, kYInitOffset + table_height), kWhiteColor);
+  overlay.Line(cv::Point(kXInitOffset, kYInitOffset),
+               cv::Point(kXInitOffset, kYInitOffset + table_height),
+               kWhiteColor);
   for (int i = 0; i <= number_of_zones; ++i) {
-    cv::line(overlay,
-             cv::Point(kXInitOffset + kFirstColumnWidth + i * kItemColumnWidth,
-                       kYInitOffset),
-             cv::Point(kXInitOffset + kFirstColumnWidth + i * kItemColumnWidth,
-                       kYInitOffset + table_height),
-             kWhiteColor);
+    overlay.Line(
+        cv::Point(kXInitOffset + kFirstColumnWidth + i * kItemColumnWidth,
+                  kYInitOffset),
+        cv::Point(kXInitOffset + kFirstColumnWidth + i * kItemColumnWidth,
+                  kYInitOffset + table_height),
+        kWhiteColor);
   }
 
   // Put table header line text
-  cv::putText(overlay, "Zone",
-              cv::Point(kXInitOffset + kXTextOffset,
-                        kYInitOffset + kRowHeight + kYTextOffset),
-              kTextFontFamily, kStatsTextFontscale, kWhiteColor,
-              kStatsTextThickness);
+  overlay.PutText("Zone",
+                  cv::Point(kXInitOffset + kXTextOffset,
+                            kYInitOffset + kRowHeight + kYTextOffset),
+                  kTextFontFamily, kStatsTextFontscale, kWhiteColor,
+                  kStatsTextThickness);
   for (int zone_id = 1; zone_id <= number_of_zones; ++zone_id) {
-    cv::putText(overlay, absl::StrCat(zone_id),
-                cv::Point(kXInitOffset + kFirstColumnWidth +
-                              (zone_id - 1) * kItemColumnWidth + kXTextOffset,
-                          kYInitOffset + kRowHeight + kYTextOffset),
-                kTextFontFamily, kStatsTextFontscale, kWhiteColor,
-                kStatsTextThickness);
+    overlay.PutText(
+        absl::StrCat(zone_id),
+        cv::Point(kXInitOffset + kFirstColumnWidth +
+                      (zone_id - 1) * kItemColumnWidth + kXTextOffset,
+                  kYInitOffset + kRowHeight + kYTextOffset),
+        kTextFontFamily, kStatsTextFontscale, kWhiteColor, kStatsTextThickness);
   }
 
   // Put person count line
   int y_index = 2;
   if (count_map[1].contains("Person")) {
-    cv::putText(overlay, "Person",
-                cv::Point(kXInitOffset + kXTextOffset,
-                          kYInitOffset + kRowHeight * y_index + kYTextOffset),
-                kTextFontFamily, kStatsTextFontscale, kWhiteColor,
-                kStatsTextThickness);
+    overlay.PutText(
+        "Person",
+        cv::Point(kXInitOffset + kXTextOffset,
+                  kYInitOffset + kRowHeight * y_index + kYTextOffset),
+        kTextFontFamily, kStatsTextFontscale, kWhiteColor, kStatsTextThickness);
     for (int zone_id = 1; zone_id <= number_of_zones; ++zone_id) {
-      cv::putText(overlay, absl::StrCat(count_map[zone_id]["Person"]),
-                  cv::Point(kXInitOffset + kFirstColumnWidth +
-                                (zone_id - 1) * kItemColumnWidth + kXTextOffset,
-                            kYInitOffset + kRowHeight * y_index + kYTextOffset),
-                  kTextFontFamily, kStatsTextFontscale, kWhiteColor,
-                  kStatsTextThickness);
+      overlay.PutText(absl::StrCat(count_map[zone_id]["Person"]),
+                      cv::Point(
+                          kXInitOffset + kFirstColumnWidth +
+                              (zone_id - 1) * kItemColumnWidth + kXTextOffset,
+                          kYInitOffset + kRowHeight * y_index + kYTextOffset),
+                      kTextFontFamily, kStatsTextFontscale, kWhiteColor,
+                      kStatsTextThickness);
     }
     ++y_index;
   }
 
   // Put vehicle count line
   if (count_map[1].contains("Vehicle")) {
-    cv::putText(overlay, "Vehicle",
-                cv::Point(kXInitOffset + kXTextOffset,
-                          kYInitOffset + kRowHeight * y_index + kYTextOffset),
-                kTextFontFamily, kStatsTextFontscale, kWhiteColor,
-                kStatsTextThickness);
+    overlay.PutText(
+        "Vehicle",
+        cv::Point(kXInitOffset + kXTextOffset,
+                  kYInitOffset + kRowHeight * y_index + kYTextOffset),
+        kTextFontFamily, kStatsTextFontscale, kWhiteColor, kStatsTextThickness);
     for (int zone_id = 1; zone_id <= number_of_zones; ++zone_id) {
-      cv::putText(overlay, absl::StrCat(count_map[zone_id]["Vehicle"]),
-                  cv::Point(kXInitOffset + kFirstColumnWidth +
-                                (zone_id - 1) * kItemColumnWidth + kXTextOffset,
-                            kYInitOffset + kRowHeight * y_index + kYTextOffset),
-                  kTextFontFamily, kStatsTextFontscale, kWhiteColor,
-                  kStatsTextThickness);
+      overlay.PutText(absl::StrCat(count_map[zone_id]["Vehicle"]),
+                      cv::Point(
+                          kXInitOffset + kFirstColumnWidth +
+                              (zone_id - 1) * kItemColumnWidth + kXTextOffset,
+                          kYInitOffset + kRowHeight * y_index + kYTextOffset),
+                      kTextFontFamily, kStatsTextFontscale, kWhiteColor,
+                      kStatsTextThickness);
     }
     ++y_index;
   }
 
   // Blend the stats with original image
-  cv::addWeighted(overlay, stats_alpha, img, 1 - stats_alpha, 0, img);
+  overlay.BlendInto(img, stats_alpha);
 }
 
 void DrawLineCrossingCount(
@@ -416,77 +687,9 @@ void DrawLineCrossingCount(
     double stats_alpha) {
   int number_of_lines = oc_result.stats().crossing_line_counts_size();
 
-  // Draw crossing lines
-  for (int line_id = 1; line_id <= number_of_lines; ++line_id) {
-    const auto& crossing_line_count =
-        oc_result.stats().crossing_line_counts(line_id - 1);
-    int number_of_vertices = crossing_line_count.annotation()
-                                 .crossing_line()
-                                 .normalized_vertices_size();
-    for (int i = 0; i < number_of_vertices - 1; ++i) {
-      // Get start point and end point of the line.
-      double start_x = crossing_line_count.annotation()
-                           .crossing_line()
-                           .normalized_vertices(i)
-                           .x() *
-                       width;
-
-      double start_y = crossing_line_count.annotation()
-                           .crossing_line()
-                           .normalized_vertices(i)
-                           .y() *
-                       height;
-
-      double end_x = crossing_line_count.annotation()
-                         .crossing_line()
-                         .normalized_vertices(i + 1)
-                         .x() *
-                     width;
-      double end_y = crossing_line_count.annotation()
-                         .crossing_line()
-                         .normalized_vertices(i + 1)
-                         .y() *
-                     height;
-
-      // Get mid point of the line.
-      double mid_x = (start_x + end_x) / 2;
-      double mid_y = (start_y + end_y) / 2;
-
-      double k = (start_x - end_x) / (end_y - start_y);
-
-      double arrow_length = std::sqrt(std::pow(end_x - start_x, 2) +
-                                      std::pow(end_y - start_y, 2)) /
-                            4;
-      // Get the start and end point of the arrow.
-      double arrow_start_x = mid_x - arrow_length / std::sqrt(1 + k * k);
-      double arrow_start_y = mid_y - arrow_length * k / std::sqrt(1 + k * k);
-      double arrow_end_x = mid_x + arrow_length / std::sqrt(1 + k * k);
-      double arrow_end_y = mid_y + arrow_length * k / std::sqrt(1 + k * k);
-      // Change the direction of the arrow if end_y < start_y.
-      if (end_y < start_y) {
-        double temp_x = arrow_start_x;
-        arrow_start_x = arrow_end_x;
-        arrow_end_x = temp_x;
-        double temp_y = arrow_start_y;
-        arrow_start_y = arrow_end_y;
-        arrow_end_y = temp_y;
-      }
-      // Draw the crossing line.
-      cv::Scalar color = GetColorFromPalette(line_id - 1);
-      cv::line(img, cv::Point(start_x, start_y), cv::Point(end_x, end_y), color,
-               kLineThick2);
-      // Draw the arrow.
-      cv::arrowedLine(img, cv::Point(arrow_start_x, arrow_start_y),
-                      cv::Point(arrow_end_x, arrow_end_y), kWhiteColor,
-                      kLineThick1);
-      // Put mark beside the start of this polyline.
-      if (i == 0) {
-        cv::putText(img, absl::StrCat("Line-", line_id),
-                    cv::Point(start_x + 5, start_y - 5), kTextFontFamily, 1,
-                    kWhiteColor, kLineThick1);
-      }
-    }
-  }
+  RecordedDrawing lines;
+  AddCrossingLines(width, height, oc_result, &lines);
+  lines.DrawOnto(img);
 
   struct LineCounts {
     int positive_count = 0;
@@ -513,7 +716,7 @@ void DrawLineCrossingCount(
   }
 
   // Begin drawing stats information
-  cv::Mat overlay = img.clone();
+  OverlayPanel overlay;
 
   // Draw black backgroud for stats table
   int table_width =
@@ -521,133 +724,136 @@ void DrawLineCrossingCount(
   int table_height = kRowHeight * (1 + 2 * count_map[1].size());
   cv::Rect black_background(kXInitOffset, kYInitOffset, table_width,
                             table_height);
-  cv::rectangle(overlay, black_background, kBlackColor,
-                /* fill */ -1);
+  overlay.FillRect(black_background, kBlackColor);
 
   // Draw horizontal lines for the stats table
   for (int i = 0; i <= 1 + 2 * count_map[1].size(); ++i) {
-    cv::line(
-        overlay, cv::Point(kXInitOffset, kYInitOffset + i * kRowHeight),
+    overlay.Line(
+        cv::Point(kXInitOffset, kYInitOffset + i * kRowHeight),
         cv::Point(kXInitOffset + table_width, kYInitOffset + i * kRowHeight),
         kWhiteColor);
   }
 
   // Draw vertical lines for the stats table
-  cv::line(overlay, cv::Point(kXInitOffset, kYInitOffset),
-           cv::Point(kXInitOffset, kYInitOffset + table_height), kWhiteColor);
+  overlay.Line(cv::Point(kXInitOffset, kYInitOffset),
+               cv::Point(kXInitOffset, kYInitOffset + table_height),
+               kWhiteColor);
   for (int i = 0; i <= number_of_lines; ++i) {
-    cv::line(overlay,
-             cv::Point(kXInitOffset + kFirstColumnWidth +
-                           i * kItemColumnWidthLineCrossing,
-                       kYInitOffset),
-             cv::Point(kXInitOffset + kFirstColumnWidth +
-                           i * kItemColumnWidthLineCrossing,
-                       kYInitOffset + table_height),
-             kWhiteColor);
+    overlay.Line(cv::Point(kXInitOffset + kFirstColumnWidth +
+                               i * kItemColumnWidthLineCrossing,
+                           kYInitOffset),
+                 cv::Point(kXInitOffset + kFirstColumnWidth +
+                               i * kItemColumnWidthLineCrossing,
+                           kYInitOffset + table_height),
+                 kWhiteColor);
   }
 
   // Put table header line text
-  cv::putText(overlay, "Line",
-              cv::Point(kXInitOffset + kXTextOffset,
-                        kYInitOffset + kRowHeight + kYTextOffset),
-              kTextFontFamily, kStatsTextLineCrossingFontscale, kWhiteColor,
-              kStatsTextThickness);
+  overlay.PutText("Line",
+                  cv::Point(kXInitOffset + kXTextOffset,
+                            kYInitOffset + kRowHeight + kYTextOffset),
+                  kTextFontFamily, kStatsTextLineCrossingFontscale, kWhiteColor,
+                  kStatsTextThickness);
   for (int line_id = 1; line_id <= number_of_lines; ++line_id) {
-    cv::putText(overlay, absl::StrCat(line_id),
-                cv::Point(kXInitOffset + kFirstColumnWidth +
-                              (line_id - 1) * kItemColumnWidthLineCrossing +
-                              kXTextOffset,
-                          kYInitOffset + kRowHeight + kYTextOffset),
-                kTextFontFamily, kStatsTextLineCrossingFontscale, kWhiteColor,
-                kStatsTextThickness);
+    overlay.PutText(absl::StrCat(line_id),
+                    cv::Point(kXInitOffset + kFirstColumnWidth +
+                                  (line_id - 1) * kItemColumnWidthLineCrossing +
+                                  kXTextOffset,
+                              kYInitOffset + kRowHeight + kYTextOffset),
+                    kTextFontFamily, kStatsTextLineCrossingFontscale,
+                    kWhiteColor, kStatsTextThickness);
   }
 
   // Put person count line
   int y_index = 2;
   if (count_map[1].contains("Person")) {
-    cv::putText(overlay, "Person Enter",
-                cv::Point(kXInitOffset + kXTextOffset,
-                          kYInitOffset + kRowHeight * y_index + kYTextOffset),
-                kTextFontFamily, kStatsTextLineCrossingFontscale, kWhiteColor,
-                kStatsTextThickness);
+    overlay.PutText("Person Enter",
+                    cv::Point(
+                        kXInitOffset + kXTextOffset,
+                        kYInitOffset + kRowHeight * y_index + kYTextOffset),
+                    kTextFontFamily, kStatsTextLineCrossingFontscale,
+                    kWhiteColor, kStatsTextThickness);
     for (int line_id = 1; line_id <= number_of_lines; ++line_id) {
-      cv::putText(overlay,
-                  absl::StrCat(count_map[line_id]["Person"].positive_count),
-                  cv::Point(kXInitOffset + kFirstColumnWidth +
-                                (line_id - 1) * kItemColumnWidthLineCrossing +
-                                kXTextOffset,
-                            kYInitOffset + kRowHeight * y_index + kYTextOffset),
-                  kTextFontFamily, kStatsTextLineCrossingFontscale, kWhiteColor,
-                  kStatsTextThickness);
+      overlay.PutText(absl::StrCat(count_map[line_id]["Person"].positive_count),
+                      cv::Point(
+                          kXInitOffset + kFirstColumnWidth +
+                              (line_id - 1) * kItemColumnWidthLineCrossing +
+                              kXTextOffset,
+                          kYInitOffset + kRowHeight * y_index + kYTextOffset),
+                      kTextFontFamily, kStatsTextLineCrossingFontscale,
+                      kWhiteColor, kStatsTextThickness);
     }
     y_index++;
-    cv::putText(overlay, "Person Exit",
-                cv::Point(kXInitOffset + kXTextOffset,
-                          kYInitOffset + kRowHeight * y_index + kYTextOffset),
-                kTextFontFamily, kStatsTextLineCrossingFontscale, kWhiteColor,
-                kStatsTextThickness);
+    overlay.PutText("Person Exit",
+                    cv::Point(
+                        kXInitOffset + kXTextOffset,
+                        kYInitOffset + kRowHeight * y_index + kYTextOffset),
+                    kTextFontFamily, kStatsTextLineCrossingFontscale,
+                    kWhiteColor, kStatsTextThickness);
     for (int line_id = 1; line_id <= number_of_lines; ++line_id) {
-      cv::putText(overlay,
-                  absl::StrCat(count_map[line_id]["Person"].negative_count),
-                  cv::Point(kXInitOffset + kFirstColumnWidth +
-                                (line_id - 1) * kItemColumnWidthLineCrossing +
-                                kXTextOffset,
-                            kYInitOffset + kRowHeight * y_index + kYTextOffset),
-                  kTextFontFamily, kStatsTextLineCrossingFontscale, kWhiteColor,
-                  kStatsTextThickness);
+      overlay.PutText(absl::StrCat(count_map[line_id]["Person"].negative_count),
+                      cv::Point(
+                          kXInitOffset + kFirstColumnWidth +
+                              (line_id - 1) * kItemColumnWidthLineCrossing +
+                              kXTextOffset,
+                          kYInitOffset + kRowHeight * y_index + kYTextOffset),
+                      kTextFontFamily, kStatsTextLineCrossingFontscale,
+                      kWhiteColor, kStatsTextThickness);
     }
     y_index++;
   }
 
   // Put vehicle count line
   if (count_map[1].contains("Vehicle")) {
-    cv::putText(overlay, "Vehicle Enter",
-                cv::Point(kXInitOffset + kXTextOffset,
-                          kYInitOffset + kRowHeight * y_index + kYTextOffset),
-                kTextFontFamily, kStatsTextLineCrossingFontscale, kWhiteColor,
-                kStatsTextThickness);
+    overlay.PutText("Vehicle Enter",
+                    cv::Point(
+                        kXInitOffset + kXTextOffset,
+                        kYInitOffset + kRowHeight * y_index + kYTextOffset),
+                    kTextFontFamily, kStatsTextLineCrossingFontscale,
+                    kWhiteColor, kStatsTextThickness);
     for (int line_id = 1; line_id <= number_of_lines; ++line_id) {
-      cv::putText(overlay,
-                  absl::StrCat(count_map[line_id]["Vehicle"].positive_count),
-                  cv::Point(kXInitOffset + kFirstColumnWidth +
-                                (line_id - 1) * kItemColumnWidthLineCrossing +
-                                kXTextOffset,
-                            kYInitOffset + kRowHeight * y_index + kYTextOffset),
-                  kTextFontFamily, kStatsTextLineCrossingFontscale, kWhiteColor,
-                  kStatsTextThickness);
+      overlay.PutText(
+          absl::StrCat(count_map[line_id]["Vehicle"].positive_count),
+          cv::Point(kXInitOffset + kFirstColumnWidth +
+                        (line_id - 1) * kItemColumnWidthLineCrossing +
+                        kXTextOffset,
+                    kYInitOffset + kRowHeight * y_index + kYTextOffset),
+          kTextFontFamily, kStatsTextLineCrossingFontscale, kWhiteColor,
+          kStatsTextThickness);
     }
     y_index++;
-    cv::putText(overlay, "Vehicle Exit",
-                cv::Point(kXInitOffset + kXTextOffset,
-                          kYInitOffset + kRowHeight * y_index + kYTextOffset),
-                kTextFontFamily, kStatsTextLineCrossingFontscale, kWhiteColor,
-                kStatsTextThickness);
+    overlay.PutText("Vehicle Exit",
+                    cv::Point(
+                        kXInitOffset + kXTextOffset,
+                        kYInitOffset + kRowHeight * y_index + kYTextOffset),
+                    kTextFontFamily, kStatsTextLineCrossingFontscale,
+                    kWhiteColor, kStatsTextThickness);
     for (int line_id = 1; line_id <= number_of_lines; ++line_id) {
-      cv::putText(overlay,
-                  absl::StrCat(count_map[line_id]["Vehicle"].negative_count),
-                  cv::Point(kXInitOffset + kFirstColumnWidth +
-                                (line_id - 1) * kItemColumnWidthLineCrossing +
-                                kXTextOffset,
-                            kYInitOffset + kRowHeight * y_index + kYTextOffset),
-                  kTextFontFamily, kStatsTextLineCrossingFontscale, kWhiteColor,
-                  kStatsTextThickness);
+      overlay.PutText(
+          absl::StrCat(count_map[line_id]["Vehicle"].negative_count),
+          cv::Point(kXInitOffset + kFirstColumnWidth +
+                        (line_id - 1) * kItemColumnWidthLineCrossing +
+                        kXTextOffset,
+                    kYInitOffset + kRowHeight * y_index + kYTextOffset),
+          kTextFontFamily, kStatsTextLineCrossingFontscale, kWhiteColor,
+          kStatsTextThickness);
     }
     y_index++;
   }
 
   // Blend the stats with original image
-  cv::addWeighted(overlay, stats_alpha, img, 1 - stats_alpha, 0, img);
+  overlay.BlendInto(img, stats_alpha);
 }
 
 void ShowAnnotationFps(cv::Mat img, double fps, double stats_alpha) {
   int width = img.cols;
 
-  cv::Mat overlay = img.clone();
+  OverlayPanel overlay;
   int rect_width = 180;
   int rect_height = 20;
   cv::Rect black_background(width - kXInitOffset - rect_width, kYInitOffset,
                             rect_width, rect_height);
-  cv::rectangle(overlay, black_background, kBlackColor, /* fill */ -1);
+  overlay.FillRect(black_background, kBlackColor);
 
   std::string fps_str;
   if (fps == 0.0) {
@@ -657,13 +863,13 @@ void ShowAnnotationFps(cv::Mat img, double fps, double stats_alpha) {
     // Round to 2 digits after decimal point.
     fps_str = absl::StrCat(std::ceil(fps * 100.0) / 100.0);
   }
-  cv::putText(overlay, absl::StrCat("Annotation FPS: ", fps_str),
-              cv::Point(width - kXInitOffset - rect_width,
-                        kYInitOffset + rect_height - 5),
-              kTextFontFamily, kTrackTextFontscale, kWhiteColor);
+  overlay.PutText(absl::StrCat("Annotation FPS: ", fps_str),
+                  cv::Point(width - kXInitOffset - rect_width,
+                            kYInitOffset + rect_height - 5),
+                  kTextFontFamily, kTrackTextFontscale, kWhiteColor);
 
   // Blend the stats with original image
-  cv::addWeighted(overlay, stats_alpha, img, 1 - stats_alpha, 0, img);
+  overlay.BlendInto(img, stats_alpha);
 }
 }  // namespace renderutils
 }  // namespace visionai
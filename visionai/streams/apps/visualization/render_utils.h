@@ -52,6 +52,139 @@ void DrawBoundingBoxesWithDwellTime(
         dwell_stats_map,
     bool show_score = false);
 
+// Shapes and text recorded to be drawn onto frames later on.
+//
+// Recording the elements rather than drawing them right away lets the
+// subclasses below bound the region of the frame that they cover, and draw
+// them more than once.
+class RecordedDrawing {
+ public:
+  // Same as cv::rectangle(img, rect, color, /* fill */ -1).
+  void FillRect(const cv::Rect& rect, const cv::Scalar& color);
+
+  // Same as cv::line(img, from, to, color, thickness).
+  void Line(const cv::Point& from, const cv::Point& to, const cv::Scalar& color,
+            int thickness = 1);
+
+  // Same as cv::arrowedLine(img, from, to, color, thickness).
+  void ArrowedLine(const cv::Point& from, const cv::Point& to,
+                   const cv::Scalar& color, int thickness = 1);
+
+  // Same as cv::drawContours(img, {contour}, 0, color, thickness).
+  void Contour(std::vector<cv::Point> contour, const cv::Scalar& color,
+               int thickness = 1);
+
+  // Same as cv::putText(img, text, origin, font_face, font_scale, color,
+  // thickness).
+  void PutText(std::string text, const cv::Point& origin, int font_face,
+               double font_scale, const cv::Scalar& color, int thickness = 1);
+
+  // Returns the region of a frame of `size` that the elements may cover.
+  cv::Rect Region(const cv::Size& size) const;
+
+  // Returns the number of elements recorded so far.
+  int size() const { return static_cast<int>(elements_.size()); }
+
+  // Returns true if no element has been recorded.
+  bool empty() const { return elements_.empty(); }
+
+  // Draws the elements onto `img` in the order they were recorded.
+  void DrawOnto(cv::Mat img) const;
+
+ protected:
+  // Draws the elements onto `img`, whose origin is at `offset` in the frame.
+  //
+  // Draws all of them in `color` rather than their own color if it is not
+  // null.
+  void DrawElements(const cv::Point& offset, const cv::Scalar* color,
+                    cv::Mat img) const;
+
+ private:
+  enum class Kind { kFilledRect, kLine, kArrowedLine, kContour, kText };
+
+  struct Element {
+    Kind kind;
+    // The filled rectangle.
+    cv::Rect rect;
+    // The end points of the line, or the origin of the text in `from`.
+    cv::Point from;
+    cv::Point to;
+    // The contour, as the only element of a list of contours.
+    std::vector<std::vector<cv::Point>> contours;
+    cv::Scalar color;
+    int thickness = 1;
+    std::string text;
+    int font_face = 0;
+    double font_scale = 1;
+  };
+
+  // Records `element`, which may cover `bounds`.
+  void Add(Element element, const cv::Rect& bounds);
+
+  static void DrawElement(const Element& element, const cv::Point& offset,
+                          const cv::Scalar& color, cv::Mat img);
+
+  std::vector<Element> elements_;
+
+  // The union of the regions that the elements may cover.
+  cv::Rect bounds_;
+};
+
+// A semi-transparent panel of shapes and text blended onto a frame.
+//
+// Drawing the panel onto a copy of the whole frame and blending the whole frame
+// back would cost two full-frame passes for a few small shapes. The panel
+// records its elements instead, and only copies and blends the region of the
+// frame that they cover. The result is the same, pixel for pixel.
+class OverlayPanel : public RecordedDrawing {
+ public:
+  // Draws the elements onto `img` in the order they were added, blended with
+  // weight `alpha` against the original pixels.
+  void BlendInto(cv::Mat img, double alpha) const;
+};
+
+// An opaque layer of shapes and text that stays the same across frames, e.g.
+// the zones and lines of an annotation.
+//
+// The layer rasterizes its elements once, along with a mask of the pixels that
+// they cover, and then only copies the masked pixels onto each frame. Since
+// the elements are opaque, this yields the same pixels as drawing them again.
+// The layer is rasterized again if the frame size changes, or if more elements
+// are recorded.
+class StaticLayer : public RecordedDrawing {
+ public:
+  // Draws the elements onto `img`.
+  void CompositeOnto(cv::Mat img);
+
+ private:
+  // The frame size and number of elements that `pixels_` was rasterized for.
+  cv::Size rasterized_size_;
+  int rasterized_elements_ = 0;
+
+  // The region of the frame that the elements cover, along with their pixels
+  // and mask within that region.
+  cv::Rect region_;
+  cv::Mat pixels_;
+  cv::Mat mask_;
+};
+
+// Records the active zones of Occupancy Counter prediction result protobuf and
+// their labels, for frames of `width` x `height`.
+void AddActiveZones(
+    int width, int height,
+    const google::cloud::visionai::v1::OccupancyCountingPredictionResult&
+        oc_result,
+    RecordedDrawing* drawing);
+
+// Records the crossing lines of Occupancy Counter prediction result protobuf,
+// along with their direction arrows and labels, for frames of `width` x
+// `height`.
+void AddCrossingLines(
+    int width, int height,
+    const google::cloud::visionai::v1::OccupancyCountingPredictionResult&
+        oc_result,
+    RecordedDrawing* drawing);
+
 // Draws full frame count stats based on Occupancy Counter prediction result
 // protobuf
 void DrawFullFrameCount(
@@ -926,6 +926,115 @@ TEST(DrawBoundingBoxesWithDwellTime, CleanMaps) {
     EXPECT_TRUE(dwell_stats_map.contains("2"));
   }
 }
+
+// Tests if OverlayPanel blends the same pixels as blending a whole frame.
+TEST(OverlayPanel, MatchesFullFrameBlend) {
+  cv::Mat image(240, 320, CV_8UC3);
+  cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(256));
+  cv::Mat expected_image = image.clone();
+
+  // Elements inside the frame, and elements clipped by each of its borders.
+  renderutils::OverlayPanel panel;
+  cv::Mat overlay = expected_image.clone();
+  panel.FillRect(cv::Rect(20, 30, 100, 60), kBlackColor);
+  cv::rectangle(overlay, cv::Rect(20, 30, 100, 60), kBlackColor,
+                /* fill */ -1);
+  panel.FillRect(cv::Rect(-10, -10, 40, 30), kRedColor);
+  cv::rectangle(overlay, cv::Rect(-10, -10, 40, 30), kRedColor,
+                /* fill */ -1);
+  panel.Line(cv::Point(20, 30), cv::Point(119, 89), kWhiteColor, kLineThick2);
+  cv::line(overlay, cv::Point(20, 30), cv::Point(119, 89), kWhiteColor,
+           kLineThick2);
+  panel.Line(cv::Point(300, 200), cv::Point(330, 250), kWhiteColor, 5);
+  cv::line(overlay, cv::Point(300, 200), cv::Point(330, 250), kWhiteColor, 5);
+  panel.PutText("Person", cv::Point(30, 60), kStatsTextFontFamily,
+                kStatsTextFontscale, kWhiteColor, kStatsTextThickness);
+  cv::putText(overlay, "Person", cv::Point(30, 60), kStatsTextFontFamily,
+              kStatsTextFontscale, kWhiteColor, kStatsTextThickness);
+  panel.PutText("Annotation FPS: 30", cv::Point(250, 235),
+                kStatsTextFontFamily, kStatsTextFontscale, kWhiteColor);
+  cv::putText(overlay, "Annotation FPS: 30", cv::Point(250, 235),
+              kStatsTextFontFamily, kStatsTextFontscale, kWhiteColor);
+  cv::addWeighted(overlay, 0.6, expected_image, 0.4, 0, expected_image);
+
+  panel.BlendInto(image, 0.6);
+  EXPECT_TRUE(testutils::CheckTwoImagesEqual(image, expected_image));
+}
+
+// Tests if OverlayPanel only touches the region that its elements cover.
+TEST(OverlayPanel, Region) {
+  renderutils::OverlayPanel panel;
+  EXPECT_TRUE(panel.Region(cv::Size(320, 240)).empty());
+
+  panel.FillRect(cv::Rect(20, 30, 100, 60), kBlackColor);
+  EXPECT_EQ(panel.Region(cv::Size(320, 240)), cv::Rect(20, 30, 100, 60));
+
+  // Elements that stick out of the frame are clipped to it.
+  panel.FillRect(cv::Rect(300, 200, 100, 100), kBlackColor);
+  EXPECT_EQ(panel.Region(cv::Size(320, 240)), cv::Rect(20, 30, 300, 210));
+
+  // Nothing changes outside of the region.
+  cv::Mat image(240, 320, CV_8UC3, kWhiteColor);
+  panel.BlendInto(image, 0.5);
+  EXPECT_EQ(image.at<cv::Vec3b>(0, 0), cv::Vec3b(255, 255, 255));
+  EXPECT_EQ(image.at<cv::Vec3b>(29, 20), cv::Vec3b(255, 255, 255));
+  EXPECT_NE(image.at<cv::Vec3b>(30, 20), cv::Vec3b(255, 255, 255));
+}
+
+// Tests if StaticLayer draws the same pixels as drawing its elements directly,
+// on every frame that it is composited onto.
+TEST(StaticLayer, MatchesDirectDrawing) {
+  std::vector<cv::Point> contour = {cv::Point(-20, 40), cv::Point(200, 10),
+                                    cv::Point(310, 230), cv::Point(30, 200)};
+  renderutils::StaticLayer layer;
+  layer.Contour(contour, renderutils::GetColorFromPalette(0), kLineThick2);
+  layer.Line(cv::Point(10, 120), cv::Point(330, 120),
+             renderutils::GetColorFromPalette(1), kLineThick2);
+  // Black elements must be drawn too, even onto a black canvas.
+  layer.ArrowedLine(cv::Point(160, 60), cv::Point(160, 180), kBlackColor,
+                    kLineThick1);
+  layer.PutText("Zone-1", cv::Point(-5, 30), kStatsTextFontFamily,
+                kStatsTextFontscale, kWhiteColor, kStatsTextThickness);
+
+  for (int i = 0; i < 3; ++i) {
+    cv::Mat image(240, 320, CV_8UC3);
+    cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(256));
+    cv::Mat expected_image = image.clone();
+    cv::drawContours(expected_image,
+                     std::vector<std::vector<cv::Point>>{contour}, 0,
+                     renderutils::GetColorFromPalette(0), kLineThick2);
+    cv::line(expected_image, cv::Point(10, 120), cv::Point(330, 120),
+             renderutils::GetColorFromPalette(1), kLineThick2);
+    cv::arrowedLine(expected_image, cv::Point(160, 60), cv::Point(160, 180),
+                    kBlackColor, kLineThick1);
+    cv::putText(expected_image, "Zone-1", cv::Point(-5, 30),
+                kStatsTextFontFamily, kStatsTextFontscale, kWhiteColor,
+                kStatsTextThickness);
+
+    layer.CompositeOnto(image);
+    EXPECT_TRUE(testutils::CheckTwoImagesEqual(image, expected_image)) << i;
+  }
+}
+
+// Tests if StaticLayer is rasterized again when the frame size changes or
+// more elements are recorded.
+TEST(StaticLayer, Invalidation) {
+  renderutils::StaticLayer layer;
+  layer.Line(cv::Point(0, 5), cv::Point(100, 5), kWhiteColor);
+
+  cv::Mat small_image(10, 10, CV_8UC3, kBlackColor);
+  layer.CompositeOnto(small_image);
+  EXPECT_EQ(cv::countNonZero(small_image.reshape(1)), 3 * 10);
+
+  cv::Mat large_image(10, 50, CV_8UC3, kBlackColor);
+  layer.CompositeOnto(large_image);
+  EXPECT_EQ(cv::countNonZero(large_image.reshape(1)), 3 * 50);
+
+  layer.Line(cv::Point(0, 7), cv::Point(100, 7), kWhiteColor);
+  large_image.setTo(kBlackColor);
+  layer.CompositeOnto(large_image);
+  EXPECT_EQ(cv::countNonZero(large_image.reshape(1)), 2 * 3 * 50);
+}
 }  // namespace
 
 }  // namespace visionai
@@ -36,9 +36,16 @@ const AttrDef* FindAttrDef(absl::string_view name, const T& def) {
 CaptureModule::CaptureModule(const visionai::CaptureConfig& config)
     : config_(config) {}
 
+CaptureModule& CaptureModule::EnableStageTracing(bool enable) {
+  trace_stages_ = enable;
+  return *this;
+}
+
 CaptureModule& CaptureModule::AttachOutput(
-    std::shared_ptr<RingBuffer<Packet>> capture_output_buffer) {
+    std::shared_ptr<RingBuffer<Packet>> capture_output_buffer,
+    std::shared_ptr<QueueMetrics> capture_output_metrics) {
   capture_output_buffer_ = std::move(capture_output_buffer);
+  capture_output_metrics_ = std::move(capture_output_metrics);
   return *this;
 }
 
@@ -82,6 +89,8 @@ CaptureModule::CreateCaptureRunContext() {
   }
   CaptureRunContext::RunData d;
   d.output_buffer = capture_output_buffer_;
+  d.trace_stages = trace_stages_;
+  d.output_metrics = capture_output_metrics_;
   return std::make_unique<CaptureRunContext>(std::move(d));
 }
 
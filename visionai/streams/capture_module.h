@@ -17,6 +17,7 @@
 #include "visionai/streams/framework/capture.h"
 #include "visionai/proto/ingester_config.pb.h"
 #include "visionai/streams/packet/packet.h"
+#include "visionai/streams/util/queue_metrics.h"
 #include "visionai/util/ring_buffer.h"
 
 namespace visionai {
@@ -32,11 +33,17 @@ class CaptureModule {
   // `Prepare` to get a usable instance.
   explicit CaptureModule(const visionai::CaptureConfig&);
 
-  // Attach the output buffer into which to push captured Packets.
+  // Attach the output buffer into which to push captured Packets, along with
+  // the metrics of its traffic, if any.
   //
   // TODO: Change to Packets.
   CaptureModule& AttachOutput(
-      std::shared_ptr<RingBuffer<Packet>> output_buffer);
+      std::shared_ptr<RingBuffer<Packet>> output_buffer,
+      std::shared_ptr<QueueMetrics> output_metrics = nullptr);
+
+  // Trace the latency of each stage of the captured Packets through the
+  // dataflow. See streams/util/stage_trace.h.
+  CaptureModule& EnableStageTracing(bool enable);
 
   // Finalizes the builder configuration and initializes the CaptureModule.
   //
@@ -69,6 +76,8 @@ class CaptureModule {
   const CaptureConfig config_;
 
   std::shared_ptr<RingBuffer<Packet>> capture_output_buffer_ = nullptr;
+  std::shared_ptr<QueueMetrics> capture_output_metrics_ = nullptr;
+  bool trace_stages_ = false;
   std::unique_ptr<CaptureInitContext> capture_init_ctx_ = nullptr;
   std::unique_ptr<CaptureRunContext> capture_run_ctx_ = nullptr;
   std::unique_ptr<Capture> capture_ = nullptr;
@@ -0,0 +1,137 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/streams/client/async_packet_sender.h"
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "glog/logging.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "visionai/streams/client/packet_sender.h"
+#include "visionai/streams/packet/packet.h"
+
+namespace visionai {
+
+AsyncPacketSender::AsyncPacketSender(std::unique_ptr<PacketSender> sender,
+                                     const Options& options)
+    : PacketSender(PacketSender::Options()),
+      async_options_(options),
+      sender_(std::move(sender)) {}
+
+absl::StatusOr<std::unique_ptr<AsyncPacketSender>> AsyncPacketSender::Create(
+    std::unique_ptr<PacketSender> sender, const Options& options) {
+  if (sender == nullptr) {
+    return absl::InvalidArgumentError("Given a null PacketSender.");
+  }
+  if (options.max_queued_bytes <= 0) {
+    return absl::InvalidArgumentError(
+        "The size of the send queue must be positive.");
+  }
+  auto async_sender =
+      absl::WrapUnique(new AsyncPacketSender(std::move(sender), options));
+  AsyncPacketSender* s = async_sender.get();
+  async_sender->sender_thread_ = std::thread([s]() { s->SendMain(); });
+  return std::move(async_sender);
+}
+
+AsyncPacketSender::~AsyncPacketSender() {
+  {
+    absl::MutexLock lock(&mu_);
+    is_stopping_ = true;
+  }
+  if (sender_thread_.joinable()) {
+    sender_thread_.join();
+  }
+}
+
+absl::Status AsyncPacketSender::Send(Packet packet) {
+  return Send(std::move(packet), absl::InfiniteDuration());
+}
+
+absl::Status AsyncPacketSender::Send(Packet packet, absl::Duration timeout) {
+  int64_t num_bytes = packet.ByteSizeLong();
+  absl::MutexLock lock(&mu_);
+  auto can_queue = [this, num_bytes]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return !status_.ok() || queue_.empty() ||
+           num_outstanding_bytes_ + num_bytes <=
+               async_options_.max_queued_bytes;
+  };
+  if (!mu_.AwaitWithTimeout(absl::Condition(&can_queue), timeout)) {
+    return absl::CancelledError(absl::StrFormat(
+        "The send queue remained full (%d bytes) for %s.",
+        num_outstanding_bytes_, absl::FormatDuration(timeout)));
+  }
+  if (!status_.ok()) {
+    return status_;
+  }
+  queue_.push_back({std::move(packet), num_bytes});
+  num_outstanding_bytes_ += num_bytes;
+  ++num_outstanding_packets_;
+  return absl::OkStatus();
+}
+
+absl::Status AsyncPacketSender::Flush(absl::Duration timeout) {
+  absl::MutexLock lock(&mu_);
+  auto is_flushed = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return num_outstanding_packets_ == 0;
+  };
+  if (!mu_.AwaitWithTimeout(absl::Condition(&is_flushed), timeout)) {
+    return absl::DeadlineExceededError(absl::StrFormat(
+        "%d packets (%d bytes) remain to be sent after %s.",
+        num_outstanding_packets_, num_outstanding_bytes_,
+        absl::FormatDuration(timeout)));
+  }
+  return status_;
+}
+
+int64_t AsyncPacketSender::num_outstanding_bytes() {
+  absl::MutexLock lock(&mu_);
+  return num_outstanding_bytes_;
+}
+
+void AsyncPacketSender::SendMain() {
+  while (true) {
+    QueuedPacket queued;
+    {
+      absl::MutexLock lock(&mu_);
+      auto has_work = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        return is_stopping_ || !queue_.empty();
+      };
+      mu_.Await(absl::Condition(&has_work));
+      if (queue_.empty()) {
+        return;
+      }
+      queued = std::move(queue_.front());
+      queue_.pop_front();
+    }
+
+    auto status = sender_->Send(std::move(queued.packet));
+
+    absl::MutexLock lock(&mu_);
+    num_outstanding_bytes_ -= queued.num_bytes;
+    --num_outstanding_packets_;
+    if (!status.ok() && status_.ok()) {
+      LOG(ERROR) << "Dropping the " << queue_.size()
+                 << " queued packets after a failed send: " << status;
+      status_ = status;
+      for (const auto& dropped : queue_) {
+        num_outstanding_bytes_ -= dropped.num_bytes;
+      }
+      num_outstanding_packets_ -= queue_.size();
+      queue_.clear();
+    }
+  }
+}
+
+}  // namespace visionai
@@ -0,0 +1,104 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef THIRD_PARTY_VISIONAI_STREAMS_CLIENT_ASYNC_PACKET_SENDER_H_
+#define THIRD_PARTY_VISIONAI_STREAMS_CLIENT_ASYNC_PACKET_SENDER_H_
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <thread>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "visionai/streams/client/packet_sender.h"
+#include "visionai/streams/packet/packet.h"
+
+namespace visionai {
+
+// The AsyncPacketSender is a PacketSender that sends the packets of another
+// PacketSender from a background thread.
+//
+// `Send` only queues the packet, so that the caller is not held up by the
+// round trips to the server. The queue is bounded by the total size of the
+// packets it holds: `Send` blocks while it is full, which pushes back on the
+// caller once the network falls behind for longer than the queue can absorb.
+//
+// The first error of the underlying PacketSender is sticky, as it is for any
+// PacketSender: the packets that are still queued are dropped, and `Send` and
+// `Flush` return it from then on.
+//
+// `Send` must not be called concurrently.
+class AsyncPacketSender : public PacketSender {
+ public:
+  struct Options {
+    // The most bytes of packets that may wait to be sent. A packet that is
+    // larger on its own is still accepted into an empty queue.
+    int64_t max_queued_bytes = 64 << 20;
+  };
+
+  // Creates an instance that sends through `sender`.
+  static absl::StatusOr<std::unique_ptr<AsyncPacketSender>> Create(
+      std::unique_ptr<PacketSender> sender, const Options& options);
+
+  // Queues `packet` to be sent.
+  //
+  // The first overload blocks until there is room in the queue. The second
+  // one blocks for at most `timeout`, after which it returns CANCELLED
+  // without queueing `packet`; this error is not sticky.
+  //
+  // Returns the error of an earlier send, if any.
+  absl::Status Send(Packet packet) override;
+  absl::Status Send(Packet packet, absl::Duration timeout) override;
+
+  // Waits for up to `timeout` for all of the queued packets to be sent.
+  //
+  // Returns DEADLINE_EXCEEDED if some are still outstanding at the deadline,
+  // and the error of the underlying PacketSender if any.
+  absl::Status Flush(absl::Duration timeout = absl::InfiniteDuration())
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Returns the total size of the packets that have not been sent yet.
+  int64_t num_outstanding_bytes() ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Sends the packets that remain in the queue, and then stops.
+  ~AsyncPacketSender() override;
+
+  AsyncPacketSender(const AsyncPacketSender&) = delete;
+  AsyncPacketSender& operator=(const AsyncPacketSender&) = delete;
+
+ private:
+  AsyncPacketSender(std::unique_ptr<PacketSender> sender,
+                    const Options& options);
+
+  struct QueuedPacket {
+    Packet packet;
+    int64_t num_bytes = 0;
+  };
+
+  // The main loop of `sender_thread_`.
+  void SendMain() ABSL_LOCKS_EXCLUDED(mu_);
+
+  const Options async_options_;
+  const std::unique_ptr<PacketSender> sender_;
+
+  absl::Mutex mu_;
+  bool is_stopping_ ABSL_GUARDED_BY(mu_) = false;
+  absl::Status status_ ABSL_GUARDED_BY(mu_);
+  std::deque<QueuedPacket> queue_ ABSL_GUARDED_BY(mu_);
+  // The bytes of the packets in `queue_` and of the one being sent.
+  int64_t num_outstanding_bytes_ ABSL_GUARDED_BY(mu_) = 0;
+  int64_t num_outstanding_packets_ ABSL_GUARDED_BY(mu_) = 0;
+
+  std::thread sender_thread_;
+};
+
+}  // namespace visionai
+
+#endif  // THIRD_PARTY_VISIONAI_STREAMS_CLIENT_ASYNC_PACKET_SENDER_H_
@@ -0,0 +1,167 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/streams/client/async_packet_sender.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "visionai/streams/client/packet_sender.h"
+#include "visionai/streams/packet/packet.h"
+
+namespace visionai {
+namespace {
+
+using ::testing::ElementsAre;
+
+constexpr absl::Duration kTestTimeout = absl::Seconds(30);
+
+Packet MakeTestPacket(const std::string& s) {
+  return *MakePacket(std::string(s));
+}
+
+std::string PacketString(Packet p) {
+  auto s = PacketAs<std::string>(std::move(p));
+  return s.ok() ? *s : "";
+}
+
+// A channel that only takes packets while it is open.
+class FakeChannel {
+ public:
+  class Sender : public PacketSender {
+   public:
+    explicit Sender(FakeChannel* channel)
+        : PacketSender(PacketSender::Options()), channel_(channel) {}
+
+    absl::Status Send(Packet p) override {
+      return Send(std::move(p), absl::InfiniteDuration());
+    }
+
+    absl::Status Send(Packet p, absl::Duration timeout) override {
+      return channel_->Receive(std::move(p));
+    }
+
+   private:
+    FakeChannel* const channel_;
+  };
+
+  void Open() {
+    absl::MutexLock lock(&mu_);
+    is_open_ = true;
+  }
+
+  // Fails every packet from now on.
+  void Fail(absl::Status status) {
+    absl::MutexLock lock(&mu_);
+    status_ = status;
+  }
+
+  std::vector<std::string> received() {
+    absl::MutexLock lock(&mu_);
+    return received_;
+  }
+
+ private:
+  absl::Status Receive(Packet p) {
+    absl::MutexLock lock(&mu_);
+    mu_.Await(absl::Condition(&is_open_));
+    if (!status_.ok()) {
+      return status_;
+    }
+    received_.push_back(PacketString(std::move(p)));
+    return absl::OkStatus();
+  }
+
+  absl::Mutex mu_;
+  bool is_open_ ABSL_GUARDED_BY(mu_) = false;
+  absl::Status status_ ABSL_GUARDED_BY(mu_);
+  std::vector<std::string> received_ ABSL_GUARDED_BY(mu_);
+};
+
+class AsyncPacketSenderTest : public ::testing::Test {
+ protected:
+  std::unique_ptr<AsyncPacketSender> CreateSender(int64_t max_queued_bytes) {
+    AsyncPacketSender::Options options;
+    options.max_queued_bytes = max_queued_bytes;
+    auto sender = AsyncPacketSender::Create(
+        std::make_unique<FakeChannel::Sender>(&channel_), options);
+    EXPECT_TRUE(sender.ok()) << sender.status();
+    return sender.ok() ? *std::move(sender) : nullptr;
+  }
+
+  FakeChannel channel_;
+};
+
+TEST_F(AsyncPacketSenderTest, SendsInOrderWithoutBlocking) {
+  auto sender = CreateSender(1 << 20);
+  ASSERT_NE(sender, nullptr);
+
+  // The underlying sender is stalled, yet the sends return right away.
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(sender->Send(MakeTestPacket(absl::StrCat(i))).ok());
+  }
+  EXPECT_GT(sender->num_outstanding_bytes(), 0);
+  EXPECT_EQ(sender->Flush(absl::Milliseconds(10)).code(),
+            absl::StatusCode::kDeadlineExceeded);
+
+  channel_.Open();
+  EXPECT_TRUE(sender->Flush(kTestTimeout).ok());
+  EXPECT_EQ(sender->num_outstanding_bytes(), 0);
+  EXPECT_THAT(channel_.received(), ElementsAre("0", "1", "2"));
+}
+
+TEST_F(AsyncPacketSenderTest, BlocksWhileTheQueueIsFull) {
+  Packet packet = MakeTestPacket("a");
+  auto sender = CreateSender(2 * packet.ByteSizeLong());
+  ASSERT_NE(sender, nullptr);
+
+  // The first two packets fill the queue, whether or not one is in flight.
+  EXPECT_TRUE(sender->Send(packet).ok());
+  EXPECT_TRUE(sender->Send(MakeTestPacket("b")).ok());
+  EXPECT_EQ(sender->Send(MakeTestPacket("c"), absl::Milliseconds(10)).code(),
+            absl::StatusCode::kCancelled);
+
+  channel_.Open();
+  EXPECT_TRUE(sender->Send(MakeTestPacket("d"), kTestTimeout).ok());
+  EXPECT_TRUE(sender->Flush(kTestTimeout).ok());
+  EXPECT_THAT(channel_.received(), ElementsAre("a", "b", "d"));
+}
+
+TEST_F(AsyncPacketSenderTest, ReportsTheFirstError) {
+  auto sender = CreateSender(1 << 20);
+  ASSERT_NE(sender, nullptr);
+  channel_.Fail(absl::UnavailableError("down"));
+  EXPECT_TRUE(sender->Send(MakeTestPacket("a")).ok());
+  EXPECT_TRUE(sender->Send(MakeTestPacket("b")).ok());
+
+  channel_.Open();
+  EXPECT_EQ(sender->Flush(kTestTimeout).code(),
+            absl::StatusCode::kUnavailable);
+  EXPECT_EQ(sender->Send(MakeTestPacket("c")).code(),
+            absl::StatusCode::kUnavailable);
+  EXPECT_EQ(sender->num_outstanding_bytes(), 0);
+  EXPECT_TRUE(channel_.received().empty());
+}
+
+TEST_F(AsyncPacketSenderTest, SendsTheQueuedPacketsBeforeDestruction) {
+  auto sender = CreateSender(1 << 20);
+  ASSERT_NE(sender, nullptr);
+  EXPECT_TRUE(sender->Send(MakeTestPacket("a")).ok());
+  EXPECT_TRUE(sender->Send(MakeTestPacket("b")).ok());
+  channel_.Open();
+  sender = nullptr;
+  EXPECT_THAT(channel_.received(), ElementsAre("a", "b"));
+}
+
+}  // namespace
+}  // namespace visionai
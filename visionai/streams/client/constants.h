@@ -46,6 +46,9 @@ constexpr absl::Duration kDefaultServerHeartbeatInterval = absl::Minutes(1);
 // Default heartbeat grace period.
 constexpr absl::Duration kDefaultHeartbeatGracePeriod = absl::Seconds(20);
 
+// Default minimum interval between two offset commits sent to the server.
+constexpr absl::Duration kDefaultCommitInterval = absl::Seconds(1);
+
 // Err Message Prefix for PacketReceiver.
 constexpr char kPacketReceiverErrMsgPrefix[] = "[PacketReceiver]";
 
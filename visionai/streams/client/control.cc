@@ -7,6 +7,7 @@
 #include "visionai/streams/client/control.h"
 
 #include <algorithm>
+#include <thread>
 
 #include "google/cloud/visionai/v1/streaming_resources.pb.h"
 #include "google/cloud/visionai/v1/streams_resources.pb.h"
@@ -94,6 +95,18 @@ absl::Status UpdateMwhExporter(const ClusterSelection& selection,
   return wait_result_statusor.status();
 }
 
+// Waits for the `operation` that creates a resource. The resource that
+// already exists counts as created.
+absl::Status WaitForCreation(
+    StreamsControlGrpcClient* client, const std::string& cluster_name,
+    const absl::StatusOr<google::longrunning::Operation>& operation) {
+  if (absl::IsAlreadyExists(operation.status())) {
+    return absl::OkStatus();
+  }
+  VAI_RETURN_IF_ERROR(operation.status());
+  return client->Wait(cluster_name, *operation).status();
+}
+
 }  // namespace
 
 // ----------------------------------------------------------------------------
@@ -240,6 +253,39 @@ absl::Status Bind(const ClusterSelection& selection,
   return wait_result_statusor.status();
 }
 
+absl::Status CreateEventAndBind(const ClusterSelection& selection,
+                                const std::string& event_id,
+                                const std::string& stream_id) {
+  VAI_ASSIGN_OR_RETURN(auto cluster_name, ClusterNameFrom(selection),
+                   _ << "while deducing the name of the selected cluster");
+  VAI_ASSIGN_OR_RETURN(auto client, CreateStreamsControlGrpcClient(selection),
+                   _ << "while creating the StreamsControlGrpcClient");
+  VAI_ASSIGN_OR_RETURN(auto channel_id, MakeChannelId(event_id, stream_id),
+                   _ << "while deducing the channel id");
+  auto create_series = [&]() {
+    return WaitForCreation(
+        client.get(), cluster_name,
+        client->CreateSeries(cluster_name, channel_id, stream_id, event_id));
+  };
+
+  // Create the Series alongside the Event rather than after it. The Series
+  // fails when it arrives at the server before the Event, which shows up
+  // either as the status of the call or as the error of its operation, so it is
+  // retried once whenever the Event succeeded and the Series did not.
+  absl::Status series_status;
+  std::thread series_creator(
+      [&series_status, &create_series]() { series_status = create_series(); });
+  auto event_status = WaitForCreation(
+      client.get(), cluster_name, client->CreateEvent(cluster_name, event_id));
+  series_creator.join();
+  VAI_RETURN_IF_ERROR(event_status) << "while creating an Event";
+  if (!series_status.ok()) {
+    series_status = create_series();
+  }
+  VAI_RETURN_IF_ERROR(series_status) << "while creating a Series";
+  return absl::OkStatus();
+}
+
 // Enable HLS playback.
 absl::Status EnableHlsPlayback(const ClusterSelection& selection,
                                const std::string& stream_id) {
@@ -86,6 +86,16 @@ absl::StatusOr<std::vector<google::cloud::visionai::v1::Event>> ListEvents(
 absl::Status Bind(const ClusterSelection& selection,
                   const std::string& event_id, const std::string& stream_id);
 
+// Create an event with the given event-id if it does not already exist, and
+// bind the given stream to it.
+//
+// This has the effect of CreateEventIfNotExist followed by Bind, but it skips
+// the lookups and creates the event and the binding concurrently. The binding
+// is created again once the event is ready if the first attempt fails.
+absl::Status CreateEventAndBind(const ClusterSelection& selection,
+                                const std::string& event_id,
+                                const std::string& stream_id);
+
 // Streams feature enablement.
 //
 // Enable HLS playback.
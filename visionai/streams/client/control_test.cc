@@ -13,6 +13,7 @@
 #include "google/longrunning/operations.pb.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/status/status.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "visionai/proto/cluster_selection.pb.h"
@@ -213,6 +214,136 @@ TEST_F(ControlTest, BasicStreamsControl) {
   EXPECT_TRUE(DisableMwhExporter(cluster_selection, std::string(kTestStreamId)).ok());
 }
 
+TEST_F(ControlTest, CreateEventAndBindSkipsTheLookups) {
+  VAI_ASSERT_OK_AND_ASSIGN(auto cluster_selection, TestClusterSelection());
+  VAI_ASSERT_OK_AND_ASSIGN(auto cluster_name, MakeClusterName(cluster_selection));
+  VAI_ASSERT_OK_AND_ASSIGN(
+      auto channel_id,
+      MakeChannelId(std::string(kTestEventId), std::string(kTestStreamId)));
+  EXPECT_CALL(*mock_streams_service_, GetEvent).Times(0);
+  EXPECT_CALL(*mock_streams_service_, GetSeries).Times(0);
+  EXPECT_CALL(*mock_streams_service_, CreateEvent)
+      .WillOnce(
+          Invoke([&](::grpc::ServerContext* context,
+                     const CreateEventRequest* request, Operation* operation) {
+            EXPECT_EQ(request->parent(), cluster_name);
+            EXPECT_EQ(request->event_id(), kTestEventId);
+            operation->set_done(true);
+            return ::grpc::Status::OK;
+          }));
+  EXPECT_CALL(*mock_streams_service_, CreateSeries)
+      .WillOnce(
+          Invoke([&](::grpc::ServerContext* context,
+                     const CreateSeriesRequest* request, Operation* operation) {
+            EXPECT_EQ(request->parent(), cluster_name);
+            EXPECT_EQ(request->series_id(), channel_id);
+            operation->set_done(true);
+            return ::grpc::Status::OK;
+          }));
+
+  EXPECT_OK(CreateEventAndBind(cluster_selection, std::string(kTestEventId),
+                               std::string(kTestStreamId)));
+}
+
+TEST_F(ControlTest, CreateEventAndBindAcceptsExistingResources) {
+  VAI_ASSERT_OK_AND_ASSIGN(auto cluster_selection, TestClusterSelection());
+  EXPECT_CALL(*mock_streams_service_, CreateEvent)
+      .WillOnce(Invoke([](::grpc::ServerContext* context,
+                          const CreateEventRequest* request,
+                          Operation* operation) {
+        return ::grpc::Status(::grpc::StatusCode::ALREADY_EXISTS, "event");
+      }));
+  EXPECT_CALL(*mock_streams_service_, CreateSeries)
+      .WillOnce(Invoke([](::grpc::ServerContext* context,
+                          const CreateSeriesRequest* request,
+                          Operation* operation) {
+        return ::grpc::Status(::grpc::StatusCode::ALREADY_EXISTS, "series");
+      }));
+
+  EXPECT_OK(CreateEventAndBind(cluster_selection, std::string(kTestEventId),
+                               std::string(kTestStreamId)));
+}
+
+TEST_F(ControlTest, CreateEventAndBindRetriesTheSeriesAfterTheEvent) {
+  VAI_ASSERT_OK_AND_ASSIGN(auto cluster_selection, TestClusterSelection());
+  EXPECT_CALL(*mock_streams_service_, CreateEvent)
+      .WillOnce(Invoke([](::grpc::ServerContext* context,
+                          const CreateEventRequest* request,
+                          Operation* operation) {
+        operation->set_done(true);
+        return ::grpc::Status::OK;
+      }));
+  // The first Series is requested before the Event exists.
+  EXPECT_CALL(*mock_streams_service_, CreateSeries)
+      .WillOnce(Invoke([](::grpc::ServerContext* context,
+                          const CreateSeriesRequest* request,
+                          Operation* operation) {
+        return ::grpc::Status(::grpc::StatusCode::NOT_FOUND, "no event");
+      }))
+      .WillOnce(Invoke([](::grpc::ServerContext* context,
+                          const CreateSeriesRequest* request,
+                          Operation* operation) {
+        operation->set_done(true);
+        return ::grpc::Status::OK;
+      }));
+
+  EXPECT_OK(CreateEventAndBind(cluster_selection, std::string(kTestEventId),
+                               std::string(kTestStreamId)));
+}
+
+TEST_F(ControlTest, CreateEventAndBindRetriesTheFailedSeriesOperation) {
+  VAI_ASSERT_OK_AND_ASSIGN(auto cluster_selection, TestClusterSelection());
+  EXPECT_CALL(*mock_streams_service_, CreateEvent)
+      .WillOnce(Invoke([](::grpc::ServerContext* context,
+                          const CreateEventRequest* request,
+                          Operation* operation) {
+        operation->set_done(true);
+        return ::grpc::Status::OK;
+      }));
+  // The first Series is accepted, but its operation fails because the Event
+  // does not exist yet.
+  EXPECT_CALL(*mock_streams_service_, CreateSeries)
+      .WillOnce(Invoke([](::grpc::ServerContext* context,
+                          const CreateSeriesRequest* request,
+                          Operation* operation) {
+        operation->set_done(true);
+        operation->mutable_error()->set_code(
+            static_cast<int>(::grpc::StatusCode::FAILED_PRECONDITION));
+        operation->mutable_error()->set_message("no event");
+        return ::grpc::Status::OK;
+      }))
+      .WillOnce(Invoke([](::grpc::ServerContext* context,
+                          const CreateSeriesRequest* request,
+                          Operation* operation) {
+        operation->set_done(true);
+        return ::grpc::Status::OK;
+      }));
+
+  EXPECT_OK(CreateEventAndBind(cluster_selection, std::string(kTestEventId),
+                               std::string(kTestStreamId)));
+}
+
+TEST_F(ControlTest, CreateEventAndBindReportsTheEventError) {
+  VAI_ASSERT_OK_AND_ASSIGN(auto cluster_selection, TestClusterSelection());
+  EXPECT_CALL(*mock_streams_service_, CreateEvent)
+      .WillOnce(Invoke([](::grpc::ServerContext* context,
+                          const CreateEventRequest* request,
+                          Operation* operation) {
+        return ::grpc::Status(::grpc::StatusCode::PERMISSION_DENIED, "denied");
+      }));
+  EXPECT_CALL(*mock_streams_service_, CreateSeries)
+      .WillRepeatedly(Invoke([](::grpc::ServerContext* context,
+                                const CreateSeriesRequest* request,
+                                Operation* operation) {
+        return ::grpc::Status(::grpc::StatusCode::NOT_FOUND, "no event");
+      }));
+
+  EXPECT_EQ(CreateEventAndBind(cluster_selection, std::string(kTestEventId),
+                               std::string(kTestStreamId))
+                .code(),
+            absl::StatusCode::kPermissionDenied);
+}
+
 TEST_F(ControlTest, BasicClusterControl) {
   {
     VAI_ASSERT_OK_AND_ASSIGN(auto cluster_selection, TestClusterSelection());
@@ -6,6 +6,7 @@
 
 #include "visionai/streams/client/event_update_receiver.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <functional>
 #include <memory>
@@ -63,32 +64,69 @@ absl::Status EventUpdateReceiver::OffsetCommitterTask(
     return s;
   };
 
+  // Offsets are coalesced so that at most one commit, carrying the latest
+  // offset, is sent to the server per `commit_interval`.
+  const absl::Duration commit_interval = options_.advanced.commit_interval;
+  absl::Time last_commit_time = absl::InfinitePast();
+  bool has_pending_offset = false;
+  int64_t pending_offset = 0;
+  auto flush_pending_offset = [&]() -> bool {
+    if (!has_pending_offset) {
+      return true;
+    }
+    has_pending_offset = false;
+    last_commit_time = absl::Now();
+    return grpc_client_->WriteCommit(pending_offset);
+  };
+
   absl::Status final_status = absl::OkStatus();
   bool write_channel_closed = false;
   while (!offset_committer_cancelled_->HasBeenNotified()) {
-    // Wait for a commit request from the client.
+    // Wait for a commit request from the client, but not past the time at
+    // which a pending offset is due.
+    absl::Duration read_timeout = kOffsetCommitterReadTimeout;
+    if (has_pending_offset) {
+      read_timeout = std::min(
+          read_timeout, std::max(absl::ZeroDuration(),
+                                 last_commit_time + commit_interval -
+                                     absl::Now()));
+    }
     int64_t offset;
     bool ok = false;
-    if (!offset_reader->Read(kOffsetCommitterReadTimeout, &offset, &ok)) {
+    if (!offset_reader->Read(read_timeout, &offset, &ok)) {
+      if (has_pending_offset &&
+          absl::Now() - last_commit_time >= commit_interval &&
+          !flush_pending_offset()) {
+        write_channel_closed = true;
+        break;
+      }
       continue;
     }
 
     // Case 1: The client has closed the channel (`CommitsDone`).
     if (!ok) {
-      grpc_client_->WritesDone();
+      if (flush_pending_offset()) {
+        grpc_client_->WritesDone();
+      }
       write_channel_closed = true;
       break;
     }
 
-    // Case 2: Got a new offset to commit.
-    if (!grpc_client_->WriteCommit(offset)) {
+    // Case 2: Got a new offset to commit. Send it right away if the interval
+    // has elapsed since the last commit; otherwise, keep it for later.
+    pending_offset = offset;
+    has_pending_offset = true;
+    if (absl::Now() - last_commit_time >= commit_interval &&
+        !flush_pending_offset()) {
       write_channel_closed = true;
       break;
     }
   }
 
-  // Forcefully close the write channel if necessary.
+  // Forcefully close the write channel if necessary. A pending offset is
+  // flushed on a best effort basis first, so that progress is not lost.
   if (!write_channel_closed) {
+    flush_pending_offset();
     grpc_client_->Cancel();
   }
 
@@ -16,6 +16,7 @@
 #include "absl/synchronization/notification.h"
 #include "absl/time/time.h"
 #include "visionai/proto/cluster_selection.pb.h"
+#include "visionai/streams/client/constants.h"
 #include "visionai/streams/client/event_update.h"
 #include "visionai/streams/client/read_write_channel.h"
 #include "visionai/streams/client/streaming_receive_events_grpc_client.h"
@@ -167,6 +168,16 @@ class EventUpdateReceiver {
       //
       // The server will choose a default if not set to a finite positive value.
       absl::Duration writes_done_grace_period;
+
+      // The minimum interval between two offset commits sent to the server.
+      //
+      // Offsets that are `Commit`ed within this interval are coalesced, and
+      // only the latest of them is sent once the interval has elapsed. Any
+      // pending offset is flushed when the commit channel is closed or the
+      // receiver is cancelled.
+      //
+      // Set to zero to send every offset as soon as it is `Commit`ed.
+      absl::Duration commit_interval = kDefaultCommitInterval;
     };
 
     // Specific advanced settings.
@@ -251,7 +262,9 @@ class EventUpdateReceiver {
   // Note that this is merely a request to commit. The actual checkpoint is
   // tracked on the server, and may only be eventually be updated, if at all.
   // The caller must be prepared to handle `EventUpdate`s that have been
-  // received should a commit be lost.
+  // received should a commit be lost. Commits are also coalesced according to
+  // `commit_interval`, so that only the latest offset of a burst of commits
+  // may reach the server.
   virtual bool Commit(absl::Duration timeout, int64_t offset, bool *ok);
 
   // Explicitly signals that all `Commit`s have been issued, and closes the
@@ -338,6 +338,101 @@ TEST_F(EventUpdateReceiverTest, ReadOnlyCommonCase) {
   EXPECT_TRUE(absl::IsOutOfRange(event_update_receiver->Finish()));
 }
 
+TEST_F(EventUpdateReceiverTest, CommitCoalesced) {
+  int num_event_updates = 5;
+  EXPECT_CALL(*mock_streams_service_, GetCluster)
+      .WillRepeatedly(
+          Invoke([&](::grpc::ServerContext* context,
+                     const GetClusterRequest* request, Cluster* cluster) {
+            cluster->set_dataplane_service_endpoint(local_server_address_);
+            return ::grpc::Status::OK;
+          }));
+  EXPECT_CALL(*mock_streaming_service_, ReceiveEvents)
+      .WillOnce(
+          Invoke([&](grpc::ServerContext* context,
+                     grpc::ServerReaderWriter<ReceiveEventsResponse,
+                                              ReceiveEventsRequest>* stream) {
+            // Expect setup message for handshake.
+            ReceiveEventsRequest req;
+            EXPECT_TRUE(stream->Read(&req));
+            EXPECT_TRUE(CheckSetupRequest(req).ok());
+
+            // Simulate the server reader.
+            //
+            // The client commits every event update, but only the first
+            // commit and the latest offset flushed by `CommitsDone` are sent.
+            absl::Notification reader_done;
+            std::thread reader([stream, &reader_done]() {
+              ReceiveEventsRequest req;
+              EXPECT_TRUE(stream->Read(&req));
+              EXPECT_TRUE(req.has_commit_request());
+              EXPECT_EQ(req.commit_request().offset(), 0);
+              EXPECT_TRUE(stream->Read(&req));
+              EXPECT_TRUE(req.has_commit_request());
+              EXPECT_EQ(req.commit_request().offset(), 4);
+              EXPECT_FALSE(stream->Read(&req));
+              reader_done.Notify();
+            });
+
+            // Write a few event updates interspersed with heartbeats.
+            for (int i = 0; i < num_event_updates; ++i) {
+              ReceiveEventsResponse resp;
+              EXPECT_TRUE(TestEventUpdateResponse(i, &resp).ok());
+              EXPECT_TRUE(stream->Write(resp));
+              absl::SleepFor(absl::Milliseconds(30));
+
+              EXPECT_TRUE(TestHeartbeatResponse(&resp).ok());
+              resp.mutable_control()->set_heartbeat(true);
+              EXPECT_TRUE(stream->Write(resp));
+              absl::SleepFor(absl::Milliseconds(30));
+            }
+
+            // Request writes done.
+            ReceiveEventsResponse resp;
+            EXPECT_TRUE(TestWriteDoneRequestResponse(&resp).ok());
+            EXPECT_TRUE(stream->Write(resp));
+
+            // Wait for reader to complete.
+            if (!reader_done.WaitForNotificationWithTimeout(
+                    kTestWritesDoneGracePeriod)) {
+              context->TryCancel();
+            }
+            reader.join();
+
+            return grpc::Status(grpc::StatusCode::OUT_OF_RANGE,
+                                "End of message stream");
+          }));
+
+  EventUpdateReceiver::Options options;
+  EXPECT_TRUE(TestEventUpdateReceiverOptions(&options).ok());
+  options.advanced.commit_interval = absl::Hours(1);
+  VAI_ASSERT_OK_AND_ASSIGN(auto event_update_receiver,
+                       EventUpdateReceiver::Create(options));
+
+  // Read a few updates.
+  EventUpdate event_update;
+  bool ok;
+  for (int i = 0; i < num_event_updates; ++i) {
+    EXPECT_TRUE(event_update_receiver->Receive(absl::InfiniteDuration(),
+                                               &event_update, &ok));
+    EXPECT_TRUE(ok);
+    EXPECT_TRUE(event_update_receiver->Commit(
+        absl::InfiniteDuration(), GetOffset(event_update), &ok));
+    EXPECT_TRUE(ok);
+  }
+
+  // Close read channel.
+  EXPECT_TRUE(event_update_receiver->Receive(absl::InfiniteDuration(),
+                                             &event_update, &ok));
+  EXPECT_FALSE(ok);
+
+  // Close write channel, flushing the pending offset.
+  event_update_receiver->CommitsDone();
+
+  // Get result.
+  EXPECT_TRUE(absl::IsOutOfRange(event_update_receiver->Finish()));
+}
+
 TEST_F(EventUpdateReceiverTest, ServerCancelTest) {
   absl::Notification server_cancelled;
   EXPECT_CALL(*mock_streams_service_, GetCluster)
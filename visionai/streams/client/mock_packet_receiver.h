@@ -24,6 +24,14 @@ class MockPacketReceiver : public PacketReceiver {
               (override));
   MOCK_METHOD(absl::Status, Receive, (absl::Duration timeout, Packet *packet),
               (override));
+  MOCK_METHOD(bool, ReceiveBatch,
+              (int max_packets, absl::Duration timeout,
+               std::vector<Packet> *packets, bool *ok),
+              (override));
+  MOCK_METHOD(absl::Status, ReceiveBatch,
+              (int max_packets, absl::Duration timeout,
+               std::vector<Packet> *packets),
+              (override));
   MOCK_METHOD(bool, Commit, (absl::Duration timeout, int64_t offset, bool *ok),
               (override));
   MOCK_METHOD(void, CommitsDone, (), (override));
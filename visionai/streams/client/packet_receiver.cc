@@ -6,10 +6,14 @@
 
 #include "visionai/streams/client/packet_receiver.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "google/cloud/visionai/v1/streaming_resources.pb.h"
+#include "glog/logging.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/functional/bind_front.h"
 #include "absl/memory/memory.h"
@@ -18,6 +22,7 @@
 #include "absl/strings/str_format.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "visionai/proto/util/net/grpc/connection_options.pb.h"
 #include "visionai/streams/client/constants.h"
@@ -62,32 +67,70 @@ absl::Status PacketReceiver::OffsetCommitterTask(
     return s;
   };
 
+  // Offsets are coalesced so that at most one commit, carrying the latest
+  // offset, is sent to the server per `commit_interval`.
+  const absl::Duration commit_interval =
+      options_.advanced.controlled_mode_options.commit_interval;
+  absl::Time last_commit_time = absl::InfinitePast();
+  bool has_pending_offset = false;
+  int64_t pending_offset = 0;
+  auto flush_pending_offset = [&]() -> bool {
+    if (!has_pending_offset) {
+      return true;
+    }
+    has_pending_offset = false;
+    last_commit_time = absl::Now();
+    return grpc_client_->WriteCommit(pending_offset);
+  };
+
   absl::Status final_status = absl::OkStatus();
   bool write_channel_closed = false;
   while (!offset_committer_cancelled_->HasBeenNotified()) {
-    // Wait for a commit request from the client.
+    // Wait for a commit request from the client, but not past the time at
+    // which a pending offset is due.
+    absl::Duration read_timeout = kOffsetCommitterReadTimeout;
+    if (has_pending_offset) {
+      read_timeout = std::min(
+          read_timeout, std::max(absl::ZeroDuration(),
+                                 last_commit_time + commit_interval -
+                                     absl::Now()));
+    }
     int64_t offset;
     bool ok;
-    if (!offset_reader->Read(kOffsetCommitterReadTimeout, &offset, &ok)) {
+    if (!offset_reader->Read(read_timeout, &offset, &ok)) {
+      if (has_pending_offset &&
+          absl::Now() - last_commit_time >= commit_interval &&
+          !flush_pending_offset()) {
+        write_channel_closed = true;
+        break;
+      }
       continue;
     }
 
     // Case 1: The client has closed the channel (`CommitsDone`).
     if (!ok) {
-      grpc_client_->WritesDone();
+      if (flush_pending_offset()) {
+        grpc_client_->WritesDone();
+      }
       write_channel_closed = true;
       break;
     }
 
-    // Case 2: Got a new offset to commit.
-    if (!grpc_client_->WriteCommit(offset)) {
+    // Case 2: Got a new offset to commit. Send it right away if the interval
+    // has elapsed since the last commit; otherwise, keep it for later.
+    pending_offset = offset;
+    has_pending_offset = true;
+    if (absl::Now() - last_commit_time >= commit_interval &&
+        !flush_pending_offset()) {
       write_channel_closed = true;
       break;
     }
   }
 
-  // Forcefully close the write channel if necessary.
+  // Forcefully close the write channel if necessary. A pending offset is
+  // flushed on a best effort basis first, so that progress is not lost.
   if (!write_channel_closed) {
+    flush_pending_offset();
     grpc_client_->Cancel();
   }
 
@@ -399,7 +442,8 @@ absl::Status PacketReceiver::Initialize() {
   // Setup channels and run the main task.
   main_status_channel_ = std::make_shared<ReadWriteChannel<absl::Status>>(1);
   receive_channel_ =
-      std::make_shared<ReadWriteChannel<std::shared_ptr<Packet>>>(1);
+      std::make_shared<ReadWriteChannel<std::shared_ptr<Packet>>>(
+          options_.advanced.receive_buffer_size);
   commit_channel_ = std::make_shared<ReadWriteChannel<int64_t>>(1);
 
   offset_committer_cancelled_ = std::make_shared<absl::Notification>();
@@ -425,6 +469,28 @@ bool PacketReceiver::Receive(absl::Duration timeout, Packet* packet, bool* ok) {
   return true;
 }
 
+bool PacketReceiver::ReceiveBatch(int max_packets, absl::Duration timeout,
+                                  std::vector<Packet>* packets, bool* ok) {
+  DCHECK_GT(max_packets, 0);
+  if (max_packets <= 0) {
+    return false;
+  }
+  std::vector<std::shared_ptr<Packet>> batch;
+  if (!receive_channel_->reader()->ReadBatch(max_packets, timeout, &batch,
+                                             ok)) {
+    return false;
+  }
+
+  if (*ok) {
+    packets->clear();
+    packets->reserve(batch.size());
+    for (auto& p : batch) {
+      packets->push_back(std::move(*p));
+    }
+  }
+  return true;
+}
+
 absl::Status PacketReceiver::Receive(absl::Duration timeout, Packet* packet) {
   bool read_ok = false;
 
@@ -450,6 +516,33 @@ absl::Status PacketReceiver::Receive(Packet* packet) {
   return Receive(absl::InfiniteDuration(), packet);
 }
 
+absl::Status PacketReceiver::ReceiveBatch(int max_packets,
+                                          absl::Duration timeout,
+                                          std::vector<Packet>* packets) {
+  if (max_packets <= 0) {
+    return absl::InvalidArgumentError(
+        "The maximum number of packets must be positive.");
+  }
+  bool read_ok = false;
+
+  // Case 1: Timeout. Signal not found.
+  if (!ReceiveBatch(max_packets, timeout, packets, &read_ok)) {
+    return absl::NotFoundError(absl::StrFormat(
+        "%s No packets are available from upstream at this time",
+        kPacketReceiverErrMsgPrefix));
+  }
+
+  // Case 2: Got packets. Deliver them to the caller.
+  if (read_ok) {
+    return absl::OkStatus();
+  }
+
+  // Case 3: The read channel terminated. Close the write channel and return
+  // the RPC status to the caller.
+  this->CommitsDone();
+  return this->Finish();
+}
+
 bool PacketReceiver::Commit(absl::Duration timeout, int64_t offset, bool* ok) {
   return commit_channel_->writer()->Write(timeout, offset, ok);
 }
@@ -478,6 +571,10 @@ PacketReceiver::~PacketReceiver() { Cancel(); }
 // ----------------------------------------------------------------------------
 
 absl::Status PacketReceiver::CompleteOptionsWithDefaults() {
+  if (options_.advanced.receive_buffer_size <= 0) {
+    options_.advanced.receive_buffer_size = 1;
+  }
+
   if (options_.advanced.grace_period == absl::ZeroDuration()) {
     options_.advanced.grace_period = kDefaultLeaseDuration;
   }
@@ -537,6 +634,7 @@ absl::Status PacketReceiver::CreateGrpcClient() {
   options.advanced.connection_options.mutable_ssl_options()
       ->set_use_insecure_channel(
           options_.cluster_selection.use_insecure_channel());
+  options.advanced.grpc_channel = options_.advanced.grpc_channel;
 
   VAI_ASSIGN_OR_RETURN(grpc_client_,
                    StreamingReceivePacketsGrpcV1Client::Create(options));
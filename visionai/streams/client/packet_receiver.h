@@ -8,13 +8,17 @@
 #define THIRD_PARTY_VISIONAI_STREAMS_CLIENT_PACKET_RECEIVER_H_
 
 #include <cstdint>
+#include <memory>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
+#include "include/grpcpp/grpcpp.h"
 #include "visionai/proto/cluster_selection.pb.h"
 #include "visionai/streams/client/channel_lease_renewal_task.h"
+#include "visionai/streams/client/constants.h"
 #include "visionai/streams/client/descriptors.h"
 #include "visionai/streams/client/read_write_channel.h"
 #include "visionai/streams/client/streaming_receive_packets_grpc_v1_client.h"
@@ -210,6 +214,22 @@ class PacketReceiver {
       // The server will choose a default if not set to a finite positive value.
       absl::Duration writes_done_grace_period;
 
+      // An existing grpc channel to the cluster's dataplane endpoint.
+      //
+      // Sharing one channel across the `PacketReceiver`s of a process avoids
+      // setting up a new connection for every receiver. A new channel is
+      // created if not set.
+      std::shared_ptr<::grpc::Channel> grpc_channel;
+
+      // The most `Packet`s to buffer ahead of the `Receive`s.
+      //
+      // A larger buffer lets `ReceiveBatch` return more `Packet`s per call
+      // when the reader falls behind. In "eager" mode, this is also how far
+      // behind the latest `Packet` the reader may get.
+      //
+      // 1 is chosen if not set to a positive value.
+      int receive_buffer_size = 0;
+
       // The options specific to "controlled" mode.
       struct ControlledModeOptions {
         // This is the where the reader will begin its reads.
@@ -226,6 +246,16 @@ class PacketReceiver {
         // "begin": Start from the earliest available message.
         // "end": Start from future messages.
         std::string fallback_starting_offset = "begin";
+
+        // The minimum interval between two offset commits sent to the server.
+        //
+        // Offsets that are `Commit`ed within this interval are coalesced, and
+        // only the latest of them is sent once the interval has elapsed. Any
+        // pending offset is flushed when the commit channel is closed or the
+        // receiver is cancelled.
+        //
+        // Set to zero to send every offset as soon as it is `Commit`ed.
+        absl::Duration commit_interval = kDefaultCommitInterval;
       };
       ControlledModeOptions controlled_mode_options;
     };
@@ -281,6 +311,19 @@ class PacketReceiver {
   // `absl::InfiniteDuration` as the timeout.
   virtual absl::Status Receive(Packet *packet);
 
+  // Receive all of the `Packet`s that are available, up to `max_packets`.
+  //
+  // This is equivalent to `Receive(absl::Duration, Packet*)`, except that on
+  // success, `*packets` is replaced with every `Packet` that is buffered once
+  // the first one has arrived, up to `max_packets`, in the order of arrival.
+  // On any other return code, `*packets` is left unchanged.
+  //
+  // `max_packets` must be positive, or INVALID_ARGUMENT is returned. Set
+  // `advanced.receive_buffer_size` to at least `max_packets` for the batches
+  // to fill up.
+  virtual absl::Status ReceiveBatch(int max_packets, absl::Duration timeout,
+                                    std::vector<Packet> *packets);
+
   // --------------------------------------------------------------------------
   // Controlled Mode Methods
   // --------------------------------------------------------------------------
@@ -323,6 +366,24 @@ class PacketReceiver {
   // latter condition, `Finish` must return `OUT_OF_RANGE`.
   virtual bool Receive(absl::Duration timeout, Packet *packet, bool *ok);
 
+  // Receive all of the `Packet`s that are available, up to `max_packets`.
+  //
+  // This is equivalent to `Receive(absl::Duration, Packet*, bool*)`, except
+  // that when `*ok` is set to `true`, `*packets` is replaced with every
+  // `Packet` that is buffered once the first one has arrived, up to
+  // `max_packets`, in the order of arrival. Otherwise, `*packets` is left
+  // unchanged.
+  //
+  // The `Packet`s of a batch need not be consumed all at once. Only `Commit`
+  // the offset of the last one that has been processed; the rest of the batch
+  // will be delivered again should the reader reconnect before committing
+  // them.
+  //
+  // `max_packets` must be positive. Set `advanced.receive_buffer_size` to at
+  // least `max_packets` for the batches to fill up.
+  virtual bool ReceiveBatch(int max_packets, absl::Duration timeout,
+                            std::vector<Packet> *packets, bool *ok);
+
   // Commit a `Packet`'s `offset`, checkpointing the read progress.
   //
   // The return boolean indicates whether the `timeout` has expired, and `ok`
@@ -356,7 +417,9 @@ class PacketReceiver {
   // Note that this is merely a request to commit. The actual checkpoint is
   // tracked on the server, and may only be eventually be updated, if at all.
   // The caller must be prepared to handle `Packet`s that have been received
-  // should a commit be lost.
+  // should a commit be lost. Commits are also coalesced according to
+  // `commit_interval`, so that only the latest offset of a burst of commits
+  // may reach the server.
   virtual bool Commit(absl::Duration timeout, int64_t offset, bool *ok);
 
   // Explicitly signals that all `Commit`s have been issued, and closes the
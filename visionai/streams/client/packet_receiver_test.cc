@@ -6,6 +6,9 @@
 
 #include "visionai/streams/client/packet_receiver.h"
 
+#include <cstdint>
+#include <vector>
+
 #include "glog/logging.h"
 #include "google/cloud/visionai/v1/common.pb.h"
 #include "google/cloud/visionai/v1/streaming_resources.pb.h"
@@ -706,6 +709,208 @@ TEST_F(PacketReceiverTest, ControlledCommitAll) {
   EXPECT_TRUE(absl::IsOutOfRange(packet_receiver->Finish()));
 }
 
+TEST_F(PacketReceiverTest, ControlledCommitCoalesced) {
+  int num_packets = 5;
+
+  EXPECT_CALL(*mock_streams_service_, GetCluster)
+      .WillRepeatedly(
+          Invoke([&](::grpc::ServerContext* context,
+                     const GetClusterRequest* request, Cluster* cluster) {
+            cluster->set_dataplane_service_endpoint(local_server_address_);
+            return ::grpc::Status::OK;
+          }));
+  EXPECT_CALL(*mock_streaming_service_, ReceivePackets)
+      .WillOnce(
+          Invoke([&](grpc::ServerContext* context,
+                     grpc::ServerReaderWriter<ReceivePacketsResponse,
+                                              ReceivePacketsRequest>* stream) {
+            // Expect setup message for handshake.
+            ReceivePacketsRequest req;
+            EXPECT_TRUE(stream->Read(&req));
+            EXPECT_TRUE(CheckSetupRequest(req).ok());
+
+            // Simulate the server reader.
+            //
+            // The client commits every packet, but only the first commit
+            // and the latest offset flushed by `CommitsDone` are sent.
+            absl::Notification reader_done;
+            std::thread reader([stream, &reader_done]() {
+              ReceivePacketsRequest req;
+              EXPECT_TRUE(stream->Read(&req));
+              EXPECT_TRUE(req.has_commit_request());
+              EXPECT_EQ(req.commit_request().offset(), 0);
+              EXPECT_TRUE(stream->Read(&req));
+              EXPECT_TRUE(req.has_commit_request());
+              EXPECT_EQ(req.commit_request().offset(), 4);
+              EXPECT_FALSE(stream->Read(&req));
+              reader_done.Notify();
+            });
+
+            // Write a few packets interspersed with heartbeats.
+            for (int i = 0; i < num_packets; ++i) {
+              ReceivePacketsResponse resp;
+              EXPECT_TRUE(TestPacketResponse(i, &resp).ok());
+              EXPECT_TRUE(stream->Write(resp));
+              absl::SleepFor(absl::Milliseconds(30));
+
+              EXPECT_TRUE(TestHeartbeatResponse(&resp).ok());
+              resp.mutable_control()->set_heartbeat(true);
+              EXPECT_TRUE(stream->Write(resp));
+              absl::SleepFor(absl::Milliseconds(30));
+            }
+
+            // Request writes done.
+            ReceivePacketsResponse resp;
+            EXPECT_TRUE(TestWriteDoneRequestResponse(&resp).ok());
+            EXPECT_TRUE(stream->Write(resp));
+
+            // Wait for reader to complete.
+            if (!reader_done.WaitForNotificationWithTimeout(
+                    kTestWritesDoneGracePeriod)) {
+              context->TryCancel();
+            }
+            reader.join();
+
+            return grpc::Status(grpc::StatusCode::OUT_OF_RANGE,
+                                "End of message stream");
+          }));
+
+  PacketReceiver::Options options;
+  EXPECT_TRUE(TestPacketReceiverOptions(&options).ok());
+  options.receive_mode = "controlled";
+  options.advanced.controlled_mode_options.commit_interval = absl::Hours(1);
+  VAI_ASSERT_OK_AND_ASSIGN(auto packet_receiver, PacketReceiver::Create(options));
+
+  // Read a few packets.
+  Packet p;
+  bool read_ok;
+  bool write_ok;
+  for (int i = 0; i < num_packets; ++i) {
+    EXPECT_TRUE(
+        packet_receiver->Receive(absl::InfiniteDuration(), &p, &read_ok));
+    EXPECT_TRUE(read_ok);
+    EXPECT_TRUE(packet_receiver->Commit(absl::InfiniteDuration(), GetOffset(p),
+                                        &write_ok));
+    EXPECT_TRUE(write_ok);
+  }
+
+  // Close read channel.
+  EXPECT_TRUE(packet_receiver->Receive(absl::InfiniteDuration(), &p, &read_ok));
+  EXPECT_FALSE(read_ok);
+
+  // Close write channel, flushing the pending offset.
+  packet_receiver->CommitsDone();
+
+  // Get result.
+  EXPECT_TRUE(absl::IsOutOfRange(packet_receiver->Finish()));
+}
+
+TEST_F(PacketReceiverTest, ControlledReceiveBatchPartialCommit) {
+  int num_packets = 5;
+
+  EXPECT_CALL(*mock_streams_service_, GetCluster)
+      .WillRepeatedly(
+          Invoke([&](::grpc::ServerContext* context,
+                     const GetClusterRequest* request, Cluster* cluster) {
+            cluster->set_dataplane_service_endpoint(local_server_address_);
+            return ::grpc::Status::OK;
+          }));
+  absl::Notification packets_written;
+  EXPECT_CALL(*mock_streaming_service_, ReceivePackets)
+      .WillOnce(
+          Invoke([&](grpc::ServerContext* context,
+                     grpc::ServerReaderWriter<ReceivePacketsResponse,
+                                              ReceivePacketsRequest>* stream) {
+            // Expect setup message for handshake.
+            ReceivePacketsRequest req;
+            EXPECT_TRUE(stream->Read(&req));
+            EXPECT_TRUE(CheckSetupRequest(req).ok());
+
+            // Simulate the server reader.
+            //
+            // The client only commits up to the middle of its first batch.
+            absl::Notification reader_done;
+            std::thread reader([stream, &reader_done]() {
+              ReceivePacketsRequest req;
+              EXPECT_TRUE(stream->Read(&req));
+              EXPECT_TRUE(req.has_commit_request());
+              EXPECT_EQ(req.commit_request().offset(), 1);
+              EXPECT_FALSE(stream->Read(&req));
+              reader_done.Notify();
+            });
+
+            // Write the packets back to back.
+            for (int i = 0; i < num_packets; ++i) {
+              ReceivePacketsResponse resp;
+              EXPECT_TRUE(TestPacketResponse(i, &resp).ok());
+              EXPECT_TRUE(stream->Write(resp));
+            }
+            packets_written.Notify();
+
+            // Request writes done.
+            ReceivePacketsResponse resp;
+            EXPECT_TRUE(TestWriteDoneRequestResponse(&resp).ok());
+            EXPECT_TRUE(stream->Write(resp));
+
+            // Wait for reader to complete.
+            if (!reader_done.WaitForNotificationWithTimeout(
+                    kTestWritesDoneGracePeriod)) {
+              context->TryCancel();
+            }
+            reader.join();
+
+            return grpc::Status(grpc::StatusCode::OUT_OF_RANGE,
+                                "End of message stream");
+          }));
+
+  PacketReceiver::Options options;
+  EXPECT_TRUE(TestPacketReceiverOptions(&options).ok());
+  options.receive_mode = "controlled";
+  options.advanced.receive_buffer_size = num_packets;
+  VAI_ASSERT_OK_AND_ASSIGN(auto packet_receiver, PacketReceiver::Create(options));
+
+  // Let all of the packets arrive.
+  packets_written.WaitForNotification();
+  absl::SleepFor(absl::Milliseconds(200));
+
+  // The first batch stops at the limit.
+  std::vector<Packet> packets;
+  bool read_ok;
+  bool write_ok;
+  EXPECT_TRUE(packet_receiver->ReceiveBatch(3, absl::InfiniteDuration(),
+                                            &packets, &read_ok));
+  EXPECT_TRUE(read_ok);
+  ASSERT_EQ(packets.size(), 3u);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(GetOffset(packets[i]), i);
+  }
+
+  // Only consume part of the batch.
+  EXPECT_TRUE(packet_receiver->Commit(absl::InfiniteDuration(),
+                                      GetOffset(packets[1]), &write_ok));
+  EXPECT_TRUE(write_ok);
+
+  // The next batch picks up after the first one.
+  EXPECT_TRUE(packet_receiver->ReceiveBatch(10, absl::InfiniteDuration(),
+                                            &packets, &read_ok));
+  EXPECT_TRUE(read_ok);
+  ASSERT_EQ(packets.size(), 2u);
+  EXPECT_EQ(GetOffset(packets[0]), 3);
+  EXPECT_EQ(GetOffset(packets[1]), 4);
+
+  // Close read channel.
+  EXPECT_TRUE(packet_receiver->ReceiveBatch(10, absl::InfiniteDuration(),
+                                            &packets, &read_ok));
+  EXPECT_FALSE(read_ok);
+  EXPECT_EQ(packets.size(), 2u);
+
+  // Close write channel without committing the rest.
+  packet_receiver->CommitsDone();
+
+  // Get result.
+  EXPECT_TRUE(absl::IsOutOfRange(packet_receiver->Finish()));
+}
+
 TEST_F(PacketReceiverTest, EagerReadCommonCase) {
   int num_packets = 5;
   EXPECT_CALL(*mock_streams_service_, GetCluster)
@@ -778,6 +983,89 @@ TEST_F(PacketReceiverTest, EagerReadCommonCase) {
   EXPECT_TRUE(absl::IsOutOfRange(status));
 }
 
+TEST_F(PacketReceiverTest, EagerReceiveBatchInOrder) {
+  int num_packets = 5;
+  EXPECT_CALL(*mock_streams_service_, GetCluster)
+      .WillRepeatedly(
+          Invoke([&](::grpc::ServerContext* context,
+                     const GetClusterRequest* request, Cluster* cluster) {
+            cluster->set_dataplane_service_endpoint(local_server_address_);
+            return ::grpc::Status::OK;
+          }));
+  EXPECT_CALL(*mock_streaming_service_, ReceivePackets)
+      .WillOnce(
+          Invoke([&](grpc::ServerContext* context,
+                     grpc::ServerReaderWriter<ReceivePacketsResponse,
+                                              ReceivePacketsRequest>* stream) {
+            // Expect setup message for handshake.
+            ReceivePacketsRequest req;
+            EXPECT_TRUE(stream->Read(&req));
+            EXPECT_TRUE(CheckSetupRequest(req).ok());
+
+            // Simulate the server reader.
+            absl::Notification reader_done;
+            std::thread reader([stream, &reader_done]() {
+              ReceivePacketsRequest req;
+              EXPECT_FALSE(stream->Read(&req));
+              reader_done.Notify();
+            });
+
+            // Write a few packets, some of them back to back.
+            for (int i = 0; i < num_packets; ++i) {
+              ReceivePacketsResponse resp;
+              EXPECT_TRUE(TestPacketResponse(i, &resp).ok());
+              EXPECT_TRUE(stream->Write(resp));
+              if (i % 2 == 0) {
+                absl::SleepFor(absl::Milliseconds(30));
+              }
+            }
+
+            // Request writes done.
+            ReceivePacketsResponse resp;
+            EXPECT_TRUE(TestWriteDoneRequestResponse(&resp).ok());
+            EXPECT_TRUE(stream->Write(resp));
+
+            // Wait for reader to complete.
+            if (!reader_done.WaitForNotificationWithTimeout(
+                    kTestWritesDoneGracePeriod)) {
+              context->TryCancel();
+            }
+            reader.join();
+
+            return grpc::Status(grpc::StatusCode::OUT_OF_RANGE,
+                                "End of message stream");
+          }));
+
+  PacketReceiver::Options options;
+  EXPECT_TRUE(TestPacketReceiverOptions(&options).ok());
+  options.receive_mode = "eager";
+  options.advanced.receive_buffer_size = num_packets;
+  VAI_ASSERT_OK_AND_ASSIGN(auto packet_receiver, PacketReceiver::Create(options));
+
+  // Read all the packets, however they are batched.
+  std::vector<int64_t> offsets;
+  std::vector<Packet> packets;
+  while (static_cast<int>(offsets.size()) < num_packets) {
+    EXPECT_TRUE(packet_receiver
+                    ->ReceiveBatch(num_packets, absl::InfiniteDuration(),
+                                   &packets)
+                    .ok());
+    EXPECT_FALSE(packets.empty());
+    for (const auto& p : packets) {
+      offsets.push_back(GetOffset(p));
+    }
+  }
+  EXPECT_EQ(offsets, std::vector<int64_t>({0, 1, 2, 3, 4}));
+
+  EXPECT_TRUE(absl::IsInvalidArgument(
+      packet_receiver->ReceiveBatch(0, absl::InfiniteDuration(), &packets)));
+
+  // Should reach the end.
+  auto status = packet_receiver->ReceiveBatch(
+      num_packets, absl::InfiniteDuration(), &packets);
+  EXPECT_TRUE(absl::IsOutOfRange(status));
+}
+
 TEST_F(PacketReceiverTest, EagerReadServerSeverance) {
   int num_packets = 5;
   EXPECT_CALL(*mock_streams_service_, GetCluster)
@@ -12,6 +12,7 @@
 #include <memory>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/synchronization/mutex.h"
@@ -58,6 +59,17 @@ class Reader {
     return rep_->TryPop(timeout, item, ok);
   }
 
+  // Read all of the messages that are available, up to `max_items`.
+  //
+  // This is equivalent to `Read`, except that once a message is available, it
+  // appends to `*items` every message that is buffered at that time, up to
+  // `max_items`, in the order in which they were written. `max_items` must be
+  // positive.
+  bool ReadBatch(size_t max_items, absl::Duration timeout,
+                 std::vector<T>* items, bool* ok) {
+    return rep_->TryPopBatch(max_items, timeout, items, ok);
+  }
+
  private:
   ReadWriteChannelState<T>* rep_ = nullptr;
 
@@ -12,6 +12,7 @@
 #include <memory>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #include "absl/base/thread_annotations.h"
 #include "absl/status/status.h"
@@ -94,6 +95,32 @@ class ReadWriteChannelState {
     }
   }
 
+  bool TryPopBatch(size_t max_items, absl::Duration timeout,
+                   std::vector<T>* items, bool* ok) ABSL_LOCKS_EXCLUDED(mu_) {
+    absl::Condition has_item_or_closed(
+        +[](State* state) {
+          return state->q_.size() ||
+                 (state->q_.empty() && state->writes_closed_);
+        },
+        &state_);
+    absl::MutexLock lock(&mu_);
+    if (!mu_.AwaitWithTimeout(has_item_or_closed, timeout)) {
+      return false;
+    }
+    if (state_.q_.empty()) {
+      *ok = false;
+      return true;
+    } else {
+      while (!state_.q_.empty() && max_items > 0) {
+        items->push_back(std::move(state_.q_.front()));
+        state_.q_.pop_front();
+        --max_items;
+      }
+      *ok = true;
+      return true;
+    }
+  }
+
   template <typename... Args>
   bool TryEmplace(absl::Duration timeout, bool* ok, Args&&... args)
       ABSL_LOCKS_EXCLUDED(mu_) {
@@ -8,6 +8,7 @@
 
 #include <memory>
 #include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "absl/status/status.h"
@@ -136,6 +137,42 @@ TEST(ReadWriteChannelTest, MultiItemBufferTest) {
   writer.join();
 }
 
+TEST(ReadWriteChannelTest, ReadBatchTest) {
+  ReadWriteChannel<int> read_write_channel(4);
+  bool ok;
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(
+        read_write_channel.writer()->Write(absl::InfiniteDuration(), i, &ok));
+  }
+  read_write_channel.writer()->Close();
+
+  // Reads what is available up to the limit, in order.
+  std::vector<int> results;
+  EXPECT_TRUE(read_write_channel.reader()->ReadBatch(
+      3, absl::InfiniteDuration(), &results, &ok));
+  EXPECT_TRUE(ok);
+  EXPECT_EQ(results, std::vector<int>({0, 1, 2}));
+  EXPECT_TRUE(read_write_channel.reader()->ReadBatch(
+      3, absl::InfiniteDuration(), &results, &ok));
+  EXPECT_TRUE(ok);
+  EXPECT_EQ(results, std::vector<int>({0, 1, 2, 3}));
+
+  // Signals the closure once drained.
+  EXPECT_TRUE(read_write_channel.reader()->ReadBatch(
+      3, absl::InfiniteDuration(), &results, &ok));
+  EXPECT_FALSE(ok);
+  EXPECT_EQ(results.size(), 4u);
+}
+
+TEST(ReadWriteChannelTest, ReadBatchTimeout) {
+  ReadWriteChannel<int> read_write_channel(1);
+  std::vector<int> results;
+  bool ok;
+  EXPECT_FALSE(read_write_channel.reader()->ReadBatch(1, absl::ZeroDuration(),
+                                                      &results, &ok));
+  EXPECT_TRUE(results.empty());
+}
+
 TEST(ReadWriteChannelTest, MultiItemSerialTest) {
   ReadWriteChannel<int> read_write_channel(6);
   {
@@ -10,6 +10,7 @@
 #include <memory>
 #include <regex>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
@@ -287,6 +288,27 @@ absl::StatusOr<Stream> ParseStreamNameStructured(
                 .stream_id = resource_info[kStreamsCollectionId]};
 }
 
+absl::StatusOr<std::vector<Stream>> ParseStreamNamesInCluster(
+    const std::vector<std::string>& stream_names) {
+  if (stream_names.empty()) {
+    return absl::InvalidArgumentError("Given no stream names.");
+  }
+  std::vector<Stream> streams;
+  for (const auto& stream_name : stream_names) {
+    VAI_ASSIGN_OR_RETURN(auto stream, ParseStreamNameStructured(stream_name));
+    if (!streams.empty() &&
+        (stream.project_id != streams[0].project_id ||
+         stream.location_id != streams[0].location_id ||
+         stream.cluster_id != streams[0].cluster_id)) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "The stream %s is not in the same cluster as the stream %s.",
+          stream_name, stream_names[0]));
+    }
+    streams.push_back(std::move(stream));
+  }
+  return streams;
+}
+
 absl::StatusOr<Application> ParseApplicationNameStructured(
     const std::string& application_name) {
   VAI_ASSIGN_OR_RETURN(auto resource_info, ParseResourceName(application_name),
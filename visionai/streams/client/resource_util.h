@@ -133,6 +133,11 @@ absl::StatusOr<std::vector<std::string>> ParseStreamName(
 absl::StatusOr<resource_ids::Stream> ParseStreamNameStructured(
     const std::string& stream_name);
 
+// Given the resource names of one or more streams of the same cluster, return
+// a Stream struct for each of them, in the same order.
+absl::StatusOr<std::vector<resource_ids::Stream>> ParseStreamNamesInCluster(
+    const std::vector<std::string>& stream_names);
+
 // Given an application resource name, return an Application struct containing
 // its resource ids.
 absl::StatusOr<resource_ids::Application> ParseApplicationNameStructured(
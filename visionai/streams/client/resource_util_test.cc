@@ -170,6 +170,35 @@ TEST(ResourceUtilTest, ParseStreamNameStructured) {
   }
 }
 
+TEST(ResourceUtilTest, ParseStreamNamesInCluster) {
+  {
+    auto streams = ParseStreamNamesInCluster(
+        {"projects/p-1/locations/l-1/clusters/c-1/streams/s-1",
+         "projects/p-1/locations/l-1/clusters/c-1/streams/s-2"});
+    ASSERT_TRUE(streams.ok());
+    ASSERT_EQ(streams->size(), 2u);
+    EXPECT_EQ((*streams)[0].cluster_id, "c-1");
+    EXPECT_EQ((*streams)[0].stream_id, "s-1");
+    EXPECT_EQ((*streams)[1].cluster_id, "c-1");
+    EXPECT_EQ((*streams)[1].stream_id, "s-2");
+  }
+  {
+    auto streams = ParseStreamNamesInCluster(
+        {"projects/p-1/locations/l-1/clusters/c-1/streams/s-1",
+         "projects/p-1/locations/l-1/clusters/c-2/streams/s-2"});
+    EXPECT_FALSE(streams.ok());
+  }
+  {
+    auto streams = ParseStreamNamesInCluster(
+        {"projects/p-1/locations/l-1/clusters/c-1/streams/s-1", "c-1"});
+    EXPECT_FALSE(streams.ok());
+  }
+  {
+    auto streams = ParseStreamNamesInCluster({});
+    EXPECT_FALSE(streams.ok());
+  }
+}
+
 TEST(ResourceUtilTest, ParseApplicationNameStructured) {
   {
     std::string app_name = "projects/p-1/locations/l-1/applications/a-1";
@@ -0,0 +1,225 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/streams/client/spooling_packet_sender.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "glog/logging.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "visionai/streams/client/packet_sender.h"
+#include "visionai/streams/packet/packet.h"
+#include "visionai/streams/util/packet_spool.h"
+#include "visionai/util/status/status_macros.h"
+
+namespace visionai {
+
+namespace {
+// Log every this many packets dropped for a full spool.
+constexpr int kDroppedPacketsLogPeriod = 100;
+}  // namespace
+
+SpoolingPacketSender::SpoolingPacketSender(Options options)
+    : PacketSender(options.sender_options),
+      spooling_options_(std::move(options)) {}
+
+absl::StatusOr<std::unique_ptr<SpoolingPacketSender>>
+SpoolingPacketSender::Create(Options options) {
+  if (!options.sender_factory) {
+    options.sender_factory = [sender_options = options.sender_options]()
+        -> absl::StatusOr<std::unique_ptr<PacketSender>> {
+      return PacketSender::Create(sender_options);
+    };
+  }
+  VAI_ASSIGN_OR_RETURN(auto spool, PacketSpool::Create(options.spool_options),
+                   _ << "while creating the packet spool");
+  auto sender = options.sender_factory();
+  if (!sender.ok()) {
+    if (absl::IsInvalidArgument(sender.status())) {
+      return sender.status();
+    }
+    LOG(WARNING) << "Failed to connect to the channel; spooling the packets "
+                    "until it succeeds: "
+                 << sender.status();
+  }
+
+  auto spooling_sender =
+      absl::WrapUnique(new SpoolingPacketSender(std::move(options)));
+  {
+    absl::MutexLock lock(&spooling_sender->mu_);
+    spooling_sender->spool_ = std::move(spool);
+    if (sender.ok()) {
+      spooling_sender->sender_ = *std::move(sender);
+    }
+  }
+  SpoolingPacketSender* s = spooling_sender.get();
+  spooling_sender->drainer_ = std::thread([s]() { s->DrainMain(); });
+  return std::move(spooling_sender);
+}
+
+SpoolingPacketSender::~SpoolingPacketSender() {
+  {
+    absl::MutexLock lock(&mu_);
+    is_stopping_ = true;
+  }
+  if (drainer_.joinable()) {
+    drainer_.join();
+  }
+}
+
+absl::Status SpoolingPacketSender::Send(Packet packet) {
+  return Send(std::move(packet), absl::InfiniteDuration());
+}
+
+absl::Status SpoolingPacketSender::Send(Packet packet,
+                                        absl::Duration timeout) {
+  std::shared_ptr<PacketSender> sender;
+  {
+    absl::MutexLock lock(&mu_);
+    // Keep the packets in order behind the ones being replayed.
+    if (!spool_->empty() || sender_ == nullptr) {
+      return SpoolLocked(packet);
+    }
+    sender = sender_;
+  }
+
+  // The packet is lost to a failed PacketSender, so keep a copy to spool.
+  Packet copy = packet;
+  auto status = sender->Send(
+      std::move(packet), std::min(timeout, spooling_options_.stall_timeout));
+  if (status.ok()) {
+    return absl::OkStatus();
+  }
+  LOG(WARNING) << "Spooling the packets until the channel recovers: "
+               << status;
+  absl::MutexLock lock(&mu_);
+  if (sender_ == sender) {
+    sender_ = nullptr;
+  }
+  return SpoolLocked(copy);
+}
+
+int64_t SpoolingPacketSender::num_spooled_packets() {
+  absl::MutexLock lock(&mu_);
+  return spool_->num_packets();
+}
+
+absl::Status SpoolingPacketSender::Drain(absl::Duration timeout) {
+  absl::MutexLock lock(&mu_);
+  auto is_drained = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return spool_->empty();
+  };
+  if (mu_.AwaitWithTimeout(absl::Condition(&is_drained), timeout)) {
+    return absl::OkStatus();
+  }
+  return absl::DeadlineExceededError(absl::StrFormat(
+      "%d packets are left in the spool in %s.", spool_->num_packets(),
+      spooling_options_.spool_options.directory));
+}
+
+absl::Status SpoolingPacketSender::SpoolLocked(const Packet& packet) {
+  auto status = spool_->Append(packet);
+  if (absl::IsResourceExhausted(status)) {
+    if (num_dropped_++ % kDroppedPacketsLogPeriod == 0) {
+      LOG(WARNING) << "Dropped " << num_dropped_
+                   << " packets in total: " << status;
+    }
+    return absl::OkStatus();
+  }
+  return status;
+}
+
+bool SpoolingPacketSender::WaitForStop(absl::Duration timeout) {
+  absl::MutexLock lock(&mu_);
+  return mu_.AwaitWithTimeout(absl::Condition(&is_stopping_), timeout);
+}
+
+void SpoolingPacketSender::DrainMain() {
+  absl::Time next_send = absl::InfinitePast();
+  while (true) {
+    std::shared_ptr<PacketSender> sender;
+    Packet packet;
+    {
+      absl::MutexLock lock(&mu_);
+      auto has_work = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        return is_stopping_ || !spool_->empty();
+      };
+      mu_.Await(absl::Condition(&has_work));
+      if (is_stopping_) {
+        return;
+      }
+      sender = sender_;
+      if (sender != nullptr) {
+        auto front = spool_->Front();
+        if (!front.ok()) {
+          LOG(ERROR) << front.status();
+          continue;
+        }
+        packet = *std::move(front);
+      }
+    }
+
+    // Reconnect.
+    if (sender == nullptr) {
+      auto new_sender = spooling_options_.sender_factory();
+      if (new_sender.ok()) {
+        absl::MutexLock lock(&mu_);
+        sender_ = *std::move(new_sender);
+        continue;
+      }
+      LOG(WARNING) << "Failed to reconnect to the channel: "
+                   << new_sender.status();
+      if (WaitForStop(spooling_options_.reconnect_interval)) {
+        return;
+      }
+      continue;
+    }
+
+    // Replay the front packet, no faster than the catch-up rate.
+    if (spooling_options_.catch_up_bytes_per_second > 0) {
+      absl::Time now = absl::Now();
+      if (next_send > now && WaitForStop(next_send - now)) {
+        return;
+      }
+      next_send = std::max(next_send, now) +
+                  absl::Seconds(static_cast<double>(packet.ByteSizeLong()) /
+                                spooling_options_.catch_up_bytes_per_second);
+    }
+    auto status =
+        sender->Send(std::move(packet), spooling_options_.stall_timeout);
+    if (status.ok()) {
+      absl::MutexLock lock(&mu_);
+      auto pop_status = spool_->PopFront();
+      if (!pop_status.ok()) {
+        LOG(ERROR) << pop_status;
+      }
+      continue;
+    }
+    LOG(WARNING) << "Failed to replay a spooled packet: " << status;
+    {
+      absl::MutexLock lock(&mu_);
+      if (sender_ == sender) {
+        sender_ = nullptr;
+      }
+    }
+    sender = nullptr;
+    if (WaitForStop(spooling_options_.reconnect_interval)) {
+      return;
+    }
+  }
+}
+
+}  // namespace visionai
@@ -0,0 +1,135 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef THIRD_PARTY_VISIONAI_STREAMS_CLIENT_SPOOLING_PACKET_SENDER_H_
+#define THIRD_PARTY_VISIONAI_STREAMS_CLIENT_SPOOLING_PACKET_SENDER_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "visionai/streams/client/packet_sender.h"
+#include "visionai/streams/packet/packet.h"
+#include "visionai/streams/util/packet_spool.h"
+
+namespace visionai {
+
+// The SpoolingPacketSender is a PacketSender that rides out network outages
+// by spooling the packets on the local disk.
+//
+// Packets are sent right away as long as the channel is healthy. Once a send
+// fails or stalls for longer than `stall_timeout`, the packet and all of the
+// ones that follow are appended to a PacketSpool instead, and `Send` returns
+// OK without waiting for the network. A background thread reconnects, and
+// then replays the spool in order, at most at `catch_up_bytes_per_second`.
+// `Send` resumes sending right away once the spool has been drained.
+//
+// Delivery is at least once: a packet that stalled may have reached the
+// server before it is replayed. Conversely, a packet that the underlying
+// PacketSender accepted is not replayed if the connection breaks before the
+// server receives it.
+//
+// When the spool is full, the packets are dropped and `Send` still returns
+// OK, so that the caller keeps writing until the channel recovers.
+//
+// Unlike a PacketSender, an instance remains usable after errors.
+//
+// `Send` must not be called concurrently.
+class SpoolingPacketSender : public PacketSender {
+ public:
+  // Creates a new PacketSender, i.e. a new connection to the channel.
+  using SenderFactory =
+      std::function<absl::StatusOr<std::unique_ptr<PacketSender>>()>;
+
+  struct Options {
+    // The options of the PacketSenders of the connections.
+    PacketSender::Options sender_options;
+
+    // The spool that takes the packets during an outage.
+    PacketSpool::Options spool_options;
+
+    // The longest that a send may take before the packet is spooled.
+    absl::Duration stall_timeout = absl::Seconds(5);
+
+    // The time to wait after a failed connection before the next attempt.
+    absl::Duration reconnect_interval = absl::Seconds(1);
+
+    // The highest rate at which to replay the spool. It must exceed the rate
+    // of the live packets for the spool to drain. Zero means no limit.
+    int64_t catch_up_bytes_per_second = 0;
+
+    // Creates the connections. Defaults to `PacketSender::Create` with
+    // `sender_options`.
+    SenderFactory sender_factory;
+  };
+
+  // Creates an instance that is ready for use.
+  //
+  // The channel does not need to be reachable: the packets are spooled until
+  // the first connection succeeds.
+  static absl::StatusOr<std::unique_ptr<SpoolingPacketSender>> Create(
+      Options options);
+
+  // Sends `packet`, or spools it.
+  //
+  // Blocks for at most min(`timeout`, `stall_timeout`).
+  absl::Status Send(Packet packet) override;
+  absl::Status Send(Packet packet, absl::Duration timeout) override;
+
+  // Returns the number of packets waiting in the spool.
+  int64_t num_spooled_packets() ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Waits for up to `timeout` for the spool to be replayed.
+  //
+  // Returns DEADLINE_EXCEEDED if packets are still left in the spool. `Send`
+  // must not be called concurrently.
+  absl::Status Drain(absl::Duration timeout) ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Stops the replay. The packets left in the spool remain on disk, and are
+  // replayed by the next instance that uses the same spool directory. Call
+  // `Drain` first to wait for them to be sent.
+  ~SpoolingPacketSender() override;
+
+  SpoolingPacketSender(const SpoolingPacketSender&) = delete;
+  SpoolingPacketSender& operator=(const SpoolingPacketSender&) = delete;
+
+ private:
+  explicit SpoolingPacketSender(Options options);
+
+  // Appends `packet` to the spool, and drops it if the spool is full.
+  absl::Status SpoolLocked(const Packet& packet)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Waits for `timeout` or for the destruction. Returns true in the latter
+  // case.
+  bool WaitForStop(absl::Duration timeout) ABSL_LOCKS_EXCLUDED(mu_);
+
+  // The main loop of `drainer_`, which reconnects and replays the spool.
+  void DrainMain() ABSL_LOCKS_EXCLUDED(mu_);
+
+  const Options spooling_options_;
+
+  absl::Mutex mu_;
+  bool is_stopping_ ABSL_GUARDED_BY(mu_) = false;
+  std::unique_ptr<PacketSpool> spool_ ABSL_GUARDED_BY(mu_);
+  int64_t num_dropped_ ABSL_GUARDED_BY(mu_) = 0;
+
+  // The current connection, if any. The caller of `Send` only uses it while
+  // the spool is empty, and `drainer_` only while it is not.
+  std::shared_ptr<PacketSender> sender_ ABSL_GUARDED_BY(mu_);
+
+  std::thread drainer_;
+};
+
+}  // namespace visionai
+
+#endif  // THIRD_PARTY_VISIONAI_STREAMS_CLIENT_SPOOLING_PACKET_SENDER_H_
@@ -0,0 +1,373 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/streams/client/spooling_packet_sender.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "google/cloud/visionai/v1/streaming_resources.pb.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "include/grpcpp/grpcpp.h"
+#include "visionai/proto/cluster_selection.pb.h"
+#include "visionai/streams/client/mock_streaming_service.h"
+#include "visionai/streams/client/packet_sender.h"
+#include "visionai/streams/packet/packet.h"
+#include "visionai/testing/grpc/mock_grpc.h"
+#include "visionai/util/file_helpers.h"
+#include "visionai/util/file_path.h"
+
+namespace visionai {
+namespace testing {
+namespace {
+
+using ::google::cloud::visionai::v1::SendPacketsRequest;
+using ::google::cloud::visionai::v1::SendPacketsResponse;
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+using ::testing::Invoke;
+
+using ServerStream =
+    grpc::ServerReaderWriter<SendPacketsResponse, SendPacketsRequest>;
+
+constexpr absl::Duration kTestTimeout = absl::Seconds(30);
+
+Packet MakeTestPacket(const std::string& s) {
+  return *MakePacket(std::string(s));
+}
+
+std::string PacketString(Packet p) {
+  auto s = PacketAs<std::string>(std::move(p));
+  return s.ok() ? *s : "";
+}
+
+// A channel that may go down, together with its PacketSenders.
+class FakeChannel {
+ public:
+  class Sender : public PacketSender {
+   public:
+    explicit Sender(FakeChannel* channel)
+        : PacketSender(PacketSender::Options()), channel_(channel) {}
+
+    absl::Status Send(Packet p) override {
+      return Send(std::move(p), absl::InfiniteDuration());
+    }
+
+    absl::Status Send(Packet p, absl::Duration timeout) override {
+      return channel_->Receive(std::move(p));
+    }
+
+   private:
+    FakeChannel* const channel_;
+  };
+
+  SpoolingPacketSender::SenderFactory Factory() {
+    return [this]() -> absl::StatusOr<std::unique_ptr<PacketSender>> {
+      absl::MutexLock lock(&mu_);
+      if (!is_up_) {
+        return absl::UnavailableError("The channel is down.");
+      }
+      return std::make_unique<Sender>(this);
+    };
+  }
+
+  void SetIsUp(bool is_up) {
+    absl::MutexLock lock(&mu_);
+    is_up_ = is_up;
+  }
+
+  std::vector<std::string> received() {
+    absl::MutexLock lock(&mu_);
+    return received_;
+  }
+
+  // Waits for up to `timeout` for `n` packets.
+  bool AwaitReceived(size_t n, absl::Duration timeout) {
+    absl::MutexLock lock(&mu_);
+    auto has_received = [this, n]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      return received_.size() >= n;
+    };
+    return mu_.AwaitWithTimeout(absl::Condition(&has_received), timeout);
+  }
+
+ private:
+  absl::Status Receive(Packet p) {
+    absl::MutexLock lock(&mu_);
+    if (!is_up_) {
+      return absl::UnavailableError("The channel is down.");
+    }
+    received_.push_back(PacketString(std::move(p)));
+    return absl::OkStatus();
+  }
+
+  absl::Mutex mu_;
+  bool is_up_ ABSL_GUARDED_BY(mu_) = true;
+  std::vector<std::string> received_ ABSL_GUARDED_BY(mu_);
+};
+
+class SpoolingPacketSenderTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    options_.spool_options.directory = file::JoinPath(
+        ::testing::TempDir(),
+        ::testing::UnitTest::GetInstance()->current_test_info()->name());
+    ASSERT_TRUE(RecursivelyCreateDir(options_.spool_options.directory).ok());
+    ASSERT_TRUE(DeleteFilesInDir(options_.spool_options.directory).ok());
+    options_.reconnect_interval = absl::Milliseconds(10);
+    options_.sender_factory = channel_.Factory();
+  }
+
+  FakeChannel channel_;
+  SpoolingPacketSender::Options options_;
+};
+
+TEST_F(SpoolingPacketSenderTest, SendsDirectlyWhileHealthy) {
+  auto sender = SpoolingPacketSender::Create(options_);
+  ASSERT_TRUE(sender.ok()) << sender.status();
+  EXPECT_TRUE((*sender)->Send(MakeTestPacket("a")).ok());
+  EXPECT_TRUE((*sender)->Send(MakeTestPacket("b")).ok());
+  EXPECT_THAT(channel_.received(), ElementsAre("a", "b"));
+  EXPECT_EQ((*sender)->num_spooled_packets(), 0);
+}
+
+TEST_F(SpoolingPacketSenderTest, ReplaysTheOutageInOrder) {
+  auto sender = SpoolingPacketSender::Create(options_);
+  ASSERT_TRUE(sender.ok()) << sender.status();
+  EXPECT_TRUE((*sender)->Send(MakeTestPacket("0")).ok());
+
+  channel_.SetIsUp(false);
+  for (int i = 1; i <= 3; ++i) {
+    EXPECT_TRUE((*sender)->Send(MakeTestPacket(absl::StrCat(i))).ok());
+  }
+  EXPECT_EQ((*sender)->num_spooled_packets(), 3);
+  EXPECT_THAT(channel_.received(), ElementsAre("0"));
+
+  // The live packets line up behind the spooled ones.
+  channel_.SetIsUp(true);
+  EXPECT_TRUE((*sender)->Send(MakeTestPacket("4")).ok());
+  ASSERT_TRUE(channel_.AwaitReceived(5, kTestTimeout));
+  EXPECT_THAT(channel_.received(), ElementsAre("0", "1", "2", "3", "4"));
+  EXPECT_EQ((*sender)->num_spooled_packets(), 0);
+}
+
+TEST_F(SpoolingPacketSenderTest, SpoolsUntilTheFirstConnection) {
+  channel_.SetIsUp(false);
+  auto sender = SpoolingPacketSender::Create(options_);
+  ASSERT_TRUE(sender.ok()) << sender.status();
+  EXPECT_TRUE((*sender)->Send(MakeTestPacket("a")).ok());
+  EXPECT_EQ((*sender)->num_spooled_packets(), 1);
+
+  channel_.SetIsUp(true);
+  ASSERT_TRUE(channel_.AwaitReceived(1, kTestTimeout));
+  EXPECT_THAT(channel_.received(), ElementsAre("a"));
+}
+
+TEST_F(SpoolingPacketSenderTest, ResumesTheSpoolOfThePreviousInstance) {
+  channel_.SetIsUp(false);
+  {
+    auto sender = SpoolingPacketSender::Create(options_);
+    ASSERT_TRUE(sender.ok()) << sender.status();
+    EXPECT_TRUE((*sender)->Send(MakeTestPacket("a")).ok());
+  }
+
+  channel_.SetIsUp(true);
+  auto sender = SpoolingPacketSender::Create(options_);
+  ASSERT_TRUE(sender.ok()) << sender.status();
+  ASSERT_TRUE(channel_.AwaitReceived(1, kTestTimeout));
+  EXPECT_THAT(channel_.received(), ElementsAre("a"));
+}
+
+TEST_F(SpoolingPacketSenderTest, DrainWaitsForTheReplay) {
+  channel_.SetIsUp(false);
+  auto sender = SpoolingPacketSender::Create(options_);
+  ASSERT_TRUE(sender.ok()) << sender.status();
+  EXPECT_TRUE((*sender)->Send(MakeTestPacket("a")).ok());
+  EXPECT_TRUE((*sender)->Send(MakeTestPacket("b")).ok());
+  EXPECT_EQ((*sender)->Drain(absl::Milliseconds(50)).code(),
+            absl::StatusCode::kDeadlineExceeded);
+
+  channel_.SetIsUp(true);
+  EXPECT_TRUE((*sender)->Drain(kTestTimeout).ok());
+  EXPECT_THAT(channel_.received(), ElementsAre("a", "b"));
+}
+
+TEST_F(SpoolingPacketSenderTest, ReplaysAtTheCatchUpRate) {
+  channel_.SetIsUp(false);
+  std::string payload(1000, 'x');
+  options_.catch_up_bytes_per_second = 10 * payload.size();
+  auto sender = SpoolingPacketSender::Create(options_);
+  ASSERT_TRUE(sender.ok()) << sender.status();
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_TRUE((*sender)->Send(MakeTestPacket(payload)).ok());
+  }
+
+  absl::Time start = absl::Now();
+  channel_.SetIsUp(true);
+  ASSERT_TRUE(channel_.AwaitReceived(5, kTestTimeout));
+  // The first packet goes right away, and each of the others 100ms later.
+  EXPECT_GE(absl::Now() - start, absl::Milliseconds(350));
+}
+
+TEST_F(SpoolingPacketSenderTest, DropsThePacketsWhenTheSpoolIsFull) {
+  channel_.SetIsUp(false);
+  Packet packet = MakeTestPacket("a");
+  // Leaves no room for a second packet along with its framing.
+  options_.spool_options.max_bytes = 2 * packet.ByteSizeLong();
+  auto sender = SpoolingPacketSender::Create(options_);
+  ASSERT_TRUE(sender.ok()) << sender.status();
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE((*sender)->Send(packet).ok());
+  }
+  EXPECT_EQ((*sender)->num_spooled_packets(), 1);
+}
+
+// Kills and restarts a local streaming server under a real PacketSender.
+class SpoolingPacketSenderGrpcTest : public SpoolingPacketSenderTest {
+ protected:
+  void SetUp() override {
+    SpoolingPacketSenderTest::SetUp();
+    options_.sender_factory = [this]() {
+      PacketSender::Options options;
+      options.cluster_selection.set_cluster_endpoint(address());
+      options.cluster_selection.set_project_id("some-project-id");
+      options.cluster_selection.set_location_id("some-location-id");
+      options.cluster_selection.set_cluster_id("some-cluster-id");
+      options.cluster_selection.set_use_insecure_channel(true);
+      options.channel.event_id = "some-event-id";
+      options.channel.stream_id = "some-stream-id";
+      options.sender = "some-sender";
+      return PacketSender::Create(options);
+    };
+  }
+
+  // Starts a server that records the packets it receives.
+  void StartServer() {
+    auto server = std::make_unique<MockGrpcServer<MockStreamingService>>();
+    EXPECT_CALL(*server->service(), SendPackets)
+        .WillRepeatedly(Invoke(
+            [this](grpc::ServerContext* context, ServerStream* stream) {
+              if (!Register(context)) {
+                return grpc::Status(grpc::StatusCode::UNAVAILABLE, "Killed.");
+              }
+              SendPacketsRequest request;
+              while (stream->Read(&request)) {
+                if (request.has_packet()) {
+                  absl::MutexLock lock(&mu_);
+                  received_.push_back(
+                      PacketString(std::move(*request.mutable_packet())));
+                }
+              }
+              Unregister(context);
+              return grpc::Status::OK;
+            }));
+    absl::MutexLock lock(&mu_);
+    address_ = server->local_credentials_server_address();
+    received_.clear();
+    is_killed_ = false;
+    server_ = std::move(server);
+  }
+
+  // Cancels the RPCs in progress and shuts the server down.
+  void KillServer() {
+    std::unique_ptr<MockGrpcServer<MockStreamingService>> server;
+    {
+      absl::MutexLock lock(&mu_);
+      is_killed_ = true;
+      for (auto* context : contexts_) {
+        context->TryCancel();
+      }
+      server = std::move(server_);
+    }
+    server = nullptr;
+  }
+
+  std::string address() {
+    absl::MutexLock lock(&mu_);
+    return address_;
+  }
+
+  std::vector<std::string> received() {
+    absl::MutexLock lock(&mu_);
+    return received_;
+  }
+
+  bool AwaitReceived(size_t n, absl::Duration timeout) {
+    absl::MutexLock lock(&mu_);
+    auto has_received = [this, n]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      return received_.size() >= n;
+    };
+    return mu_.AwaitWithTimeout(absl::Condition(&has_received), timeout);
+  }
+
+ private:
+  bool Register(grpc::ServerContext* context) {
+    absl::MutexLock lock(&mu_);
+    if (is_killed_) {
+      return false;
+    }
+    contexts_.push_back(context);
+    return true;
+  }
+
+  void Unregister(grpc::ServerContext* context) {
+    absl::MutexLock lock(&mu_);
+    contexts_.erase(std::remove(contexts_.begin(), contexts_.end(), context),
+                    contexts_.end());
+  }
+
+  absl::Mutex mu_;
+  std::string address_ ABSL_GUARDED_BY(mu_);
+  std::vector<std::string> received_ ABSL_GUARDED_BY(mu_);
+  std::vector<grpc::ServerContext*> contexts_ ABSL_GUARDED_BY(mu_);
+  bool is_killed_ ABSL_GUARDED_BY(mu_) = false;
+  std::unique_ptr<MockGrpcServer<MockStreamingService>> server_;
+};
+
+TEST_F(SpoolingPacketSenderGrpcTest, ReplaysAfterTheServerIsKilled) {
+  StartServer();
+  auto sender = SpoolingPacketSender::Create(options_);
+  ASSERT_TRUE(sender.ok()) << sender.status();
+  ASSERT_TRUE((*sender)->Send(MakeTestPacket("0")).ok());
+  ASSERT_TRUE(AwaitReceived(1, kTestTimeout));
+
+  // The packets in flight when the connection breaks are lost. The spool
+  // takes over from the first send that fails.
+  KillServer();
+  int i = 1;
+  for (; i < 100 && (*sender)->num_spooled_packets() == 0; ++i) {
+    ASSERT_TRUE((*sender)->Send(MakeTestPacket(absl::StrCat(i))).ok());
+    absl::SleepFor(absl::Milliseconds(20));
+  }
+  ASSERT_GT((*sender)->num_spooled_packets(), 0);
+  std::vector<std::string> expected = {absl::StrCat(i - 1)};
+  for (int j = 0; j < 3; ++j, ++i) {
+    ASSERT_TRUE((*sender)->Send(MakeTestPacket(absl::StrCat(i))).ok());
+    expected.push_back(absl::StrCat(i));
+  }
+
+  StartServer();
+  for (int j = 0; j < 3; ++j, ++i) {
+    ASSERT_TRUE((*sender)->Send(MakeTestPacket(absl::StrCat(i))).ok());
+    expected.push_back(absl::StrCat(i));
+  }
+  ASSERT_TRUE(AwaitReceived(expected.size(), kTestTimeout));
+  EXPECT_THAT(received(), ElementsAreArray(expected));
+  sender->reset();
+  KillServer();
+}
+
+}  // namespace
+}  // namespace testing
+}  // namespace visionai
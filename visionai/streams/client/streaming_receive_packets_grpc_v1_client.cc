@@ -94,8 +94,12 @@ absl::Status StreamingReceivePacketsGrpcV1Client::PrepareRpcStubs() {
   VAI_RETURN_IF_ERROR(SetAuthorizationHeaderFromJsonKey(
       options_.target_address, options_.advanced.connection_options))
       << "while configuring authorization information";
-  stub_ = StreamingService::NewStub(CreateChannel(
-      options_.target_address, options_.advanced.connection_options));
+  auto channel = options_.advanced.grpc_channel;
+  if (channel == nullptr) {
+    channel = CreateChannel(options_.target_address,
+                            options_.advanced.connection_options);
+  }
+  stub_ = StreamingService::NewStub(channel);
   ctx_ = CreateClientContext(options_.advanced.connection_options);
   return absl::OkStatus();
 }
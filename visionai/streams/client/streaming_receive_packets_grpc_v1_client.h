@@ -126,6 +126,11 @@ class StreamingReceivePacketsGrpcV1Client {
       // Options to configure the RPC connection.
       ConnectionOptions connection_options = DefaultConnectionOptions();
 
+      // An existing grpc channel to `target_address` to open the RPC on.
+      //
+      // A new channel is created from `connection_options` if not set.
+      std::shared_ptr<::grpc::Channel> grpc_channel;
+
       // The options specific to "controlled" mode.
       struct ControlledModeOptions {
         // This is the where the reader will begin its reads.
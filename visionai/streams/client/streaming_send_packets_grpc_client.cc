@@ -100,6 +100,19 @@ absl::Status StreamingSendPacketsGrpcClient::OpenRpc() {
   }
   stream_ = stub_->SendPackets(ctx_.get());
 
+  WriteCoalescer<SendPacketsRequest>::Options writer_options;
+  writer_options.max_delay = options_.max_write_coalescing_delay;
+  writer_options.max_message_bytes = options_.max_coalesced_packet_bytes;
+  writer_ = std::make_unique<WriteCoalescer<SendPacketsRequest>>(
+      writer_options,
+      [stream = stream_.get()](const SendPacketsRequest& request,
+                               bool buffer_hint) {
+        grpc::WriteOptions write_options;
+        if (buffer_hint) {
+          write_options.set_buffer_hint();
+        }
+        return stream->Write(request, write_options);
+      });
   return absl::OkStatus();
 }
 
@@ -136,7 +149,7 @@ absl::Status StreamingSendPacketsGrpcClient::SendSetupMessage() {
 absl::Status StreamingSendPacketsGrpcClient::Send(Packet packet) {
   SendPacketsRequest request;
   *request.mutable_packet() = std::move(packet);
-  if (!stream_->Write(request)) {
+  if (!writer_->Write(std::move(request))) {
     return CloseRpcExpectingErrors();
   }
   return absl::OkStatus();
@@ -209,14 +222,20 @@ absl::Status StreamingSendPacketsGrpcClient::CloseRpc(
     return absl::FailedPreconditionError("The RPC is already closed.");
   }
 
+  // Write out the packets held back for coalescing, unless the user
+  // cancelled, in which case cancelling first unblocks any pending write.
+  if (user_cancel_notification_.HasBeenNotified()) {
+    ctx_->TryCancel();
+  } else if (writer_ != nullptr && !writer_->Flush()) {
+    LOG(WARNING) << "Failed to write the packets held back for coalescing.";
+  }
+  writer_.reset();
+
   if (!stream_->WritesDone()) {
     LOG(WARNING)
         << "WritesDone() has returned false; but this may not necessarily be a "
            "problem if the RPC was already cancelled or terminated.";
   }
-  if (user_cancel_notification_.HasBeenNotified()) {
-    ctx_->TryCancel();
-  }
 
   // Since the server has gotten word that the client has completed its writes
   // (WritesDone returned true), it seems that the Read should eventually return
@@ -12,10 +12,12 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
 #include "include/grpcpp/grpcpp.h"
 #include "visionai/proto/util/net/grpc/connection_options.pb.h"
 #include "visionai/streams/client/descriptors.h"
 #include "visionai/streams/packet/packet.h"
+#include "visionai/util/net/grpc/write_coalescer.h"
 
 namespace visionai {
 
@@ -99,6 +101,15 @@ class StreamingSendPacketsGrpcClient {
 
     // Options to configure the RPC connection.
     ConnectionOptions connection_options;
+
+    // The longest that a small packet may be held back so that it goes onto
+    // the wire along with the packets that closely follow it. Only the
+    // packets sent in quick succession are held back. Zero disables the
+    // coalescing.
+    absl::Duration max_write_coalescing_delay = absl::Milliseconds(2);
+
+    // The largest packet, in bytes, that may be coalesced with others.
+    size_t max_coalesced_packet_bytes = 16 * 1024;
   };
 
   // Creates and initializes an instance that is ready for use.
@@ -134,6 +145,9 @@ class StreamingSendPacketsGrpcClient {
       google::cloud::visionai::v1::SendPacketsRequest,
       google::cloud::visionai::v1::SendPacketsResponse>>
       stream_ = nullptr;
+  std::unique_ptr<
+      WriteCoalescer<google::cloud::visionai::v1::SendPacketsRequest>>
+      writer_ = nullptr;
 
   absl::Notification user_cancel_notification_;
 
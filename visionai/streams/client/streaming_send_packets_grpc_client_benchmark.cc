@@ -0,0 +1,107 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+// Measures the throughput of StreamingSendPacketsGrpcClient against an
+// in-process mock server, with and without write coalescing.
+//
+// The benchmarks only report the rate of packets. To count the syscalls that
+// send and receive them, run a single benchmark under strace, e.g.
+//
+//   strace -c -f -e trace=sendmsg,recvmsg,write,read \
+//     streaming_send_packets_grpc_client_benchmark \
+//     --benchmark_filter='BM_Send/delay_us:500/bytes:64/'
+//
+// and divide the counts by the iterations that it prints, one packet each.
+// Both ends of the RPC live in this process, so that the counts cover the
+// client and the server together.
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "google/cloud/visionai/v1/streaming_resources.pb.h"
+#include "benchmark/benchmark.h"
+#include "gmock/gmock.h"
+#include "absl/time/time.h"
+#include "include/grpcpp/grpcpp.h"
+#include "visionai/streams/client/mock_streaming_service.h"
+#include "visionai/streams/client/streaming_send_packets_grpc_client.h"
+#include "visionai/streams/packet/packet.h"
+#include "visionai/util/net/grpc/client_connect.h"
+
+namespace visionai {
+namespace {
+
+using ::google::cloud::visionai::v1::SendPacketsRequest;
+using ::google::cloud::visionai::v1::SendPacketsResponse;
+using ::testing::Invoke;
+
+using ServerStream =
+    grpc::ServerReaderWriter<SendPacketsResponse, SendPacketsRequest>;
+
+// Args: {max write coalescing delay in us, packet size in bytes}.
+void BM_Send(benchmark::State& state) {
+  MockGrpcServer<MockStreamingService> server;
+  std::atomic<int64_t> num_received{0};
+  EXPECT_CALL(*server.service(), SendPackets)
+      .WillRepeatedly(Invoke([&num_received](grpc::ServerContext* context,
+                                             ServerStream* stream) {
+        SendPacketsRequest request;
+        while (stream->Read(&request)) {
+          if (request.has_packet()) {
+            ++num_received;
+          }
+        }
+        return grpc::Status::OK;
+      }));
+
+  StreamingSendPacketsGrpcClient::Options options;
+  options.target_address = server.local_credentials_server_address();
+  options.cluster_name =
+      "projects/test-project/locations/test-location/clusters/test-cluster";
+  options.channel.event_id = "some-event";
+  options.channel.stream_id = "some-stream";
+  options.sender = "some-sender";
+  options.connection_options = DefaultConnectionOptions();
+  options.connection_options.mutable_ssl_options()->set_use_insecure_channel(
+      true);
+  options.max_write_coalescing_delay = absl::Microseconds(state.range(0));
+  auto client = StreamingSendPacketsGrpcClient::Create(options);
+  if (!client.ok()) {
+    state.SkipWithError(client.status().ToString().c_str());
+    return;
+  }
+  auto packet = MakePacket(std::string(state.range(1), 'x'));
+  if (!packet.ok()) {
+    state.SkipWithError(packet.status().ToString().c_str());
+    return;
+  }
+
+  for (auto _ : state) {
+    if (!(*client)->Send(*packet).ok()) {
+      state.SkipWithError("Failed to send a packet.");
+      break;
+    }
+  }
+  // Wait for the server to receive everything.
+  client->reset();
+
+  double num_packets = static_cast<double>(state.iterations());
+  state.counters["packets"] =
+      benchmark::Counter(num_packets, benchmark::Counter::kIsRate);
+  state.counters["received"] = static_cast<double>(num_received.load());
+  state.SetBytesProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_Send)
+    ->ArgNames({"delay_us", "bytes"})
+    ->ArgsProduct({{0, 500, 2000}, {64, 1024, 32 * 1024}})
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace visionai
+
+BENCHMARK_MAIN();
@@ -22,6 +22,7 @@
 #include "visionai/streams/framework/attr_value_util.h"
 #include "visionai/streams/framework/event_writer.h"
 #include "visionai/streams/framework/event_writer_def_registry.h"
+#include "visionai/streams/util/stage_trace.h"
 #include "visionai/proto/ingester_config.pb.h"
 #include "visionai/util/producer_consumer_queue.h"
 #include "visionai/util/random_string.h"
@@ -33,8 +34,10 @@ DepositorModule::DepositorModule(const visionai::DepositorConfig& config)
     : config_(config) {}
 
 DepositorModule& DepositorModule::AttachInput(
-    std::shared_ptr<ProducerConsumerQueue<FilteredElement>> input_buffer) {
+    std::shared_ptr<ProducerConsumerQueue<FilteredElement>> input_buffer,
+    std::shared_ptr<QueueMetrics> input_metrics) {
   depositor_input_buffer_ = std::move(input_buffer);
+  depositor_input_metrics_ = std::move(input_metrics);
   return *this;
 }
 
@@ -58,6 +61,9 @@ absl::Status DepositorModule::Run() {
     if (!depositor_input_buffer_->TryPop(f, input_poll_timeout)) {
       continue;
     }
+    if (depositor_input_metrics_ != nullptr) {
+      depositor_input_metrics_->RecordPop();
+    }
 
     switch (f.type()) {
       case FilteredElementType::kOpen:
@@ -117,6 +123,7 @@ absl::Status DepositorModule::HandlePacketFilteredElement(FilteredElement f) {
   auto event_sink = sinks_[f.event_id()];
   VAI_ASSIGN_OR_RETURN(auto p, PacketFromFilteredElement(std::move(f)),
                    _ << "while converting a filtered element to a packet");
+  VAI_RETURN_IF_ERROR(TraceStage(kFilterOutputBufferStage, &p));
   VAI_RETURN_IF_ERROR(event_sink->Write(std::move(p)))
       << "while writing a packet into an event sink";
   return absl::OkStatus();
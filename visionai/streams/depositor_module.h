@@ -19,6 +19,7 @@
 #include "visionai/streams/filtered_element.h"
 #include "visionai/proto/ingester_config.pb.h"
 #include "visionai/streams/packet/packet.h"
+#include "visionai/streams/util/queue_metrics.h"
 #include "visionai/util/producer_consumer_queue.h"
 #include "visionai/util/ring_buffer.h"
 
@@ -33,9 +34,11 @@ class DepositorModule {
   // `Initialize` to get a usable instance.
   explicit DepositorModule(const visionai::DepositorConfig&);
 
-  // Attach the input buffer from which to poll for filtered Packets.
+  // Attach the input buffer from which to poll for filtered Packets, along
+  // with the metrics of its traffic, if any.
   DepositorModule& AttachInput(
-      std::shared_ptr<ProducerConsumerQueue<FilteredElement>> input_buffer);
+      std::shared_ptr<ProducerConsumerQueue<FilteredElement>> input_buffer,
+      std::shared_ptr<QueueMetrics> input_metrics = nullptr);
 
   // Attach an event manager.
   DepositorModule& AttachEventManager(
@@ -68,6 +71,7 @@ class DepositorModule {
 
   std::shared_ptr<ProducerConsumerQueue<FilteredElement>>
       depositor_input_buffer_ = nullptr;
+  std::shared_ptr<QueueMetrics> depositor_input_metrics_ = nullptr;
   std::shared_ptr<EventManager> event_manager_ = nullptr;
   std::shared_ptr<EventSink> event_sink_ = nullptr;
 
@@ -13,17 +13,40 @@
 #include "absl/cleanup/cleanup.h"
 #include "absl/status/status.h"
 #include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "absl/types/optional.h"
 #include "visionai/streams/constants.h"
 #include "visionai/streams/framework/event_writer.h"
 #include "visionai/proto/ingester_config.pb.h"
 #include "visionai/streams/packet/packet.h"
+#include "visionai/streams/util/queue_metrics.h"
+#include "visionai/streams/util/stage_trace.h"
 #include "visionai/streams/util/worker.h"
 #include "visionai/util/producer_consumer_queue.h"
 #include "visionai/util/status/status_macros.h"
 
 namespace visionai {
 
+namespace {
+
+// Writes `p` into `writer`, and records the remaining stages of `p` if it is
+// traced.
+absl::Status WriteTraced(EventWriter* writer, Packet p) {
+  absl::Time capture_time = GetCaptureTime(p);
+  absl::optional<absl::Time> write_start =
+      EndStageTrace(kEventSinkBufferStage, &p);
+  VAI_RETURN_IF_ERROR(writer->Write(std::move(p)));
+  if (write_start.has_value()) {
+    absl::Time now = absl::Now();
+    RecordStageLatency(kEventWriterStage, *write_start, now);
+    RecordStageLatency(kTotalStage, capture_time, now);
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
 EventSink::EventSink(const Options& options) : options_(options) {}
 
 absl::StatusOr<std::shared_ptr<EventSink>> EventSink::Create(
@@ -40,6 +63,9 @@ absl::Status EventSink::Initialize() {
   }
   write_buffer_ =
       std::make_shared<ProducerConsumerQueue<Packet>>(write_buffer_capacity);
+  write_buffer_metrics_ = std::make_unique<QueueMetrics>(
+      GetQueueMetricsStreamId(options_.event_writer_config),
+      kEventSinkBufferStage, write_buffer_capacity);
 
   // Create an EventWriter.
   VAI_ASSIGN_OR_RETURN(auto writer,
@@ -86,16 +112,18 @@ absl::Status EventSink::WriterMain(const MainContext& ctx) {
             absl::Milliseconds(kDefaultEventSinkFinalizationTimeoutMs / 2))) {
       continue;
     }
+    write_buffer_metrics_->RecordPop();
     // TODO: Currently, any error just ends the event.
     //       We may want to distinguish between different conditions.
-    VAI_RETURN_IF_ERROR(ctx.writer->Write(std::move(p)))
+    VAI_RETURN_IF_ERROR(WriteTraced(ctx.writer.get(), std::move(p)))
         << "during an EventWrite write";
   }
 
   // Write any lingering packets.
   Packet p;
   while (write_buffer_->TryPop(p)) {
-    VAI_RETURN_IF_ERROR(ctx.writer->Write(std::move(p)))
+    write_buffer_metrics_->RecordPop();
+    VAI_RETURN_IF_ERROR(WriteTraced(ctx.writer.get(), std::move(p)))
         << "during final EventWrite writes";
   }
   return absl::OkStatus();
@@ -136,12 +164,15 @@ absl::Status EventSink::Write(Packet p) {
     }
     return return_status;
   }
+  VAI_RETURN_IF_ERROR(TraceStage(kDepositorStage, &p));
   auto p_ptr = std::make_unique<Packet>(std::move(p));
   if (!write_buffer_->TryPush(p_ptr)) {
+    write_buffer_metrics_->RecordDrop();
     return absl::UnavailableError(
         absl::StrFormat("The write buffer is currently full (capacity = %d).",
                         write_buffer_->capacity()));
   }
+  write_buffer_metrics_->RecordPush();
   return absl::OkStatus();
 }
 
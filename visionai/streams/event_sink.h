@@ -14,6 +14,7 @@
 #include "visionai/streams/framework/event_writer.h"
 #include "visionai/proto/ingester_config.pb.h"
 #include "visionai/streams/packet/packet.h"
+#include "visionai/streams/util/queue_metrics.h"
 #include "visionai/streams/util/worker.h"
 #include "visionai/util/producer_consumer_queue.h"
 
@@ -70,6 +71,7 @@ class EventSink {
   const Options options_;
 
   std::shared_ptr<ProducerConsumerQueue<Packet>> write_buffer_ = nullptr;
+  std::unique_ptr<QueueMetrics> write_buffer_metrics_ = nullptr;
   std::unique_ptr<streams_internal::Worker> worker_ = nullptr;
   absl::Notification close_signal_;
 
@@ -37,14 +37,18 @@ FilterModule::FilterModule(const visionai::FilterConfig& config)
     : config_(config) {}
 
 FilterModule& FilterModule::AttachInput(
-    std::shared_ptr<RingBuffer<Packet>> filter_input_buffer) {
+    std::shared_ptr<RingBuffer<Packet>> filter_input_buffer,
+    std::shared_ptr<QueueMetrics> filter_input_metrics) {
   filter_input_buffer_ = std::move(filter_input_buffer);
+  filter_input_metrics_ = std::move(filter_input_metrics);
   return *this;
 }
 
 FilterModule& FilterModule::AttachOutput(
-    std::shared_ptr<ProducerConsumerQueue<FilteredElement>> output_buffer) {
+    std::shared_ptr<ProducerConsumerQueue<FilteredElement>> output_buffer,
+    std::shared_ptr<QueueMetrics> output_metrics) {
   filter_output_buffer_ = std::move(output_buffer);
+  filter_output_metrics_ = std::move(output_metrics);
   return *this;
 }
 
@@ -93,6 +97,8 @@ FilterModule::CreateFilterRunContext() {
   d.input_buffer = filter_input_buffer_;
   d.output_buffer = filter_output_buffer_;
   d.event_manager = event_manager_;
+  d.input_metrics = filter_input_metrics_;
+  d.output_metrics = filter_output_metrics_;
   return std::make_unique<FilterRunContext>(std::move(d));
 }
 
@@ -19,6 +19,7 @@
 #include "visionai/streams/framework/filter.h"
 #include "visionai/proto/ingester_config.pb.h"
 #include "visionai/streams/packet/packet.h"
+#include "visionai/streams/util/queue_metrics.h"
 #include "visionai/util/producer_consumer_queue.h"
 #include "visionai/util/ring_buffer.h"
 
@@ -35,12 +36,17 @@ class FilterModule {
   // `Prepare` to get a usable instance.
   explicit FilterModule(const visionai::FilterConfig&);
 
-  // Attach the input buffer from which to poll for filter inputs.
-  FilterModule& AttachInput(std::shared_ptr<RingBuffer<Packet>> input_buffer);
+  // Attach the input buffer from which to poll for filter inputs, along with
+  // the metrics of its traffic, if any.
+  FilterModule& AttachInput(
+      std::shared_ptr<RingBuffer<Packet>> input_buffer,
+      std::shared_ptr<QueueMetrics> input_metrics = nullptr);
 
-  // Attach the output buffer to which to push filtered outputs.
+  // Attach the output buffer to which to push filtered outputs, along with the
+  // metrics of its traffic, if any.
   FilterModule& AttachOutput(
-      std::shared_ptr<ProducerConsumerQueue<FilteredElement>> output_buffer);
+      std::shared_ptr<ProducerConsumerQueue<FilteredElement>> output_buffer,
+      std::shared_ptr<QueueMetrics> output_metrics = nullptr);
 
   // Attach an event manager.
   FilterModule& AttachEventManager(std::shared_ptr<EventManager> event_manager);
@@ -78,6 +84,8 @@ class FilterModule {
   std::shared_ptr<RingBuffer<Packet>> filter_input_buffer_ = nullptr;
   std::shared_ptr<ProducerConsumerQueue<FilteredElement>>
       filter_output_buffer_ = nullptr;
+  std::shared_ptr<QueueMetrics> filter_input_metrics_ = nullptr;
+  std::shared_ptr<QueueMetrics> filter_output_metrics_ = nullptr;
   std::shared_ptr<EventManager> event_manager_ = nullptr;
 
   std::unique_ptr<FilterInitContext> filter_init_ctx_ = nullptr;
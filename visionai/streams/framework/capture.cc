@@ -9,6 +9,8 @@
 #include "absl/status/status.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "visionai/streams/util/stage_trace.h"
+#include "visionai/util/status/status_macros.h"
 
 namespace visionai {
 
@@ -43,7 +45,20 @@ absl::Status CaptureInitContext::GetInputUrls(
 }
 
 CaptureRunContext::CaptureRunContext(RunData d)
-    : output_buffer_(std::move(d.output_buffer)) {}
+    : output_buffer_(std::move(d.output_buffer)),
+      trace_stages_(d.trace_stages),
+      output_metrics_(std::move(d.output_metrics)) {}
+
+absl::Status CaptureRunContext::Push(Packet v) {
+  if (trace_stages_) {
+    VAI_RETURN_IF_ERROR(StartStageTrace(&v));
+  }
+  bool evicted = !output_buffer_->EmplaceFront(std::move(v));
+  if (output_metrics_ != nullptr) {
+    output_metrics_->RecordPush(evicted);
+  }
+  return absl::OkStatus();
+}
 
 CaptureRegistry* CaptureRegistry::Global() {
   static CaptureRegistry* global_registry = new CaptureRegistry;
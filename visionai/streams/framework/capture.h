@@ -21,6 +21,7 @@
 #include "visionai/streams/framework/attr_value_util.h"
 #include "visionai/streams/framework/registration.h"
 #include "visionai/streams/packet/packet.h"
+#include "visionai/streams/util/queue_metrics.h"
 #include "visionai/util/ring_buffer.h"
 
 namespace visionai {
@@ -60,16 +61,22 @@ class CaptureRunContext {
  public:
   struct RunData {
     std::shared_ptr<RingBuffer<Packet>> output_buffer;
+
+    // Whether to trace the latency of each stage of the pushed Packets. See
+    // streams/util/stage_trace.h.
+    bool trace_stages = false;
+
+    // The metrics of `output_buffer`, if any.
+    std::shared_ptr<QueueMetrics> output_metrics;
   };
   explicit CaptureRunContext(RunData d);
 
-  absl::Status Push(Packet v) {
-    output_buffer_->EmplaceFront(std::move(v));
-    return absl::OkStatus();
-  }
+  absl::Status Push(Packet v);
 
  private:
   std::shared_ptr<RingBuffer<Packet>> output_buffer_;
+  bool trace_stages_;
+  std::shared_ptr<QueueMetrics> output_metrics_;
 };
 
 // Capture is the base class for all source captures.
@@ -11,6 +11,7 @@
 #include "absl/strings/string_view.h"
 #include "visionai/streams/event_manager.h"
 #include "visionai/streams/filtered_element.h"
+#include "visionai/streams/util/stage_trace.h"
 
 namespace visionai {
 
@@ -19,12 +20,28 @@ FilterInitContext::FilterInitContext(InitData d) : attrs_(std::move(d.attrs)) {}
 FilterRunContext::FilterRunContext(RunData d)
     : input_buffer_(std::move(d.input_buffer)),
       output_buffer_(std::move(d.output_buffer)),
-      event_manager_(std::move(d.event_manager)) {}
+      event_manager_(std::move(d.event_manager)),
+      input_metrics_(std::move(d.input_metrics)),
+      output_metrics_(std::move(d.output_metrics)) {}
+
+bool FilterRunContext::TryPushOutput(FilteredElement f) {
+  if (!output_buffer_->TryEmplace(std::move(f))) {
+    if (output_metrics_ != nullptr) {
+      output_metrics_->RecordDrop();
+    }
+    return false;
+  }
+  if (output_metrics_ != nullptr) {
+    output_metrics_->RecordPush();
+  }
+  return true;
+}
 
 absl::Status FilterRunContext::Push(absl::string_view event_id, Packet p) {
+  VAI_RETURN_IF_ERROR(TraceStage(kFilterStage, &p));
   VAI_ASSIGN_OR_RETURN(auto f, MakePacketFilteredElement(event_id, std::move(p)),
                    _ << "while converting a packet into a filtered element.");
-  if (!output_buffer_->TryEmplace(std::move(f))) {
+  if (!TryPushOutput(std::move(f))) {
     LOG_EVERY_T(WARNING, 1)
         << "The filtered element queue is currently full; dropping an element.";
   }
@@ -36,7 +53,10 @@ absl::Status FilterRunContext::Poll(Packet* p, absl::Duration timeout) {
     return absl::UnavailableError(
         "No inputs arrived before the timeout expired.");
   }
-  return absl::OkStatus();
+  if (input_metrics_ != nullptr) {
+    input_metrics_->RecordPop();
+  }
+  return TraceStage(kCaptureOutputBufferStage, p);
 }
 
 absl::StatusOr<std::string> FilterRunContext::StartEvent() {
@@ -44,7 +64,7 @@ absl::StatusOr<std::string> FilterRunContext::StartEvent() {
                    _ << "while attempting to open a new event");
   VAI_ASSIGN_OR_RETURN(auto f, MakeOpenFilteredElement(event_id),
                    _ << "while making an (open) control filtered element");
-  if (!output_buffer_->TryEmplace(std::move(f))) {
+  if (!TryPushOutput(std::move(f))) {
     return absl::ResourceExhaustedError(
         "The filtered element queue is full; could not push a control "
         "element.");
@@ -55,7 +75,7 @@ absl::StatusOr<std::string> FilterRunContext::StartEvent() {
 absl::Status FilterRunContext::EndEvent(absl::string_view event_id) {
   VAI_ASSIGN_OR_RETURN(auto f, MakeCloseFilteredElement(event_id),
                    _ << "while making a (close) control filtered element");
-  if (!output_buffer_->TryEmplace(std::move(f))) {
+  if (!TryPushOutput(std::move(f))) {
     return absl::ResourceExhaustedError(
         "The filtered element queue is full; could not push a control "
         "element.");
@@ -21,6 +21,7 @@
 #include "visionai/streams/framework/attr_value_util.h"
 #include "visionai/streams/framework/registration.h"
 #include "visionai/streams/packet/packet.h"
+#include "visionai/streams/util/queue_metrics.h"
 #include "visionai/util/producer_consumer_queue.h"
 #include "visionai/util/ring_buffer.h"
 
@@ -55,6 +56,10 @@ class FilterRunContext {
     std::shared_ptr<RingBuffer<Packet>> input_buffer;
     std::shared_ptr<ProducerConsumerQueue<FilteredElement>> output_buffer;
     std::shared_ptr<EventManager> event_manager;
+
+    // The metrics of `input_buffer` and `output_buffer`, if any.
+    std::shared_ptr<QueueMetrics> input_metrics;
+    std::shared_ptr<QueueMetrics> output_metrics;
   };
   explicit FilterRunContext(RunData d);
 
@@ -85,6 +90,11 @@ class FilterRunContext {
   std::shared_ptr<RingBuffer<Packet>> input_buffer_;
   std::shared_ptr<ProducerConsumerQueue<FilteredElement>> output_buffer_;
   std::shared_ptr<EventManager> event_manager_;
+  std::shared_ptr<QueueMetrics> input_metrics_;
+  std::shared_ptr<QueueMetrics> output_metrics_;
+
+  // Pushes `f` into the output buffer. Returns false if it is full.
+  bool TryPushOutput(FilteredElement f);
 };
 
 // Filter is the base class for all source filters.
@@ -7,6 +7,7 @@
 #include "visionai/streams/ingester.h"
 
 #include <memory>
+#include <string>
 #include <thread>
 
 #include "absl/status/status.h"
@@ -17,6 +18,8 @@
 #include "visionai/streams/depositor_module.h"
 #include "visionai/streams/event_manager.h"
 #include "visionai/streams/filtered_element.h"
+#include "visionai/streams/util/queue_metrics.h"
+#include "visionai/streams/util/stage_trace.h"
 #include "visionai/util/producer_consumer_queue.h"
 #include "visionai/util/ring_buffer.h"
 #include "visionai/util/status/status_macros.h"
@@ -112,6 +115,8 @@ absl::Status Ingester::Cancel() {
 
 absl::Status Ingester::CreateModules() {
   capture_module_ = std::make_shared<CaptureModule>(config_.capture_config());
+  capture_module_->EnableStageTracing(
+      config_.parameters().enable_stage_tracing());
   filter_module_ = std::make_shared<FilterModule>(config_.filter_config());
   depositor_module_ =
       std::make_shared<DepositorModule>(config_.depositor_config());
@@ -119,6 +124,9 @@ absl::Status Ingester::CreateModules() {
 }
 
 absl::Status Ingester::CreateAndAttachInterModuleBuffers() {
+  std::string stream_id =
+      GetQueueMetricsStreamId(config_.event_writer_config());
+
   int capture_output_buffer_capacity =
       config_.parameters().capture_output_buffer_capacity();
   if (capture_output_buffer_capacity <= 0) {
@@ -126,7 +134,10 @@ absl::Status Ingester::CreateAndAttachInterModuleBuffers() {
   }
   capture_output_buffer_ =
       std::make_shared<RingBuffer<Packet>>(capture_output_buffer_capacity);
-  capture_module_->AttachOutput(capture_output_buffer_);
+  auto capture_output_metrics = std::make_shared<QueueMetrics>(
+      stream_id, kCaptureOutputBufferStage, capture_output_buffer_capacity);
+  capture_module_->AttachOutput(capture_output_buffer_,
+                                capture_output_metrics);
 
   int filter_output_buffer_capacity =
       config_.parameters().filter_output_buffer_capacity();
@@ -136,10 +147,12 @@ absl::Status Ingester::CreateAndAttachInterModuleBuffers() {
   filter_output_buffer_ =
       std::make_shared<ProducerConsumerQueue<FilteredElement>>(
           filter_output_buffer_capacity);
-  filter_module_->AttachInput(capture_output_buffer_);
-  filter_module_->AttachOutput(filter_output_buffer_);
+  auto filter_output_metrics = std::make_shared<QueueMetrics>(
+      stream_id, kFilterOutputBufferStage, filter_output_buffer_capacity);
+  filter_module_->AttachInput(capture_output_buffer_, capture_output_metrics);
+  filter_module_->AttachOutput(filter_output_buffer_, filter_output_metrics);
 
-  depositor_module_->AttachInput(filter_output_buffer_);
+  depositor_module_->AttachInput(filter_output_buffer_, filter_output_metrics);
 
   return absl::OkStatus();
 }
@@ -11,6 +11,7 @@
 #include "absl/synchronization/notification.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "visionai/algorithms/media/util/frame_sampling.h"
 #include "visionai/algorithms/media/util/gstreamer_runner.h"
 #include "visionai/algorithms/media/util/type_util.h"
 #include "visionai/util/producer_consumer_queue.h"
@@ -32,7 +33,11 @@ std::string RTSPImageCapture::OutputGstPipelineStr() {
   gst_pipeline.push_back("video/x-raw,format=RGB");
 
   if (!frame_rate_.empty()) {
-    gst_pipeline.push_back("videorate");
+    // When frames are dropped before decoding, videorate must not duplicate
+    // the decoded frames to fill the gaps back up to `frame_rate_`.
+    gst_pipeline.push_back(sampling_mode_ == FrameSamplingMode::kAll
+                               ? "videorate"
+                               : "videorate drop-only=true");
     gst_pipeline.push_back(
         absl::StrFormat("video/x-raw,framerate=%s", frame_rate_));
   }
@@ -50,6 +55,10 @@ absl::Status RTSPImageCapture::Init(CaptureInitContext* ctx) {
   VAI_RETURN_IF_ERROR(ctx->GetAttr<int>("buffer_size", &buffer_size_));
   VAI_RETURN_IF_ERROR(ctx->GetAttr<std::string>("frame_rate", &frame_rate_));
   VAI_RETURN_IF_ERROR(ctx->GetAttr<int>("timeout", &timeout_seconds_));
+  std::string sampling_mode;
+  VAI_RETURN_IF_ERROR(
+      ctx->GetAttr<std::string>("sampling_mode", &sampling_mode));
+  VAI_ASSIGN_OR_RETURN(sampling_mode_, ToFrameSamplingMode(sampling_mode));
   return absl::OkStatus();
 }
 
@@ -129,9 +138,12 @@ absl::Status RTSPImageCapture::Run(CaptureRunContext* ctx) {
   VAI_ASSIGN_OR_RETURN(auto output_pipeline,
                    GstreamerRunner::Create(output_pipeline_opts));
 
-  // Feed the buffers to the output pipeline.
+  // Feed the buffers to the output pipeline. Buffers that are not selected by
+  // the sampling mode are dropped here so that they are never decoded.
   while (!is_cancelled_.HasBeenNotified()) {
-    VAI_RETURN_IF_ERROR(output_pipeline->Feed(buffer));
+    if (ShouldDecodeFrame(sampling_mode_, buffer)) {
+      VAI_RETURN_IF_ERROR(output_pipeline->Feed(buffer));
+    }
     if (!queue.TryPop(buffer, absl::Seconds(timeout_seconds_))) {
       break;
     }
@@ -162,6 +174,10 @@ REGISTER_CAPTURE_INTERFACE("RTSPImageCapture")
     // Optional: the timeout (in seconds) to receive contents from the RTSP
     // source. Default to 10s.
     .Attr("timeout", "int")
+    // Optional: the frames to decode. One of "all", "skip_non_reference" or
+    // "key_frames_only". Frames that are not selected are dropped before
+    // decoding. Default to "all".
+    .Attr("sampling_mode", "string")
     .Doc(
         "RTSPImageCapture receives media data from an RTSP uri source. It "
         "drops the initial several non-key frame packets and converts the "
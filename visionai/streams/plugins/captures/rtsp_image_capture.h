@@ -10,6 +10,7 @@
 #define THIRD_PARTY_VISIONAI_STREAMS_PLUGINS_CAPTURES_RTSP_IMAGE_CAPTURE_H_
 
 #include "absl/synchronization/notification.h"
+#include "visionai/algorithms/media/util/frame_sampling.h"
 #include "visionai/streams/framework/capture.h"
 #include "visionai/streams/framework/capture_def_registry.h"
 
@@ -39,6 +40,7 @@ class RTSPImageCapture : public Capture {
   std::string source_uri_;
   int buffer_size_ = 100;
   int timeout_seconds_ = 10;
+  FrameSamplingMode sampling_mode_ = FrameSamplingMode::kAll;
 
   absl::Notification is_cancelled_;
 
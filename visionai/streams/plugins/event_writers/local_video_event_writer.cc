@@ -6,6 +6,7 @@
 
 #include "visionai/streams/plugins/event_writers/local_video_event_writer.h"
 
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -13,6 +14,8 @@
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "visionai/algorithms/media/gstreamer_video_writer.h"
 #include "visionai/streams/framework/event_writer.h"
 #include "visionai/streams/framework/event_writer_def_registry.h"
@@ -35,14 +38,47 @@ absl::Status LocalVideoEventWriter::Init(EventWriterInitContext* ctx) {
   }
   VAI_RETURN_IF_ERROR(ctx->GetAttr<bool>("skip_until_first_key_frame",
                                      &skip_until_first_key_frame_));
+  VAI_RETURN_IF_ERROR(
+      ctx->GetAttr<int>("segment_duration_sec", &segment_duration_sec_));
+  VAI_RETURN_IF_ERROR(ctx->GetAttr<int>("segment_max_mb", &segment_max_mb_));
+  VAI_RETURN_IF_ERROR(
+      ctx->GetAttr<int>("fragment_duration_ms", &fragment_duration_ms_));
+  if (segment_duration_sec_ < 0 || segment_max_mb_ < 0 ||
+      fragment_duration_ms_ < 0) {
+    return absl::InvalidArgumentError(
+        "The segment and fragment sizes cannot be negative.");
+  }
   return absl::OkStatus();
 }
 
 absl::Status LocalVideoEventWriter::Open(absl::string_view event_id) {
   event_id_ = std::string(event_id);
+  segment_index_ = 0;
   return absl::OkStatus();
 }
 
+bool LocalVideoEventWriter::IsSegmented() const {
+  return segment_duration_sec_ > 0 || segment_max_mb_ > 0;
+}
+
+bool LocalVideoEventWriter::IsSegmentFull(
+    const GstreamerBuffer& buffer) const {
+  if (segment_max_mb_ > 0 &&
+      segment_bytes_ >= (static_cast<int64_t>(segment_max_mb_) << 20)) {
+    return true;
+  }
+  if (segment_duration_sec_ > 0) {
+    // Prefer the media time, so that the segments have the same length
+    // whatever the pace of the input.
+    absl::Duration elapsed =
+        buffer.get_pts() >= 0 && segment_start_pts_ >= 0
+            ? absl::Nanoseconds(buffer.get_pts() - segment_start_pts_)
+            : absl::Now() - segment_start_time_;
+    return elapsed >= absl::Seconds(segment_duration_sec_);
+  }
+  return false;
+}
+
 absl::Status LocalVideoEventWriter::Write(Packet p) {
   auto gstreamer_buffer = PacketAs<GstreamerBuffer>(std::move(p));
   VAI_RETURN_IF_ERROR(gstreamer_buffer.status());
@@ -50,16 +86,30 @@ absl::Status LocalVideoEventWriter::Write(Packet p) {
   if (skip_until_first_key_frame_ && !got_key_frame_) {
     return absl::OkStatus();
   }
+  // Only start a new segment on a key frame, so that each one is decodable
+  // on its own.
+  if (video_writer_ && IsSegmented() && gstreamer_buffer->is_key_frame() &&
+      IsSegmentFull(*gstreamer_buffer)) {
+    video_writer_.reset();
+    ++segment_index_;
+  }
   if (!video_writer_) {
     GstreamerVideoWriter::Options options;
-    options.file_path = file::JoinPath(output_,
-                                       absl::StrCat(event_id_, ".mp4"));
+    options.file_path = file::JoinPath(
+        output_, IsSegmented()
+                     ? absl::StrFormat("%s-%05d.mp4", event_id_, segment_index_)
+                     : absl::StrCat(event_id_, ".mp4"));
     options.caps_string = gstreamer_buffer->caps_string();
     options.h264_mux_only = true;
     options.h264_only = true;
+    options.fragment_duration = absl::Milliseconds(fragment_duration_ms_);
     LOG(ERROR) << "Launching the gstreamer video writer";
     VAI_ASSIGN_OR_RETURN(video_writer_, GstreamerVideoWriter::Create(options));
+    segment_start_pts_ = gstreamer_buffer->get_pts();
+    segment_start_time_ = absl::Now();
+    segment_bytes_ = 0;
   }
+  segment_bytes_ += gstreamer_buffer->size();
   LOG_EVERY_T(INFO, 10) << "Writing...";
   return video_writer_->Put(gstreamer_buffer.value());
 }
@@ -72,6 +122,9 @@ absl::Status LocalVideoEventWriter::Close() {
 REGISTER_EVENT_WRITER_INTERFACE("LocalVideoEventWriter")
     .Attr("output", "string")
     .Attr("skip_until_first_key_frame", "bool")
+    .Attr("segment_duration_sec", "int")
+    .Attr("segment_max_mb", "int")
+    .Attr("fragment_duration_ms", "int")
     .Doc(R"doc(
 LocalVideoEventWriter saves the incoming packets to local mp4 file.
 
@@ -79,6 +132,15 @@ Attributes:
   output (string, required): the output dir for segmented mp4 files.
   skip_until_first_key_frame (bool, optional): if set true, the writer drops
     all the frames until a key frame arrives.
+  segment_duration_sec (int, optional): if positive, starts a new file at the
+    first key frame after this long. The files of an event are then named
+    <event_id>-<index>.mp4 rather than <event_id>.mp4. Default is 0.
+  segment_max_mb (int, optional): if positive, starts a new file at the first
+    key frame after this many megabytes. Default is 0.
+  fragment_duration_ms (int, optional): if positive, writes fragmented mp4
+    files with a fragment this often, which are readable while they are
+    written and survive a crash. Zero writes regular mp4 files, which are
+    only readable once closed. Default is 1000.
 )doc");
 
 REGISTER_EVENT_WRITER_IMPLEMENTATION("LocalVideoEventWriter",
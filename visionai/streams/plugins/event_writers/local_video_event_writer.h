@@ -29,11 +29,15 @@
 #ifndef THIRD_PARTY_VISIONAI_STREAMS_PLUGINS_EVENT_WRITERS_LOCAL_VIDEO_EVENT_WRITER_H_
 #define THIRD_PARTY_VISIONAI_STREAMS_PLUGINS_EVENT_WRITERS_LOCAL_VIDEO_EVENT_WRITER_H_
 
+#include <cstdint>
 #include <memory>
+#include <string>
 
 #include "absl/status/status.h"
+#include "absl/time/time.h"
 #include "visionai/algorithms/media/gstreamer_video_writer.h"
 #include "visionai/streams/framework/event_writer.h"
+#include "visionai/types/gstreamer_buffer.h"
 #include "visionai/util/status/status_macros.h"
 
 namespace visionai {
@@ -53,12 +57,28 @@ class LocalVideoEventWriter : public EventWriter {
 
   absl::Status Close() override;
  private:
+  // Returns true if the events are split into several files.
+  bool IsSegmented() const;
+
+  // Returns true if the current file should end before `buffer`.
+  bool IsSegmentFull(const GstreamerBuffer& buffer) const;
+
   std::unique_ptr<GstreamerVideoWriter> video_writer_;
   std::string event_id_;
   std::string output_;
 
   bool skip_until_first_key_frame_ = false;
   bool got_key_frame_ = false;
+
+  int segment_duration_sec_ = 0;
+  int segment_max_mb_ = 0;
+  int fragment_duration_ms_ = 1000;
+
+  // The current segment of the event.
+  int segment_index_ = 0;
+  int64_t segment_start_pts_ = -1;
+  absl::Time segment_start_time_;
+  int64_t segment_bytes_ = 0;
 };
 }  // namespace visionai
 
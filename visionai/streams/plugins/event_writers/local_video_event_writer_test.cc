@@ -28,18 +28,25 @@
 
 #include "visionai/streams/plugins/event_writers/local_video_event_writer.h"
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
 #include "google/protobuf/text_format.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "testing/base/public/mock-log.h"
 #include "absl/debugging/leak_check.h"
+#include "absl/strings/str_format.h"
 #include "absl/strings/substitute.h"
+#include "absl/time/time.h"
 #include "third_party/gstreamer/subprojects/gstreamer/gst/gstplugin.h"
 #include "visionai/algorithms/media/util/gstreamer_registry.h"
 #include "visionai/algorithms/media/util/gstreamer_runner.h"
 #include "visionai/algorithms/media/util/util.h"
 #include "visionai/testing/status/status_matchers.h"
 #include "visionai/util/file_helpers.h"
+#include "visionai/util/file_path.h"
 
 namespace visionai {
 
@@ -130,6 +137,55 @@ TEST_F(LocalEventWriterTest, WriteVideoInLocal) {
   ASSERT_TRUE(DeleteFile(kTestOutputFile).ok());
 }
 
+TEST_F(LocalEventWriterTest, WriteVideoInSegments) {
+  std::unique_ptr<LocalVideoEventWriter> writer =
+      std::make_unique<LocalVideoEventWriter>();
+  EventWriterConfig config;
+  EXPECT_TRUE(TextFormat::ParseFromString(
+      absl::Substitute(kTestConfigTemplate),
+      &config));
+  (*config.mutable_attr())["output"] = kOutputDir;
+  (*config.mutable_attr())["segment_duration_sec"] = "1";
+  VAI_ASSERT_OK_AND_ASSIGN(auto context, EventWriterInitContext::Create(config));
+  ASSERT_TRUE(writer->Init(context.get()).ok());
+  ASSERT_TRUE(writer->Open(kTestEventId).ok());
+
+  // The number of frames in each segment, as split by their pts.
+  std::vector<int> segment_counts = {0};
+  int64_t segment_start_pts = -1;
+  GstreamerRunner::Options input_runner_opt;
+  input_runner_opt.processing_pipeline_string = absl::StrFormat(
+      "filesrc location=%s ! qtdemux ! h264parse", kTestExerciseVideoPath);
+  input_runner_opt.appsink_sync = true;
+  input_runner_opt.receiver_callback =
+      [&](GstreamerBuffer buffer) -> absl::Status {
+    buffer.set_is_key_frame(true);
+    if (segment_start_pts < 0) {
+      segment_start_pts = buffer.get_pts();
+    } else if (buffer.get_pts() - segment_start_pts >=
+               absl::ToInt64Nanoseconds(absl::Seconds(1))) {
+      segment_start_pts = buffer.get_pts();
+      segment_counts.push_back(0);
+    }
+    ++segment_counts.back();
+    return writer->Write(MakePacket(std::move(buffer)).value());
+  };
+  auto input_runner = GstreamerRunner::Create(input_runner_opt).value();
+  absl::SleepFor(absl::Seconds(2));
+  input_runner->SignalEOS();
+  absl::SleepFor(absl::Milliseconds(100));
+  ASSERT_TRUE(writer->Close().ok());
+
+  ASSERT_GE(segment_counts.size(), 2u);
+  for (int i = 0; i < static_cast<int>(segment_counts.size()); ++i) {
+    std::string output_file = file::JoinPath(
+        kOutputDir, absl::StrFormat("%s-%05d.mp4", kTestEventId, i));
+    ASSERT_TRUE(FileExists(output_file).ok()) << output_file;
+    VerifyOutputVideo(output_file, segment_counts[i]);
+    ASSERT_TRUE(DeleteFile(output_file).ok());
+  }
+}
+
 TEST_F(LocalEventWriterTest, WriteVideoFileFailedWithNoKeyFrame) {
   std::unique_ptr<LocalVideoEventWriter> writer =
       std::make_unique<LocalVideoEventWriter>();
@@ -6,21 +6,40 @@
 
 #include "visionai/streams/plugins/event_writers/streams_event_writer.h"
 
+#include <dirent.h>
+#include <string.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
 #include <memory>
+#include <string>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/synchronization/notification.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "visionai/algorithms/media/util/gstreamer_runner.h"
 #include "visionai/proto/cluster_selection.pb.h"
+#include "visionai/streams/client/async_packet_sender.h"
 #include "visionai/streams/client/control.h"
 #include "visionai/streams/client/descriptors.h"
 #include "visionai/streams/client/packet_sender.h"
+#include "visionai/streams/client/spooling_packet_sender.h"
 #include "visionai/streams/framework/event_writer.h"
 #include "visionai/streams/framework/event_writer_def_registry.h"
+#include "visionai/util/file_helpers.h"
+#include "visionai/util/file_path.h"
+#include "visionai/util/gstreamer/pipeline_string.h"
 #include "visionai/util/random_string.h"
 #include "visionai/util/status/status_macros.h"
 
@@ -28,6 +47,87 @@ namespace visionai {
 
 namespace {
 constexpr int kRandomSenderNameLength = 8;
+
+// Returns the frames per second of a framerate fraction such as "30000/1001".
+absl::StatusOr<double> FramesPerSecond(const std::string& framerate) {
+  std::vector<std::string> parts = absl::StrSplit(framerate, '/');
+  int numerator = 0, denominator = 0;
+  if (parts.size() != 2 || !absl::SimpleAtoi(parts[0], &numerator) ||
+      !absl::SimpleAtoi(parts[1], &denominator) || denominator <= 0) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Given an invalid framerate \"%s\".", framerate));
+  }
+  return static_cast<double>(numerator) / denominator;
+}
+
+// The spool directories held by the StreamsEventWriters of the process, so
+// that each spool is replayed by a single writer.
+ABSL_CONST_INIT absl::Mutex spool_dirs_mu(absl::kConstInit);
+
+absl::flat_hash_set<std::string>& SpoolDirsInUse()
+    ABSL_EXCLUSIVE_LOCKS_REQUIRED(spool_dirs_mu) {
+  static auto* spool_dirs = new absl::flat_hash_set<std::string>();
+  return *spool_dirs;
+}
+
+// Holds the spool `directory`. Returns false if another writer holds it.
+bool HoldSpoolDir(const std::string& directory) {
+  absl::MutexLock lock(&spool_dirs_mu);
+  return SpoolDirsInUse().insert(directory).second;
+}
+
+// Releases the spool `directory`, after deleting it if it was `drained`.
+void ReleaseSpoolDir(const std::string& directory, bool drained) {
+  if (drained) {
+    absl::Status status = DeleteFilesInDir(directory);
+    if (status.ok()) {
+      status = DeleteFile(directory);
+    }
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to delete the spool directory " << directory
+                   << ": " << status;
+    }
+  }
+  absl::MutexLock lock(&spool_dirs_mu);
+  SpoolDirsInUse().erase(directory);
+}
+
+// Returns the names of the sub-directories of `directory`.
+absl::StatusOr<std::vector<std::string>> ListSubdirectories(
+    const std::string& directory) {
+  DIR* d = opendir(directory.c_str());
+  if (d == nullptr) {
+    return absl::NotFoundError(absl::StrFormat(
+        "Can't open dir: %s. errno: %s", directory, strerror(errno)));
+  }
+  std::vector<std::string> names;
+  struct dirent* entry;
+  while ((entry = readdir(d)) != nullptr) {
+    std::string name(entry->d_name);
+    if (name == "." || name == "..") {
+      continue;
+    }
+    if (IsDirectory(file::JoinPath(directory, name)).ok()) {
+      names.push_back(std::move(name));
+    }
+  }
+  closedir(d);
+  std::sort(names.begin(), names.end());
+  return names;
+}
+}  // namespace
+
+StreamsEventWriter::~StreamsEventWriter() {
+  // Leave the spools that were not drained for the next writer of the stream.
+  gstreamer_runner_.reset();
+  sender_.reset();
+  if (!spool_directory_.empty()) {
+    ReleaseSpoolDir(spool_directory_, /*drained=*/false);
+  }
+  for (auto& spool : orphaned_spools_) {
+    spool.sender.reset();
+    ReleaseSpoolDir(spool.directory, /*drained=*/false);
+  }
 }
 
 absl::Status StreamsEventWriter::Init(EventWriterInitContext* ctx) {
@@ -50,17 +150,55 @@ absl::Status StreamsEventWriter::Init(EventWriterInitContext* ctx) {
   }
   VAI_RETURN_IF_ERROR(ctx->GetAttr<bool>("encoded", &encoded_))
       << "while getting the encoded option";
+  VAI_RETURN_IF_ERROR(ctx->GetAttr<std::string>("spool_dir", &spool_dir_))
+      << "while getting the spool directory";
+  VAI_RETURN_IF_ERROR(ctx->GetAttr<int>("spool_max_mb", &spool_max_mb_))
+      << "while getting the spool size";
+  VAI_RETURN_IF_ERROR(ctx->GetAttr<int>("spool_catch_up_bytes_per_sec",
+                                        &spool_catch_up_bytes_per_sec_))
+      << "while getting the spool catch-up rate";
+  VAI_RETURN_IF_ERROR(ctx->GetAttr<int>("spool_drain_timeout_sec",
+                                        &spool_drain_timeout_sec_))
+      << "while getting the spool drain timeout";
+  VAI_RETURN_IF_ERROR(ctx->GetAttr<int>("send_queue_mb", &send_queue_mb_))
+      << "while getting the send queue size";
+  VAI_RETURN_IF_ERROR(ctx->GetAttr<std::string>("encoder_speed_preset",
+                                                &encoder_speed_preset_))
+      << "while getting the encoder speed preset";
+  VAI_RETURN_IF_ERROR(
+      ctx->GetAttr<std::string>("encoder_tune", &encoder_tune_))
+      << "while getting the encoder tuning";
+  VAI_RETURN_IF_ERROR(ctx->GetAttr<int>("encoder_threads", &encoder_threads_))
+      << "while getting the encoder thread count";
+  VAI_RETURN_IF_ERROR(
+      ctx->GetAttr<int>("encoder_bitrate_kbps", &encoder_bitrate_kbps_))
+      << "while getting the encoder bitrate";
+  VAI_RETURN_IF_ERROR(ctx->GetAttr<float>("keyframe_interval_sec",
+                                          &keyframe_interval_sec_))
+      << "while getting the keyframe interval";
+  if (spool_drain_timeout_sec_ < 0) {
+    return absl::InvalidArgumentError(
+        "The spool drain timeout cannot be negative.");
+  }
+  if (encoder_threads_ < 0 || encoder_bitrate_kbps_ < 0 ||
+      keyframe_interval_sec_ < 0) {
+    return absl::InvalidArgumentError(
+        "The encoder threads, bitrate and keyframe interval cannot be "
+        "negative.");
+  }
   return absl::OkStatus();
 }
 
 absl::Status StreamsEventWriter::Open(absl::string_view event_id) {
   event_id_ = std::string(event_id);
-  VAI_RETURN_IF_ERROR(CheckStreamExists(cluster_selection_, stream_id_))
-      << "while checking if a stream exists in the cluster";
-  VAI_RETURN_IF_ERROR(CreateEventIfNotExist(cluster_selection_, event_id_))
-      << "while creating an event in the cluster";
-  VAI_RETURN_IF_ERROR(Bind(cluster_selection_, event_id_, stream_id_))
-      << "while binding a stream to an event";
+  if (!stream_exists_) {
+    VAI_RETURN_IF_ERROR(CheckStreamExists(cluster_selection_, stream_id_))
+        << "while checking if a stream exists in the cluster";
+    stream_exists_ = true;
+  }
+  VAI_RETURN_IF_ERROR(
+      CreateEventAndBind(cluster_selection_, event_id_, stream_id_))
+      << "while creating an event and binding a stream to it";
 
   // Currently, we just initialize the packet sender one time, upfront.
   // Might consider moving this to `Write` so that a retry is possible.
@@ -72,8 +210,44 @@ absl::Status StreamsEventWriter::Open(absl::string_view event_id) {
   options.sender = sender_name_;
   options.grace_period = grace_period_;
 
-  VAI_ASSIGN_OR_RETURN(sender_, PacketSender::Create(options),
-                   _ << "while creating a packet sender");
+  std::unique_ptr<PacketSender> sender;
+  SpoolingPacketSender* spooling_sender = nullptr;
+  if (spool_dir_.empty()) {
+    VAI_ASSIGN_OR_RETURN(
+        sender,
+        sender_factory_ ? sender_factory_(options)
+                        : PacketSender::Create(options),
+        _ << "while creating a packet sender");
+  } else {
+    std::string directory = file::JoinPath(spool_dir_, stream_id_, event_id_);
+    if (!HoldSpoolDir(directory)) {
+      return absl::FailedPreconditionError(absl::StrFormat(
+          "The spool directory %s is in use by another writer.", directory));
+    }
+    spool_directory_ = directory;
+    VAI_ASSIGN_OR_RETURN(
+        auto new_sender,
+        SpoolingPacketSender::Create(MakeSpoolingOptions(options, directory)),
+        _ << "while creating a spooling packet sender");
+    spooling_sender = new_sender.get();
+    sender = std::move(new_sender);
+  }
+  if (send_queue_mb_ > 0) {
+    AsyncPacketSender::Options async_options;
+    async_options.max_queued_bytes = static_cast<int64_t>(send_queue_mb_)
+                                     << 20;
+    VAI_ASSIGN_OR_RETURN(
+        auto async_sender,
+        AsyncPacketSender::Create(std::move(sender), async_options),
+        _ << "while creating an asynchronous packet sender");
+    async_sender_ = async_sender.get();
+    sender = std::move(async_sender);
+  }
+  sender_ = std::move(sender);
+  spooling_sender_ = spooling_sender;
+  if (spooling_sender_ != nullptr) {
+    ResumeOrphanedSpools(options);
+  }
   LOG(INFO) << absl::StrFormat(
       "Sending data into event \"%s\" through stream \"%s\".", event_id_,
       stream_id_);
@@ -92,8 +266,10 @@ absl::Status StreamsEventWriter::Write(Packet p) {
       GstreamerRunner::Options gstreamer_runner_options;
       gstreamer_runner_options.appsrc_caps_string =
           gstreamer_buffer->caps_string();
-      gstreamer_runner_options.processing_pipeline_string =
-          AssembleGstreamerPipeline();
+      VAI_ASSIGN_OR_RETURN(
+          gstreamer_runner_options.processing_pipeline_string,
+          AssembleGstreamerPipeline(gstreamer_buffer->caps_string()),
+          _ << "while assembling the encoding pipeline");
       LOG(ERROR) << "Launching the gstreamer pipeline: "
                  << gstreamer_runner_options.processing_pipeline_string;
       LOG(ERROR) << "Accepting the caps string: "
@@ -116,17 +292,134 @@ absl::Status StreamsEventWriter::Write(Packet p) {
 }
 
 absl::Status StreamsEventWriter::Close() {
+  // Wait for the packets that are still queued to be sent.
+  absl::Status status;
+  if (async_sender_ != nullptr) {
+    status = async_sender_->Flush();
+    async_sender_ = nullptr;
+  }
+
+  // Then for the spooled ones, including those of the earlier events.
+  absl::Time deadline = absl::Now() + absl::Seconds(spool_drain_timeout_sec_);
+  bool drained = false;
+  if (spooling_sender_ != nullptr) {
+    absl::Status drain_status = spooling_sender_->Drain(deadline - absl::Now());
+    if (drain_status.ok()) {
+      drained = true;
+    } else {
+      LOG(ERROR) << absl::StrFormat(
+          "Closing event \"%s\" before its spool was replayed; the next event "
+          "of stream \"%s\" replays it: %s",
+          event_id_, stream_id_, drain_status.ToString());
+      status.Update(drain_status);
+    }
+    spooling_sender_ = nullptr;
+  }
   sender_.reset();
-  return absl::OkStatus();
+  if (!spool_directory_.empty()) {
+    ReleaseSpoolDir(spool_directory_, drained);
+    spool_directory_.clear();
+  }
+  for (auto& spool : orphaned_spools_) {
+    absl::Status drain_status = spool.sender->Drain(
+        std::max(deadline - absl::Now(), absl::ZeroDuration()));
+    if (!drain_status.ok()) {
+      LOG(WARNING) << "Leaving a spool for the next event of stream \""
+                   << stream_id_ << "\": " << drain_status;
+    }
+    spool.sender.reset();
+    ReleaseSpoolDir(spool.directory, drain_status.ok());
+  }
+  orphaned_spools_.clear();
+  return status;
+}
+
+SpoolingPacketSender::Options StreamsEventWriter::MakeSpoolingOptions(
+    const PacketSender::Options& options, const std::string& directory) {
+  SpoolingPacketSender::Options spooling_options;
+  spooling_options.sender_options = options;
+  spooling_options.spool_options.directory = directory;
+  spooling_options.spool_options.max_bytes =
+      static_cast<int64_t>(spool_max_mb_) << 20;
+  spooling_options.catch_up_bytes_per_second = spool_catch_up_bytes_per_sec_;
+  if (sender_factory_) {
+    spooling_options.sender_factory = [sender_factory = sender_factory_,
+                                       options]() {
+      return sender_factory(options);
+    };
+  }
+  return spooling_options;
+}
+
+void StreamsEventWriter::ResumeOrphanedSpools(
+    const PacketSender::Options& options) {
+  std::string stream_spool_dir = file::JoinPath(spool_dir_, stream_id_);
+  auto event_ids = ListSubdirectories(stream_spool_dir);
+  if (!event_ids.ok()) {
+    LOG(WARNING) << "Failed to look for the spools left in "
+                 << stream_spool_dir << ": " << event_ids.status();
+    return;
+  }
+  for (const std::string& event_id : *event_ids) {
+    std::string directory = file::JoinPath(stream_spool_dir, event_id);
+    if (!HoldSpoolDir(directory)) {
+      continue;
+    }
+    PacketSender::Options orphan_options = options;
+    orphan_options.channel.event_id = event_id;
+    auto sender = SpoolingPacketSender::Create(
+        MakeSpoolingOptions(orphan_options, directory));
+    if (!sender.ok()) {
+      LOG(WARNING) << "Failed to resume the spool in " << directory << ": "
+                   << sender.status();
+      ReleaseSpoolDir(directory, /*drained=*/false);
+      continue;
+    }
+    int64_t num_packets = (*sender)->num_spooled_packets();
+    if (num_packets == 0) {
+      sender->reset();
+      ReleaseSpoolDir(directory, /*drained=*/true);
+      continue;
+    }
+    LOG(INFO) << absl::StrFormat(
+        "Replaying the %d packets that event \"%s\" left in the spool.",
+        num_packets, event_id);
+    orphaned_spools_.push_back({directory, *std::move(sender)});
+  }
 }
 
-std::string StreamsEventWriter::AssembleGstreamerPipeline() {
+absl::StatusOr<std::string> StreamsEventWriter::AssembleGstreamerPipeline(
+    const std::string& caps_string) {
+  // Keep the framerate of the input, only evening out its frame intervals.
+  VAI_ASSIGN_OR_RETURN(std::string framerate,
+                   GetFramerateFractionFromCaps(caps_string));
   std::vector<std::string> pipeline_elements;
   pipeline_elements.push_back("videoconvert");
   pipeline_elements.push_back("videorate");
-  // TODO: make output frame rate configurable.
-  pipeline_elements.push_back("video/x-raw,framerate=25/1");
-  pipeline_elements.push_back("x264enc");
+  pipeline_elements.push_back(
+      absl::StrFormat("video/x-raw,framerate=%s", framerate));
+
+  std::vector<std::string> encoder = {"x264enc"};
+  if (!encoder_speed_preset_.empty()) {
+    encoder.push_back(
+        absl::StrFormat("speed-preset=%s", encoder_speed_preset_));
+  }
+  if (!encoder_tune_.empty()) {
+    encoder.push_back(absl::StrFormat("tune=%s", encoder_tune_));
+  }
+  if (encoder_threads_ > 0) {
+    encoder.push_back(absl::StrFormat("threads=%d", encoder_threads_));
+  }
+  if (encoder_bitrate_kbps_ > 0) {
+    encoder.push_back(absl::StrFormat("bitrate=%d", encoder_bitrate_kbps_));
+  }
+  if (keyframe_interval_sec_ > 0) {
+    VAI_ASSIGN_OR_RETURN(double fps, FramesPerSecond(framerate));
+    int key_int_max = std::max(
+        1, static_cast<int>(std::lround(fps * keyframe_interval_sec_)));
+    encoder.push_back(absl::StrFormat("key-int-max=%d", key_int_max));
+  }
+  pipeline_elements.push_back(absl::StrJoin(encoder, " "));
   return absl::StrJoin(pipeline_elements, " ! ");
 }
 
@@ -134,6 +427,16 @@ REGISTER_EVENT_WRITER_INTERFACE("StreamsEventWriter")
     .Attr("sender_name", "string")
     .Attr("stream_id", "string")
     .Attr("encoded", "bool")
+    .Attr("spool_dir", "string")
+    .Attr("spool_max_mb", "int")
+    .Attr("spool_catch_up_bytes_per_sec", "int")
+    .Attr("spool_drain_timeout_sec", "int")
+    .Attr("send_queue_mb", "int")
+    .Attr("encoder_speed_preset", "string")
+    .Attr("encoder_tune", "string")
+    .Attr("encoder_threads", "int")
+    .Attr("encoder_bitrate_kbps", "int")
+    .Attr("keyframe_interval_sec", "float")
     .Doc(R"doc(
 StreamsEventWriter sends data into a Vision AI Stream.
 
@@ -141,6 +444,43 @@ sender_name: A name to identifying the sender.
 
 stream_id: The stream to which data shall be sent. It must have been created
            beforehand.
+
+spool_dir: A local directory under which to spool the packets while the
+           stream is unreachable. They are replayed in order once it recovers.
+           Empty disables the spool.
+
+spool_max_mb: The most disk space that the spool of an event may take. The
+              packets are dropped once it is full. Default is 1024.
+
+spool_catch_up_bytes_per_sec: The highest rate at which to replay the spool.
+                              Zero means no limit, which is the default.
+
+spool_drain_timeout_sec: The longest that closing an event waits for its spool
+                         to be replayed. What is left is replayed by the next
+                         event of the stream. Default is 30.
+
+send_queue_mb: The most packet data that may wait to be sent, so that network
+               jitter does not hold up the writes. The writes block once it is
+               full. Zero sends the packets synchronously. Default is 64.
+
+The following only apply when `encoded` is true. The video is re-encoded with
+x264 at the framerate of the input.
+
+encoder_speed_preset: The x264 speed preset, from "ultrafast" to "placebo".
+                      Default is "ultrafast", which takes the least CPU.
+
+encoder_tune: The x264 tuning. Default is "zerolatency", which avoids
+              buffering frames in the encoder. Empty uses no tuning.
+
+encoder_threads: The number of encoding threads. Zero, the default, lets x264
+                 choose from the number of CPUs.
+
+encoder_bitrate_kbps: The target bitrate. Zero, the default, uses the x264enc
+                      default.
+
+keyframe_interval_sec: The longest interval between two keyframes, which
+                       bounds how long a new receiver waits to start decoding.
+                       Default is 1. Zero uses the x264enc default.
 )doc");
 
 REGISTER_EVENT_WRITER_IMPLEMENTATION("StreamsEventWriter", StreamsEventWriter);
@@ -29,26 +29,48 @@
 #ifndef THIRD_PARTY_VISIONAI_STREAMS_PLUGINS_EVENT_WRITERS_STREAMS_EVENT_WRITER_H_
 #define THIRD_PARTY_VISIONAI_STREAMS_PLUGINS_EVENT_WRITERS_STREAMS_EVENT_WRITER_H_
 
+#include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/time/time.h"
 #include "visionai/algorithms/media/util/gstreamer_runner.h"
+#include "visionai/streams/client/async_packet_sender.h"
 #include "visionai/streams/client/packet_sender.h"
+#include "visionai/streams/client/spooling_packet_sender.h"
 #include "visionai/streams/framework/event_writer.h"
 
 namespace visionai {
 
 // The StreamsEventWriter writes packets into a specific event in the
 // Vision AI Stream.
+//
+// With a spool directory, the packets of an event are spooled on disk under
+// `<spool_dir>/<stream_id>/<event_id>` while the stream is unreachable. `Close`
+// waits for up to `spool_drain_timeout_sec` for them to be replayed. The spools
+// that are left over, from an earlier event or an earlier process, are
+// replayed by the next event of the stream while it is open, and deleted once
+// they are empty.
 class StreamsEventWriter : public EventWriter {
  public:
+  // Creates the connections to the stream.
+  using PacketSenderFactory =
+      std::function<absl::StatusOr<std::unique_ptr<PacketSender>>(
+          const PacketSender::Options& options)>;
+
   StreamsEventWriter() {}
 
   // Used by tests only to inject the mock.
   StreamsEventWriter(std::shared_ptr<PacketSender> sender) : sender_(sender) {}
 
-  ~StreamsEventWriter() override {}
+  // Used by tests only to inject the connections to the stream.
+  explicit StreamsEventWriter(PacketSenderFactory sender_factory)
+      : sender_factory_(std::move(sender_factory)) {}
+
+  ~StreamsEventWriter() override;
 
   // Initialize the EventWriter with EventWriterInitConext.
   absl::Status Init(EventWriterInitContext* ctx) override;
@@ -60,21 +82,64 @@ class StreamsEventWriter : public EventWriter {
   absl::Status Write(Packet p) override;
 
   // Close the current event.
+  //
+  // Returns DEADLINE_EXCEEDED if the spool of the event could not be replayed
+  // in time. It is then left for the next event of the stream to replay.
   absl::Status Close() override;
 
  private:
+  // A spool left over by an earlier event of the stream.
+  struct OrphanedSpool {
+    std::string directory;
+    std::unique_ptr<SpoolingPacketSender> sender;
+  };
+
   std::string event_id_;
   std::string stream_id_;
   std::string sender_name_;
   ClusterSelection cluster_selection_;
+  // Whether the stream is known to exist, so that it is only checked by the
+  // first `Open`.
+  bool stream_exists_ = false;
   absl::Duration grace_period_;
   std::shared_ptr<PacketSender> sender_;
+  // The sender that queues the packets of `sender_`, if any. It is owned by
+  // `sender_`.
+  AsyncPacketSender* async_sender_ = nullptr;
+  // The sender that spools the packets of `sender_`, if any, and its
+  // directory. It is owned by `sender_`.
+  SpoolingPacketSender* spooling_sender_ = nullptr;
+  std::string spool_directory_;
+  std::vector<OrphanedSpool> orphaned_spools_;
+  PacketSenderFactory sender_factory_;
   // Whether to encode the received packets (RawImages) before sending to the
   // output stream.
   bool encoded_ = false;
+  // The directory under which to spool the packets during network outages.
+  // Empty disables the spool.
+  std::string spool_dir_;
+  int spool_max_mb_ = 1024;
+  int spool_catch_up_bytes_per_sec_ = 0;
+  int spool_drain_timeout_sec_ = 30;
+  int send_queue_mb_ = 64;
+  // The settings of the encoder when `encoded_` is true.
+  std::string encoder_speed_preset_ = "ultrafast";
+  std::string encoder_tune_ = "zerolatency";
+  int encoder_threads_ = 0;
+  int encoder_bitrate_kbps_ = 0;
+  float keyframe_interval_sec_ = 1;
   std::unique_ptr<GstreamerRunner> gstreamer_runner_ = nullptr;
 
-  std::string AssembleGstreamerPipeline();
+  absl::StatusOr<std::string> AssembleGstreamerPipeline(
+      const std::string& caps_string);
+
+  // Returns the options of a spooling sender to the channel of `options`.
+  SpoolingPacketSender::Options MakeSpoolingOptions(
+      const PacketSender::Options& options, const std::string& directory);
+
+  // Starts to replay the spools that the earlier events of the stream left
+  // behind, unless another writer of the process holds them.
+  void ResumeOrphanedSpools(const PacketSender::Options& options);
 };
 
 }  // namespace visionai
@@ -28,7 +28,9 @@
 
 #include "visionai/streams/plugins/event_writers/streams_event_writer.h"
 
+#include <map>
 #include <memory>
+#include <string>
 
 #include "google/cloud/visionai/v1/streams_resources.pb.h"
 #include "google/cloud/visionai/v1/streams_service.pb.h"
@@ -41,6 +43,8 @@
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "third_party/gstreamer/subprojects/gstreamer/gst/gstplugin.h"
 #include "visionai/algorithms/media/util/gstreamer_registry.h"
 #include "visionai/algorithms/media/util/gstreamer_runner.h"
@@ -51,16 +55,14 @@
 #include "visionai/streams/client/resource_util.h"
 #include "visionai/testing/grpc/mock_grpc.h"
 #include "visionai/testing/status/status_matchers.h"
+#include "visionai/util/file_helpers.h"
+#include "visionai/util/file_path.h"
 
 namespace visionai {
 
 using ::google::cloud::visionai::v1::CreateEventRequest;
 using ::google::cloud::visionai::v1::CreateSeriesRequest;
-using ::google::cloud::visionai::v1::Event;
-using ::google::cloud::visionai::v1::GetEventRequest;
-using ::google::cloud::visionai::v1::GetSeriesRequest;
 using ::google::cloud::visionai::v1::GetStreamRequest;
-using ::google::cloud::visionai::v1::Series;
 using ::google::cloud::visionai::v1::Stream;
 using ::google::longrunning::Operation;
 using ::google::protobuf::TextFormat;
@@ -95,6 +97,71 @@ extern "C" {
 GST_PLUGIN_STATIC_DECLARE(videotestsrc);
 }
 
+// A stream that may go down, and that counts the packets it receives by event.
+class FakeStream {
+ public:
+  StreamsEventWriter::PacketSenderFactory Factory() {
+    return [this](const PacketSender::Options& options)
+               -> absl::StatusOr<std::unique_ptr<PacketSender>> {
+      absl::MutexLock lock(&mu_);
+      if (!is_up_) {
+        return absl::UnavailableError("The stream is down.");
+      }
+      return std::make_unique<Sender>(this, options);
+    };
+  }
+
+  void SetIsUp(bool is_up) {
+    absl::MutexLock lock(&mu_);
+    is_up_ = is_up;
+  }
+
+  // Waits for up to `timeout` for `n` packets of `event_id`.
+  bool AwaitReceived(const std::string& event_id, int n,
+                     absl::Duration timeout) {
+    absl::MutexLock lock(&mu_);
+    auto has_received = [this, &event_id, n]()
+                            ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+                              return num_received_[event_id] >= n;
+                            };
+    return mu_.AwaitWithTimeout(absl::Condition(&has_received), timeout);
+  }
+
+ private:
+  class Sender : public PacketSender {
+   public:
+    Sender(FakeStream* stream, const PacketSender::Options& options)
+        : PacketSender(options),
+          stream_(stream),
+          event_id_(options.channel.event_id) {}
+
+    absl::Status Send(Packet p) override {
+      return Send(std::move(p), absl::InfiniteDuration());
+    }
+
+    absl::Status Send(Packet p, absl::Duration timeout) override {
+      return stream_->Receive(event_id_);
+    }
+
+   private:
+    FakeStream* const stream_;
+    const std::string event_id_;
+  };
+
+  absl::Status Receive(const std::string& event_id) {
+    absl::MutexLock lock(&mu_);
+    if (!is_up_) {
+      return absl::UnavailableError("The stream is down.");
+    }
+    ++num_received_[event_id];
+    return absl::OkStatus();
+  }
+
+  absl::Mutex mu_;
+  bool is_up_ ABSL_GUARDED_BY(mu_) = true;
+  std::map<std::string, int> num_received_ ABSL_GUARDED_BY(mu_);
+};
+
 class StreamsEventWriterTest : public ::testing::Test {
  protected:
   StreamsEventWriterTest()
@@ -223,8 +290,6 @@ TEST_F(StreamsEventWriterTest,
 
   EXPECT_CALL(*mock_streams_service_, GetStream)
       .WillOnce(Return(grpc::Status::OK));
-  EXPECT_CALL(*mock_streams_service_, GetEvent)
-      .WillOnce(Return(grpc::Status(grpc::StatusCode::NOT_FOUND, "no event")));
   EXPECT_CALL(*mock_streams_service_, CreateEvent)
       .WillOnce(
           Invoke([&](::grpc::ServerContext* context,
@@ -234,8 +299,6 @@ TEST_F(StreamsEventWriterTest,
             operation->set_done(true);
             return ::grpc::Status::OK;
           }));
-  EXPECT_CALL(*mock_streams_service_, GetSeries)
-      .WillOnce(Return(grpc::Status(grpc::StatusCode::NOT_FOUND, "no series")));
   EXPECT_CALL(*mock_streams_service_, CreateSeries)
       .WillOnce(
           Invoke([&](::grpc::ServerContext* context,
@@ -275,22 +338,129 @@ TEST_F(StreamsEventWriterTest, OpenHappyPath) {
 
   EXPECT_CALL(*mock_streams_service_, GetStream)
       .WillOnce(Return(grpc::Status::OK));
-  EXPECT_CALL(*mock_streams_service_, GetEvent)
-      .WillOnce(Invoke([&](::grpc::ServerContext* context,
-                           const GetEventRequest* request, Event* event) {
-        EXPECT_EQ(request->name(), event_name);
-        event->set_name(event_name);
+  EXPECT_CALL(*mock_streams_service_, CreateEvent)
+      .WillOnce(
+          Invoke([&](::grpc::ServerContext* context,
+                     const CreateEventRequest* request, Operation* operation) {
+            EXPECT_EQ(request->event_id(), kTestEventId);
+            return grpc::Status(grpc::StatusCode::ALREADY_EXISTS, event_name);
+          }));
+  EXPECT_CALL(*mock_streams_service_, CreateSeries)
+      .WillOnce(
+          Invoke([&](::grpc::ServerContext* context,
+                     const CreateSeriesRequest* request, Operation* operation) {
+            EXPECT_EQ(request->series_id(), channel_id);
+            return grpc::Status(grpc::StatusCode::ALREADY_EXISTS,
+                                channel_name);
+          }));
+
+  ASSERT_TRUE(writer->Open(kTestEventId).ok());
+  ASSERT_TRUE(writer->Close().ok());
+}
+
+TEST_F(StreamsEventWriterTest, OpenChecksTheStreamOnce) {
+  std::shared_ptr<StreamsEventWriter> writer =
+      std::make_shared<StreamsEventWriter>();
+
+  EventWriterConfig config;
+  EXPECT_TRUE(TextFormat::ParseFromString(
+      absl::Substitute(kTestConfigTemplate, kTestSenderName, kTestStreamId,
+                       /* encoded */ false, local_server_address_,
+                       kTestProjectId, kTestLocationId, kTestClusterId),
+      &config));
+  VAI_ASSERT_OK_AND_ASSIGN(auto context, EventWriterInitContext::Create(config));
+  ASSERT_TRUE(writer->Init(context.get()).ok());
+
+  EXPECT_CALL(*mock_streams_service_, GetStream)
+      .WillOnce(Return(grpc::Status::OK));
+  EXPECT_CALL(*mock_streams_service_, CreateEvent)
+      .Times(2)
+      .WillRepeatedly(Invoke([](::grpc::ServerContext* context,
+                                const CreateEventRequest* request,
+                                Operation* operation) {
+        operation->set_done(true);
         return grpc::Status::OK;
       }));
-  EXPECT_CALL(*mock_streams_service_, GetSeries)
-      .WillOnce(Invoke([&](::grpc::ServerContext* context,
-                           const GetSeriesRequest* request, Series* series) {
-        EXPECT_EQ(request->name(), channel_name);
+  EXPECT_CALL(*mock_streams_service_, CreateSeries)
+      .Times(2)
+      .WillRepeatedly(Invoke([](::grpc::ServerContext* context,
+                                const CreateSeriesRequest* request,
+                                Operation* operation) {
+        operation->set_done(true);
         return grpc::Status::OK;
       }));
 
   ASSERT_TRUE(writer->Open(kTestEventId).ok());
   ASSERT_TRUE(writer->Close().ok());
+  ASSERT_TRUE(writer->Open("another-event-id").ok());
+  ASSERT_TRUE(writer->Close().ok());
+}
+
+TEST_F(StreamsEventWriterTest, ReplaysTheSpoolOfAnEventClosedDuringAnOutage) {
+  const std::string spool_dir =
+      file::JoinPath(::testing::TempDir(), "streams_event_writer_spool");
+  EventWriterConfig config;
+  EXPECT_TRUE(TextFormat::ParseFromString(
+      absl::Substitute(kTestConfigTemplate, kTestSenderName, kTestStreamId,
+                       /* encoded */ false, local_server_address_,
+                       kTestProjectId, kTestLocationId, kTestClusterId),
+      &config));
+  (*config.mutable_attr())["spool_dir"] = spool_dir;
+  (*config.mutable_attr())["spool_drain_timeout_sec"] = "1";
+  (*config.mutable_attr())["send_queue_mb"] = "0";
+
+  EXPECT_CALL(*mock_streams_service_, GetStream)
+      .Times(2)
+      .WillRepeatedly(Return(grpc::Status::OK));
+  EXPECT_CALL(*mock_streams_service_, CreateEvent)
+      .Times(2)
+      .WillRepeatedly(Invoke([](::grpc::ServerContext* context,
+                                const CreateEventRequest* request,
+                                Operation* operation) {
+        operation->set_done(true);
+        return grpc::Status::OK;
+      }));
+  EXPECT_CALL(*mock_streams_service_, CreateSeries)
+      .Times(2)
+      .WillRepeatedly(Invoke([](::grpc::ServerContext* context,
+                                const CreateSeriesRequest* request,
+                                Operation* operation) {
+        operation->set_done(true);
+        return grpc::Status::OK;
+      }));
+
+  // The first event closes while the stream is down, so its packets are left
+  // in the spool.
+  FakeStream stream;
+  stream.SetIsUp(false);
+  {
+    StreamsEventWriter writer(stream.Factory());
+    VAI_ASSERT_OK_AND_ASSIGN(auto context,
+                         EventWriterInitContext::Create(config));
+    ASSERT_TRUE(writer.Init(context.get()).ok());
+    ASSERT_TRUE(writer.Open("event-1").ok());
+    for (int i = 0; i < 3; ++i) {
+      VAI_ASSERT_OK_AND_ASSIGN(Packet p, MakePacket(std::string("data")));
+      ASSERT_TRUE(writer.Write(std::move(p)).ok());
+    }
+    EXPECT_EQ(writer.Close().code(), absl::StatusCode::kDeadlineExceeded);
+  }
+  const std::string event_1_spool =
+      file::JoinPath(spool_dir, kTestStreamId, "event-1");
+  EXPECT_TRUE(Exists(event_1_spool).ok());
+
+  // The next event of the stream replays them once the stream is back, and
+  // deletes the spools once they are empty.
+  stream.SetIsUp(true);
+  StreamsEventWriter writer(stream.Factory());
+  VAI_ASSERT_OK_AND_ASSIGN(auto context, EventWriterInitContext::Create(config));
+  ASSERT_TRUE(writer.Init(context.get()).ok());
+  ASSERT_TRUE(writer.Open("event-2").ok());
+  EXPECT_TRUE(stream.AwaitReceived("event-1", 3, absl::Seconds(30)));
+  EXPECT_TRUE(writer.Close().ok());
+  EXPECT_FALSE(Exists(event_1_spool).ok());
+  EXPECT_FALSE(
+      Exists(file::JoinPath(spool_dir, kTestStreamId, "event-2")).ok());
 }
 
 TEST_F(StreamsEventWriterTest, WriteUnencodedPacket) {
@@ -342,4 +512,46 @@ TEST_F(StreamsEventWriterTest, WriteEncodedPacket) {
   WritePackets(writer);
 }
 
+TEST_F(StreamsEventWriterTest, WriteEncodedPacketWithEncoderSettings) {
+  std::shared_ptr<StreamsEventWriter> writer =
+      std::make_shared<StreamsEventWriter>(mock_packet_sender_);
+  EXPECT_CALL(*mock_packet_sender_, Send(_))
+      .Times(AtLeast(1))
+      .WillRepeatedly(Invoke([&](Packet p) {
+        PacketAs<GstreamerBuffer> packet_as_gbuf(p);
+        EXPECT_TRUE(packet_as_gbuf.status().ok());
+        EXPECT_EQ(packet_as_gbuf->media_type(), kXH264MediaType);
+        return absl::OkStatus();
+      }));
+  EventWriterConfig config;
+  EXPECT_TRUE(TextFormat::ParseFromString(
+      absl::Substitute(kTestConfigTemplate, kTestSenderName, kTestStreamId,
+                       /* encoded */ true, local_server_address_,
+                       kTestProjectId, kTestLocationId, kTestClusterId),
+      &config));
+  (*config.mutable_attr())["encoder_speed_preset"] = "superfast";
+  (*config.mutable_attr())["encoder_tune"] = "zerolatency";
+  (*config.mutable_attr())["encoder_threads"] = "2";
+  (*config.mutable_attr())["encoder_bitrate_kbps"] = "500";
+  (*config.mutable_attr())["keyframe_interval_sec"] = "0.5";
+  VAI_ASSERT_OK_AND_ASSIGN(auto context, EventWriterInitContext::Create(config));
+  ASSERT_TRUE(writer->Init(context.get()).ok());
+  WritePackets(writer);
+}
+
+TEST_F(StreamsEventWriterTest, NegativeEncoderSettings) {
+  std::shared_ptr<StreamsEventWriter> writer =
+      std::make_shared<StreamsEventWriter>();
+  EventWriterConfig config;
+  EXPECT_TRUE(TextFormat::ParseFromString(
+      absl::Substitute(kTestConfigTemplate, kTestSenderName, kTestStreamId,
+                       /* encoded */ true, local_server_address_,
+                       kTestProjectId, kTestLocationId, kTestClusterId),
+      &config));
+  (*config.mutable_attr())["keyframe_interval_sec"] = "-1";
+  VAI_ASSERT_OK_AND_ASSIGN(auto context, EventWriterInitContext::Create(config));
+  EXPECT_EQ(writer->Init(context.get()).code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
 }  // namespace visionai
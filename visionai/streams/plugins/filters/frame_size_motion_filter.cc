@@ -0,0 +1,277 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/streams/plugins/filters/frame_size_motion_filter.h"
+
+#include <memory>
+#include <string>
+
+#include "glog/logging.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "visionai/algorithms/detection/motion_detection/frame_size_motion_detector.h"
+#include "visionai/algorithms/detection/motion_detection/frame_size_motion_detector_config.pb.h"
+#include "visionai/streams/framework/filter.h"
+#include "visionai/streams/packet/packet.h"
+#include "visionai/streams/util/h264_frame_buffer.h"
+#include "visionai/types/gstreamer_buffer.h"
+#include "visionai/util/status/status_macros.h"
+
+namespace visionai {
+namespace {
+// Default configuration for the motion filter.
+constexpr float kSizeRatioThreshold = 2.0;
+constexpr float kBaselineUpdateRate = 0.05;
+constexpr int kWarmupFrames = 15;
+constexpr float kEarlyKeyFrameRatio = 0.5;
+constexpr int kCoolDownPeriodDurationInSeconds = 300;
+constexpr int kLookbackWindowInSeconds = 3;
+constexpr int kMinEventDurationInSeconds = 10;
+constexpr int kPollTimeOutInMs = 10000;
+
+// The minimum number of consecutive motion frames to be considered as the start
+// of a new motion event.
+constexpr int kMinMotionFramesForEvent = 3;
+}  // namespace
+
+absl::Status FrameSizeMotionFilter::Init(FilterInitContext* ctx) {
+  // Get attributes to initialize the motion detector config.
+  float size_ratio_threshold = kSizeRatioThreshold;
+  float baseline_update_rate = kBaselineUpdateRate;
+  int warmup_frames = kWarmupFrames;
+  float early_key_frame_ratio = kEarlyKeyFrameRatio;
+
+  VAI_RETURN_IF_ERROR(
+      ctx->GetAttr("size_ratio_threshold", &size_ratio_threshold));
+  if (size_ratio_threshold <= 1) {
+    LOG(WARNING) << absl::StrCat(
+        "The size_ratio_threshold must be larger than 1. Got ",
+        size_ratio_threshold, ". Reset to default: ", kSizeRatioThreshold);
+    size_ratio_threshold = kSizeRatioThreshold;
+  }
+  VAI_RETURN_IF_ERROR(
+      ctx->GetAttr("baseline_update_rate", &baseline_update_rate));
+  if (baseline_update_rate <= 0 || baseline_update_rate > 1) {
+    LOG(WARNING) << absl::StrCat(
+        "The baseline_update_rate must be (0, 1]. Got ", baseline_update_rate,
+        ". Reset to default: ", kBaselineUpdateRate);
+    baseline_update_rate = kBaselineUpdateRate;
+  }
+  VAI_RETURN_IF_ERROR(ctx->GetAttr("warmup_frames", &warmup_frames));
+  if (warmup_frames <= 0) {
+    LOG(WARNING) << absl::StrCat("The warmup_frames must be positive. Got ",
+                                 warmup_frames,
+                                 ". Reset to default: ", kWarmupFrames);
+    warmup_frames = kWarmupFrames;
+  }
+  VAI_RETURN_IF_ERROR(
+      ctx->GetAttr("early_key_frame_ratio", &early_key_frame_ratio));
+  if (early_key_frame_ratio < 0 || early_key_frame_ratio > 1) {
+    LOG(WARNING) << absl::StrCat(
+        "The early_key_frame_ratio must be [0, 1]. Got ", early_key_frame_ratio,
+        ". Reset to default: ", kEarlyKeyFrameRatio);
+    early_key_frame_ratio = kEarlyKeyFrameRatio;
+  }
+
+  detector_config_.Clear();
+  detector_config_.set_size_ratio_threshold(size_ratio_threshold);
+  detector_config_.set_baseline_update_rate(baseline_update_rate);
+  detector_config_.set_warmup_frames(warmup_frames);
+  detector_config_.set_early_key_frame_ratio(early_key_frame_ratio);
+  detector_ = std::make_unique<motion_detection::FrameSizeMotionDetector>(
+      detector_config_);
+
+  // Get attributes to initialize the motion filter.
+  int poll_time_out_in_ms = kPollTimeOutInMs;
+  int min_event_duration_in_seconds = kMinEventDurationInSeconds;
+  int cool_down_period_duration_in_seconds = kCoolDownPeriodDurationInSeconds;
+  int lookback_window_in_seconds = kLookbackWindowInSeconds;
+  min_frames_trigger_motion_ = kMinMotionFramesForEvent;
+
+  VAI_RETURN_IF_ERROR(
+      ctx->GetAttr("min_frames_trigger_motion", &min_frames_trigger_motion_));
+  if (min_frames_trigger_motion_ <= 0) {
+    LOG(WARNING) << absl::StrCat(
+        "The min_frames_trigger_motion must be positive. Got ",
+        min_frames_trigger_motion_,
+        ". Reset to default: ", kMinMotionFramesForEvent);
+    min_frames_trigger_motion_ = kMinMotionFramesForEvent;
+  }
+
+  VAI_RETURN_IF_ERROR(ctx->GetAttr("time_out_in_ms", &poll_time_out_in_ms));
+  if (poll_time_out_in_ms <= 0) {
+    LOG(WARNING) << absl::StrCat(
+        "The poll_time_out_in_ms must be positive. Got ", poll_time_out_in_ms,
+        ". Reset to default: ", kPollTimeOutInMs);
+    poll_time_out_in_ms = kPollTimeOutInMs;
+  }
+  poll_timeout_ = absl::Milliseconds(poll_time_out_in_ms);
+
+  VAI_RETURN_IF_ERROR(ctx->GetAttr("min_event_length_in_seconds",
+                                   &min_event_duration_in_seconds));
+  if (min_event_duration_in_seconds <= 0) {
+    LOG(WARNING) << absl::StrCat(
+        "The min_event_length_in_seconds must be positive. Got ",
+        min_event_duration_in_seconds,
+        ". Reset to default: ", kMinEventDurationInSeconds);
+    min_event_duration_in_seconds = kMinEventDurationInSeconds;
+  }
+  min_event_duration_ = absl::Seconds(min_event_duration_in_seconds);
+
+  VAI_RETURN_IF_ERROR(ctx->GetAttr("cool_down_period_in_seconds",
+                                   &cool_down_period_duration_in_seconds));
+  if (cool_down_period_duration_in_seconds < 0) {
+    LOG(WARNING) << absl::StrCat(
+        "The cool_down_period_in_seconds must not be negative. Got ",
+        cool_down_period_duration_in_seconds,
+        ". Reset to default: ", kCoolDownPeriodDurationInSeconds);
+    cool_down_period_duration_in_seconds = kCoolDownPeriodDurationInSeconds;
+  }
+  cool_down_period_duration_ =
+      absl::Seconds(cool_down_period_duration_in_seconds);
+
+  VAI_RETURN_IF_ERROR(
+      ctx->GetAttr("lookback_window_in_seconds", &lookback_window_in_seconds));
+  if (lookback_window_in_seconds < 0) {
+    LOG(WARNING) << absl::StrCat(
+        "The lookback_window_in_seconds can't be negative. Got ",
+        lookback_window_in_seconds,
+        ". Reset to default: ", kLookbackWindowInSeconds);
+    lookback_window_in_seconds = kLookbackWindowInSeconds;
+  }
+  lookback_window_duration_ = absl::Seconds(lookback_window_in_seconds);
+
+  consecutive_motion_detections_ = 0;
+  cooldown_until_ = absl::UnixEpoch();
+  current_gop_active_ = false;
+  event_id_.clear();
+  frame_buffer_.Clear();
+  gbuf_ts_offset_ = absl::ZeroDuration();
+
+  return absl::OkStatus();
+}
+
+absl::Status FrameSizeMotionFilter::RunInternal(TimedFrame timed_frame,
+                                                int64_t frame_size,
+                                                FilterRunContext* ctx) {
+  absl::Time timestamp = timed_frame.timestamp;
+  bool motion_prediction =
+      detector_->DetectMotion(frame_size, timed_frame.is_key_frame);
+  UpdateMotionDetection(motion_prediction, timestamp);
+
+  if (timed_frame.is_key_frame && current_gop_active_ &&
+      latest_motion_detection_time_ + min_event_duration_ < timestamp) {
+    // The motion event ends because it's been long enough since the last
+    // motion detected.
+    current_gop_active_ = false;
+    cooldown_until_ = timestamp + cool_down_period_duration_;
+
+    // Push this key frame since in some cases it is essential for decoding
+    // previous frames.
+    VAI_RETURN_IF_ERROR(ctx->Push(event_id_, timed_frame.frame));
+    VAI_RETURN_IF_ERROR(ctx->EndEvent(event_id_));
+  }
+
+  // Pushes the current frame and discards GOPs out of lookback window.
+  frame_buffer_.Push(std::move(timed_frame));
+  frame_buffer_.UpdateLookBackWindow(timestamp - lookback_window_duration_);
+  VLOG(2) << "motion buffer size : " << frame_buffer_.Size();
+
+  // Filter all the frames during the cool down period.
+  if (cooldown_until_ > timestamp) {
+    return absl::OkStatus();
+  }
+
+  if (current_gop_active_) {
+    // In this state, the current motion event is active so we simply push the
+    // latest input packet to the event writer. There should be no pile up in
+    // `frame_buffer_`.
+    while (!frame_buffer_.Empty()) {
+      VAI_RETURN_IF_ERROR(
+          ctx->Push(event_id_, std::move(frame_buffer_.Front().frame)));
+      frame_buffer_.Pop();
+    }
+  } else if (consecutive_motion_detections_ == min_frames_trigger_motion_) {
+    // A new event starts.
+    VAI_ASSIGN_OR_RETURN(event_id_, ctx->StartEvent());
+    current_gop_active_ = true;
+    VLOG(2) << "frame size motion filter event started";
+
+    // Push all the frames in the buffer to event writer.
+    while (!frame_buffer_.Empty()) {
+      VAI_RETURN_IF_ERROR(
+          ctx->Push(event_id_, std::move(frame_buffer_.Front().frame)));
+      frame_buffer_.Pop();
+    }
+  }
+
+  return absl::OkStatus();
+}
+
+absl::Status FrameSizeMotionFilter::Run(FilterRunContext* ctx) {
+  Packet current_packet;
+  bool is_first_frame = true;
+  while (!is_cancelled_.HasBeenNotified()) {
+    VAI_RETURN_IF_ERROR(ctx->Poll(&current_packet, poll_timeout_));
+    PacketAs<GstreamerBuffer> packet_as_gbuf(current_packet);
+    VAI_RETURN_IF_ERROR(packet_as_gbuf.status());
+    if (is_first_frame) {
+      gbuf_ts_offset_ =
+          absl::Now() - absl::FromUnixNanos(packet_as_gbuf->get_dts());
+      is_first_frame = false;
+    }
+
+    absl::Time timestamp =
+        absl::FromUnixNanos(packet_as_gbuf->get_dts()) + gbuf_ts_offset_;
+    TimedFrame timed_frame{/*.timestamp = */ timestamp,
+                           /*.frame = */ std::move(current_packet),
+                           /*.is_key_frame = */ packet_as_gbuf->is_key_frame()};
+    VAI_RETURN_IF_ERROR(
+        RunInternal(std::move(timed_frame), packet_as_gbuf->size(), ctx));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status FrameSizeMotionFilter::Cancel() {
+  is_cancelled_.Notify();
+  return absl::OkStatus();
+}
+
+void FrameSizeMotionFilter::UpdateMotionDetection(bool motion_prediction,
+                                                  const absl::Time& timestamp) {
+  if (motion_prediction) {
+    ++consecutive_motion_detections_;
+    if (consecutive_motion_detections_ >= min_frames_trigger_motion_)
+      // Update the event start time to the latest detection motion timestamp
+      // so that we can decide if the current motion event is still active
+      // correctly.
+      latest_motion_detection_time_ = timestamp;
+  } else {
+    consecutive_motion_detections_ = 0;
+  }
+}
+
+REGISTER_FILTER_INTERFACE("FrameSizeMotionFilter")
+    .Attr("size_ratio_threshold", "float")
+    .Attr("baseline_update_rate", "float")
+    .Attr("warmup_frames", "int")
+    .Attr("early_key_frame_ratio", "float")
+    .Attr("min_frames_trigger_motion", "int")
+    .Attr("min_event_length_in_seconds", "int")
+    .Attr("lookback_window_in_seconds", "int")
+    .Attr("cool_down_period_in_seconds", "int")
+    .Attr("time_out_in_ms", "int")
+    .Doc(
+        "FrameSizeMotionFilter is to filter out video segments that do not "
+        "contain motion. It only looks at the encoded frame sizes and the key "
+        "frame cadence, and never decodes the video.");
+REGISTER_FILTER_IMPLEMENTATION("FrameSizeMotionFilter", FrameSizeMotionFilter);
+
+}  // namespace visionai
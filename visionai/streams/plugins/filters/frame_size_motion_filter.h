@@ -0,0 +1,93 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file or at
+ * https://developers.google.com/open-source/licenses/bsd
+ */
+
+#ifndef THIRD_PARTY_VISIONAI_STREAMS_PLUGINS_FILTERS_FRAME_SIZE_MOTION_FILTER_H_
+#define THIRD_PARTY_VISIONAI_STREAMS_PLUGINS_FILTERS_FRAME_SIZE_MOTION_FILTER_H_
+
+#include <memory>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+#include "visionai/algorithms/detection/motion_detection/frame_size_motion_detector.h"
+#include "visionai/algorithms/detection/motion_detection/frame_size_motion_detector_config.pb.h"
+#include "visionai/streams/framework/filter.h"
+#include "visionai/streams/framework/filter_def_registry.h"
+#include "visionai/streams/util/h264_frame_buffer.h"
+#include "visionai/types/gstreamer_buffer.h"
+
+namespace visionai {
+
+// A filter that operates on encoded video streams and passes through only the
+// portion that likely contains motion.
+//
+// Unlike the EncodedMotionFilter, it does not decode the stream at all. The
+// decision is made from the sizes of the encoded frames and the key frame
+// cadence (see FrameSizeMotionDetector). This makes it a very cheap but coarse
+// "something changed" gate.
+//
+// Init(): Called from the main thread to initialize the module.
+// Run(): Called from a worker thread to actually filter data.
+// Cancel(): Called from the main thread to stop the worker thread.
+class FrameSizeMotionFilter : public Filter {
+ public:
+  FrameSizeMotionFilter() = default;
+  ~FrameSizeMotionFilter() override = default;
+
+  absl::Status Init(FilterInitContext* ctx) override;
+  absl::Status Run(FilterRunContext* ctx) override;
+  absl::Status Cancel() override;
+
+ private:
+  // A buffer of frames in the past (specified by lookback_window_duration_).
+  H264FrameBuffer frame_buffer_;
+
+  absl::Duration min_event_duration_;
+  absl::Duration lookback_window_duration_;
+  absl::Duration cool_down_period_duration_;
+  absl::Duration poll_timeout_;
+
+  std::string event_id_;
+  absl::Notification is_cancelled_;
+
+  motion_detection::FrameSizeMotionDetectorConfig detector_config_;
+  std::unique_ptr<motion_detection::FrameSizeMotionDetector> detector_;
+
+  // The time point when the cooldown period ends.
+  absl::Time cooldown_until_ = absl::UnixEpoch();
+  absl::Time latest_motion_detection_time_ = absl::UnixEpoch();
+
+  // Flag to indicate whether the current GOP is active.
+  bool current_gop_active_ = false;
+
+  // Counter of consecutively frames with motion detected.
+  int consecutive_motion_detections_ = 0;
+
+  // The mininum number of frames needed to trigger a motion event.
+  int min_frames_trigger_motion_ = 0;
+
+  // The offset that converts the relative DTS (Decoding TimeStamp) of the
+  // gstreamer buffers into absolute timestamps. It is set upon the first frame.
+  absl::Duration gbuf_ts_offset_ = absl::ZeroDuration();
+
+  // Updates `consecutive_motion_detections_` and updates
+  // `latest_motion_detection_time_` after detections are observed for
+  // `min_frames_trigger_motion_` times in a row.
+  void UpdateMotionDetection(bool motion_prediction,
+                             const absl::Time& timestamp);
+
+  // Detects motion from the next frame and pushes the packet in the output
+  // buffer when needed.
+  absl::Status RunInternal(TimedFrame timed_frame, int64_t frame_size,
+                           FilterRunContext* ctx);
+};
+
+}  // namespace visionai
+
+#endif  // THIRD_PARTY_VISIONAI_STREAMS_PLUGINS_FILTERS_FRAME_SIZE_MOTION_FILTER_H_
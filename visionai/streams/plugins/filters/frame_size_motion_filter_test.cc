@@ -0,0 +1,161 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/streams/plugins/filters/frame_size_motion_filter.h"
+
+#include <memory>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "visionai/streams/filtered_element.h"
+#include "visionai/streams/framework/event_writer.h"
+#include "visionai/streams/framework/event_writer_def_registry.h"
+#include "visionai/types/gstreamer_buffer.h"
+
+namespace visionai {
+
+namespace {
+
+constexpr absl::string_view kH264CapsString =
+    "video/x-h264, stream-format=(string)byte-stream, alignment=(string)au";
+constexpr int kGopLength = 30;
+constexpr int kStaticFrameSize = 1000;
+constexpr int kMotionFrameSize = 10000;
+constexpr int kKeyFrameSize = 50000;
+constexpr int64_t kFrameDurationNanos = 1000000000 / kGopLength;
+
+Packet MakeFramePacket(int index, int size) {
+  GstreamerBuffer gstreamer_buffer;
+  gstreamer_buffer.assign(std::string(size, '\0'));
+  gstreamer_buffer.set_caps_string(kH264CapsString);
+  gstreamer_buffer.set_is_key_frame(index % kGopLength == 0);
+  gstreamer_buffer.set_dts(index * kFrameDurationNanos);
+  gstreamer_buffer.set_pts(index * kFrameDurationNanos);
+  return *MakePacket(std::move(gstreamer_buffer));
+}
+
+// Counts Packet-type elements in the buffer.
+int CountPackets(
+    std::shared_ptr<ProducerConsumerQueue<FilteredElement>> buffer) {
+  int cnt = 0;
+  while (buffer->count() > 0) {
+    FilteredElement elem;
+    buffer->Pop(elem);
+    if (elem.type() == FilteredElementType::kPacket) {
+      cnt++;
+    }
+  }
+  return cnt;
+}
+
+// A Mock Event Writer to for unit tests.
+class MockEventWriter : public EventWriter {
+ public:
+  MockEventWriter() {}
+  ~MockEventWriter() override {}
+
+  absl::Status Init(EventWriterInitContext* ctx) override {
+    return absl::OkStatus();
+  }
+
+  absl::Status Open(absl::string_view event_id) override {
+    return absl::OkStatus();
+  }
+
+  absl::Status Write(Packet p) override { return absl::OkStatus(); }
+  absl::Status Close() override { return absl::OkStatus(); }
+};
+
+REGISTER_EVENT_WRITER_INTERFACE("MockEventWriter")
+    .Doc(R"doc(MockEventWriter)doc");
+REGISTER_EVENT_WRITER_IMPLEMENTATION("MockEventWriter", MockEventWriter);
+
+FilterInitContext::InitData MakeInitData() {
+  FilterInitContext::InitData init_data;
+  init_data.attrs["size_ratio_threshold"].set_f(2.0);
+  init_data.attrs["baseline_update_rate"].set_f(0.1);
+  init_data.attrs["warmup_frames"].set_i(10);
+  init_data.attrs["min_frames_trigger_motion"].set_i(3);
+  init_data.attrs["min_event_length_in_seconds"].set_i(1);
+  init_data.attrs["cool_down_period_in_seconds"].set_i(0);
+  init_data.attrs["lookback_window_in_seconds"].set_i(1);
+  init_data.attrs["time_out_in_ms"].set_i(10);
+  return init_data;
+}
+
+}  // namespace
+
+TEST(FrameSizeMotionFilterTest, TestRunNoMotion) {
+  FrameSizeMotionFilter filter;
+  FilterInitContext init_context(MakeInitData());
+  ASSERT_TRUE(filter.Init(&init_context).ok());
+
+  constexpr int kNumFrames = 3 * kGopLength;
+  auto input_buffer = std::make_shared<RingBuffer<Packet>>(kNumFrames);
+  auto output_buffer =
+      std::make_shared<ProducerConsumerQueue<FilteredElement>>(kNumFrames);
+  FilterRunContext::RunData run_data;
+  run_data.input_buffer = input_buffer;
+  run_data.output_buffer = output_buffer;
+  EventManager::Options event_manager_options;
+  event_manager_options.config.set_name("MockEventWriter");
+  run_data.event_manager =
+      std::make_unique<EventManager>(event_manager_options);
+
+  for (int i = 0; i < kNumFrames; ++i) {
+    input_buffer->EmplaceFront(MakeFramePacket(
+        i, i % kGopLength == 0 ? kKeyFrameSize : kStaticFrameSize));
+  }
+
+  FilterRunContext run_context(std::move(run_data));
+  // Expects error caused by polling timeout.
+  EXPECT_FALSE(filter.Run(&run_context).ok());
+  EXPECT_EQ(CountPackets(output_buffer), 0);
+  EXPECT_EQ(input_buffer->count(), 0);
+}
+
+TEST(FrameSizeMotionFilterTest, TestRunMotion) {
+  FrameSizeMotionFilter filter;
+  FilterInitContext init_context(MakeInitData());
+  ASSERT_TRUE(filter.Init(&init_context).ok());
+
+  constexpr int kNumFrames = 2 * kGopLength;
+  auto input_buffer = std::make_shared<RingBuffer<Packet>>(kNumFrames);
+  auto output_buffer =
+      std::make_shared<ProducerConsumerQueue<FilteredElement>>(kNumFrames +
+                                                               1);
+  FilterRunContext::RunData run_data;
+  run_data.input_buffer = input_buffer;
+  run_data.output_buffer = output_buffer;
+  EventManager::Options event_manager_options;
+  event_manager_options.config.set_name("MockEventWriter");
+  run_data.event_manager =
+      std::make_unique<EventManager>(event_manager_options);
+
+  // A static first GOP, followed by a GOP with motion.
+  for (int i = 0; i < kNumFrames; ++i) {
+    int size = kStaticFrameSize;
+    if (i % kGopLength == 0) {
+      size = kKeyFrameSize;
+    } else if (i >= kGopLength) {
+      size = kMotionFrameSize;
+    }
+    input_buffer->EmplaceFront(MakeFramePacket(i, size));
+  }
+
+  FilterRunContext run_context(std::move(run_data));
+  // Expects error caused by polling timeout.
+  EXPECT_FALSE(filter.Run(&run_context).ok());
+  // The event starts on the 3rd frame with motion. It carries the whole
+  // lookback window, which covers both GOPs, and every frame after it.
+  EXPECT_EQ(CountPackets(output_buffer), kNumFrames);
+  EXPECT_EQ(input_buffer->count(), 0);
+}
+
+}  // namespace visionai
@@ -6,6 +6,8 @@
 
 #include "visionai/streams/plugins/filters/motion_filter.h"
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
 #include <string>
 #include <vector>
@@ -15,10 +17,15 @@
 #include "absl/strings/str_split.h"
 #include "absl/synchronization/notification.h"
 #include "absl/time/time.h"
+#include "visionai/algorithms/detection/motion_detection/frame_difference_motion_detector.h"
+#include "visionai/algorithms/detection/motion_detection/frame_difference_motion_detector_config.pb.h"
 #include "visionai/algorithms/detection/motion_detection/opencv_motion_detector.h"
+#include "visionai/algorithms/media/gstreamer_async_decoder.h"
 #include "visionai/algorithms/media/util/type_util.h"
 #include "visionai/streams/framework/filter.h"
 #include "visionai/streams/packet/packet.h"
+#include "visionai/streams/util/h264_frame_buffer.h"
+#include "visionai/types/gstreamer_buffer.h"
 #include "visionai/types/raw_image.h"
 #include "visionai/util/status/status_macros.h"
 
@@ -30,6 +37,14 @@ constexpr float kVarianceThresholdNumPix = 16;
 constexpr int kMotionForegroundPixelThreshold = 120;
 constexpr float kImageScale = 0.1;
 constexpr float kMotionAreaThreshold = 0.01;
+constexpr bool kExcludeAnnotatedZone = false;
+constexpr char kZoneAnnotation[] = "";
+// The supported motion detectors.
+constexpr char kMog2MotionDetector[] = "mog2";
+constexpr char kFrameDifferenceMotionDetector[] = "frame_difference";
+constexpr int kPixelDifferenceThreshold = 20;
+// The largest downscale factor of the frame difference motion detector.
+constexpr int kMaxDownscaleFactor = 16;
 constexpr absl::Duration kTimeOut = absl::Seconds(10);
 constexpr absl::Duration kMinEventDuration = absl::Seconds(10);
 constexpr absl::Duration kLookBackWindowDuration = absl::Seconds(3);
@@ -38,6 +53,20 @@ constexpr absl::Duration kCoolDownPeriodDuration = absl::Minutes(5);
 // of a new motion event.
 // TODO: make it depends on fps.
 constexpr int kMinMotionFramesForEvent = 3;
+constexpr absl::Duration kFeedTimeout = absl::Seconds(10);
+constexpr int kPcQueueSize = 30;
+// The packet type class of GstreamerBuffer packets.
+constexpr char kGstreamerBufferTypeClass[] = "gst";
+
+// Returns the downscale factor of the frame difference motion detector that is
+// the closest to the given scale.
+int DownscaleFactor(float scale) {
+  if (scale <= 0) {
+    return kMaxDownscaleFactor;
+  }
+  return std::min(kMaxDownscaleFactor,
+                  std::max(1, static_cast<int>(std::lround(1 / scale))));
+}
 }  // namespace
 
 absl::Status MotionFilter::Init(FilterInitContext* ctx) {
@@ -49,6 +78,8 @@ absl::Status MotionFilter::Init(FilterInitContext* ctx) {
   bool shadow_detection = false;
   float motion_area_threshold = kMotionAreaThreshold;
   int time_out_in_ms = 0;
+  std::string motion_detector = kMog2MotionDetector;
+  int pixel_difference_threshold = kPixelDifferenceThreshold;
 
   // Get attributes to initialize the motion detector.
   // TODO: take a config instead.
@@ -102,18 +133,63 @@ absl::Status MotionFilter::Init(FilterInitContext* ctx) {
     poll_timeout_ = kTimeOut;
   }
 
-  ::visionai::motion_detection::OpenCVMotionDetectorConfig config;
-  config.set_variance_threshold_num_pix(variance_threshold_num_pix);
-  config.set_background_history_frame_length(background_history_frame_length);
-  config.set_shadow_detection(shadow_detection);
-  config.set_scale(scale);
-  config.set_motion_foreground_pixel_threshold(
-      motion_foreground_pixel_threshold);
-  config.set_motion_area_threshold(motion_area_threshold);
+  VAI_RETURN_IF_ERROR(ctx->GetAttr("motion_detector", &motion_detector));
+  if (motion_detector != kMog2MotionDetector &&
+      motion_detector != kFrameDifferenceMotionDetector) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "The motion_detector must be \"", kMog2MotionDetector, "\" or \"",
+        kFrameDifferenceMotionDetector, "\". Got \"", motion_detector, "\""));
+  }
+  VAI_RETURN_IF_ERROR(
+      ctx->GetAttr("pixel_difference_threshold", &pixel_difference_threshold));
+  if (pixel_difference_threshold < 0 || pixel_difference_threshold > 255) {
+    LOG(WARNING) << absl::StrCat(
+        "The pixel_difference_threshold must be [0, 255]. Got ",
+        pixel_difference_threshold,
+        ". Reset to default: ", kPixelDifferenceThreshold);
+    pixel_difference_threshold = kPixelDifferenceThreshold;
+  }
+
+  // Get attributes to initialize the motion detector zone config.
+  std::string zone_annotation = kZoneAnnotation;
+  bool exclude_annotated_zone = kExcludeAnnotatedZone;
+  VAI_RETURN_IF_ERROR(ctx->GetAttr("zone_annotation", &zone_annotation));
+  VAI_RETURN_IF_ERROR(
+      ctx->GetAttr("exclude_annotated_zone", &exclude_annotated_zone));
+
+  opencv_motion_detector_.reset();
+  frame_difference_motion_detector_.reset();
+  if (motion_detector == kFrameDifferenceMotionDetector) {
+    if (!zone_annotation.empty()) {
+      LOG(WARNING) << "The frame_difference motion detector does not support "
+                      "zones. Detecting motion in the whole frame instead.";
+    }
+    // Downscale the frames about as much as the MOG2 detector does.
+    ::visionai::motion_detection::FrameDifferenceMotionDetectorConfig config;
+    config.set_downscale_factor(DownscaleFactor(scale));
+    config.set_pixel_difference_threshold(pixel_difference_threshold);
+    config.set_motion_area_threshold(motion_area_threshold);
+    frame_difference_motion_detector_ = std::make_unique<
+        ::visionai::motion_detection::FrameDifferenceMotionDetector>(config);
+  } else {
+    ::visionai::motion_detection::OpenCVMotionDetectorConfig config;
+    config.set_variance_threshold_num_pix(variance_threshold_num_pix);
+    config.set_background_history_frame_length(
+        background_history_frame_length);
+    config.set_shadow_detection(shadow_detection);
+    config.set_scale(scale);
+    config.set_motion_foreground_pixel_threshold(
+        motion_foreground_pixel_threshold);
+    config.set_motion_area_threshold(motion_area_threshold);
+    opencv_motion_detector_ =
+        std::make_unique<::visionai::motion_detection::OpenCVMotionDetector>(
+            config);
+  }
 
-  opencv_motion_detector_ =
-      std::make_unique<::visionai::motion_detection::OpenCVMotionDetector>(
-          config);
+  opencv_motion_detector_zone_config_.Clear();
+  opencv_motion_detector_zone_config_.set_zone_annotation(zone_annotation);
+  opencv_motion_detector_zone_config_.set_exclude_annotated_zone(
+      exclude_annotated_zone);
 
   // Get attributes to initialize the motion filter.
   int min_event_duration_in_seconds = 0;
@@ -163,93 +239,177 @@ absl::Status MotionFilter::Init(FilterInitContext* ctx) {
   motion_event_started_ = false;
   consecutive_motion_detections_ = 0;
   cooldown_timer_ = absl::ZeroDuration();
+  frame_buffer_.Clear();
+  event_id_.clear();
 
   return absl::OkStatus();
 }
 
 absl::Status MotionFilter::Run(FilterRunContext* ctx) {
-  std::string event_id;
   Packet current_packet;
   while (!is_cancelled_.HasBeenNotified()) {
+    {
+      absl::MutexLock lock(&decoder_status_mu_);
+      VAI_RETURN_IF_ERROR(decoder_status_);
+    }
     VAI_RETURN_IF_ERROR(ctx->Poll(&current_packet, poll_timeout_));
+    if (GetTypeClass(current_packet) == kGstreamerBufferTypeClass) {
+      VAI_RETURN_IF_ERROR(FeedEncodedFrame(std::move(current_packet), ctx));
+      continue;
+    }
     PacketAs<RawImage> p_as_image(current_packet);
     if (!p_as_image.status().ok()) {
       return p_as_image.status();
     }
-    TimedRawImage timed_raw_image;
     // TODO: what we really want is PTS.
-    timed_raw_image.timestamp = GetCaptureTime(current_packet);
-    VLOG(2) << "motion timestamp: " << timed_raw_image.timestamp;
-    timed_raw_image.image = std::move(*p_as_image);
-    image_buffer_.emplace_back(std::move(timed_raw_image));
-    VLOG(2) << "motion buffer size : " << image_buffer_.size();
+    TimedFrame timed_frame{/*.timestamp = */ GetCaptureTime(current_packet),
+                           /*.frame = */ std::move(current_packet),
+                           /*.is_key_frame = */ true};
+    VAI_RETURN_IF_ERROR(
+        ProcessFrame(std::move(timed_frame), *p_as_image, ctx));
+  }
+  return absl::OkStatus();
+}
 
-    time_elapsed_since_last_packet_ =
-        image_buffer_.back().timestamp - image_buffer_.front().timestamp;
-    // Make sure images in the buffer do not exceed the duration of
-    // lookback_window_in_seconds_.
-    if (time_elapsed_since_last_packet_ > lookback_window_duration_) {
-      VLOG(2) << "Pop from the lookback buffer.";
-      image_buffer_.pop_front();
-    }
-    // Filter all the frames during the cool down period.
-    if (InCoolDown()) {
-      continue;
-    }
+absl::Status MotionFilter::FeedEncodedFrame(Packet packet,
+                                            FilterRunContext* ctx) {
+  PacketAs<GstreamerBuffer> packet_as_gbuf(packet);
+  VAI_RETURN_IF_ERROR(packet_as_gbuf.status());
+  if (decoder_ == nullptr) {
+    pcqueue_ =
+        std::make_unique<ProducerConsumerQueue<TimedFrame>>(kPcQueueSize);
+    decoder_ = std::make_unique<GstreamerAsyncDecoder<>>(
+        [this, ctx](absl::StatusOr<RawImage> image) {
+          TimedFrame timed_frame;
+          this->pcqueue_->Pop(timed_frame);
+          absl::Status status = image.status();
+          if (status.ok()) {
+            status = this->ProcessFrame(std::move(timed_frame), *image, ctx);
+          }
+          if (!status.ok()) {
+            absl::MutexLock lock(&this->decoder_status_mu_);
+            if (this->decoder_status_.ok()) {
+              this->decoder_status_ = status;
+            }
+          }
+        },
+        kPcQueueSize, kFeedTimeout);
+  }
+
+  // TODO: what we really want is PTS.
+  bool is_key_frame = packet_as_gbuf->is_key_frame();
+  auto timed_frame = std::make_unique<TimedFrame>(
+      TimedFrame{/*.timestamp = */ GetCaptureTime(packet),
+                 /*.frame = */ std::move(packet),
+                 /*.is_key_frame = */ is_key_frame});
+  VAI_RETURN_IF_ERROR(decoder_->Feed(*packet_as_gbuf));
+  if (!pcqueue_->TryPush(timed_frame, kFeedTimeout)) {
+    return absl::DeadlineExceededError(
+        "Frame processing timeout deadline reached.");
+  }
+  return absl::OkStatus();
+}
+
+absl::Status MotionFilter::ProcessFrame(TimedFrame timed_frame,
+                                        const RawImage& image,
+                                        FilterRunContext* ctx) {
+  bool is_key_frame = timed_frame.is_key_frame;
+  latest_timestamp_ = timed_frame.timestamp;
+  VLOG(2) << "motion timestamp: " << latest_timestamp_;
+  frame_buffer_.Push(std::move(timed_frame));
+  VLOG(2) << "motion buffer size : " << frame_buffer_.Size();
 
-    // Note that the background model needs a buffer of frames to update so
-    // everytime it requires sometime after the cool down for the background
-    // model to be updated.
+  time_elapsed_since_last_packet_ =
+      latest_timestamp_ - frame_buffer_.Front().timestamp;
+  // Make sure frames in the buffer do not exceed the duration of
+  // lookback_window_in_seconds_. Whole GOPs are dropped at a time.
+  frame_buffer_.UpdateLookBackWindow(latest_timestamp_ -
+                                     lookback_window_duration_);
+  // Filter all the frames during the cool down period.
+  if (InCoolDown()) {
+    return absl::OkStatus();
+  }
+
+  // Note that the background model needs a buffer of frames to update so
+  // everytime it requires sometime after the cool down for the background
+  // model to be updated.
+  bool motion_prediction = false;
+  if (frame_difference_motion_detector_ != nullptr) {
     VAI_ASSIGN_OR_RETURN(
-        auto motion_prediction,
-        opencv_motion_detector_->DetectMotion(image_buffer_.back().image));
-    // Check if a new motion event is starting and update the event start time
-    // according.
-    bool start_new_event = CheckAndUpdateEventStartTime(motion_prediction);
-    bool event_active = CurrentEventActive();
-    if (!event_active) {
-      if (motion_event_started_) {
-        VAI_RETURN_IF_ERROR(ctx->EndEvent(event_id));
-        motion_event_started_ = false;
-        VLOG(2) << "motion filter event ended";
-        // Start cool down period.
-        cooldown_timer_ = cool_down_period_duration_;
-      } else if (start_new_event) {
-        VAI_ASSIGN_OR_RETURN(event_id, ctx->StartEvent());
-        motion_event_started_ = true;
-        VLOG(2) << "motion filter event started";
-        // Push all the packets in the lookback window to event writer.
-        while (!image_buffer_.empty()) {
-          VAI_ASSIGN_OR_RETURN(
-              auto raw_image_gstreamer_buffer,
-              ToGstreamerBuffer(std::move(image_buffer_.front().image)));
-          VAI_ASSIGN_OR_RETURN(auto pkt,
-                           MakePacket(std::move(raw_image_gstreamer_buffer)));
-          VAI_RETURN_IF_ERROR(ctx->Push(event_id, pkt));
-          image_buffer_.pop_front();
-        }
+        motion_prediction,
+        frame_difference_motion_detector_->DetectMotion(image));
+  } else {
+    VAI_ASSIGN_OR_RETURN(motion_prediction,
+                         opencv_motion_detector_->ZoneBasedDetectMotion(
+                             image, opencv_motion_detector_zone_config_));
+  }
+  // Check if a new motion event is starting and update the event start time
+  // according.
+  bool start_new_event = CheckAndUpdateEventStartTime(motion_prediction);
+  bool event_active = CurrentEventActive();
+  if (!event_active) {
+    if (motion_event_started_) {
+      if (!is_key_frame) {
+        // Keep the event open until the next key frame, otherwise the next
+        // lookback window would start in the middle of a GOP.
+        return PushLookBackWindow(ctx);
       }
-    } else {
-      // In this state, the current motion event is active so we simply push the
-      // latest input packet to the event writer. There should be no pile up in
-      // the image_buffer.
-      VAI_ASSIGN_OR_RETURN(
-          auto raw_image_gstreamer_buffer,
-          ToGstreamerBuffer(std::move(image_buffer_.front().image)));
-      VAI_ASSIGN_OR_RETURN(auto pkt,
+      // The current key frame stays in the buffer and starts the next
+      // lookback window.
+      VAI_RETURN_IF_ERROR(ctx->EndEvent(event_id_));
+      motion_event_started_ = false;
+      VLOG(2) << "motion filter event ended";
+      // Start cool down period.
+      cooldown_timer_ = cool_down_period_duration_;
+    } else if (start_new_event) {
+      VAI_ASSIGN_OR_RETURN(event_id_, ctx->StartEvent());
+      motion_event_started_ = true;
+      VLOG(2) << "motion filter event started";
+      // Push all the packets in the lookback window to event writer.
+      VAI_RETURN_IF_ERROR(PushLookBackWindow(ctx));
+    }
+  } else {
+    // In this state, the current motion event is active so we simply push the
+    // latest input packet to the event writer. There should be no pile up in
+    // the frame_buffer_.
+    VAI_RETURN_IF_ERROR(PushLookBackWindow(ctx));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status MotionFilter::PushLookBackWindow(FilterRunContext* ctx) {
+  while (!frame_buffer_.Empty()) {
+    Packet pkt = std::move(frame_buffer_.Front().frame);
+    frame_buffer_.Pop();
+    if (GetTypeClass(pkt) != kGstreamerBufferTypeClass) {
+      // RawImage packets are converted to raw video GstreamerBuffers.
+      PacketAs<RawImage> p_as_image(std::move(pkt));
+      VAI_RETURN_IF_ERROR(p_as_image.status());
+      VAI_ASSIGN_OR_RETURN(auto raw_image_gstreamer_buffer,
+                       ToGstreamerBuffer(std::move(*p_as_image)));
+      VAI_ASSIGN_OR_RETURN(pkt,
                        MakePacket(std::move(raw_image_gstreamer_buffer)));
-      VAI_RETURN_IF_ERROR(ctx->Push(event_id, pkt));
-      image_buffer_.pop_front();
     }
+    VAI_RETURN_IF_ERROR(ctx->Push(event_id_, std::move(pkt)));
   }
   return absl::OkStatus();
 }
 
 absl::Status MotionFilter::Cancel() {
   is_cancelled_.Notify();
+  if (decoder_ != nullptr) {
+    decoder_->SignalEOS();
+  }
   return absl::OkStatus();
 }
 
+bool MotionFilter::WaitUntilCompleted(absl::Duration timeout) {
+  if (decoder_ == nullptr) {
+    return true;
+  }
+  return decoder_->WaitUntilCompleted(timeout);
+}
+
 bool MotionFilter::InCoolDown() {
   if (cooldown_timer_ > time_elapsed_since_last_packet_) {
     // TODO: we really want cooldown_timer_ = cooldown_timer -
@@ -270,7 +430,7 @@ bool MotionFilter::CheckAndUpdateEventStartTime(bool motion_prediction) {
       // Update the event start time to the latest detection motion timestamp so
       // that we can decide if the current motion event is still active
       // correctly.
-      latest_motion_detection_time_ = image_buffer_.back().timestamp;
+      latest_motion_detection_time_ = latest_timestamp_;
   } else {
     consecutive_motion_detections_ = 0;
   }
@@ -283,7 +443,7 @@ bool MotionFilter::CurrentEventActive() {
   // elapsed since last consecutive motion detection is less than
   // min_event_length_in_seconds_.
   if (motion_event_started_ &&
-      image_buffer_.back().timestamp - latest_motion_detection_time_ <
+      latest_timestamp_ - latest_motion_detection_time_ <
           min_event_duration_) {
     VLOG(2) << "motion filter event active";
     return true;
@@ -303,9 +463,16 @@ REGISTER_FILTER_INTERFACE("MotionFilter")
     .Attr("min_event_length_in_seconds", "int")
     .Attr("lookback_window_in_seconds", "int")
     .Attr("cool_down_period_in_seconds", "int")
+    .Attr("zone_annotation", "string")
+    .Attr("exclude_annotated_zone", "bool")
+    .Attr("motion_detector", "string")
+    .Attr("pixel_difference_threshold", "int")
     .Doc(
         "MotionFilter is to filter out video segments that do not contain "
-        "motion.");
+        "motion. It accepts either raw images or encoded video. For encoded "
+        "video, the original encoded packets are passed through. The "
+        "motion_detector is either \"mog2\" (default) or the cheaper "
+        "\"frame_difference\", which ignores the zones.");
 REGISTER_FILTER_IMPLEMENTATION("MotionFilter", MotionFilter);
 
 }  // namespace visionai
@@ -10,21 +10,40 @@
 #define THIRD_PARTY_VISIONAI_STREAMS_PLUGINS_FILTERS_MOTION_FILTER_H_
 
 #include <memory>
+#include <string>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/synchronization/notification.h"
 #include "absl/time/time.h"
+#include "visionai/algorithms/detection/motion_detection/frame_difference_motion_detector.h"
 #include "visionai/algorithms/detection/motion_detection/opencv_motion_detector.h"
+#include "visionai/algorithms/media/gstreamer_async_decoder.h"
 #include "visionai/streams/framework/filter.h"
 #include "visionai/streams/framework/filter_def_registry.h"
+#include "visionai/streams/util/h264_frame_buffer.h"
 #include "visionai/types/raw_image.h"
+#include "visionai/util/producer_consumer_queue.h"
 
 namespace visionai {
 
 // A filter that operates on video streams and passes through only the portion
 // that contains motion.
 //
+// The input may either be RawImage packets or encoded GstreamerBuffer packets.
+// Encoded packets are decoded only to run the motion detection; the lookback
+// window keeps the original encoded packets and those are what get pushed once
+// a motion event is triggered. Events of encoded streams only end on key
+// frames, so that every event as well as every lookback window starts with a
+// decodable GOP.
+//
+// The motion is detected with background subtraction (MOG2) by default. Set
+// the motion_detector attribute to "frame_difference" to compare the frames
+// against a slowly updated reference frame instead, which is much cheaper but
+// does not support zones.
+//
 // Init(): Called from the main thread to initialize the module.
 // Run(): Called from a worker thread to actually filter data.
 // Cancel(): Called from the main thread to stop the worker thread.
@@ -37,13 +56,20 @@ class MotionFilter : public Filter {
   absl::Status Run(FilterRunContext* ctx) override;
   absl::Status Cancel() override;
 
+  // Wait until the async decoder to finish. This is for unit test only. It
+  // returns true immediately if the input was never encoded.
+  bool WaitUntilCompleted(absl::Duration timeout);
+
  private:
-  struct TimedRawImage {
-    absl::Time timestamp;
-    RawImage image;
-  };
-  // A buffer of images in the past (specified by lookback_window_in_seconds_).
-  std::deque<TimedRawImage> image_buffer_;
+  // A buffer of the original input packets in the past (specified by
+  // lookback_window_in_seconds_). RawImage packets are all treated as key
+  // frames.
+  H264FrameBuffer frame_buffer_;
+
+  // The timestamp of the latest frame that has been processed.
+  absl::Time latest_timestamp_;
+
+  std::string event_id_;
 
   absl::Duration min_event_duration_;
   absl::Duration lookback_window_duration_;
@@ -51,8 +77,13 @@ class MotionFilter : public Filter {
   absl::Duration poll_timeout_;
 
   absl::Notification is_cancelled_;
+  // Exactly one of the motion detectors is set.
   std::unique_ptr<visionai::motion_detection::OpenCVMotionDetector>
       opencv_motion_detector_;
+  std::unique_ptr<visionai::motion_detection::FrameDifferenceMotionDetector>
+      frame_difference_motion_detector_;
+  visionai::motion_detection::OpenCVMotionDetectorZoneConfig
+      opencv_motion_detector_zone_config_;
   // Time remaining in the cooldown period.
   absl::Duration cooldown_timer_;
   absl::Duration time_elapsed_since_last_packet_;
@@ -62,6 +93,29 @@ class MotionFilter : public Filter {
   // Counter of consecutively frames with motion detected.
   int consecutive_motion_detections_;
 
+  // Async decoder for encoded inputs. It is created upon the first encoded
+  // packet.
+  std::unique_ptr<GstreamerAsyncDecoder<>> decoder_;
+
+  // PCQueue for matching the original packets with the decoded images.
+  std::unique_ptr<ProducerConsumerQueue<TimedFrame>> pcqueue_;
+
+  // The first error that happened inside the decoder callback.
+  absl::Mutex decoder_status_mu_;
+  absl::Status decoder_status_ ABSL_GUARDED_BY(decoder_status_mu_);
+
+  // Runs motion detection on `image` and pushes, buffers or drops the
+  // original packet in `timed_frame` accordingly.
+  absl::Status ProcessFrame(TimedFrame timed_frame, const RawImage& image,
+                            FilterRunContext* ctx);
+
+  // Feeds an encoded packet into the decoder. `ProcessFrame` is called from
+  // the decoder callback once the frame is decoded.
+  absl::Status FeedEncodedFrame(Packet packet, FilterRunContext* ctx);
+
+  // Pushes all the frames in the lookback window to the current event.
+  absl::Status PushLookBackWindow(FilterRunContext* ctx);
+
   // Check if a new motion event is starting and update the event start time
   // accordingly. Returns true if a new motion event starts.
   bool CheckAndUpdateEventStartTime(bool motion_prediction);
@@ -11,12 +11,17 @@
 #include "opencv4/opencv2/core.hpp"
 #include "opencv4/opencv2/imgcodecs.hpp"
 #include "opencv4/opencv2/imgproc.hpp"
+#include "absl/debugging/leak_check.h"
 #include "absl/strings/string_view.h"
+#include "third_party/gstreamer/subprojects/gstreamer/gst/gstplugin.h"
+#include "visionai/algorithms/media/util/util.h"
 #include "visionai/streams/filtered_element.h"
 #include "visionai/streams/framework/attr_value_util.h"
 #include "visionai/streams/framework/event_writer.h"
 #include "visionai/streams/framework/event_writer_def_registry.h"
+#include "visionai/types/gstreamer_buffer.h"
 #include "visionai/types/raw_image.h"
+#include "visionai/util/file_helpers.h"
 #include "visionai/util/file_path.h"
 
 namespace visionai {
@@ -26,6 +31,42 @@ namespace {
 const char kTestFolder[] = "visionai/testing/testdata/media/motion";
 constexpr int kNumTestImages = 20;
 
+const char kEncodedTestFolder[] =
+    "visionai/testing/testdata/media/encoded-frames";
+// Only the 1st of the 6 frames is a key frame.
+constexpr int kNumEncodedTestFrames = 6;
+constexpr absl::string_view kH264CapsString =
+    "video/x-h264, stream-format=(string)avc, alignment=(string)au, "
+    "level=(string)1.3, profile=(string)high, "
+    "codec_data=(buffer)"
+    "0164000dffe100186764000dacd94161fb016c80000003008000001e078a14cb01000668eb"
+    "e3cb22c0, width=(int)352, height=(int)240, framerate=(fraction)30/1, "
+    "pixel-aspect-ratio=(fraction)1/1, chroma-format=(string)4:2:0, "
+    "bit-depth-luma=(uint)8, bit-depth-chroma=(uint)8, parsed=(boolean)true";
+constexpr absl::Duration kDecoderTimeout = absl::Seconds(1);
+
+extern "C" {
+GST_PLUGIN_STATIC_DECLARE(app);
+GST_PLUGIN_STATIC_DECLARE(coreelements);
+GST_PLUGIN_STATIC_DECLARE(libav);
+GST_PLUGIN_STATIC_DECLARE(playback);
+GST_PLUGIN_STATIC_DECLARE(videoconvert);
+GST_PLUGIN_STATIC_DECLARE(videoparsersbad);
+}
+
+absl::StatusOr<Packet> LoadEncodedPacket(absl::string_view file_path,
+                                         bool is_key_frame, int64_t dts) {
+  GstreamerBuffer gstreamer_buffer;
+  std::string file_contents;
+  VAI_RETURN_IF_ERROR(GetFileContents(file_path, &file_contents));
+  gstreamer_buffer.assign(std::move(file_contents));
+  gstreamer_buffer.set_caps_string(kH264CapsString);
+  gstreamer_buffer.set_is_key_frame(is_key_frame);
+  gstreamer_buffer.set_dts(dts);
+  gstreamer_buffer.set_pts(dts);
+  return MakePacket(std::move(gstreamer_buffer));
+}
+
 absl::StatusOr<RawImage> CvMatToRawImage(cv::Mat cv_mat) {
   if (cv_mat.channels() != 3) {
     LOG(ERROR) << "cv_mat should have 3 channels instead of "
@@ -66,6 +107,21 @@ int CountPackets(
   return cnt;
 }
 
+// Gets the type of each Packet-type element in the buffer.
+std::vector<std::string> GetPacketTypes(
+    std::shared_ptr<ProducerConsumerQueue<FilteredElement>> buffer) {
+  std::vector<std::string> types;
+  while (buffer->count() > 0) {
+    FilteredElement elem;
+    buffer->Pop(elem);
+    if (elem.type() == FilteredElementType::kPacket) {
+      std::unique_ptr<Packet> packet = std::move(elem).ReleasePacket();
+      types.push_back(GetType(*packet));
+    }
+  }
+  return types;
+}
+
 // A Mock Event Writer to for unit tests.
 class MockEventWriter : public EventWriter {
  public:
@@ -193,4 +249,69 @@ TEST(MotionFilterTest, TestRunMotion) {
   EXPECT_EQ(input_buffer->count(), 0);
 }
 
+TEST(MotionFilterTest, TestRunMotionEncoded) {
+  {
+    absl::LeakCheckDisabler disabler;
+    ASSERT_TRUE(GstInit().ok());
+    GST_PLUGIN_STATIC_REGISTER(app);
+    GST_PLUGIN_STATIC_REGISTER(coreelements);
+    GST_PLUGIN_STATIC_REGISTER(libav);
+    GST_PLUGIN_STATIC_REGISTER(playback);
+    GST_PLUGIN_STATIC_REGISTER(videoconvert);
+    GST_PLUGIN_STATIC_REGISTER(videoparsersbad);
+  }
+  MotionFilter filter;
+
+  FilterInitContext::InitData init_data;
+  init_data.attrs["background_history_frame_length"].set_i(5);
+  init_data.attrs["variance_threshold_num_pix"].set_f(16);
+  init_data.attrs["shadow_detection"].set_b(false);
+  init_data.attrs["scale"].set_f(0.1);
+  init_data.attrs["motion_foreground_pixel_threshold"].set_i(120);
+  init_data.attrs["motion_area_threshold"].set_f(0);
+  init_data.attrs["time_out_in_ms"].set_i(100);
+  init_data.attrs["min_event_length_in_seconds"].set_i(1);
+  init_data.attrs["lookback_window_in_seconds"].set_i(1);
+  init_data.attrs["cool_down_period_in_seconds"].set_i(0);
+  FilterInitContext init_context(init_data);
+  EXPECT_TRUE(filter.Init(&init_context).ok());
+
+  std::shared_ptr<RingBuffer<Packet>> input_buffer =
+      std::make_shared<RingBuffer<Packet>>(kNumEncodedTestFrames);
+  std::shared_ptr<ProducerConsumerQueue<FilteredElement>> output_buffer =
+      std::make_shared<ProducerConsumerQueue<FilteredElement>>(
+          kNumEncodedTestFrames + 1);
+  FilterRunContext::RunData run_data;
+  run_data.input_buffer = input_buffer;
+  run_data.output_buffer = output_buffer;
+  EventManager::Options event_manager_options;
+  event_manager_options.config.set_name("MockEventWriter");
+  run_data.event_manager =
+      std::make_unique<EventManager>(event_manager_options);
+
+  for (int i = 1; i <= kNumEncodedTestFrames; ++i) {
+    std::string filename = absl::StrFormat("shadow-cubicle-frame-%d.264", i);
+    absl::StatusOr<Packet> p = LoadEncodedPacket(
+        file::JoinPath(kEncodedTestFolder, filename), /*is_key_frame=*/i == 1,
+        /*dts=*/i);
+    ASSERT_TRUE(p.ok());
+    run_data.input_buffer->EmplaceFront(std::move(*p));
+  }
+
+  FilterRunContext run_context(std::move(run_data));
+  // Expects error caused by polling timeout.
+  EXPECT_FALSE(filter.Run(&run_context).ok());
+  ASSERT_TRUE(filter.Cancel().ok());
+  ASSERT_TRUE(filter.WaitUntilCompleted(kDecoderTimeout));
+
+  // Motion detected because motion_area_threshold = 0.0, so all frames are
+  // passed through as the original encoded packets.
+  std::vector<std::string> types = GetPacketTypes(output_buffer);
+  EXPECT_EQ(types.size(), kNumEncodedTestFrames);
+  for (const auto& type : types) {
+    EXPECT_EQ(type, "video/x-h264");
+  }
+  EXPECT_EQ(input_buffer->count(), 0);
+}
+
 }  // namespace visionai
@@ -0,0 +1,269 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/streams/util/packet_spool.h"
+
+#include <dirent.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "visionai/streams/packet/packet.h"
+#include "visionai/util/file_helpers.h"
+#include "visionai/util/file_path.h"
+#include "visionai/util/status/status_macros.h"
+
+namespace visionai {
+
+namespace {
+
+constexpr char kSegmentExtension[] = ".spool";
+
+// Each record is the size of the serialized packet, as a little-endian 32-bit
+// integer, followed by the serialized packet.
+constexpr int kRecordHeaderBytes = 4;
+
+void EncodeRecordHeader(uint32_t size, char* header) {
+  for (int i = 0; i < kRecordHeaderBytes; ++i) {
+    header[i] = static_cast<char>((size >> (8 * i)) & 0xff);
+  }
+}
+
+uint32_t DecodeRecordHeader(const char* header) {
+  uint32_t size = 0;
+  for (int i = 0; i < kRecordHeaderBytes; ++i) {
+    size |= static_cast<uint32_t>(static_cast<unsigned char>(header[i]))
+            << (8 * i);
+  }
+  return size;
+}
+
+std::string SegmentPath(const std::string& directory, int64_t index) {
+  return file::JoinPath(directory,
+                        absl::StrFormat("%020d%s", index, kSegmentExtension));
+}
+
+// Returns the indices of the segments in `directory`, in increasing order.
+absl::StatusOr<std::vector<int64_t>> ListSegments(
+    const std::string& directory) {
+  DIR* d = opendir(directory.c_str());
+  if (d == nullptr) {
+    return absl::NotFoundError(absl::StrFormat(
+        "Can't open dir: %s. errno: %s", directory, strerror(errno)));
+  }
+  std::vector<int64_t> indices;
+  struct dirent* entry;
+  while ((entry = readdir(d)) != nullptr) {
+    absl::string_view name(entry->d_name);
+    int64_t index;
+    if (absl::ConsumeSuffix(&name, kSegmentExtension) &&
+        absl::SimpleAtoi(name, &index)) {
+      indices.push_back(index);
+    }
+  }
+  closedir(d);
+  std::sort(indices.begin(), indices.end());
+  return indices;
+}
+
+// Returns the number of complete records in the segment at `path`.
+int64_t CountRecords(const std::string& path, int64_t file_size) {
+  std::ifstream in(path, std::ios::binary);
+  int64_t num_records = 0;
+  int64_t offset = 0;
+  char header[kRecordHeaderBytes];
+  while (in.read(header, kRecordHeaderBytes)) {
+    offset += kRecordHeaderBytes + DecodeRecordHeader(header);
+    if (offset > file_size) {
+      break;
+    }
+    ++num_records;
+    in.seekg(offset);
+  }
+  return num_records;
+}
+
+}  // namespace
+
+PacketSpool::PacketSpool(const Options& options) : options_(options) {}
+
+PacketSpool::~PacketSpool() {
+  writer_.close();
+  reader_.close();
+}
+
+absl::StatusOr<std::unique_ptr<PacketSpool>> PacketSpool::Create(
+    const Options& options) {
+  if (options.directory.empty()) {
+    return absl::InvalidArgumentError("The spool directory cannot be empty.");
+  }
+  if (options.max_bytes <= 0 || options.segment_bytes <= 0) {
+    return absl::InvalidArgumentError(
+        "The spool and segment sizes must be positive.");
+  }
+  auto spool = absl::WrapUnique(new PacketSpool(options));
+  VAI_RETURN_IF_ERROR(spool->Recover())
+      << "while recovering the spool in " << options.directory;
+  return std::move(spool);
+}
+
+absl::Status PacketSpool::Recover() {
+  VAI_RETURN_IF_ERROR(RecursivelyCreateDir(options_.directory));
+  VAI_ASSIGN_OR_RETURN(auto indices, ListSegments(options_.directory));
+  for (int64_t index : indices) {
+    Segment segment;
+    segment.index = index;
+    segment.path = SegmentPath(options_.directory, index);
+    VAI_ASSIGN_OR_RETURN(segment.num_bytes, GetFileSize(segment.path));
+    segment.num_packets = CountRecords(segment.path, segment.num_bytes);
+    next_index_ = index + 1;
+    if (segment.num_packets == 0) {
+      VAI_RETURN_IF_ERROR(DeleteFile(segment.path));
+      continue;
+    }
+    num_packets_ += segment.num_packets;
+    num_bytes_ += segment.num_bytes;
+    segments_.push_back(std::move(segment));
+  }
+  if (num_packets_ > 0) {
+    LOG(INFO) << absl::StrFormat(
+        "Resuming the spool in %s with %d packets (%d bytes).",
+        options_.directory, num_packets_, num_bytes_);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status PacketSpool::StartSegment() {
+  writer_.close();
+  Segment segment;
+  segment.index = next_index_++;
+  segment.path = SegmentPath(options_.directory, segment.index);
+  writer_.open(segment.path, std::ios::binary | std::ios::trunc);
+  if (!writer_) {
+    return absl::InternalError(absl::StrFormat(
+        "Failed to create the spool segment %s.", segment.path));
+  }
+  segments_.push_back(std::move(segment));
+  return absl::OkStatus();
+}
+
+absl::Status PacketSpool::Append(const Packet& packet) {
+  std::string bytes;
+  if (!packet.SerializeToString(&bytes)) {
+    return absl::InvalidArgumentError("Failed to serialize the packet.");
+  }
+  int64_t record_bytes = kRecordHeaderBytes + bytes.size();
+  if (num_bytes_ + record_bytes > options_.max_bytes) {
+    return absl::ResourceExhaustedError(absl::StrFormat(
+        "The spool in %s is full: it holds %d packets (%d bytes).",
+        options_.directory, num_packets_, num_bytes_));
+  }
+  if (!writer_.is_open() ||
+      segments_.back().num_bytes >= options_.segment_bytes) {
+    VAI_RETURN_IF_ERROR(StartSegment());
+  }
+
+  char header[kRecordHeaderBytes];
+  EncodeRecordHeader(bytes.size(), header);
+  writer_.write(header, kRecordHeaderBytes);
+  writer_.write(bytes.data(), bytes.size());
+  writer_.flush();
+  Segment& segment = segments_.back();
+  if (!writer_) {
+    // The segment may end with a partial record now, which is never read
+    // since it is not counted. Continue in a new segment.
+    writer_.close();
+    return absl::InternalError(
+        absl::StrFormat("Failed to write to the spool segment %s.",
+                        segment.path));
+  }
+  segment.num_bytes += record_bytes;
+  ++segment.num_packets;
+  num_bytes_ += record_bytes;
+  ++num_packets_;
+  return absl::OkStatus();
+}
+
+absl::StatusOr<Packet> PacketSpool::Front() {
+  if (empty()) {
+    return absl::NotFoundError("The spool is empty.");
+  }
+  if (front_.has_value()) {
+    return *front_;
+  }
+
+  Segment& head = segments_.front();
+  if (!reader_.is_open()) {
+    reader_.open(head.path, std::ios::binary);
+    num_read_ = 0;
+  }
+  char header[kRecordHeaderBytes];
+  std::string bytes;
+  Packet packet;
+  bool ok = static_cast<bool>(reader_.read(header, kRecordHeaderBytes));
+  if (ok) {
+    bytes.resize(DecodeRecordHeader(header));
+    ok = reader_.read(&bytes[0], bytes.size()) &&
+         packet.ParseFromString(bytes);
+  }
+  if (!ok) {
+    // Give up on the rest of the segment, so that the spool moves on.
+    std::string path = head.path;
+    int64_t num_lost = head.num_packets - num_read_;
+    num_packets_ -= num_lost;
+    DeleteHead();
+    return absl::DataLossError(absl::StrFormat(
+        "Lost %d packets to the corrupted spool segment %s.", num_lost, path));
+  }
+  front_ = packet;
+  return packet;
+}
+
+absl::Status PacketSpool::PopFront() {
+  if (!front_.has_value()) {
+    VAI_RETURN_IF_ERROR(Front().status());
+  }
+  front_.reset();
+  ++num_read_;
+  --num_packets_;
+  if (num_read_ == segments_.front().num_packets) {
+    DeleteHead();
+  }
+  return absl::OkStatus();
+}
+
+void PacketSpool::DeleteHead() {
+  Segment head = std::move(segments_.front());
+  segments_.pop_front();
+  reader_.close();
+  reader_.clear();
+  num_read_ = 0;
+  if (segments_.empty()) {
+    writer_.close();
+  }
+  num_bytes_ -= head.num_bytes;
+  auto status = DeleteFile(head.path);
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to delete the spool segment " << head.path << ": "
+                 << status;
+  }
+}
+
+}  // namespace visionai
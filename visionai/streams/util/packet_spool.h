@@ -0,0 +1,118 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef THIRD_PARTY_VISIONAI_STREAMS_UTIL_PACKET_SPOOL_H_
+#define THIRD_PARTY_VISIONAI_STREAMS_UTIL_PACKET_SPOOL_H_
+
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/optional.h"
+#include "visionai/streams/packet/packet.h"
+
+namespace visionai {
+
+// A bounded first-in first-out queue of packets, stored on the local disk.
+//
+// The packets are appended to segment files in `directory`, and a segment is
+// deleted once all of its packets have been popped. Each packet is flushed to
+// the file as it is appended, so that the spool survives a restart of the
+// process: the segments that are found on creation are replayed first, in
+// order. A packet may thus be replayed twice if the process stopped after
+// sending it but before popping it.
+//
+// This class is not thread-safe.
+class PacketSpool {
+ public:
+  struct Options {
+    // The directory of the segment files. It is created if needed, and must
+    // not be shared with another spool.
+    std::string directory;
+
+    // The most disk space that the segments may take.
+    int64_t max_bytes = int64_t{1} << 30;
+
+    // The size after which a segment is closed and a new one is started.
+    int64_t segment_bytes = int64_t{16} << 20;
+  };
+
+  // Creates a spool, which resumes from the segments left in `directory`.
+  static absl::StatusOr<std::unique_ptr<PacketSpool>> Create(
+      const Options& options);
+
+  ~PacketSpool();
+
+  // Appends `packet` to the back of the spool.
+  //
+  // Returns RESOURCE_EXHAUSTED if the spool has no room left for it.
+  absl::Status Append(const Packet& packet);
+
+  // Returns the packet at the front of the spool.
+  //
+  // Returns NOT_FOUND if the spool is empty.
+  absl::StatusOr<Packet> Front();
+
+  // Removes the packet at the front of the spool.
+  //
+  // Returns NOT_FOUND if the spool is empty.
+  absl::Status PopFront();
+
+  // Returns true if there is no packet in the spool.
+  bool empty() const { return num_packets_ == 0; }
+
+  // Returns the number of packets in the spool.
+  int64_t num_packets() const { return num_packets_; }
+
+  // Returns the disk space taken by the segments.
+  int64_t num_bytes() const { return num_bytes_; }
+
+  PacketSpool(const PacketSpool&) = delete;
+  PacketSpool& operator=(const PacketSpool&) = delete;
+
+ private:
+  struct Segment {
+    int64_t index = 0;
+    std::string path;
+    int64_t num_bytes = 0;
+    int64_t num_packets = 0;
+  };
+
+  explicit PacketSpool(const Options& options);
+
+  // Takes over the segments found in the directory.
+  absl::Status Recover();
+
+  // Closes the back segment and starts a new one.
+  absl::Status StartSegment();
+
+  // Deletes the front segment, which has no packet left to read.
+  void DeleteHead();
+
+  const Options options_;
+
+  // The segments, from the oldest to the newest. Appends go to the back one
+  // while `writer_` is open; otherwise, a new one is started first.
+  std::deque<Segment> segments_;
+  std::ofstream writer_;
+  int64_t next_index_ = 0;
+
+  // The reads of the front segment, and the cached front packet.
+  std::ifstream reader_;
+  int64_t num_read_ = 0;
+  absl::optional<Packet> front_;
+
+  int64_t num_packets_ = 0;
+  int64_t num_bytes_ = 0;
+};
+
+}  // namespace visionai
+
+#endif  // THIRD_PARTY_VISIONAI_STREAMS_UTIL_PACKET_SPOOL_H_
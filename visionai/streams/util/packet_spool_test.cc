@@ -0,0 +1,160 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/streams/util/packet_spool.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "visionai/streams/packet/packet.h"
+#include "visionai/util/file_helpers.h"
+#include "visionai/util/file_path.h"
+
+namespace visionai {
+namespace {
+
+Packet MakeTestPacket(const std::string& payload) {
+  Packet packet;
+  packet.set_payload(payload);
+  return packet;
+}
+
+class PacketSpoolTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    options_.directory = file::JoinPath(
+        ::testing::TempDir(),
+        ::testing::UnitTest::GetInstance()->current_test_info()->name());
+    ASSERT_TRUE(RecursivelyCreateDir(options_.directory).ok());
+    ASSERT_TRUE(DeleteFilesInDir(options_.directory).ok());
+  }
+
+  std::unique_ptr<PacketSpool> CreateSpool() {
+    auto spool = PacketSpool::Create(options_);
+    EXPECT_TRUE(spool.ok()) << spool.status();
+    return spool.ok() ? *std::move(spool) : nullptr;
+  }
+
+  // Pops the front packet and returns its payload.
+  std::string PopPayload(PacketSpool* spool) {
+    auto packet = spool->Front();
+    EXPECT_TRUE(packet.ok()) << packet.status();
+    EXPECT_TRUE(spool->PopFront().ok());
+    return packet.ok() ? packet->payload() : "";
+  }
+
+  PacketSpool::Options options_;
+};
+
+TEST_F(PacketSpoolTest, PopsInOrder) {
+  auto spool = CreateSpool();
+  ASSERT_NE(spool, nullptr);
+  EXPECT_TRUE(spool->empty());
+  EXPECT_EQ(spool->Front().status().code(), absl::StatusCode::kNotFound);
+
+  ASSERT_TRUE(spool->Append(MakeTestPacket("a")).ok());
+  ASSERT_TRUE(spool->Append(MakeTestPacket("b")).ok());
+  EXPECT_EQ(spool->num_packets(), 2);
+  EXPECT_EQ(PopPayload(spool.get()), "a");
+
+  // Appends may interleave with the pops.
+  ASSERT_TRUE(spool->Append(MakeTestPacket("c")).ok());
+  EXPECT_EQ(PopPayload(spool.get()), "b");
+  EXPECT_EQ(PopPayload(spool.get()), "c");
+  EXPECT_TRUE(spool->empty());
+  EXPECT_EQ(spool->num_bytes(), 0);
+  EXPECT_EQ(spool->PopFront().code(), absl::StatusCode::kNotFound);
+}
+
+TEST_F(PacketSpoolTest, DeletesTheSegmentsOnceRead) {
+  options_.segment_bytes = 1;
+  auto spool = CreateSpool();
+  ASSERT_NE(spool, nullptr);
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(spool->Append(MakeTestPacket(absl::StrCat(i))).ok());
+  }
+  std::string first_segment =
+      file::JoinPath(options_.directory, "00000000000000000000.spool");
+  std::string last_segment =
+      file::JoinPath(options_.directory, "00000000000000000002.spool");
+  EXPECT_TRUE(FileExists(first_segment).ok());
+  EXPECT_TRUE(FileExists(last_segment).ok());
+
+  EXPECT_EQ(PopPayload(spool.get()), "0");
+  EXPECT_FALSE(FileExists(first_segment).ok());
+  EXPECT_EQ(PopPayload(spool.get()), "1");
+  EXPECT_EQ(PopPayload(spool.get()), "2");
+  EXPECT_FALSE(FileExists(last_segment).ok());
+}
+
+TEST_F(PacketSpoolTest, RejectsPacketsWhenFull) {
+  auto spool = CreateSpool();
+  ASSERT_NE(spool, nullptr);
+  ASSERT_TRUE(spool->Append(MakeTestPacket("a")).ok());
+  options_.max_bytes = spool->num_bytes();
+  ASSERT_TRUE(spool->PopFront().ok());
+
+  spool = nullptr;
+  spool = CreateSpool();
+  ASSERT_NE(spool, nullptr);
+  ASSERT_TRUE(spool->Append(MakeTestPacket("a")).ok());
+  EXPECT_EQ(spool->Append(MakeTestPacket("b")).code(),
+            absl::StatusCode::kResourceExhausted);
+  EXPECT_EQ(PopPayload(spool.get()), "a");
+  EXPECT_TRUE(spool->Append(MakeTestPacket("b")).ok());
+  EXPECT_EQ(PopPayload(spool.get()), "b");
+}
+
+TEST_F(PacketSpoolTest, ResumesFromTheSegmentsLeftBehind) {
+  options_.segment_bytes = 1;
+  {
+    auto spool = CreateSpool();
+    ASSERT_NE(spool, nullptr);
+    for (int i = 0; i < 3; ++i) {
+      ASSERT_TRUE(spool->Append(MakeTestPacket(absl::StrCat(i))).ok());
+    }
+    EXPECT_EQ(PopPayload(spool.get()), "0");
+  }
+
+  auto spool = CreateSpool();
+  ASSERT_NE(spool, nullptr);
+  EXPECT_EQ(spool->num_packets(), 2);
+  ASSERT_TRUE(spool->Append(MakeTestPacket("3")).ok());
+  EXPECT_EQ(PopPayload(spool.get()), "1");
+  EXPECT_EQ(PopPayload(spool.get()), "2");
+  EXPECT_EQ(PopPayload(spool.get()), "3");
+  EXPECT_TRUE(spool->empty());
+}
+
+TEST_F(PacketSpoolTest, IgnoresATruncatedRecord) {
+  {
+    auto spool = CreateSpool();
+    ASSERT_NE(spool, nullptr);
+    ASSERT_TRUE(spool->Append(MakeTestPacket("a")).ok());
+    ASSERT_TRUE(spool->Append(MakeTestPacket("b")).ok());
+  }
+  // A record that was cut short by a crash.
+  ASSERT_TRUE(SetFileContents(file::JoinPath(options_.directory,
+                                             "00000000000000000000.spool"),
+                              std::string("\x10\0\0\0ab", 6),
+                              /*should_append=*/true)
+                  .ok());
+
+  auto spool = CreateSpool();
+  ASSERT_NE(spool, nullptr);
+  EXPECT_EQ(spool->num_packets(), 2);
+  ASSERT_TRUE(spool->Append(MakeTestPacket("c")).ok());
+  EXPECT_EQ(PopPayload(spool.get()), "a");
+  EXPECT_EQ(PopPayload(spool.get()), "b");
+  EXPECT_EQ(PopPayload(spool.get()), "c");
+}
+
+}  // namespace
+}  // namespace visionai
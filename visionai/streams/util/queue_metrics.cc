@@ -0,0 +1,57 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/streams/util/queue_metrics.h"
+
+#include <map>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "visionai/proto/ingester_config.pb.h"
+#include "visionai/util/telemetry/metrics/stats.h"
+
+namespace visionai {
+
+QueueMetrics::QueueMetrics(absl::string_view stream_id,
+                           absl::string_view stage, size_t capacity) {
+  std::map<std::string, std::string> labels = {
+      {"stream_id", std::string(stream_id)}, {"stage", std::string(stage)}};
+  ingester_queue_capacity().Add(labels).Set(capacity);
+  occupancy_ = &ingester_queue_occupancy().Add(labels);
+  pushed_ = &ingester_queue_pushed_total().Add(labels);
+  popped_ = &ingester_queue_popped_total().Add(labels);
+  dropped_ = &ingester_queue_dropped_total().Add(labels);
+}
+
+QueueMetrics::~QueueMetrics() { occupancy_->Decrement(count_.load()); }
+
+void QueueMetrics::RecordPush(bool evicted) {
+  pushed_->Increment();
+  if (evicted) {
+    dropped_->Increment();
+    return;
+  }
+  ++count_;
+  occupancy_->Increment();
+}
+
+void QueueMetrics::RecordPop() {
+  popped_->Increment();
+  --count_;
+  occupancy_->Decrement();
+}
+
+void QueueMetrics::RecordDrop() { dropped_->Increment(); }
+
+std::string GetQueueMetricsStreamId(const EventWriterConfig& config) {
+  auto it = config.attr().find("stream_id");
+  if (it == config.attr().end()) {
+    return "";
+  }
+  return it->second;
+}
+
+}  // namespace visionai
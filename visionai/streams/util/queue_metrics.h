@@ -0,0 +1,78 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef THIRD_PARTY_VISIONAI_STREAMS_UTIL_QUEUE_METRICS_H_
+#define THIRD_PARTY_VISIONAI_STREAMS_UTIL_QUEUE_METRICS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "prometheus/counter.h"
+#include "prometheus/gauge.h"
+#include "absl/strings/string_view.h"
+#include "visionai/proto/ingester_config.pb.h"
+
+namespace visionai {
+
+// Reports the traffic through one of the queues between the stages of the
+// ingester dataflow.
+//
+// The metrics are the `ingester_queue_*` Prometheus families, labeled with the
+// stream id and the stage of the wait in the queue, e.g.
+// `kCaptureOutputBufferStage` of streams/util/stage_trace.h:
+//
+// + `ingester_queue_capacity`: the capacity of the queue.
+// + `ingester_queue_occupancy`: the number of elements waiting in the queue.
+// + `ingester_queue_pushed_total`: the elements that entered the queue.
+// + `ingester_queue_popped_total`: the elements that left the queue.
+// + `ingester_queue_dropped_total`: the elements that were lost because the
+//   queue was full, whether they were rejected or evicted by a newer element.
+//
+// Several queues may share the same labels, e.g. the write buffers of the
+// overlapping events of a stream. Their occupancies then add up, and each
+// instance takes back whatever it leaves in the occupancy on destruction.
+//
+// This class is thread-safe, and its methods never block.
+class QueueMetrics {
+ public:
+  QueueMetrics(absl::string_view stream_id, absl::string_view stage,
+               size_t capacity);
+  ~QueueMetrics();
+
+  // Records that an element was pushed into the queue.
+  //
+  // `evicted` is true if the queue was full, and the oldest element was
+  // overwritten to make room for the new one.
+  void RecordPush(bool evicted = false);
+
+  // Records that an element was popped from the queue.
+  void RecordPop();
+
+  // Records that an element was rejected because the queue was full.
+  void RecordDrop();
+
+  QueueMetrics(const QueueMetrics&) = delete;
+  QueueMetrics& operator=(const QueueMetrics&) = delete;
+
+ private:
+  prometheus::Gauge* occupancy_;
+  prometheus::Counter* pushed_;
+  prometheus::Counter* popped_;
+  prometheus::Counter* dropped_;
+
+  // The contribution of this instance to `occupancy_`.
+  std::atomic<int64_t> count_{0};
+};
+
+// Returns the stream id with which to label the queues that feed `config`,
+// i.e. its "stream_id" attribute, or an empty string if it has none.
+std::string GetQueueMetricsStreamId(const EventWriterConfig& config);
+
+}  // namespace visionai
+
+#endif  // THIRD_PARTY_VISIONAI_STREAMS_UTIL_QUEUE_METRICS_H_
@@ -0,0 +1,80 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/streams/util/queue_metrics.h"
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "visionai/proto/ingester_config.pb.h"
+#include "visionai/util/telemetry/metrics/stats.h"
+
+namespace visionai {
+namespace {
+
+std::map<std::string, std::string> Labels(const std::string& stream_id,
+                                          const std::string& stage) {
+  return {{"stream_id", stream_id}, {"stage", stage}};
+}
+
+TEST(QueueMetricsTest, RecordsPushesAndPops) {
+  auto labels = Labels("push-pop", "filter");
+  QueueMetrics metrics("push-pop", "filter", 8);
+  EXPECT_EQ(ingester_queue_capacity().Add(labels).Value(), 8);
+
+  metrics.RecordPush();
+  metrics.RecordPush();
+  metrics.RecordPop();
+  EXPECT_EQ(ingester_queue_pushed_total().Add(labels).Value(), 2);
+  EXPECT_EQ(ingester_queue_popped_total().Add(labels).Value(), 1);
+  EXPECT_EQ(ingester_queue_dropped_total().Add(labels).Value(), 0);
+  EXPECT_EQ(ingester_queue_occupancy().Add(labels).Value(), 1);
+}
+
+TEST(QueueMetricsTest, RecordsDrops) {
+  auto labels = Labels("drop", "filter");
+  QueueMetrics metrics("drop", "filter", 1);
+
+  metrics.RecordPush();
+  metrics.RecordDrop();
+  EXPECT_EQ(ingester_queue_pushed_total().Add(labels).Value(), 1);
+  EXPECT_EQ(ingester_queue_dropped_total().Add(labels).Value(), 1);
+  EXPECT_EQ(ingester_queue_occupancy().Add(labels).Value(), 1);
+
+  // An eviction replaces the oldest element, so the occupancy stays the same.
+  metrics.RecordPush(/*evicted=*/true);
+  EXPECT_EQ(ingester_queue_pushed_total().Add(labels).Value(), 2);
+  EXPECT_EQ(ingester_queue_dropped_total().Add(labels).Value(), 2);
+  EXPECT_EQ(ingester_queue_occupancy().Add(labels).Value(), 1);
+}
+
+TEST(QueueMetricsTest, SharedLabelsAddUp) {
+  auto labels = Labels("shared", "depositor");
+  auto first = std::make_unique<QueueMetrics>("shared", "depositor", 4);
+  auto second = std::make_unique<QueueMetrics>("shared", "depositor", 4);
+  first->RecordPush();
+  first->RecordPush();
+  second->RecordPush();
+  EXPECT_EQ(ingester_queue_occupancy().Add(labels).Value(), 3);
+
+  // The elements left behind no longer count once their queue is gone.
+  first.reset();
+  EXPECT_EQ(ingester_queue_occupancy().Add(labels).Value(), 1);
+  second->RecordPop();
+  EXPECT_EQ(ingester_queue_occupancy().Add(labels).Value(), 0);
+}
+
+TEST(QueueMetricsTest, GetQueueMetricsStreamId) {
+  EventWriterConfig config;
+  EXPECT_EQ(GetQueueMetricsStreamId(config), "");
+  (*config.mutable_attr())["stream_id"] = "my-stream";
+  EXPECT_EQ(GetQueueMetricsStreamId(config), "my-stream");
+}
+
+}  // namespace
+}  // namespace visionai
@@ -0,0 +1,103 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/streams/util/stage_trace.h"
+
+#include <cstdint>
+#include <string>
+
+#include "google/protobuf/struct.pb.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "visionai/streams/packet/packet.h"
+#include "visionai/util/telemetry/metrics/stats.h"
+
+namespace visionai {
+
+namespace {
+
+// The metadata field that holds the end of the previous stage of a traced
+// packet, in microseconds since the Unix epoch. Doubles represent these
+// exactly for the next couple of centuries.
+constexpr char kStageTraceField[] = "visionai_stage_trace_us";
+
+// Returns the end of the previous stage of `p`, or nullopt if `p` is not
+// traced.
+absl::optional<absl::Time> GetStageMark(const Packet& p) {
+  const auto& fields = p.header().metadata().fields();
+  auto it = fields.find(kStageTraceField);
+  if (it == fields.end()) {
+    return absl::nullopt;
+  }
+  return absl::FromUnixMicros(static_cast<int64_t>(it->second.number_value()));
+}
+
+void SetStageMark(absl::Time t, Packet* p) {
+  auto* fields = p->mutable_header()->mutable_metadata()->mutable_fields();
+  (*fields)[kStageTraceField].set_number_value(
+      static_cast<double>(absl::ToUnixMicros(t)));
+}
+
+}  // namespace
+
+absl::Status StartStageTrace(Packet* p) {
+  if (p == nullptr) {
+    return absl::InvalidArgumentError("Given a nullptr to a Packet");
+  }
+  absl::Time now = absl::Now();
+  RecordStageLatency(kCaptureStage, GetCaptureTime(*p), now);
+  SetStageMark(now, p);
+  return absl::OkStatus();
+}
+
+bool IsStageTraced(const Packet& p) {
+  return p.header().metadata().fields().contains(kStageTraceField);
+}
+
+absl::Status TraceStage(absl::string_view stage, Packet* p) {
+  if (p == nullptr) {
+    return absl::InvalidArgumentError("Given a nullptr to a Packet");
+  }
+  absl::optional<absl::Time> mark = GetStageMark(*p);
+  if (!mark.has_value()) {
+    return absl::OkStatus();
+  }
+  absl::Time now = absl::Now();
+  RecordStageLatency(stage, *mark, now);
+  SetStageMark(now, p);
+  return absl::OkStatus();
+}
+
+absl::optional<absl::Time> EndStageTrace(absl::string_view stage, Packet* p) {
+  if (p == nullptr) {
+    return absl::nullopt;
+  }
+  absl::optional<absl::Time> mark = GetStageMark(*p);
+  if (!mark.has_value()) {
+    return absl::nullopt;
+  }
+  absl::Time now = absl::Now();
+  RecordStageLatency(stage, *mark, now);
+  p->mutable_header()->mutable_metadata()->mutable_fields()->erase(
+      kStageTraceField);
+  return now;
+}
+
+void RecordStageLatency(absl::string_view stage, absl::Time start,
+                        absl::Time end) {
+  // Packets whose capture time is unset report the Unix epoch instead.
+  if (start <= absl::UnixEpoch()) {
+    return;
+  }
+  ingester_stage_latency_ms()
+      .Add({{"stage", std::string(stage)}}, latency_boundaries_ms)
+      .Observe(absl::ToDoubleMilliseconds(end - start));
+}
+
+}  // namespace visionai
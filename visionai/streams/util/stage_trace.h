@@ -0,0 +1,80 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef THIRD_PARTY_VISIONAI_STREAMS_UTIL_STAGE_TRACE_H_
+#define THIRD_PARTY_VISIONAI_STREAMS_UTIL_STAGE_TRACE_H_
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "visionai/streams/packet/packet.h"
+
+namespace visionai {
+
+// ----------------------------------------------------------------------------
+// Stage tracing
+// ----------------------------------------------------------------------------
+//
+// Per stage latency tracing of the packets that flow through the ingester.
+//
+// A traced packet carries the time at which its previous stage ended in its
+// metadata. Every stage that it goes through records the time elapsed since
+// then into the `ingester_stage_latency_ms` Prometheus histogram, labeled with
+// the name of the stage, and moves the mark to the current time.
+//
+// Packets that are not traced go through all of the stages untouched, so that
+// tracing is enabled simply by starting the trace of the captured packets. A
+// filter that creates new packets rather than passing its inputs through
+// starts over without a trace.
+
+// The stages of the ingester dataflow, in order. Each one ends at the point
+// given in its comment.
+
+// The capture of the packet, from its capture time to `Capture` push.
+constexpr char kCaptureStage[] = "capture";
+// The wait in the capture output buffer, to `Filter` poll.
+constexpr char kCaptureOutputBufferStage[] = "capture_output_buffer";
+// The filtering of the packet, to `Filter` push.
+constexpr char kFilterStage[] = "filter";
+// The wait in the filter output buffer, to the depositor pop.
+constexpr char kFilterOutputBufferStage[] = "filter_output_buffer";
+// The handling in the depositor, to `EventSink::Write`.
+constexpr char kDepositorStage[] = "depositor";
+// The wait in the event sink write buffer, to `EventWriter::Write`.
+constexpr char kEventSinkBufferStage[] = "event_sink_buffer";
+// The `EventWriter::Write` call, which includes any network send.
+constexpr char kEventWriterStage[] = "event_writer";
+// The whole dataflow, from the capture time to the end of the write.
+constexpr char kTotalStage[] = "total";
+
+// Starts tracing `p`, and records its capture stage until now.
+absl::Status StartStageTrace(Packet* p);
+
+// Returns true if `p` is traced.
+bool IsStageTraced(const Packet& p);
+
+// Records `stage` of `p`, from the end of its previous stage until now.
+//
+// Does nothing if `p` is not traced.
+absl::Status TraceStage(absl::string_view stage, Packet* p);
+
+// Same as `TraceStage`, but also removes the trace from `p`, so that it never
+// leaves the process.
+//
+// Returns the time at which the stage ended, or nullopt if `p` is not traced.
+absl::optional<absl::Time> EndStageTrace(absl::string_view stage, Packet* p);
+
+// Records that `stage` started at `start` and ended at `end`.
+//
+// Does nothing if `start` is not after the Unix epoch, which is what an unset
+// capture time reads as.
+void RecordStageLatency(absl::string_view stage, absl::Time start,
+                        absl::Time end);
+
+}  // namespace visionai
+
+#endif  // THIRD_PARTY_VISIONAI_STREAMS_UTIL_STAGE_TRACE_H_
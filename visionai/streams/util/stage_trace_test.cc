@@ -0,0 +1,92 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/streams/util/stage_trace.h"
+
+#include <cstdint>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "prometheus/metric_family.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "visionai/streams/packet/packet.h"
+#include "visionai/util/telemetry/metrics/stats.h"
+
+namespace visionai {
+namespace {
+
+// Returns the number of latencies recorded for `stage` so far.
+uint64_t SampleCount(absl::string_view stage) {
+  for (const auto& family : ingester_stage_latency_ms().Collect()) {
+    for (const auto& metric : family.metric) {
+      for (const auto& label : metric.label) {
+        if (label.name == "stage" && label.value == stage) {
+          return metric.histogram.sample_count;
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+TEST(StageTraceTest, UntracedPacketsAreUntouched) {
+  auto p = MakePacket(std::string("hello"));
+  ASSERT_TRUE(p.ok());
+  uint64_t filter_count = SampleCount(kFilterStage);
+
+  EXPECT_FALSE(IsStageTraced(*p));
+  EXPECT_TRUE(TraceStage(kFilterStage, &*p).ok());
+  EXPECT_FALSE(EndStageTrace(kEventSinkBufferStage, &*p).has_value());
+  EXPECT_TRUE(p->header().metadata().fields().empty());
+  EXPECT_EQ(SampleCount(kFilterStage), filter_count);
+}
+
+TEST(StageTraceTest, TracesEachStage) {
+  auto p = MakePacket(std::string("hello"));
+  ASSERT_TRUE(p.ok());
+  uint64_t capture_count = SampleCount(kCaptureStage);
+  uint64_t filter_count = SampleCount(kFilterStage);
+  uint64_t buffer_count = SampleCount(kEventSinkBufferStage);
+
+  absl::Time start = absl::Now();
+  ASSERT_TRUE(StartStageTrace(&*p).ok());
+  EXPECT_TRUE(IsStageTraced(*p));
+  EXPECT_EQ(SampleCount(kCaptureStage), capture_count + 1);
+
+  ASSERT_TRUE(TraceStage(kFilterStage, &*p).ok());
+  EXPECT_TRUE(IsStageTraced(*p));
+  EXPECT_EQ(SampleCount(kFilterStage), filter_count + 1);
+
+  absl::optional<absl::Time> end = EndStageTrace(kEventSinkBufferStage, &*p);
+  ASSERT_TRUE(end.has_value());
+  EXPECT_GE(*end, start);
+  EXPECT_LE(*end, absl::Now());
+  EXPECT_EQ(SampleCount(kEventSinkBufferStage), buffer_count + 1);
+
+  // The trace never leaves the process.
+  EXPECT_FALSE(IsStageTraced(*p));
+  EXPECT_TRUE(p->header().metadata().fields().empty());
+}
+
+TEST(StageTraceTest, SkipsUnsetCaptureTime) {
+  Packet p;
+  uint64_t capture_count = SampleCount(kCaptureStage);
+  ASSERT_TRUE(StartStageTrace(&p).ok());
+  EXPECT_TRUE(IsStageTraced(p));
+  EXPECT_EQ(SampleCount(kCaptureStage), capture_count);
+}
+
+TEST(StageTraceTest, NullPacket) {
+  EXPECT_FALSE(StartStageTrace(nullptr).ok());
+  EXPECT_FALSE(TraceStage(kFilterStage, nullptr).ok());
+  EXPECT_FALSE(EndStageTrace(kFilterStage, nullptr).has_value());
+}
+
+}  // namespace
+}  // namespace visionai
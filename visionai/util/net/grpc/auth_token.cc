@@ -8,12 +8,13 @@
 
 #include "src/core/lib/security/credentials/jwt/json_token.h"
 #include "include/grpc/support/alloc.h"
+#include "absl/time/time.h"
 
 namespace visionai {
 
 namespace {
-// Token should expire in 1 hour.
-const gpr_timespec TOKEN_LIFETIME = {3600, 0, GPR_TIMESPAN};
+const gpr_timespec TOKEN_LIFETIME = {
+    absl::ToInt64Seconds(kJwtLifetime), 0, GPR_TIMESPAN};
 }  // namespace
 
 absl::StatusOr<std::string> GetJwt(const std::string& json_secret,
@@ -12,9 +12,13 @@
 #include <string>
 
 #include "absl/status/statusor.h"
+#include "absl/time/time.h"
 
 namespace visionai {
 
+// The lifetime of the JWTs generated by `GetJwt`.
+constexpr absl::Duration kJwtLifetime = absl::Hours(1);
+
 // GetJwt generates the JWT from json secret with audience.
 absl::StatusOr<std::string> GetJwt(const std::string& json_secret,
                                    const std::string& audience);
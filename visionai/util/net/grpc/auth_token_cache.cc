@@ -0,0 +1,168 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/util/net/grpc/auth_token_cache.h"
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "visionai/util/file_helpers.h"
+#include "visionai/util/status/status_macros.h"
+
+namespace visionai {
+
+AuthTokenCache* AuthTokenCache::Global() {
+  static AuthTokenCache* global_cache = new AuthTokenCache(Options());
+  return global_cache;
+}
+
+AuthTokenCache::AuthTokenCache(Options options)
+    : options_(std::move(options)) {}
+
+AuthTokenCache::~AuthTokenCache() {
+  std::thread refresher;
+  {
+    absl::MutexLock lock(&mu_);
+    is_stopping_ = true;
+    cv_.Signal();
+    refresher = std::move(refresher_);
+  }
+  if (refresher.joinable()) {
+    refresher.join();
+  }
+}
+
+absl::StatusOr<std::string> AuthTokenCache::GetToken(
+    absl::string_view key_path, absl::string_view audience) {
+  Key key = {std::string(key_path), std::string(audience)};
+  std::string token;
+  {
+    absl::MutexLock lock(&mu_);
+    if (LookUp(key, &token)) {
+      return token;
+    }
+  }
+
+  absl::MutexLock sign_lock(&sign_mu_);
+  {
+    // Another client may have signed the token while this one waited.
+    absl::MutexLock lock(&mu_);
+    if (LookUp(key, &token)) {
+      return token;
+    }
+  }
+  std::string json_key;
+  VAI_RETURN_IF_ERROR(GetFileContents(key.first, &json_key));
+  VAI_ASSIGN_OR_RETURN(Entry entry, Sign(std::move(json_key), key.second));
+  token = entry.token;
+
+  absl::MutexLock lock(&mu_);
+  entries_[key] = std::move(entry);
+  if (!refresher_.joinable()) {
+    refresher_ = std::thread([this]() { RefreshMain(); });
+  }
+  cv_.Signal();
+  return token;
+}
+
+absl::StatusOr<AuthTokenCache::Entry> AuthTokenCache::Sign(
+    std::string json_key, const std::string& audience) {
+  absl::Time now = absl::Now();
+  VAI_ASSIGN_OR_RETURN(std::string token, options_.signer(json_key, audience));
+  Entry entry;
+  entry.json_key = std::move(json_key);
+  entry.token = std::move(token);
+  entry.expiry = now + options_.token_lifetime;
+  entry.next_refresh = entry.expiry - options_.refresh_margin;
+  return entry;
+}
+
+bool AuthTokenCache::LookUp(const Key& key, std::string* token) {
+  auto it = entries_.find(key);
+  if (it == entries_.end() || absl::Now() >= it->second.expiry) {
+    return false;
+  }
+  *token = it->second.token;
+  return true;
+}
+
+absl::Time AuthTokenCache::NextRefresh() {
+  absl::Time next_refresh = absl::InfiniteFuture();
+  for (const auto& p : entries_) {
+    next_refresh = std::min(next_refresh, p.second.next_refresh);
+  }
+  return next_refresh;
+}
+
+void AuthTokenCache::RefreshMain() {
+  while (true) {
+    // Wait for the next entries that are due, and take a copy of their keys.
+    std::vector<std::pair<Key, std::string>> due;
+    {
+      absl::MutexLock lock(&mu_);
+      while (!is_stopping_) {
+        absl::Time next_refresh = NextRefresh();
+        if (absl::Now() >= next_refresh) {
+          break;
+        }
+        cv_.WaitWithDeadline(&mu_, next_refresh);
+      }
+      if (is_stopping_) {
+        return;
+      }
+      absl::Time now = absl::Now();
+      for (const auto& p : entries_) {
+        if (p.second.next_refresh <= now) {
+          due.emplace_back(p.first, p.second.json_key);
+        }
+      }
+    }
+
+    // Sign without holding `mu_`, so that the clients keep reading the
+    // current tokens in the meantime.
+    for (auto& d : due) {
+      // Read the key file again, so that a rotated key is picked up.
+      std::string json_key;
+      absl::Status read_status = GetFileContents(d.first.first, &json_key);
+      if (!read_status.ok()) {
+        LOG(WARNING) << "Failed to read the key file " << d.first.first
+                     << " again; refreshing the token with the key read "
+                        "before: "
+                     << read_status;
+        json_key = std::move(d.second);
+      }
+      absl::StatusOr<Entry> entry;
+      {
+        absl::MutexLock sign_lock(&sign_mu_);
+        entry = Sign(std::move(json_key), d.first.second);
+      }
+      absl::MutexLock lock(&mu_);
+      auto it = entries_.find(d.first);
+      if (it == entries_.end()) {
+        continue;
+      }
+      if (entry.ok()) {
+        it->second = *std::move(entry);
+      } else {
+        LOG(WARNING) << "Failed to refresh the token for audience \""
+                     << d.first.second << "\": " << entry.status();
+        it->second.next_refresh =
+            absl::Now() + options_.refresh_retry_interval;
+      }
+    }
+  }
+}
+
+}  // namespace visionai
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file or at
+ * https://developers.google.com/open-source/licenses/bsd
+ */
+
+#ifndef THIRD_PARTY_VISIONAI_UTIL_NET_GRPC_AUTH_TOKEN_CACHE_H_
+#define THIRD_PARTY_VISIONAI_UTIL_NET_GRPC_AUTH_TOKEN_CACHE_H_
+
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "visionai/util/net/grpc/auth_token.h"
+
+namespace visionai {
+
+// A cache of the JWTs that authenticate the clients of the data plane.
+//
+// Signing a JWT means reading the service account key from disk and doing an
+// RSA signature. The cache does it once per key file and audience, and shares
+// the token among all of the clients that connect afterwards. A background
+// thread signs a new token some time before the current one expires, so that
+// the clients never wait for a signature after the first one, even when they
+// all reconnect at once. It reads the key file again for every refresh, so
+// that a rotated key is picked up, and only falls back to the key it read
+// before if the file can't be read.
+//
+// This class is thread-safe.
+class AuthTokenCache {
+ public:
+  // Signs a token for `audience` with the contents of a JSON key file.
+  using Signer = std::function<absl::StatusOr<std::string>(
+      const std::string& json_key, const std::string& audience)>;
+
+  struct Options {
+    // The function that signs new tokens.
+    Signer signer = GetJwt;
+
+    // The lifetime of the tokens produced by `signer`.
+    absl::Duration token_lifetime = kJwtLifetime;
+
+    // How long before its expiry to replace a token.
+    absl::Duration refresh_margin = absl::Minutes(5);
+
+    // How long to wait before retrying a failed refresh.
+    absl::Duration refresh_retry_interval = absl::Seconds(10);
+  };
+
+  // Returns the cache shared by the whole process.
+  static AuthTokenCache* Global();
+
+  explicit AuthTokenCache(Options options);
+  ~AuthTokenCache();
+
+  // Returns a valid token for `audience`, signed with the JSON key stored at
+  // `key_path`.
+  //
+  // The key file is read the first time that a token is requested for the
+  // pair, and the token is then kept fresh in the background.
+  absl::StatusOr<std::string> GetToken(absl::string_view key_path,
+                                       absl::string_view audience);
+
+  AuthTokenCache(const AuthTokenCache&) = delete;
+  AuthTokenCache& operator=(const AuthTokenCache&) = delete;
+
+ private:
+  using Key = std::pair<std::string, std::string>;
+
+  struct Entry {
+    std::string json_key;
+    std::string token;
+    absl::Time expiry;
+    absl::Time next_refresh;
+  };
+
+  // Signs a new token for `audience` and returns its entry.
+  absl::StatusOr<Entry> Sign(std::string json_key, const std::string& audience);
+
+  // Receives the token of `key` in `token` if it is still valid. Otherwise,
+  // returns false.
+  bool LookUp(const Key& key, std::string* token)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Returns the earliest time at which an entry is due for a refresh.
+  absl::Time NextRefresh() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // The main loop of `refresher_`.
+  void RefreshMain();
+
+  const Options options_;
+
+  // Serializes the signatures, so that the clients that miss the cache at the
+  // same time sign a single token.
+  absl::Mutex sign_mu_;
+
+  absl::Mutex mu_;
+  absl::CondVar cv_;
+  absl::flat_hash_map<Key, Entry> entries_ ABSL_GUARDED_BY(mu_);
+  bool is_stopping_ ABSL_GUARDED_BY(mu_) = false;
+
+  // Started along with the first entry.
+  std::thread refresher_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace visionai
+
+#endif  // THIRD_PARTY_VISIONAI_UTIL_NET_GRPC_AUTH_TOKEN_CACHE_H_
@@ -0,0 +1,156 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/util/net/grpc/auth_token_cache.h"
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "visionai/util/file_helpers.h"
+
+namespace visionai {
+namespace {
+
+class AuthTokenCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    key_path_ = absl::StrCat(::testing::TempDir(), "/key.json");
+    ASSERT_TRUE(SetFileContents(key_path_, "secret").ok());
+    options_.signer = [this](const std::string& json_key,
+                             const std::string& audience)
+        -> absl::StatusOr<std::string> {
+      if (json_key != "secret") {
+        return absl::InvalidArgumentError("JSON key is invalid.");
+      }
+      return absl::StrCat(audience, "-", ++num_signatures_);
+    };
+  }
+
+  void TearDown() override { std::remove(key_path_.c_str()); }
+
+  std::string key_path_;
+  std::atomic<int> num_signatures_{0};
+  AuthTokenCache::Options options_;
+};
+
+TEST_F(AuthTokenCacheTest, ReusesTokens) {
+  AuthTokenCache cache(options_);
+  auto token = cache.GetToken(key_path_, "a");
+  ASSERT_TRUE(token.ok()) << token.status();
+  EXPECT_EQ(*token, "a-1");
+
+  // The key file is not needed anymore.
+  std::remove(key_path_.c_str());
+  token = cache.GetToken(key_path_, "a");
+  ASSERT_TRUE(token.ok()) << token.status();
+  EXPECT_EQ(*token, "a-1");
+  EXPECT_EQ(num_signatures_, 1);
+}
+
+TEST_F(AuthTokenCacheTest, KeyedByAudience) {
+  AuthTokenCache cache(options_);
+  auto a = cache.GetToken(key_path_, "a");
+  auto b = cache.GetToken(key_path_, "b");
+  ASSERT_TRUE(a.ok()) << a.status();
+  ASSERT_TRUE(b.ok()) << b.status();
+  EXPECT_EQ(*a, "a-1");
+  EXPECT_EQ(*b, "b-2");
+}
+
+TEST_F(AuthTokenCacheTest, RefreshesBeforeExpiry) {
+  options_.token_lifetime = absl::Seconds(10);
+  options_.refresh_margin = absl::Seconds(10) - absl::Milliseconds(50);
+  AuthTokenCache cache(options_);
+  auto token = cache.GetToken(key_path_, "a");
+  ASSERT_TRUE(token.ok()) << token.status();
+  EXPECT_EQ(*token, "a-1");
+
+  absl::Time deadline = absl::Now() + absl::Seconds(10);
+  while (num_signatures_ < 3 && absl::Now() < deadline) {
+    absl::SleepFor(absl::Milliseconds(10));
+  }
+  EXPECT_GE(num_signatures_, 3);
+  token = cache.GetToken(key_path_, "a");
+  ASSERT_TRUE(token.ok()) << token.status();
+  EXPECT_NE(*token, "a-1");
+}
+
+TEST_F(AuthTokenCacheTest, RefreshesWithTheRotatedKey) {
+  absl::Mutex mu;
+  std::vector<std::string> json_keys;
+  auto num_signatures = [&mu, &json_keys]() {
+    absl::MutexLock lock(&mu);
+    return json_keys.size();
+  };
+  auto await_num_signatures = [&num_signatures](size_t n) {
+    absl::Time deadline = absl::Now() + absl::Seconds(10);
+    while (num_signatures() < n && absl::Now() < deadline) {
+      absl::SleepFor(absl::Milliseconds(10));
+    }
+    return num_signatures() >= n;
+  };
+  options_.signer = [&mu, &json_keys](const std::string& json_key,
+                                      const std::string& audience)
+      -> absl::StatusOr<std::string> {
+    absl::MutexLock lock(&mu);
+    json_keys.push_back(json_key);
+    return absl::StrCat(audience, "-", json_keys.size());
+  };
+  options_.token_lifetime = absl::Seconds(10);
+  options_.refresh_margin = absl::Seconds(10) - absl::Milliseconds(50);
+  AuthTokenCache cache(options_);
+  ASSERT_TRUE(cache.GetToken(key_path_, "a").ok());
+
+  // The next refresh signs with the new contents of the key file.
+  ASSERT_TRUE(SetFileContents(key_path_, "rotated").ok());
+  size_t n = num_signatures();
+  ASSERT_TRUE(await_num_signatures(n + 2));
+  {
+    absl::MutexLock lock(&mu);
+    EXPECT_EQ(json_keys.back(), "rotated");
+  }
+
+  // Without the key file, the refreshes fall back to the key read before.
+  std::remove(key_path_.c_str());
+  n = num_signatures();
+  ASSERT_TRUE(await_num_signatures(n + 2));
+  absl::MutexLock lock(&mu);
+  EXPECT_EQ(json_keys.back(), "rotated");
+}
+
+TEST_F(AuthTokenCacheTest, ReadsTheKeyFileAgainOnceExpired) {
+  options_.token_lifetime = absl::ZeroDuration();
+  // Never refresh in the background.
+  options_.refresh_margin = -absl::Hours(1);
+  AuthTokenCache cache(options_);
+  ASSERT_TRUE(cache.GetToken(key_path_, "a").ok());
+  std::remove(key_path_.c_str());
+  EXPECT_FALSE(cache.GetToken(key_path_, "a").ok());
+}
+
+TEST_F(AuthTokenCacheTest, DoesNotCacheErrors) {
+  ASSERT_TRUE(SetFileContents(key_path_, "invalid").ok());
+  AuthTokenCache cache(options_);
+  EXPECT_EQ(cache.GetToken(key_path_, "a").status().code(),
+            absl::StatusCode::kInvalidArgument);
+
+  ASSERT_TRUE(SetFileContents(key_path_, "secret").ok());
+  auto token = cache.GetToken(key_path_, "a");
+  ASSERT_TRUE(token.ok()) << token.status();
+  EXPECT_EQ(*token, "a-1");
+}
+
+}  // namespace
+}  // namespace visionai
@@ -20,8 +20,7 @@
 #include "include/grpcpp/support/channel_arguments.h"
 #include "visionai/proto/util/net/grpc/connection_options.pb.h"
 #include "visionai/proto/util/net/grpc/connection_options.pb.h"
-#include "visionai/util/file_helpers.h"
-#include "visionai/util/net/grpc/auth_token.h"
+#include "visionai/util/net/grpc/auth_token_cache.h"
 #include "visionai/util/status/status_macros.h"
 #include "visionai/util/time_util.h"
 
@@ -222,12 +221,8 @@ absl::Status SetAuthorizationHeaderFromJsonKey(
     token = std::string(cred);
   } else {
     const char* cred_path = std::getenv(kGoogleApplicationCredentials);
-    // Read json key file.
-    std::string file_contents;
-    VAI_RETURN_IF_ERROR(GetFileContents(cred_path, &file_contents));
-
-    VAI_ASSIGN_OR_RETURN(token,
-                         GetJwt(file_contents, GetAudience(target_address)));
+    VAI_ASSIGN_OR_RETURN(token, AuthTokenCache::Global()->GetToken(
+                                    cred_path, GetAudience(target_address)));
   }
 
   connection_options.mutable_client_context_options()
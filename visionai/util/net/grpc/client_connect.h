@@ -56,6 +56,9 @@ std::unique_ptr<::grpc::ClientContext> CreateClientContext(
 // will check if the GOOGLE_APPLICATION_CREDENTIALS is set and the target
 // address has the visionai.goog suffix. This function is expected to be called
 // by SeriesServer client and EventWatcher client only.
+//
+// The tokens signed with the json key are shared through
+// `AuthTokenCache::Global()`, so that the key is only read once per process.
 absl::Status SetAuthorizationHeaderFromJsonKey(
     absl::string_view target_address,
     ::visionai::ConnectionOptions&
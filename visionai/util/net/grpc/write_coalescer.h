@@ -0,0 +1,210 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file or at
+ * https://developers.google.com/open-source/licenses/bsd
+ */
+
+#ifndef THIRD_PARTY_VISIONAI_UTIL_NET_GRPC_WRITE_COALESCER_H_
+#define THIRD_PARTY_VISIONAI_UTIL_NET_GRPC_WRITE_COALESCER_H_
+
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+
+namespace visionai {
+
+// Coalesces the consecutive writes of small messages into a gRPC stream.
+//
+// A gRPC write normally flushes its message onto the wire right away, so that
+// a stream of small messages pays a flush, and an HTTP/2 frame, per message.
+// A write with the buffer hint (`grpc::WriteOptions::set_buffer_hint`) lets
+// gRPC hold the message back instead, and it goes out along with the next
+// write without the hint.
+//
+// The coalescer sets the buffer hint on the writes of small messages that
+// follow each other within `max_delay`. It holds back the last message of a
+// batch, which is then written without the hint, either by the next write or
+// by a background thread once the batch is `max_delay` old. A message is thus
+// never delayed by more than `max_delay`. Isolated messages and large
+// messages are written through right away.
+//
+// `Message` is a protobuf message. The writes may block on flow control.
+//
+// This class is thread-safe, and the writes never run concurrently.
+template <typename Message>
+class WriteCoalescer {
+ public:
+  struct Options {
+    // The longest that a message may be held back. Zero disables coalescing.
+    absl::Duration max_delay = absl::ZeroDuration();
+
+    // The largest message that may be coalesced.
+    size_t max_message_bytes = 16 * 1024;
+
+    // The largest size of a batch of coalesced messages.
+    size_t max_batch_bytes = 64 * 1024;
+  };
+
+  // Writes a message into the stream, with the buffer hint if `buffer_hint` is
+  // true. Returns false if the stream is broken.
+  using WriteFunction =
+      std::function<bool(const Message& message, bool buffer_hint)>;
+
+  WriteCoalescer(const Options& options, WriteFunction write);
+
+  // Stops the background flushes. The message held back, if any, is dropped;
+  // call `Flush` first to write it.
+  ~WriteCoalescer();
+
+  // Writes `message`, or holds it back for at most `max_delay`.
+  //
+  // Returns false if this or an earlier write failed, in which case the
+  // stream is broken and no further writes are attempted.
+  bool Write(Message message) ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Writes the message held back, if any.
+  //
+  // Returns false if this or an earlier write failed.
+  bool Flush() ABSL_LOCKS_EXCLUDED(mu_);
+
+  WriteCoalescer(const WriteCoalescer&) = delete;
+  WriteCoalescer& operator=(const WriteCoalescer&) = delete;
+
+ private:
+  const Options options_;
+  const WriteFunction write_;
+
+  absl::Mutex mu_;
+  absl::CondVar cv_;
+  bool ok_ ABSL_GUARDED_BY(mu_) = true;
+  bool is_stopping_ ABSL_GUARDED_BY(mu_) = false;
+  absl::Time last_write_time_ ABSL_GUARDED_BY(mu_) = absl::InfinitePast();
+
+  // The message held back, and the batch it ends.
+  absl::optional<Message> held_ ABSL_GUARDED_BY(mu_);
+  size_t batch_bytes_ ABSL_GUARDED_BY(mu_) = 0;
+  absl::Time flush_deadline_ ABSL_GUARDED_BY(mu_) = absl::InfiniteFuture();
+
+  // Started along with the first batch.
+  std::thread flusher_ ABSL_GUARDED_BY(mu_);
+
+  bool WriteLocked(const Message& message, bool buffer_hint)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  bool FlushLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void FlusherMain() ABSL_LOCKS_EXCLUDED(mu_);
+};
+
+// --------- Implementation below ---------
+
+template <typename Message>
+WriteCoalescer<Message>::WriteCoalescer(const Options& options,
+                                        WriteFunction write)
+    : options_(options), write_(std::move(write)) {}
+
+template <typename Message>
+WriteCoalescer<Message>::~WriteCoalescer() {
+  std::thread flusher;
+  {
+    absl::MutexLock lock(&mu_);
+    is_stopping_ = true;
+    cv_.Signal();
+    flusher = std::move(flusher_);
+  }
+  if (flusher.joinable()) {
+    flusher.join();
+  }
+}
+
+template <typename Message>
+bool WriteCoalescer<Message>::Write(Message message) {
+  absl::MutexLock lock(&mu_);
+  if (!ok_) {
+    return false;
+  }
+  absl::Time now = absl::Now();
+  size_t size = message.ByteSizeLong();
+  // Only hold back the messages that arrive faster than the latency budget,
+  // so that sparse streams see no added latency at all.
+  bool coalesce = options_.max_delay > absl::ZeroDuration() &&
+                  size <= options_.max_message_bytes &&
+                  now - last_write_time_ < options_.max_delay;
+  last_write_time_ = now;
+
+  // The held message is followed right away, so it may go out buffered.
+  if (held_.has_value()) {
+    if (!WriteLocked(*held_, /*buffer_hint=*/true)) {
+      return false;
+    }
+    held_.reset();
+  }
+  if (!coalesce || batch_bytes_ + size > options_.max_batch_bytes ||
+      now >= flush_deadline_) {
+    batch_bytes_ = 0;
+    flush_deadline_ = absl::InfiniteFuture();
+    return WriteLocked(message, /*buffer_hint=*/false);
+  }
+
+  if (batch_bytes_ == 0) {
+    flush_deadline_ = now + options_.max_delay;
+    if (!flusher_.joinable()) {
+      flusher_ = std::thread([this]() { FlusherMain(); });
+    }
+    cv_.Signal();
+  }
+  batch_bytes_ += size;
+  held_ = std::move(message);
+  return true;
+}
+
+template <typename Message>
+bool WriteCoalescer<Message>::Flush() {
+  absl::MutexLock lock(&mu_);
+  return FlushLocked();
+}
+
+template <typename Message>
+bool WriteCoalescer<Message>::WriteLocked(const Message& message,
+                                          bool buffer_hint) {
+  ok_ = write_(message, buffer_hint);
+  return ok_;
+}
+
+template <typename Message>
+bool WriteCoalescer<Message>::FlushLocked() {
+  batch_bytes_ = 0;
+  flush_deadline_ = absl::InfiniteFuture();
+  if (!ok_) {
+    return false;
+  }
+  if (!held_.has_value()) {
+    return true;
+  }
+  bool ok = WriteLocked(*held_, /*buffer_hint=*/false);
+  held_.reset();
+  return ok;
+}
+
+template <typename Message>
+void WriteCoalescer<Message>::FlusherMain() {
+  absl::MutexLock lock(&mu_);
+  while (!is_stopping_) {
+    if (absl::Now() < flush_deadline_) {
+      cv_.WaitWithDeadline(&mu_, flush_deadline_);
+      continue;
+    }
+    FlushLocked();
+  }
+}
+
+}  // namespace visionai
+
+#endif  // THIRD_PARTY_VISIONAI_UTIL_NET_GRPC_WRITE_COALESCER_H_
@@ -0,0 +1,150 @@
+// Copyright 2023 Google LLC
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "visionai/util/net/grpc/write_coalescer.h"
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace visionai {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Pair;
+
+// A stand-in for a protobuf message.
+struct FakeMessage {
+  std::string payload;
+  size_t ByteSizeLong() const { return payload.size(); }
+};
+
+// Records the writes into a stream.
+class FakeStream {
+ public:
+  WriteCoalescer<FakeMessage>::WriteFunction WriteFunction() {
+    return [this](const FakeMessage& message, bool buffer_hint) {
+      absl::MutexLock lock(&mu_);
+      writes_.emplace_back(message.payload, buffer_hint);
+      return !broken_;
+    };
+  }
+
+  std::vector<std::pair<std::string, bool>> writes() {
+    absl::MutexLock lock(&mu_);
+    return writes_;
+  }
+
+  // Waits for up to `timeout` for `n` writes.
+  bool AwaitWrites(size_t n, absl::Duration timeout) {
+    absl::MutexLock lock(&mu_);
+    auto has_writes = [this, n]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      return writes_.size() >= n;
+    };
+    return mu_.AwaitWithTimeout(absl::Condition(&has_writes), timeout);
+  }
+
+  void Break() {
+    absl::MutexLock lock(&mu_);
+    broken_ = true;
+  }
+
+ private:
+  absl::Mutex mu_;
+  std::vector<std::pair<std::string, bool>> writes_ ABSL_GUARDED_BY(mu_);
+  bool broken_ ABSL_GUARDED_BY(mu_) = false;
+};
+
+WriteCoalescer<FakeMessage>::Options CoalescingOptions(
+    absl::Duration max_delay) {
+  WriteCoalescer<FakeMessage>::Options options;
+  options.max_delay = max_delay;
+  options.max_message_bytes = 4;
+  options.max_batch_bytes = 8;
+  return options;
+}
+
+TEST(WriteCoalescerTest, DisabledByDefault) {
+  FakeStream stream;
+  WriteCoalescer<FakeMessage> coalescer({}, stream.WriteFunction());
+  EXPECT_TRUE(coalescer.Write({"a"}));
+  EXPECT_TRUE(coalescer.Write({"b"}));
+  EXPECT_THAT(stream.writes(), ElementsAre(Pair("a", false), Pair("b", false)));
+}
+
+TEST(WriteCoalescerTest, CoalescesBursts) {
+  FakeStream stream;
+  WriteCoalescer<FakeMessage> coalescer(CoalescingOptions(absl::Hours(1)),
+                                        stream.WriteFunction());
+  // The first message of the burst is isolated so far.
+  EXPECT_TRUE(coalescer.Write({"a"}));
+  EXPECT_TRUE(coalescer.Write({"b"}));
+  EXPECT_TRUE(coalescer.Write({"c"}));
+  EXPECT_TRUE(coalescer.Write({"d"}));
+  EXPECT_THAT(stream.writes(), ElementsAre(Pair("a", false), Pair("b", true),
+                                           Pair("c", true)));
+
+  EXPECT_TRUE(coalescer.Flush());
+  EXPECT_THAT(stream.writes(),
+              ElementsAre(Pair("a", false), Pair("b", true), Pair("c", true),
+                          Pair("d", false)));
+}
+
+TEST(WriteCoalescerTest, FlushesLargeMessagesAndFullBatches) {
+  FakeStream stream;
+  WriteCoalescer<FakeMessage> coalescer(CoalescingOptions(absl::Hours(1)),
+                                        stream.WriteFunction());
+  EXPECT_TRUE(coalescer.Write({"a"}));
+  EXPECT_TRUE(coalescer.Write({"bbbb"}));
+  EXPECT_TRUE(coalescer.Write({"large"}));
+  EXPECT_THAT(stream.writes(), ElementsAre(Pair("a", false), Pair("bbbb", true),
+                                           Pair("large", false)));
+
+  EXPECT_TRUE(coalescer.Write({"cccc"}));
+  EXPECT_TRUE(coalescer.Write({"dddd"}));
+  EXPECT_TRUE(coalescer.Write({"eeee"}));
+  EXPECT_THAT(stream.writes(),
+              ElementsAre(Pair("a", false), Pair("bbbb", true),
+                          Pair("large", false), Pair("cccc", true),
+                          Pair("dddd", true), Pair("eeee", false)));
+}
+
+TEST(WriteCoalescerTest, FlushesWithinTheLatencyBudget) {
+  FakeStream stream;
+  WriteCoalescer<FakeMessage> coalescer(
+      CoalescingOptions(absl::Milliseconds(500)), stream.WriteFunction());
+  absl::Time start = absl::Now();
+  EXPECT_TRUE(coalescer.Write({"a"}));
+  EXPECT_TRUE(coalescer.Write({"b"}));
+  EXPECT_THAT(stream.writes(), ElementsAre(Pair("a", false)));
+
+  ASSERT_TRUE(stream.AwaitWrites(2, absl::Seconds(10)));
+  EXPECT_GE(absl::Now() - start, absl::Milliseconds(500));
+  EXPECT_THAT(stream.writes(), ElementsAre(Pair("a", false), Pair("b", false)));
+}
+
+TEST(WriteCoalescerTest, StopsOnceBroken) {
+  FakeStream stream;
+  WriteCoalescer<FakeMessage> coalescer(CoalescingOptions(absl::Hours(1)),
+                                        stream.WriteFunction());
+  EXPECT_TRUE(coalescer.Write({"a"}));
+  EXPECT_TRUE(coalescer.Write({"b"}));
+  stream.Break();
+  EXPECT_FALSE(coalescer.Write({"c"}));
+  EXPECT_FALSE(coalescer.Write({"d"}));
+  EXPECT_FALSE(coalescer.Flush());
+  EXPECT_THAT(stream.writes(), ElementsAre(Pair("a", false), Pair("b", true)));
+}
+
+}  // namespace
+}  // namespace visionai
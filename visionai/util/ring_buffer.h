@@ -39,8 +39,11 @@ class RingBuffer {
   size_t count() const;
 
   // Emplaces an element to the front of the ring buffer.
+  //
+  // Returns false if the buffer was full, in which case the element at the
+  // back was overwritten to make room. Otherwise, returns true.
   template <typename... Args>
-  void EmplaceFront(Args&&... args) ABSL_LOCKS_EXCLUDED(mu_);
+  bool EmplaceFront(Args&&... args) ABSL_LOCKS_EXCLUDED(mu_);
 
   // If the buffer is not empty, removes an element from the back and receives
   // it in `elem`. Otherwise, return false and causes no side effects.
@@ -82,9 +85,11 @@ inline size_t RingBuffer<T>::count() const {
 
 template <typename T>
 template <typename... Args>
-void RingBuffer<T>::EmplaceFront(Args&&... args) {
+bool RingBuffer<T>::EmplaceFront(Args&&... args) {
   absl::MutexLock lock(&mu_);
+  bool was_full = buffer_.full();
   buffer_.emplace_front(std::forward<Args>(args)...);
+  return !was_full;
 }
 
 template <typename T>
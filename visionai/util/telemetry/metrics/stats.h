@@ -149,6 +149,10 @@ COUNTER(capture_received_events_total,
         "Total number of events the downstream consumer received from the "
         "event discovery server",
         *GlobalRegistry());
+COUNTER(stream_runner_restarts_total,
+        "Total number of times the processing of a stream was restarted after "
+        "a failure.",
+        *GlobalRegistry());
 
 COUNTER(hls_segments_count_total,
         "Total number of the video segments generated for HLS livestream.",
@@ -164,6 +168,30 @@ GAUGE(hls_packet_delay_sec,
       "The processing delay of the packets in HLS livestream pipeline",
       *GlobalRegistry());
 
+// Metrics for the ingester dataflow. See streams/util/stage_trace.h and
+// streams/util/queue_metrics.h.
+HISTOGRAM(ingester_stage_latency_ms,
+          "The latency of each stage of the ingester dataflow, in ms.",
+          *GlobalRegistry());
+GAUGE(ingester_queue_capacity,
+      "The capacity of each queue of the ingester dataflow.",
+      *GlobalRegistry());
+GAUGE(ingester_queue_occupancy,
+      "The number of elements waiting in each queue of the ingester dataflow.",
+      *GlobalRegistry());
+COUNTER(ingester_queue_pushed_total,
+        "Total number of elements pushed into each queue of the ingester "
+        "dataflow.",
+        *GlobalRegistry());
+COUNTER(ingester_queue_popped_total,
+        "Total number of elements popped from each queue of the ingester "
+        "dataflow.",
+        *GlobalRegistry());
+COUNTER(ingester_queue_dropped_total,
+        "Total number of elements that each queue of the ingester dataflow "
+        "dropped because it was full.",
+        *GlobalRegistry());
+
 COUNTER(mwh_grpc_client_ingest_file_success_count_total,
         "Total number of the files successfully ingested to MWH.",
         *GlobalRegistry());